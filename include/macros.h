@@ -34,8 +34,13 @@ extern "C"
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "qg8.h"
+
 #define STRINGIFY(x) #x
 
+#define MIN(x,y) ((x) < (y) ? (x) : (y))
+#define MAX(x,y) ((x) > (y) ? (x) : (y))
+
 #define READNN(x,y,z,w) _size_check(fread(x, y, z, w), z, __LINE__)
 #define READN(x,y,z) _size_check(fread(x, 1, y, z), y, __LINE__)
 #define READ(x,y,z) _size_check(fread(x, 1, sizeof(y), z), sizeof(y), __LINE__)
@@ -59,9 +64,162 @@ _shape##x(z *data, \
 	return shape##x; \
 }
 
+/*
+ * SplitMix64 random streams, defined static in the files drawing from
+ * them: _mix scrambles a seed into a key and _unit(key, ctr) is word ctr
+ * of the stream of key, in [0, 1).
+ */
+#define SPLITMIX_GAMMA 0x9e3779b97f4a7c15UL
+
+#define SPLITMIX() \
+static \
+uint64_t \
+_mix(uint64_t z) \
+{ \
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL; \
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL; \
+	return z ^ (z >> 31); \
+} \
+static \
+double \
+_unit(uint64_t key, \
+      uint64_t ctr) \
+{ \
+	return (double) (_mix(key + (ctr + 1) * SPLITMIX_GAMMA) >> 11) * \
+	       (1.0 / 9007199254740992.0); \
+}
+
+/* row compressed view of a rank 1 or 2 tensor, values widened to double */
+typedef struct
+qg8_csr_s
+{
+	uint64_t rows, cols;
+	uint64_t *rowptr;
+	uint64_t *colidx;
+	double *re;
+	double *im;    /* NULL for real tensors */
+	uint64_t nparts;
+	uint64_t *parts; /* row ranges of about equal entry counts */
+} qg8_csr;
+
+/* dense gate on a list of qubits, qubits[0] the most significant index bit */
+typedef struct
+qg8_gate_s
+{
+	uint64_t k;
+	uint64_t *qubits;
+	double *re;       /* 2^k x 2^k, row-major */
+	double *im;
+} qg8_gate;
+
+/* graph chunks with their operands resolved from the adjacency chunk */
+typedef struct
+qg8_dag_s
+{
+	uint64_t num_nodes;
+	qg8_chunk **nodes;
+	uint64_t *opptr;     /* operands of j are opsrc[opptr[j]..opptr[j+1]] */
+	uint64_t *opsrc;
+	uint64_t *consumers; /* number of edges leaving each node */
+} qg8_dag;
+
+/* register tile of the dense product, see src/gemm.c */
+#define GEMM_MR 4
+#define GEMM_NR 8
+
+/* c[MR x NR] += alpha * (packed a panel) * (packed b panel) over kc */
+typedef void (*qg8_gemm_tile)(uint64_t, const double *, const double *,
+                              double, double *, uint64_t);
+
 void _size_check(size_t, size_t, int);
 uint8_t _type_to_size(uint8_t);
 
+int         _tensor_is_complex(qg8_tensor *);
+void        _tensor_to_double(qg8_tensor *, double *, double *);
+void        _tensor_element(qg8_tensor *, uint64_t, double *, double *);
+uint8_t     _convert_dtype(uint8_t, uint8_t);
+void        _convert_values(const void *, uint8_t, uint64_t, void *, uint8_t);
+int         _tensor_as_double(qg8_tensor *, double **, double **);
+qg8_tensor *_tensor_new(uint8_t, uint16_t, uint64_t *, uint64_t, int);
+qg8_tensor *_tensor_new_packed(uint8_t, uint64_t *, uint64_t, uint64_t,
+                               int);
+qg8_tensor *_tensor_copy(qg8_tensor *);
+uint64_t    _tensor_index_len(qg8_tensor *);
+uint16_t    _tensor_index_arrays(qg8_tensor *);
+int         _tensor_index_size(qg8_tensor *);
+void        _tensor_fill_full_indices(qg8_tensor *);
+uint64_t    _tensor_full_size(qg8_tensor *);
+void        _tensor_to_dense(qg8_tensor *, double *, double *);
+int         _tensor_is_packed(qg8_tensor *);
+qg8_tensor *_tensor_expand(qg8_tensor *);
+uint64_t   *_canon_order(qg8_tensor *);
+int         _canon_is_sorted(qg8_tensor *);
+
+qg8_csr    *_csr_from_tensor(qg8_tensor *, int);
+void        _csr_spmv(qg8_csr *, const double *, const double *,
+                      double *, double *);
+void        _csr_spmm(qg8_csr *, uint64_t, const double *, const double *,
+                      double *, double *);
+void        _csr_scan(uint64_t *, uint64_t);
+void        _csr_destroy(qg8_csr *);
+
+void        _kernel_zcsrmv(qg8_csr *, uint64_t, uint64_t, const double *,
+                           const double *, double *, double *);
+qg8_gemm_tile _kernel_dgemm_tile(void);
+void        _kernel_unpack(const uint8_t *, uint64_t, int, uint64_t *);
+float       _half_to_float(uint16_t);
+uint16_t    _float_to_half(float);
+float       _bf16_to_float(uint16_t);
+uint16_t    _float_to_bf16(float);
+uint16_t    _double_to_half(double);
+uint16_t    _double_to_bf16(double);
+
+void        _dgemm(uint64_t, uint64_t, uint64_t, double, const double *,
+                   uint64_t, const double *, uint64_t, double *, uint64_t);
+
+void        _gate_apply(uint64_t, double *, double *, const double *,
+                        const double *, const uint64_t *, uint64_t);
+void        _gate_fuse_apply(uint64_t, double *, double *, qg8_gate *,
+                             uint64_t, uint64_t);
+
+uint64_t    _pauli_qubits(qg8_tensor *);
+void        _pauli_apply(qg8_tensor *, const double *, const double *,
+                         double *, double *);
+void        _pauli_expectation(qg8_tensor *, const double *, const double *,
+                               double *, double *);
+qg8_tensor *_pauli_expand(qg8_tensor *);
+qg8_tensor *_pauli_join(qg8_tensor *, qg8_tensor *);
+
+uint64_t    _dia_length(qg8_tensor *);
+void        _dia_apply(qg8_tensor *, const double *, const double *,
+                       double *, double *);
+qg8_tensor *_dia_expand(qg8_tensor *);
+uint64_t    _bsr_blocks(qg8_tensor *);
+void        _bsr_apply(qg8_tensor *, const double *, const double *,
+                       double *, double *);
+qg8_tensor *_bsr_expand(qg8_tensor *);
+uint64_t    _linear_size(qg8_tensor *);
+qg8_tensor *_linear_view(qg8_tensor *);
+void        _linear_view_free(qg8_tensor *);
+void        _linear_unflatten(qg8_tensor *);
+uint8_t    *_codec_encode(qg8_tensor *, uint64_t *);
+void        _codec_decode(qg8_tensor *, const uint8_t *, uint64_t, uint64_t);
+uint8_t    *_compress_values(qg8_tensor *, uint64_t *);
+void        _decompress_values(qg8_tensor *, const uint8_t *, uint64_t,
+                               size_t, uint8_t);
+
+void        _vdot(uint64_t, const double *, const double *, const double *,
+                  const double *, double *, double *);
+double      _vnorm(uint64_t, const double *, const double *);
+void        _vaxpy(uint64_t, double, double, const double *, const double *,
+                   double *, double *);
+void        _vscale(uint64_t, double, const double *, const double *,
+                    double *, double *);
+
+qg8_dag    *_dag_build(qg8_graph *);
+uint64_t    _dag_find(qg8_dag *, qg8_chunk *);
+void        _dag_destroy(qg8_dag *);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -54,6 +54,7 @@ extern "C"
 #define QG8_TYPE_SOLVE             14
 #define QG8_TYPE_EXPECTATIONVALUE  15
 #define QG8_TYPE_SAMPLE            16
+#define QG8_TYPE_PERMUTATION       17 /* basis relabelling, see reorder.c */
 
 #define QG8_SIZE_8                 1
 #define QG8_SIZE_16                2
@@ -74,13 +75,41 @@ extern "C"
 #define QG8_DTYPE_FLOAT64          12
 #define QG8_DTYPE_COMPLEX64        13
 #define QG8_DTYPE_COMPLEX128       14
+#define QG8_DTYPE_FLOAT16          15 /* IEEE half precision */
+#define QG8_DTYPE_BFLOAT16         16 /* upper half of a FLOAT32 */
+#define QG8_DTYPE_COMPLEX32        17 /* FLOAT16 parts */
+#define QG8_DTYPE_BCOMPLEX32       18 /* BFLOAT16 parts */
 
 #define QG8_PACKING_FULL           1
 #define QG8_PACKING_SPARSE_COO     2
 #define QG8_PACKING_HALF_HERMITIAN 3
+#define QG8_PACKING_PAULI          4 /* sum of Pauli strings, see pauli.c */
+#define QG8_PACKING_DIA            5 /* stored diagonals, see dia.c */
+#define QG8_PACKING_BSR            6 /* stored blocks, see bsr.c */
+
+/* tensor flags */
+#define QG8_TENSOR_SORTED          0x01 /* sorted, no duplicates, canon.c */
+#define QG8_TENSOR_PACKED_INDEX    0x02 /* on disk only, see codec.c */
+#define QG8_TENSOR_LINEAR_INDEX    0x04 /* on disk only, see linear.c */
 
 #define QG8_FLAG_LABEL             1
 
+/* chunk value compression */
+#define QG8_COMPRESS_NONE          0
+#define QG8_COMPRESS_SHUFFLE_LZ    1 /* shuffled LZ blocks, compress.c */
+
+/* chunk index encoding */
+#define QG8_INDEX_PLAIN            0
+#define QG8_INDEX_LINEAR           1 /* flat indices on disk, linear.c */
+
+#define QG8_ISA_SCALAR             1
+#define QG8_ISA_AVX2               2
+#define QG8_ISA_AVX512             3
+
+#define QG8_SOLVE_TOL              1e-10
+#define QG8_EIGEN_TOL              1e-9
+#define QG8_FUSE_DEFAULT           4
+
 #define QG8_MODE_READ              1
 #define QG8_MODE_WRITE             2
 /*#define QG8_MODE_APPEND            3*/
@@ -100,7 +129,8 @@ qg8_chunk_header_s
 	uint16_t type;
 	uint8_t flags;
 	uint8_t id[16];
-	uint8_t _reserved[5];
+	uint8_t compression;
+	uint8_t _reserved[4];
 	uint64_t skip;
 } __attribute__((__packed__))
 qg8_chunk_header;
@@ -112,7 +142,8 @@ qg8_tensor_header_s
 	uint8_t itype_id;
 	uint8_t dtype_id;
 	uint16_t rank;
-	uint8_t _reserved[3];
+	uint8_t flags;
+	uint8_t _reserved[2];
 	/*uint8_t *dims;*/
 	uint64_t num_elements;
 } __attribute__((__packed__))
@@ -137,11 +168,14 @@ qg8_tensor_s
 	uint8_t dtype_id;
 	uint16_t rank;
 	uint8_t loaded;
+	uint8_t flags;         /* QG8_TENSOR_* */
 	uint64_t *dimensions;
 	uint64_t num_elems;
 	uint64_t **indices;
 	void *redata;
 	void *imdata;
+	struct qg8_csr_s *csr; /* cached by qg8_tensor_csr_build */
+	uint64_t *order;       /* cached by the lookups, see lookup.c */
 } qg8_tensor;
 
 qg8_tensor *qg8_tensor_create_float(uint64_t **, float *, float *, uint64_t,
@@ -164,6 +198,11 @@ qg8_tensor *qg8_tensor_create_int32(uint64_t **, int32_t *, uint64_t,
                                      uint64_t *, uint8_t, uint8_t);
 qg8_tensor *qg8_tensor_create_int64(uint64_t **, int64_t *, uint64_t,
                                      uint64_t *, uint8_t, uint8_t);
+qg8_tensor *qg8_tensor_create_half(uint64_t **, uint16_t *, uint16_t *,
+                                   uint64_t, uint64_t *, uint8_t, uint8_t);
+qg8_tensor *qg8_tensor_create_bfloat16(uint64_t **, uint16_t *, uint16_t *,
+                                       uint64_t, uint64_t *, uint8_t,
+                                       uint8_t);
 int         qg8_tensor_destroy(qg8_tensor *);
 uint16_t    qg8_tensor_get_rank(qg8_tensor *);
 uint64_t  **qg8_tensor_get_indices(qg8_tensor *);
@@ -173,6 +212,18 @@ uint8_t     qg8_tensor_get_itypeid(qg8_tensor *);
 void       *qg8_tensor_get_dims(qg8_tensor *);
 void       *qg8_tensor_get_re(qg8_tensor *);
 void       *qg8_tensor_get_im(qg8_tensor *);
+int         qg8_tensor_csr_build(qg8_tensor *);
+int         qg8_tensor_csr_release(qg8_tensor *);
+qg8_tensor *qg8_tensor_to_dia(qg8_tensor *);
+qg8_tensor *qg8_tensor_to_bsr(qg8_tensor *, uint64_t, uint64_t);
+uint64_t   *qg8_tensor_rcm(qg8_tensor *);
+qg8_tensor *qg8_tensor_canonical(qg8_tensor *);
+int         qg8_tensor_get_element(qg8_tensor *, const uint64_t *, double *,
+                                   double *);
+uint64_t    qg8_tensor_find_range(qg8_tensor *, const uint64_t *,
+                                  const uint64_t *, uint64_t **);
+int         qg8_tensor_lookup_release(qg8_tensor *);
+qg8_tensor *qg8_tensor_permute(qg8_tensor *, const uint64_t *, int);
 
 /* Adjacency matrices */
 
@@ -187,6 +238,8 @@ qg8_chunk_s
 	uint16_t type;
 	uint8_t flags;
 	uint8_t string_id[16];
+	uint8_t compression;    /* QG8_COMPRESS_* */
+	uint8_t index_encoding; /* QG8_INDEX_* */
 } qg8_chunk;
 
 typedef struct
@@ -202,6 +255,10 @@ qg8_tensor *qg8_chunk_get_tensor(qg8_chunk *);
 uint8_t     qg8_chunk_get_flags(qg8_chunk *);
 uint8_t    *qg8_chunk_get_string_id(qg8_chunk *);
 uint16_t    qg8_chunk_get_type(qg8_chunk *);
+uint8_t     qg8_chunk_get_compression(qg8_chunk *);
+int         qg8_chunk_set_compression(qg8_chunk *, uint8_t);
+uint8_t     qg8_chunk_get_index_encoding(qg8_chunk *);
+int         qg8_chunk_set_index_encoding(qg8_chunk *, uint8_t);
 
 /* Graph */
 
@@ -220,9 +277,11 @@ qg8_graph_s
 	qg8_chunk_linkedlist *chunks;
 	qg8_adjacencymatrix *adj;
 	qg8_chunk *adjchunk;
+	uint8_t max_fused; /* qubits per fused gate, 0 expands circuits */
 } qg8_graph;
 
 qg8_graph *qg8_graph_load(const char *);
+qg8_graph *qg8_graph_load_as(const char *, uint8_t);
 qg8_graph *qg8_graph_create(void);
 int        qg8_graph_write(const char *, qg8_graph *);
 int        qg8_graph_destroy(qg8_graph *);
@@ -230,6 +289,12 @@ uint64_t   qg8_graph_get_number_chunks(qg8_graph *);
 qg8_chunk *qg8_graph_get_chunk(qg8_graph *, uint64_t);
 int        qg8_graph_add_chunk(qg8_graph *, qg8_chunk *);
 int        qg8_graph_remove_chunk(qg8_graph *, qg8_chunk *);
+qg8_tensor *qg8_graph_evaluate(qg8_graph *, qg8_chunk *);
+qg8_tensor **qg8_graph_evaluate_batch(qg8_graph *, qg8_chunk *, qg8_chunk **,
+                                      uint64_t, qg8_tensor **, uint64_t);
+int        qg8_graph_set_max_fused(qg8_graph *, uint8_t);
+uint8_t    qg8_graph_get_max_fused(qg8_graph *);
+qg8_chunk *qg8_graph_reorder(qg8_graph *, qg8_chunk *);
 
 /* TODO */
 /*qg8_adjacencymatrix *qg8_graph_get_edges(qg8_graph *);*/
@@ -257,6 +322,109 @@ qg8_iter   qg8_file_iterator(qg8_file *);
 int        qg8_file_has_next(qg8_iter *);
 int        qg8_file_next(qg8_iter *);
 qg8_chunk *qg8_file_extract(qg8_iter *);
+qg8_chunk *qg8_file_extract_as(qg8_iter *, uint8_t);
+
+/* Operations */
+
+qg8_tensor *qg8_tensor_matmul(qg8_tensor *, qg8_tensor *);
+qg8_tensor *qg8_tensor_join(qg8_tensor *, qg8_tensor *);
+int         qg8_tensor_spmv(qg8_tensor *, const double *, const double *,
+                            double *, double *);
+int         qg8_tensor_spmm(qg8_tensor *, uint64_t, const double *,
+                            const double *, double *, double *);
+qg8_tensor *qg8_tensor_apply(qg8_tensor *, qg8_tensor *);
+int         qg8_tensor_apply_gate(qg8_tensor *, qg8_tensor *,
+                                  const uint64_t *, uint64_t);
+int         qg8_tensor_expectation(qg8_tensor *, qg8_tensor *, double *,
+                                   double *);
+qg8_tensor *qg8_tensor_expectation_value(qg8_tensor *, qg8_tensor *);
+qg8_tensor *qg8_tensor_sample(qg8_tensor *, uint64_t, uint64_t);
+qg8_tensor *qg8_tensor_evolve(qg8_tensor *, qg8_tensor *, const double *,
+                              uint64_t, double);
+int         qg8_tensor_eigen(qg8_tensor *, uint64_t, double, double *,
+                             qg8_tensor **);
+qg8_chunk **qg8_tensor_eigenkets(qg8_tensor *, uint64_t, double *);
+qg8_tensor *qg8_tensor_trajectories(qg8_tensor *, qg8_chunk **, uint64_t,
+                                    uint64_t, uint64_t);
+qg8_tensor *qg8_tensor_partial_trace(qg8_tensor *, const uint64_t *,
+                                     uint64_t);
+
+/* Kernels */
+
+int    qg8_kernel_get_isa(void);
+int    qg8_kernel_set_isa(int);
+void   qg8_kernel_zaxpy(uint64_t, double, double, const double *,
+                        const double *, double *, double *);
+void   qg8_kernel_caxpy(uint64_t, float, float, const float *,
+                        const float *, float *, float *);
+void   qg8_kernel_daxpy(uint64_t, double, const double *, double *);
+void   qg8_kernel_saxpy(uint64_t, float, const float *, float *);
+void   qg8_kernel_zscal(uint64_t, double, double, double *, double *);
+void   qg8_kernel_cscal(uint64_t, float, float, float *, float *);
+void   qg8_kernel_dscal(uint64_t, double, double *);
+void   qg8_kernel_sscal(uint64_t, float, float *);
+void   qg8_kernel_zmul(uint64_t, const double *, const double *,
+                       double *, double *);
+void   qg8_kernel_cmul(uint64_t, const float *, const float *,
+                       float *, float *);
+void   qg8_kernel_dmul(uint64_t, const double *, double *);
+void   qg8_kernel_smul(uint64_t, const float *, float *);
+void   qg8_kernel_zconj(uint64_t, double *);
+void   qg8_kernel_cconj(uint64_t, float *);
+void   qg8_kernel_zdotc(uint64_t, const double *, const double *,
+                        const double *, const double *, double *, double *);
+void   qg8_kernel_cdotc(uint64_t, const float *, const float *,
+                        const float *, const float *, double *, double *);
+double qg8_kernel_ddot(uint64_t, const double *, const double *);
+double qg8_kernel_sdot(uint64_t, const float *, const float *);
+double qg8_kernel_znrm2(uint64_t, const double *, const double *);
+double qg8_kernel_cnrm2(uint64_t, const float *, const float *);
+double qg8_kernel_dnrm2(uint64_t, const double *);
+double qg8_kernel_snrm2(uint64_t, const float *);
+void   qg8_kernel_dgemm(uint64_t, uint64_t, uint64_t, const double *,
+                        const double *, double *);
+void   qg8_kernel_zgemm(uint64_t, uint64_t, uint64_t, const double *,
+                        const double *, const double *, const double *,
+                        double *, double *);
+void   qg8_kernel_half_to_float(uint64_t, const uint16_t *, float *);
+void   qg8_kernel_float_to_half(uint64_t, const float *, uint16_t *);
+void   qg8_kernel_bf16_to_float(uint64_t, const uint16_t *, float *);
+void   qg8_kernel_float_to_bf16(uint64_t, const float *, uint16_t *);
+
+/* Planner */
+
+typedef struct
+qg8_plan_s
+{
+	uint16_t type;         /* QG8_TYPE_MATMUL or QG8_TYPE_JOIN */
+	uint64_t num_operands;
+	uint64_t *steps;       /* operand slot pairs, results fill slots n.. */
+	double cost;
+} qg8_plan;
+
+qg8_plan   *qg8_plan_create(uint16_t, qg8_tensor **, uint64_t);
+qg8_tensor *qg8_plan_execute(qg8_plan *, qg8_tensor **);
+double      qg8_plan_get_cost(qg8_plan *);
+int         qg8_plan_destroy(qg8_plan *);
+
+/* Pauli strings */
+
+int         qg8_pauli_parse(const char *, uint64_t *, uint64_t *);
+
+/* Kronecker views */
+
+typedef struct
+qg8_kron_s
+{
+	uint64_t num_factors;
+	qg8_tensor **factors;      /* borrowed, first factor most significant */
+	struct qg8_csr_s **csr;    /* NULL for identity factors */
+	uint64_t rows, cols;
+} qg8_kron;
+
+qg8_kron   *qg8_kron_create(qg8_tensor **, uint64_t);
+qg8_tensor *qg8_kron_apply(qg8_kron *, qg8_tensor *);
+int         qg8_kron_destroy(qg8_kron *);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,326 @@
+/*
+ * bsr.c
+ * QG8 base library block sparse packing source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A tensor in QG8_PACKING_BSR packing is a rows x cols matrix cut into
+ * R x C blocks, of which only some are stored. The first entries of the
+ * index arrays hold the block shape, indices[0][0] = R and indices[1][0] =
+ * C, both dividing the matching dimension. Block b = 1, 2, ... sits at
+ * block row indices[0][b] and block column indices[1][b], that is at rows
+ * R * indices[0][b] onwards and columns C * indices[1][b] onwards, and its
+ * R * C entries follow row by row in the data from (b - 1) * R * C. So
+ * num_elems is R * C times the number of blocks.
+ *
+ * Block diagonal and banded block operators then cost two integers per
+ * block rather than per element, and the product with a vector reuses
+ * every gathered slice of the vector across R rows.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+static
+int
+_bsr_compare(const void *a,
+             const void *b)
+{
+	uint64_t x, y;
+
+	x = *((const uint64_t *) a);
+	y = *((const uint64_t *) b);
+	return x < y ? -1 : x > y;
+}
+
+/*
+ * Number of stored blocks. The tensor must be a matrix whose block shape
+ * divides its dimensions and whose data holds whole blocks.
+ */
+uint64_t
+_bsr_blocks(qg8_tensor *t)
+{
+	uint64_t br, bc;
+
+	if (t->rank != 2)
+	{
+		DIE("Block sparse packing applies to matrices only.\n");
+	}
+	br = *(*(t->indices));
+	bc = *(*(t->indices+1));
+	if (br == 0 || bc == 0 || *(t->dimensions) % br != 0 ||
+	    *(t->dimensions+1) % bc != 0)
+	{
+		DIE("Block shape does not divide the matrix.\n");
+	}
+	if (t->num_elems % (br * bc) != 0)
+	{
+		DIE("Block sparse tensor does not hold whole blocks.\n");
+	}
+	return t->num_elems / (br * bc);
+}
+
+/*
+ * Stored blocks grouped by block row, in storage order within a row:
+ * the blocks of block row i are order[ptr[i]..ptr[i+1]-1], numbered from
+ * 0. Checks that every block lies inside the matrix.
+ */
+static
+void
+_bsr_rows(qg8_tensor *t,
+          uint64_t **ptr,
+          uint64_t **order)
+{
+	uint64_t nb, nbr, nbc, b, i, *fill;
+
+	nb = _bsr_blocks(t);
+	nbr = *(t->dimensions) / *(*(t->indices));
+	nbc = *(t->dimensions+1) / *(*(t->indices+1));
+	*ptr = (uint64_t *) calloc(nbr + 1, sizeof(uint64_t));
+	ALLOC(*ptr);
+	*order = (uint64_t *) malloc(sizeof(uint64_t) * MAX(nb, 1));
+	ALLOC(*order);
+	for (b = 1; b <= nb; ++b)
+	{
+		if (*(*(t->indices)+b) >= nbr || *(*(t->indices+1)+b) >= nbc)
+		{
+			DIE("Block lies outside of the matrix.\n");
+		}
+		(*(*ptr+*(*(t->indices)+b)+1))++;
+	}
+	for (i = 0; i < nbr; ++i)
+		*(*ptr+i+1) += *(*ptr+i);
+	fill = (uint64_t *) malloc(sizeof(uint64_t) * MAX(nbr, 1));
+	ALLOC(fill);
+	memcpy(fill, *ptr, sizeof(uint64_t) * nbr);
+	for (b = 1; b <= nb; ++b)
+		*(*order+(*(fill+*(*(t->indices)+b)))++) = b - 1;
+	free(fill);
+}
+
+/*
+ * y = t*x for split complex vectors. Every block row is summed by one
+ * thread, block by block in storage order, so the result does not depend
+ * on the thread count.
+ */
+void
+_bsr_apply(qg8_tensor *t,
+           const double *xr,
+           const double *xi,
+           double *yr,
+           double *yi)
+{
+	double *vr, *vi;
+	uint64_t *ptr, *order, br, bc, nbr, i;
+	int own;
+
+	br = *(*(t->indices));
+	bc = *(*(t->indices+1));
+	_bsr_rows(t, &ptr, &order);
+	nbr = *(t->dimensions) / br;
+	own = _tensor_as_double(t, &vr, &vi);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64) if(nbr > 64)
+#endif /* _OPENMP */
+	for (i = 0; i < nbr; ++i)
+	{
+		const double *dr, *di, *cr, *ci;
+		double sr, si;
+		uint64_t p, b, r, c;
+
+		memset(yr+i*br, 0, sizeof(double) * br);
+		memset(yi+i*br, 0, sizeof(double) * br);
+		for (p = *(ptr+i); p < *(ptr+i+1); ++p)
+		{
+			b = *(order+p);
+			cr = xr + *(*(t->indices+1)+b+1) * bc;
+			ci = xi + *(*(t->indices+1)+b+1) * bc;
+			for (r = 0; r < br; ++r)
+			{
+				dr = vr + (b * br + r) * bc;
+				di = vi ? vi + (b * br + r) * bc : NULL;
+				sr = 0.0;
+				si = 0.0;
+				for (c = 0; c < bc; ++c)
+				{
+					sr += *(dr+c) * *(cr+c);
+					si += *(dr+c) * *(ci+c);
+					if (di)
+					{
+						sr -= *(di+c) * *(ci+c);
+						si += *(di+c) * *(cr+c);
+					}
+				}
+				*(yr+i*br+r) += sr;
+				*(yi+i*br+r) += si;
+			}
+		}
+	}
+	free(ptr);
+	free(order);
+	if (own)
+	{
+		free(vr);
+		free(vi);
+	}
+}
+
+/* sparse COO copy of a BSR tensor, one entry per stored block element */
+qg8_tensor *
+_bsr_expand(qg8_tensor *t)
+{
+	qg8_tensor *out;
+	double *vr, *vi;
+	uint64_t br, bc, nb, b, r, c, p;
+	int own;
+
+	nb = _bsr_blocks(t);
+	br = *(*(t->indices));
+	bc = *(*(t->indices+1));
+	own = _tensor_as_double(t, &vr, &vi);
+	out = _tensor_new(QG8_PACKING_SPARSE_COO, 2, t->dimensions, nb * br * bc,
+	                  vi != NULL);
+	p = 0;
+	for (b = 0; b < nb; ++b)
+	{
+		for (r = 0; r < br; ++r)
+		{
+			for (c = 0; c < bc; ++c, ++p)
+			{
+				*(*(out->indices)+p) = *(*(t->indices)+b+1) * br + r;
+				*(*(out->indices+1)+p) = *(*(t->indices+1)+b+1) * bc + c;
+				*((double *) out->redata+p) = *(vr+p);
+				if (vi)
+					*((double *) out->imdata+p) = *(vi+p);
+			}
+		}
+	}
+	if (own)
+	{
+		free(vr);
+		free(vi);
+	}
+	return out;
+}
+
+/*
+ * Returns a copy of a rank 2 tensor in BSR packing with block_rows x
+ * block_cols blocks, FLOAT64 for real data and COMPLEX128 otherwise. Every
+ * block holding a stored entry is kept, ordered by block row then block
+ * column, with zeros where the block has no entry. Duplicate entries are
+ * summed.
+ */
+qg8_tensor *
+qg8_tensor_to_bsr(qg8_tensor *t,
+                  uint64_t block_rows,
+                  uint64_t block_cols)
+{
+	qg8_tensor *out;
+	qg8_csr *m;
+	double *re, *im;
+	uint64_t *seen, *cols, *ptr, nbr, nbc, nb, i, r, p, c, b, k, sz;
+	int cplx;
+
+	if (!t)
+	{
+		DIE("Cannot convert a NULL tensor.\n");
+	}
+	if (t->rank != 2 || block_rows == 0 || block_cols == 0 ||
+	    *(t->dimensions) % block_rows != 0 ||
+	    *(t->dimensions+1) % block_cols != 0)
+	{
+		DIE("Block shape does not divide the matrix.\n");
+	}
+	nbr = *(t->dimensions) / block_rows;
+	nbc = *(t->dimensions+1) / block_cols;
+	sz = block_rows * block_cols;
+	m = _csr_from_tensor(t, 0);
+	cplx = m->im != NULL;
+
+	/* block columns of every block row, seen[] stamped with the row + 1 */
+	seen = (uint64_t *) calloc(nbc, sizeof(uint64_t));
+	ALLOC(seen);
+	ptr = (uint64_t *) calloc(nbr + 1, sizeof(uint64_t));
+	ALLOC(ptr);
+	cols = (uint64_t *) malloc(sizeof(uint64_t) * MAX(*(m->rowptr+m->rows),
+	                                                  1));
+	ALLOC(cols);
+	nb = 0;
+	for (i = 0; i < nbr; ++i)
+	{
+		*(ptr+i) = nb;
+		for (r = i * block_rows; r < (i + 1) * block_rows; ++r)
+		{
+			for (p = *(m->rowptr+r); p < *(m->rowptr+r+1); ++p)
+			{
+				c = *(m->colidx+p) / block_cols;
+				if (*(seen+c) == i + 1)
+					continue;
+				*(seen+c) = i + 1;
+				*(cols+nb++) = c;
+			}
+		}
+		qsort(cols + *(ptr+i), nb - *(ptr+i), sizeof(uint64_t),
+		      _bsr_compare);
+	}
+	*(ptr+nbr) = nb;
+
+	out = _tensor_new_packed(QG8_PACKING_BSR, t->dimensions, nb + 1,
+	                         nb * sz, cplx);
+	re = (double *) out->redata;
+	im = (double *) out->imdata;
+	memset(re, 0, sizeof(double) * MAX(nb * sz, 1));
+	if (cplx)
+		memset(im, 0, sizeof(double) * MAX(nb * sz, 1));
+	*(*(out->indices)) = block_rows;
+	*(*(out->indices+1)) = block_cols;
+	for (i = 0; i < nbr; ++i)
+	{
+		for (b = *(ptr+i); b < *(ptr+i+1); ++b)
+		{
+			*(*(out->indices)+b+1) = i;
+			*(*(out->indices+1)+b+1) = *(cols+b);
+			/* seen[] now maps a block column to its block number */
+			*(seen+*(cols+b)) = b;
+		}
+		for (r = i * block_rows; r < (i + 1) * block_rows; ++r)
+		{
+			for (p = *(m->rowptr+r); p < *(m->rowptr+r+1); ++p)
+			{
+				c = *(m->colidx+p);
+				k = *(seen+c/block_cols) * sz +
+				    (r - i * block_rows) * block_cols + c % block_cols;
+				*(re+k) += *(m->re+p);
+				if (cplx)
+					*(im+k) += *(m->im+p);
+			}
+		}
+	}
+	free(seen);
+	free(ptr);
+	free(cols);
+	_csr_destroy(m);
+	return out;
+}
@@ -0,0 +1,373 @@
+/*
+ * canon.c
+ * QG8 base library canonical sparse ordering source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A tensor with QG8_TENSOR_SORTED in its flags stores its entries in
+ * lexicographic order of their coordinates, first axis first, with no
+ * coordinate twice. The flag is written to the tensor header and read back
+ * with it, so canonical tensors stay canonical across files, and row
+ * compressed views of them are built without sorting.
+ *
+ * The entries are sorted with a least significant digit radix sort, one
+ * byte per pass, from the last axis to the first. An axis costs as many
+ * passes as its largest index has bytes, and a pass in which every entry
+ * has the same digit is skipped.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* entries per counting block, fixed so the order is the same on any team */
+#define RADIX_BLOCK 65536
+#define RADIX_SIZE  256
+
+/* bytes needed to tell the indices 0..dim-1 apart */
+static
+int
+_radix_bytes(uint64_t dim)
+{
+	uint64_t v;
+	int b;
+
+	b = 0;
+	for (v = dim - 1; v; v >>= 8)
+		++b;
+	return b;
+}
+
+/*
+ * Stable pass on the byte of key at shift, moving key and ord to tkey and
+ * tord. hist holds RADIX_SIZE counters per block. Returns 0 without moving
+ * anything if all entries have the same digit.
+ */
+static
+int
+_radix_pass(uint64_t n,
+            int shift,
+            const uint64_t *key,
+            const uint64_t *ord,
+            uint64_t *tkey,
+            uint64_t *tord,
+            uint64_t *hist)
+{
+	uint64_t nb, b, d, sum, c;
+
+	nb = (n + RADIX_BLOCK - 1) / RADIX_BLOCK;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(nb > 1)
+#endif /* _OPENMP */
+	for (b = 0; b < nb; ++b)
+	{
+		uint64_t *h, i, hi;
+
+		h = hist + b * RADIX_SIZE;
+		memset(h, 0, sizeof(uint64_t) * RADIX_SIZE);
+		hi = MIN(n, (b + 1) * RADIX_BLOCK);
+		for (i = b * RADIX_BLOCK; i < hi; ++i)
+			(*(h+((*(key+i) >> shift) & 0xff)))++;
+	}
+
+	/* block b writes digit d after all smaller digits and earlier blocks */
+	sum = 0;
+	for (d = 0; d < RADIX_SIZE; ++d)
+	{
+		c = 0;
+		for (b = 0; b < nb; ++b)
+			c += *(hist+b*RADIX_SIZE+d);
+		if (c == n)
+			return 0;
+		for (b = 0; b < nb; ++b)
+		{
+			c = *(hist+b*RADIX_SIZE+d);
+			*(hist+b*RADIX_SIZE+d) = sum;
+			sum += c;
+		}
+	}
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(nb > 1)
+#endif /* _OPENMP */
+	for (b = 0; b < nb; ++b)
+	{
+		uint64_t *h, i, hi, p;
+
+		h = hist + b * RADIX_SIZE;
+		hi = MIN(n, (b + 1) * RADIX_BLOCK);
+		for (i = b * RADIX_BLOCK; i < hi; ++i)
+		{
+			p = (*(h+((*(key+i) >> shift) & 0xff)))++;
+			*(tkey+p) = *(key+i);
+			*(tord+p) = *(ord+i);
+		}
+	}
+	return 1;
+}
+
+/*
+ * Whether the entries of t are stored as QG8_TENSOR_SORTED claims, in one
+ * pass: every coordinate inside the dimensions and after the one before.
+ * Packed entries are not at their coordinates and never are.
+ */
+int
+_canon_is_sorted(qg8_tensor *t)
+{
+	uint64_t e, a, b;
+	uint16_t k;
+
+	if (_tensor_is_packed(t))
+		return 0;
+	for (e = 0; e < t->num_elems; ++e)
+	{
+		for (k = 0; k < t->rank; ++k)
+			if (*(*(t->indices+k)+e) >= *(t->dimensions+k))
+				return 0;
+		if (e == 0)
+			continue;
+		for (k = 0; k < t->rank; ++k)
+		{
+			a = *(*(t->indices+k)+e-1);
+			b = *(*(t->indices+k)+e);
+			if (a != b)
+				break;
+		}
+		if (k == t->rank || a > b)
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * Order of the entries of t sorted by coordinates, as an array of
+ * num_elems entry numbers which the caller frees.
+ */
+uint64_t *
+_canon_order(qg8_tensor *t)
+{
+	uint64_t *key, *ord, *tkey, *tord, *hist, *idx, *swap, n, i;
+	int k, s, bytes;
+
+	n = t->num_elems;
+	key = (uint64_t *) malloc(sizeof(uint64_t) * MAX(n, 1));
+	ALLOC(key);
+	ord = (uint64_t *) malloc(sizeof(uint64_t) * MAX(n, 1));
+	ALLOC(ord);
+	tkey = (uint64_t *) malloc(sizeof(uint64_t) * MAX(n, 1));
+	ALLOC(tkey);
+	tord = (uint64_t *) malloc(sizeof(uint64_t) * MAX(n, 1));
+	ALLOC(tord);
+	hist = (uint64_t *) malloc(sizeof(uint64_t) * RADIX_SIZE *
+	                           MAX((n + RADIX_BLOCK - 1) / RADIX_BLOCK, 1));
+	ALLOC(hist);
+	for (i = 0; i < n; ++i)
+		*(ord+i) = i;
+	for (k = t->rank - 1; k >= 0; --k)
+	{
+		bytes = _radix_bytes(*(t->dimensions+k));
+		if (bytes == 0)
+			continue;
+		idx = *(t->indices+k);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif /* _OPENMP */
+		for (i = 0; i < n; ++i)
+			*(key+i) = *(idx+*(ord+i));
+		for (s = 0; s < bytes; ++s)
+		{
+			if (!_radix_pass(n, 8 * s, key, ord, tkey, tord, hist))
+				continue;
+			swap = key;
+			key = tkey;
+			tkey = swap;
+			swap = ord;
+			ord = tord;
+			tord = swap;
+		}
+	}
+	free(key);
+	free(tkey);
+	free(tord);
+	free(hist);
+	return ord;
+}
+
+/* *acc += *v in the dtype of the tensor, booleans or-ed */
+static
+void
+_canon_add(void *acc,
+           const void *v,
+           uint8_t dtype)
+{
+	switch (dtype)
+	{
+	case QG8_DTYPE_BOOL:
+		*((uint8_t *) acc) |= *((const uint8_t *) v);
+		break;
+	case QG8_DTYPE_CHAR:
+	case QG8_DTYPE_UINT8:
+		*((uint8_t *) acc) += *((const uint8_t *) v);
+		break;
+	case QG8_DTYPE_UINT16:
+		*((uint16_t *) acc) += *((const uint16_t *) v);
+		break;
+	case QG8_DTYPE_UINT32:
+		*((uint32_t *) acc) += *((const uint32_t *) v);
+		break;
+	case QG8_DTYPE_UINT64:
+		*((uint64_t *) acc) += *((const uint64_t *) v);
+		break;
+	case QG8_DTYPE_INT8:
+		*((int8_t *) acc) += *((const int8_t *) v);
+		break;
+	case QG8_DTYPE_INT16:
+		*((int16_t *) acc) += *((const int16_t *) v);
+		break;
+	case QG8_DTYPE_INT32:
+		*((int32_t *) acc) += *((const int32_t *) v);
+		break;
+	case QG8_DTYPE_INT64:
+		*((int64_t *) acc) += *((const int64_t *) v);
+		break;
+	case QG8_DTYPE_FLOAT32:
+	case QG8_DTYPE_COMPLEX64:
+		*((float *) acc) += *((const float *) v);
+		break;
+	case QG8_DTYPE_FLOAT64:
+	case QG8_DTYPE_COMPLEX128:
+		*((double *) acc) += *((const double *) v);
+		break;
+	case QG8_DTYPE_FLOAT16:
+	case QG8_DTYPE_COMPLEX32:
+		*((uint16_t *) acc) = _float_to_half(
+		                      _half_to_float(*((uint16_t *) acc)) +
+		                      _half_to_float(*((const uint16_t *) v)));
+		break;
+	case QG8_DTYPE_BFLOAT16:
+	case QG8_DTYPE_BCOMPLEX32:
+		*((uint16_t *) acc) = _float_to_bf16(
+		                      _bf16_to_float(*((uint16_t *) acc)) +
+		                      _bf16_to_float(*((const uint16_t *) v)));
+		break;
+	default:
+		fprintf(stderr, "Cannot sum elements of dtype %d.\n", dtype);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ * Returns a canonical copy of t: its entries sorted by coordinates and
+ * the entries sharing a coordinate summed, with QG8_TENSOR_SORTED set.
+ * The copy keeps the dtype of t, and its packing for half Hermitian
+ * tensors; other tensors come back in sparse COO packing. Duplicates are
+ * summed in storage order, so the result does not depend on the thread
+ * count.
+ */
+qg8_tensor *
+qg8_tensor_canonical(qg8_tensor *t)
+{
+	qg8_tensor *src, *out;
+	uint64_t *ord, *first, n, m, i, g;
+	uint16_t k;
+	size_t dsize;
+	int bad, same;
+
+	if (!t)
+	{
+		DIE("Cannot sort a NULL tensor.\n");
+	}
+	src = _tensor_is_packed(t) ? _tensor_expand(t) : t;
+	n = src->num_elems;
+	bad = 0;
+	for (k = 0; k < src->rank; ++k)
+	{
+#ifdef _OPENMP
+#pragma omp parallel for reduction(|:bad)
+#endif /* _OPENMP */
+		for (i = 0; i < n; ++i)
+			bad |= *(*(src->indices+k)+i) >= *(src->dimensions+k);
+	}
+	if (bad)
+	{
+		DIE("Tensor index is out of bounds.\n");
+	}
+	ord = _canon_order(src);
+
+	/* entries first[g]..first[g+1]-1 of ord share a coordinate */
+	first = (uint64_t *) malloc(sizeof(uint64_t) * (n + 1));
+	ALLOC(first);
+	m = 0;
+	for (i = 0; i < n; ++i)
+	{
+		same = i > 0;
+		for (k = 0; same && k < src->rank; ++k)
+			same = *(*(src->indices+k)+*(ord+i)) ==
+			       *(*(src->indices+k)+*(ord+i-1));
+		if (!same)
+			*(first+m++) = i;
+	}
+	*(first+m) = n;
+
+	/* _tensor_new holds doubles, wide enough for any dtype */
+	out = _tensor_new(src->packing == QG8_PACKING_HALF_HERMITIAN ?
+	                  QG8_PACKING_HALF_HERMITIAN : QG8_PACKING_SPARSE_COO,
+	                  src->rank, src->dimensions, m, _tensor_is_complex(src));
+	out->dtype_id = src->dtype_id;
+	out->flags = QG8_TENSOR_SORTED;
+	dsize = _type_to_size(src->dtype_id);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(m > RADIX_BLOCK)
+#endif /* _OPENMP */
+	for (g = 0; g < m; ++g)
+	{
+		uint8_t *re, *im;
+		uint64_t e, j;
+		uint16_t a;
+
+		e = *(ord+*(first+g));
+		for (a = 0; a < src->rank; ++a)
+			*(*(out->indices+a)+g) = *(*(src->indices+a)+e);
+		re = (uint8_t *) out->redata + g * dsize;
+		im = out->imdata ? (uint8_t *) out->imdata + g * dsize : NULL;
+		memcpy(re, (uint8_t *) src->redata + e * dsize, dsize);
+		if (im)
+			memcpy(im, (uint8_t *) src->imdata + e * dsize, dsize);
+		for (j = *(first+g) + 1; j < *(first+g+1); ++j)
+		{
+			e = *(ord+j);
+			_canon_add(re, (uint8_t *) src->redata + e * dsize,
+			           src->dtype_id);
+			if (im)
+				_canon_add(im, (uint8_t *) src->imdata + e * dsize,
+				           src->dtype_id);
+		}
+	}
+	free(ord);
+	free(first);
+	if (src != t)
+		qg8_tensor_destroy(src);
+	return out;
+}
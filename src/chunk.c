@@ -52,6 +52,8 @@ qg8_chunk_create(uint16_t type,
 	}
 	chunk->flags = new_flags;
 	chunk->type = type;
+	chunk->compression = QG8_COMPRESS_NONE;
+	chunk->index_encoding = QG8_INDEX_PLAIN;
 	return chunk;
 }
 
@@ -108,3 +110,65 @@ qg8_chunk_get_type(qg8_chunk *chunk)
 	return chunk->type;
 }
 
+uint8_t
+qg8_chunk_get_compression(qg8_chunk *chunk)
+{
+	if (!chunk)
+	{
+		DIE("Cannot get compression from a NULL chunk.\n");
+	}
+	return chunk->compression;
+}
+
+/*
+ * Sets how the values of the tensor of the chunk are written to files,
+ * see compress.c. Chunks read from a file keep the compression they were
+ * written with.
+ */
+int
+qg8_chunk_set_compression(qg8_chunk *chunk,
+                          uint8_t compression)
+{
+	if (!chunk)
+	{
+		DIE("Cannot set compression of a NULL chunk.\n");
+	}
+	if (compression != QG8_COMPRESS_NONE &&
+	    compression != QG8_COMPRESS_SHUFFLE_LZ)
+	{
+		DIE("Unknown chunk compression.\n");
+	}
+	chunk->compression = compression;
+	return 1;
+}
+
+uint8_t
+qg8_chunk_get_index_encoding(qg8_chunk *chunk)
+{
+	if (!chunk)
+	{
+		DIE("Cannot get index encoding from a NULL chunk.\n");
+	}
+	return chunk->index_encoding;
+}
+
+/*
+ * Sets how the index arrays of the tensor of the chunk are written to
+ * files, see linear.c. Chunks read from a file keep the encoding they were
+ * written with, their tensors being back in sparse COO packing.
+ */
+int
+qg8_chunk_set_index_encoding(qg8_chunk *chunk,
+                             uint8_t encoding)
+{
+	if (!chunk)
+	{
+		DIE("Cannot set index encoding of a NULL chunk.\n");
+	}
+	if (encoding != QG8_INDEX_PLAIN && encoding != QG8_INDEX_LINEAR)
+	{
+		DIE("Unknown chunk index encoding.\n");
+	}
+	chunk->index_encoding = encoding;
+	return 1;
+}
@@ -0,0 +1,256 @@
+/*
+ * codec.c
+ * QG8 base library packed index codec source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Canonical tensors, see canon.c, are written with their index arrays
+ * delta coded and bit packed, and QG8_TENSOR_PACKED_INDEX set in the
+ * tensor header. Since the entries come in lexicographic order, index k of
+ * an entry is at least that of the previous entry whenever their indices
+ * on the axes before k agree, so it is stored as the difference, and as
+ * itself otherwise. The first axis, and the single key of LINEAR indices,
+ * thus become the gaps between entries, and the columns of a sorted matrix
+ * the gaps within a row.
+ *
+ * The differences of every array are cut into blocks of CODEC_BLOCK. A
+ * block is one byte holding the bit width b of its largest difference,
+ * followed by its differences in b bits each, least significant bit
+ * first, in ceil(count * b / 8) bytes. The index data of the chunk is the
+ * byte length of all arrays as a uint64, then the arrays one after the
+ * other.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* differences per block sharing a bit width */
+#define CODEC_BLOCK 128
+
+/* bits needed for v */
+static
+int
+_codec_width(uint64_t v)
+{
+	int b;
+
+	for (b = 0; v; v >>= 1)
+		++b;
+	return b;
+}
+
+/* payload bytes of a block of cnt differences of b bits */
+static
+uint64_t
+_codec_bytes(uint64_t cnt,
+             int b)
+{
+	return (cnt * b + 7) / 8;
+}
+
+/*
+ * Differences of index array k, or 0 if the entries are not in order.
+ * same[e] tells whether entry e agrees with entry e - 1 on the axes before
+ * k, and is narrowed to axis k on return.
+ */
+static
+int
+_codec_diff(const uint64_t *idx,
+            uint64_t n,
+            uint8_t *same,
+            uint64_t *diff)
+{
+	uint64_t e;
+	int bad;
+
+	bad = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(|:bad)
+#endif /* _OPENMP */
+	for (e = 0; e < n; ++e)
+	{
+		uint64_t prev;
+
+		prev = e > 0 ? *(idx+e-1) : 0;
+		if (!*(same+e))
+		{
+			*(diff+e) = *(idx+e);
+			continue;
+		}
+		bad |= *(idx+e) < prev;
+		*(diff+e) = *(idx+e) - prev;
+	}
+	if (bad)
+		return 0;
+	for (e = 1; e < n; ++e)
+		*(same+e) = *(same+e) && *(idx+e) == *(idx+e-1);
+	return 1;
+}
+
+/*
+ * Encodes the index arrays of a canonical COO, half Hermitian or full
+ * tensor, or of the LINEAR view of one, see linear.c. Returns a new
+ * buffer and sets *len to its size, or returns NULL if the tensor is not
+ * canonical or its entries are out of order.
+ */
+uint8_t *
+_codec_encode(qg8_tensor *t,
+              uint64_t *len)
+{
+	uint8_t *buf, *same, *p;
+	uint64_t *diff, n, nb, b, e, cnt, max, size, bit;
+	uint16_t k, na;
+	int w;
+
+	if (!(t->flags & QG8_TENSOR_SORTED) || _tensor_is_packed(t))
+		return NULL;
+	n = t->num_elems;
+	na = _tensor_index_arrays(t);
+	nb = (n + CODEC_BLOCK - 1) / CODEC_BLOCK;
+	same = (uint8_t *) malloc(MAX(n, 1));
+	ALLOC(same);
+	memset(same, 1, MAX(n, 1));
+	diff = (uint64_t *) malloc(sizeof(uint64_t) * MAX(n, 1) * na);
+	ALLOC(diff);
+	for (k = 0; k < na; ++k)
+	{
+		if (!_codec_diff(*(t->indices+k), n, same, diff + k * n))
+		{
+			free(same);
+			free(diff);
+			return NULL;
+		}
+	}
+	free(same);
+
+	/* a byte of width per block, at most 8 bytes per difference */
+	buf = (uint8_t *) calloc(na * (nb + 8 * n) + 1, 1);
+	ALLOC(buf);
+	p = buf;
+	for (k = 0; k < na; ++k)
+	{
+		for (b = 0; b < nb; ++b)
+		{
+			cnt = MIN(CODEC_BLOCK, n - b * CODEC_BLOCK);
+			max = 0;
+			for (e = 0; e < cnt; ++e)
+				max |= *(diff+k*n+b*CODEC_BLOCK+e);
+			w = _codec_width(max);
+			*(p++) = (uint8_t) w;
+			for (e = 0, bit = 0; w > 0 && e < cnt; ++e)
+			{
+				uint64_t v;
+				int done;
+
+				v = *(diff+k*n+b*CODEC_BLOCK+e);
+				for (done = 0; done < w; done += 8 - (int) ((bit + done) & 7))
+					*(p+((bit+done)>>3)) |= (uint8_t)
+					                        ((v >> done) << ((bit + done) & 7));
+				bit += w;
+			}
+			p += _codec_bytes(cnt, w);
+		}
+	}
+	size = p - buf;
+	free(diff);
+	*len = size;
+	return buf;
+}
+
+/*
+ * Decodes len bytes of packed index arrays into the index arrays of t,
+ * allocated here, for n entries. The buffer must be readable 8 bytes past
+ * len, which the vector unpacking reads ahead.
+ */
+void
+_codec_decode(qg8_tensor *t,
+              const uint8_t *buf,
+              uint64_t len,
+              uint64_t n)
+{
+	uint64_t *off, *idx, nb, b, e, pos;
+	uint8_t *same;
+	uint16_t k, na;
+
+	na = _tensor_index_arrays(t);
+	nb = (n + CODEC_BLOCK - 1) / CODEC_BLOCK;
+
+	/* block offsets, from the widths */
+	off = (uint64_t *) malloc(sizeof(uint64_t) * MAX(na * nb, 1));
+	ALLOC(off);
+	pos = 0;
+	for (b = 0; b < na * nb; ++b)
+	{
+		if (pos >= len || *(buf+pos) > 64)
+		{
+			DIE("Packed indices do not match their chunk.\n");
+		}
+		*(off+b) = pos;
+		pos += 1 + _codec_bytes(MIN(CODEC_BLOCK, n - (b % nb) * CODEC_BLOCK),
+		                        *(buf+pos));
+	}
+	if (pos != len)
+	{
+		DIE("Packed indices do not match their chunk.\n");
+	}
+
+	for (k = 0; k < t->rank; ++k)
+		*(t->indices+k) = NULL;
+	for (k = 0; k < na; ++k)
+	{
+		*(t->indices+k) = (uint64_t *) malloc(sizeof(uint64_t) * MAX(n, 1));
+		ALLOC(*(t->indices+k));
+	}
+	qg8_kernel_get_isa(); /* resolve the dispatch before the threads start */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(na * nb > 8)
+#endif /* _OPENMP */
+	for (b = 0; b < na * nb; ++b)
+	{
+		uint64_t first;
+
+		first = (b % nb) * CODEC_BLOCK;
+		_kernel_unpack(buf + *(off+b) + 1, MIN(CODEC_BLOCK, n - first),
+		               *(buf+*(off+b)), *(t->indices+b/nb) + first);
+	}
+	free(off);
+
+	/* undo the differences, axis by axis, as _codec_diff made them */
+	same = (uint8_t *) malloc(MAX(n, 1));
+	ALLOC(same);
+	memset(same, 1, MAX(n, 1));
+	for (k = 0; k < na; ++k)
+	{
+		idx = *(t->indices+k);
+		for (e = 0; e < n; ++e)
+		{
+			if (*(same+e) && e > 0)
+				*(idx+e) += *(idx+e-1);
+			if (e > 0)
+				*(same+e) = *(same+e) && *(idx+e) == *(idx+e-1);
+		}
+	}
+	free(same);
+}
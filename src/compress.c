@@ -0,0 +1,446 @@
+/*
+ * compress.c
+ * QG8 base library tensor value compression source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A chunk with QG8_COMPRESS_SHUFFLE_LZ in the compression byte of its
+ * header stores the values of its tensor compressed, and the byte length
+ * of the compressed values as a uint64 right after num_elems, ahead of the
+ * indices, so the reader knows how the chunk is shared out before reading
+ * any of it.
+ *
+ * The real parts, then the imaginary parts, are cut into blocks of
+ * COMPRESS_BLOCK bytes. A block is byte shuffled: the first bytes of all
+ * its values come first, then all the second bytes, and so on, which lines
+ * up the slowly changing sign and exponent bytes of floating point data.
+ * It is then compressed on its own with a byte oriented LZ77 coder, so the
+ * blocks are read back in parallel. The compressed values are a uint32 size
+ * per block, followed by the blocks. A block which does not get smaller is
+ * kept shuffled only, its size being its plain size.
+ *
+ * An LZ block is a list of sequences. A sequence is a token whose high
+ * nibble is the number of literals and low nibble the match length less
+ * LZ_MIN_MATCH, either being continued by bytes of 255 and a last smaller
+ * byte when it reaches 15, then the literals, then the distance back to
+ * the match as 2 little endian bytes. The last sequence stops after its
+ * literals.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* bytes per block, a multiple of every value size */
+#define COMPRESS_BLOCK 65536
+#define LZ_MIN_MATCH   4
+#define LZ_HASH_BITS   13
+
+/* value arrays of t: the real parts, and the imaginary ones if complex */
+static
+int
+_compress_parts(qg8_tensor *t)
+{
+	return _tensor_is_complex(t) ? 2 : 1;
+}
+
+/* blocks of one value array of len bytes */
+static
+uint64_t
+_compress_blocks(uint64_t len)
+{
+	return (len + COMPRESS_BLOCK - 1) / COMPRESS_BLOCK;
+}
+
+static
+void
+_shuffle(const uint8_t *in,
+         uint64_t len,
+         size_t dsize,
+         uint8_t *out)
+{
+	uint64_t m, i;
+	size_t b;
+
+	m = len / dsize;
+	for (b = 0; b < dsize; ++b)
+		for (i = 0; i < m; ++i)
+			*(out+b*m+i) = *(in+i*dsize+b);
+}
+
+static
+void
+_unshuffle(const uint8_t *in,
+           uint64_t len,
+           size_t dsize,
+           uint8_t *out)
+{
+	uint64_t m, i;
+	size_t b;
+
+	m = len / dsize;
+	for (b = 0; b < dsize; ++b)
+		for (i = 0; i < m; ++i)
+			*(out+i*dsize+b) = *(in+b*m+i);
+}
+
+/* writes the continuation bytes of a length, returns the new end or NULL */
+static
+uint8_t *
+_lz_length(uint8_t *op,
+           const uint8_t *end,
+           uint64_t v)
+{
+	for (; v >= 255; v -= 255)
+	{
+		if (op >= end)
+			return NULL;
+		*(op++) = 255;
+	}
+	if (op >= end)
+		return NULL;
+	*(op++) = (uint8_t) v;
+	return op;
+}
+
+/* sequence of the literals lit..lit+nlit-1 and a match, if len is not 0 */
+static
+uint8_t *
+_lz_sequence(uint8_t *op,
+             const uint8_t *end,
+             const uint8_t *lit,
+             uint64_t nlit,
+             uint64_t dist,
+             uint64_t len)
+{
+	uint8_t *token;
+
+	if (op >= end)
+		return NULL;
+	token = op++;
+	*token = (uint8_t) (MIN(nlit, 15) << 4);
+	if (nlit >= 15 && !(op = _lz_length(op, end, nlit - 15)))
+		return NULL;
+	if ((uint64_t) (end - op) < nlit)
+		return NULL;
+	memcpy(op, lit, nlit);
+	op += nlit;
+	if (len == 0)
+		return op;
+	len -= LZ_MIN_MATCH;
+	*token |= (uint8_t) MIN(len, 15);
+	if (end - op < 2)
+		return NULL;
+	*(op++) = (uint8_t) (dist & 0xff);
+	*(op++) = (uint8_t) (dist >> 8);
+	if (len >= 15 && !(op = _lz_length(op, end, len - 15)))
+		return NULL;
+	return op;
+}
+
+/*
+ * Compresses the n bytes of in to out, returning the compressed size, or 0
+ * if it would not be below cap bytes.
+ */
+static
+uint64_t
+_lz_compress(const uint8_t *in,
+             uint64_t n,
+             uint8_t *out,
+             uint64_t cap)
+{
+	uint32_t table[1 << LZ_HASH_BITS], seq;
+	uint64_t ip, anchor, ref, len, h;
+	const uint8_t *end;
+	uint8_t *op;
+
+	memset(table, 0, sizeof(table));
+	end = out + cap;
+	op = out;
+	ip = 0;
+	anchor = 0;
+	while (ip + LZ_MIN_MATCH <= n)
+	{
+		memcpy(&seq, in + ip, sizeof(seq));
+		h = ((seq * 2654435761UL) & 0xffffffffUL) >> (32 - LZ_HASH_BITS);
+		ref = *(table+h);
+		*(table+h) = (uint32_t) ip;
+		if (ref >= ip || ip - ref > 0xffff ||
+		    memcmp(in + ref, in + ip, LZ_MIN_MATCH) != 0)
+		{
+			/* step faster through data that does not match */
+			ip += 1 + ((ip - anchor) >> 6);
+			continue;
+		}
+		len = LZ_MIN_MATCH;
+		while (ip + len < n && *(in+ref+len) == *(in+ip+len))
+			++len;
+		op = _lz_sequence(op, end, in + anchor, ip - anchor, ip - ref, len);
+		if (!op)
+			return 0;
+		ip += len;
+		anchor = ip;
+	}
+	op = _lz_sequence(op, end, in + anchor, n - anchor, 0, 0);
+	return op ? (uint64_t) (op - out) : 0;
+}
+
+/* reads a length continued past 15, returns 0 on running out of input */
+static
+int
+_lz_read_length(const uint8_t **ip,
+                const uint8_t *end,
+                uint64_t *v)
+{
+	uint8_t b;
+
+	do
+	{
+		if (*ip >= end)
+			return 0;
+		b = *((*ip)++);
+		*v += b;
+	} while (b == 255);
+	return 1;
+}
+
+/* decompresses len bytes of in to exactly n bytes of out, 0 on bad data */
+static
+int
+_lz_decompress(const uint8_t *in,
+               uint64_t len,
+               uint8_t *out,
+               uint64_t n)
+{
+	const uint8_t *ip, *end;
+	uint64_t op, nlit, mlen, dist, i;
+	uint8_t token;
+
+	ip = in;
+	end = in + len;
+	op = 0;
+	while (ip < end)
+	{
+		token = *(ip++);
+		nlit = token >> 4;
+		if (nlit == 15 && !_lz_read_length(&ip, end, &nlit))
+			return 0;
+		if ((uint64_t) (end - ip) < nlit || n - op < nlit)
+			return 0;
+		memcpy(out + op, ip, nlit);
+		ip += nlit;
+		op += nlit;
+		if (ip == end)
+			break;
+		if (end - ip < 2)
+			return 0;
+		dist = *ip | ((uint64_t) *(ip+1) << 8);
+		ip += 2;
+		mlen = token & 0x0f;
+		if (mlen == 15 && !_lz_read_length(&ip, end, &mlen))
+			return 0;
+		mlen += LZ_MIN_MATCH;
+		if (dist == 0 || dist > op || n - op < mlen)
+			return 0;
+		/* byte by byte, the match may overlap what it writes */
+		for (i = 0; i < mlen; ++i, ++op)
+			*(out+op) = *(out+op-dist);
+	}
+	return op == n;
+}
+
+/*
+ * Compresses the values of t as described above. Returns a new buffer and
+ * sets *len to its size.
+ */
+uint8_t *
+_compress_values(qg8_tensor *t,
+                 uint64_t *len)
+{
+	uint8_t **blk, *buf, *p;
+	uint64_t *size, plain, nb, nbp, b, total;
+	size_t dsize;
+	int parts;
+
+	dsize = _type_to_size(t->dtype_id);
+	parts = _compress_parts(t);
+	plain = dsize * t->num_elems;
+	nbp = _compress_blocks(plain);
+	nb = nbp * parts;
+	blk = (uint8_t **) malloc(sizeof(uint8_t *) * MAX(nb, 1));
+	ALLOC(blk);
+	size = (uint64_t *) malloc(sizeof(uint64_t) * MAX(nb, 1));
+	ALLOC(size);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if(nb > 1)
+#endif /* _OPENMP */
+	for (b = 0; b < nb; ++b)
+	{
+		const uint8_t *src;
+		uint8_t *sh;
+		uint64_t first, n;
+
+		src = (const uint8_t *) (b < nbp ? t->redata : t->imdata);
+		first = (b % nbp) * COMPRESS_BLOCK;
+		n = MIN(COMPRESS_BLOCK, plain - first);
+		sh = (uint8_t *) malloc(n);
+		ALLOC(sh);
+		_shuffle(src + first, n, dsize, sh);
+		*(blk+b) = (uint8_t *) malloc(n);
+		ALLOC(*(blk+b));
+		*(size+b) = _lz_compress(sh, n, *(blk+b), n - 1);
+		if (*(size+b) == 0)
+		{
+			/* incompressible, kept shuffled */
+			free(*(blk+b));
+			*(blk+b) = sh;
+			*(size+b) = n;
+		}
+		else
+		{
+			free(sh);
+		}
+	}
+
+	total = sizeof(uint32_t) * nb;
+	for (b = 0; b < nb; ++b)
+		total += *(size+b);
+	buf = (uint8_t *) malloc(MAX(total, 1));
+	ALLOC(buf);
+	p = buf + sizeof(uint32_t) * nb;
+	for (b = 0; b < nb; ++b)
+	{
+		uint32_t s;
+
+		s = (uint32_t) *(size+b);
+		memcpy(buf + sizeof(uint32_t) * b, &s, sizeof(s));
+		memcpy(p, *(blk+b), *(size+b));
+		p += *(size+b);
+		free(*(blk+b));
+	}
+	free(blk);
+	free(size);
+	*len = total;
+	return buf;
+}
+
+/*
+ * Decompresses the len bytes of compressed values in buf into the new
+ * value arrays of t, whose values are dsize bytes each. Each block is
+ * converted to dtype to on its way out, see _convert_values, and t is left
+ * of that dtype.
+ */
+void
+_decompress_values(qg8_tensor *t,
+                   const uint8_t *buf,
+                   uint64_t len,
+                   size_t dsize,
+                   uint8_t to)
+{
+	uint64_t *off, plain, nb, nbp, b, pos;
+	uint32_t s;
+	size_t tsize;
+	int parts, bad;
+
+	parts = _compress_parts(t);
+	plain = dsize * t->num_elems;
+	nbp = _compress_blocks(plain);
+	nb = nbp * parts;
+
+	/* block offsets, from the sizes */
+	off = (uint64_t *) malloc(sizeof(uint64_t) * (nb + 1));
+	ALLOC(off);
+	pos = sizeof(uint32_t) * nb;
+	if (pos > len)
+	{
+		DIE("Compressed values do not match their chunk.\n");
+	}
+	for (b = 0; b < nb; ++b)
+	{
+		memcpy(&s, buf + sizeof(uint32_t) * b, sizeof(s));
+		*(off+b) = pos;
+		pos += s;
+	}
+	*(off+nb) = pos;
+	if (pos != len)
+	{
+		DIE("Compressed values do not match their chunk.\n");
+	}
+
+	tsize = _type_to_size(to);
+	t->redata = malloc(MAX(tsize * t->num_elems, 1));
+	ALLOC(t->redata);
+	if (parts == 2)
+	{
+		t->imdata = malloc(MAX(tsize * t->num_elems, 1));
+		ALLOC(t->imdata);
+	}
+	qg8_kernel_get_isa(); /* resolve the dispatch before the threads start */
+	bad = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if(nb > 1) reduction(|:bad)
+#endif /* _OPENMP */
+	for (b = 0; b < nb; ++b)
+	{
+		const uint8_t *src;
+		uint8_t *dst, *sh, *out;
+		uint64_t first, n, size;
+
+		dst = (uint8_t *) (b < nbp ? t->redata : t->imdata);
+		first = (b % nbp) * COMPRESS_BLOCK;
+		n = MIN(COMPRESS_BLOCK, plain - first);
+		src = buf + *(off+b);
+		size = *(off+b+1) - *(off+b);
+		/* blocks hold whole values, converted from a block of the plain */
+		out = to == t->dtype_id ? dst + first : (uint8_t *) malloc(n);
+		ALLOC(out);
+		if (size == n)
+		{
+			_unshuffle(src, n, dsize, out);
+		}
+		else
+		{
+			sh = (uint8_t *) malloc(n);
+			ALLOC(sh);
+			if (size > n || !_lz_decompress(src, size, sh, n))
+				bad = 1;
+			else
+				_unshuffle(sh, n, dsize, out);
+			free(sh);
+		}
+		if (out != dst + first)
+		{
+			if (!bad)
+				_convert_values(out, t->dtype_id, n / dsize,
+				                dst + first / dsize * tsize, to);
+			free(out);
+		}
+	}
+	free(off);
+	if (bad)
+	{
+		DIE("Compressed values are corrupt.\n");
+	}
+	t->dtype_id = to;
+}
@@ -0,0 +1,272 @@
+/*
+ * dia.c
+ * QG8 base library diagonal packing source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A tensor in QG8_PACKING_DIA packing is a rows x cols matrix stored as a
+ * list of diagonals, each L = min(rows, cols) elements long. Diagonal d
+ * starts at row indices[0][d] and column indices[1][d], and its element k
+ * is the entry (indices[0][d] + k, indices[1][d] + k), held in the data at
+ * d * L + k. The slots past the edge of the matrix are padding and are
+ * never read. The index arrays hold one entry per diagonal, so num_elems
+ * is L times the number of diagonals.
+ *
+ * Banded operators then cost two integers per diagonal rather than per
+ * element, and the product with a vector streams every diagonal at unit
+ * stride through both the data and the vector.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* rows per partial product */
+#define DIA_BLOCK 4096
+
+/*
+ * Length of every stored diagonal. The tensor must be a matrix whose
+ * data holds whole diagonals.
+ */
+uint64_t
+_dia_length(qg8_tensor *t)
+{
+	uint64_t len;
+
+	if (t->rank != 2)
+	{
+		DIE("Diagonal packing applies to matrices only.\n");
+	}
+	len = MIN(*(t->dimensions), *(t->dimensions+1));
+	if (t->num_elems % len != 0)
+	{
+		DIE("Diagonal tensor does not hold whole diagonals.\n");
+	}
+	return len;
+}
+
+/* number of diagonals, each of them checked to start inside the matrix */
+static
+uint64_t
+_dia_count(qg8_tensor *t)
+{
+	uint64_t nd, d;
+
+	nd = t->num_elems / _dia_length(t);
+	for (d = 0; d < nd; ++d)
+	{
+		if (*(*(t->indices)+d) >= *(t->dimensions) ||
+		    *(*(t->indices+1)+d) >= *(t->dimensions+1))
+		{
+			DIE("Diagonal starts outside of the matrix.\n");
+		}
+	}
+	return nd;
+}
+
+/* elements of diagonal d inside the matrix */
+static
+uint64_t
+_dia_span(qg8_tensor *t,
+          uint64_t d)
+{
+	return MIN(*(t->dimensions) - *(*(t->indices)+d),
+	           *(t->dimensions+1) - *(*(t->indices+1)+d));
+}
+
+/*
+ * y = t*x for split complex vectors. The rows are cut into blocks and
+ * every block walks all diagonals in order, so each element of y is
+ * summed by one thread in the same order whatever the thread count.
+ */
+void
+_dia_apply(qg8_tensor *t,
+           const double *xr,
+           const double *xi,
+           double *yr,
+           double *yi)
+{
+	double *vr, *vi;
+	uint64_t rows, len, nd, nb, b;
+	int own;
+
+	rows = *(t->dimensions);
+	len = _dia_length(t);
+	nd = _dia_count(t);
+	own = _tensor_as_double(t, &vr, &vi);
+	nb = (rows + DIA_BLOCK - 1) / DIA_BLOCK;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(nb > 1)
+#endif /* _OPENMP */
+	for (b = 0; b < nb; ++b)
+	{
+		const double *dr, *di, *cr, *ci;
+		uint64_t lo, hi, d, r0, s, e, k;
+
+		lo = b * DIA_BLOCK;
+		hi = MIN(lo + DIA_BLOCK, rows);
+		memset(yr+lo, 0, sizeof(double) * (hi - lo));
+		memset(yi+lo, 0, sizeof(double) * (hi - lo));
+		for (d = 0; d < nd; ++d)
+		{
+			r0 = *(*(t->indices)+d);
+			s = MAX(lo, r0);
+			e = MIN(hi, r0 + _dia_span(t, d));
+			if (s >= e)
+				continue;
+			/* element k of the diagonal meets x at column c0 + k */
+			dr = vr + d * len;
+			cr = xr + *(*(t->indices+1)+d);
+			ci = xi + *(*(t->indices+1)+d);
+			if (vi)
+			{
+				di = vi + d * len;
+				for (k = s - r0; k < e - r0; ++k)
+				{
+					*(yr+r0+k) += *(dr+k) * *(cr+k) - *(di+k) * *(ci+k);
+					*(yi+r0+k) += *(dr+k) * *(ci+k) + *(di+k) * *(cr+k);
+				}
+			}
+			else
+			{
+				for (k = s - r0; k < e - r0; ++k)
+				{
+					*(yr+r0+k) += *(dr+k) * *(cr+k);
+					*(yi+r0+k) += *(dr+k) * *(ci+k);
+				}
+			}
+		}
+	}
+	if (own)
+	{
+		free(vr);
+		free(vi);
+	}
+}
+
+/* sparse COO copy of a DIA tensor, without the padding */
+qg8_tensor *
+_dia_expand(qg8_tensor *t)
+{
+	qg8_tensor *out;
+	double *vr, *vi;
+	uint64_t len, nd, n, d, k, p;
+	int own;
+
+	len = _dia_length(t);
+	nd = _dia_count(t);
+	n = 0;
+	for (d = 0; d < nd; ++d)
+		n += _dia_span(t, d);
+	own = _tensor_as_double(t, &vr, &vi);
+	out = _tensor_new(QG8_PACKING_SPARSE_COO, 2, t->dimensions, n, vi != NULL);
+	p = 0;
+	for (d = 0; d < nd; ++d)
+	{
+		for (k = 0; k < _dia_span(t, d); ++k, ++p)
+		{
+			*(*(out->indices)+p) = *(*(t->indices)+d) + k;
+			*(*(out->indices+1)+p) = *(*(t->indices+1)+d) + k;
+			*((double *) out->redata+p) = *(vr+d*len+k);
+			if (vi)
+				*((double *) out->imdata+p) = *(vi+d*len+k);
+		}
+	}
+	if (own)
+	{
+		free(vr);
+		free(vi);
+	}
+	return out;
+}
+
+/*
+ * Returns a copy of a rank 2 tensor in DIA packing, FLOAT64 for real data
+ * and COMPLEX128 otherwise, holding every diagonal with a stored entry in
+ * increasing order of column minus row. Duplicate entries are summed.
+ */
+qg8_tensor *
+qg8_tensor_to_dia(qg8_tensor *t)
+{
+	qg8_tensor *out;
+	qg8_csr *m;
+	double *re, *im;
+	uint64_t *slot, rows, cols, len, nd, r, p, c, d, k;
+	int cplx;
+
+	if (!t)
+	{
+		DIE("Cannot convert a NULL tensor.\n");
+	}
+	if (t->rank != 2)
+	{
+		DIE("Diagonal packing applies to matrices only.\n");
+	}
+	rows = *(t->dimensions);
+	cols = *(t->dimensions+1);
+	len = MIN(rows, cols);
+	m = _csr_from_tensor(t, 0);
+	cplx = m->im != NULL;
+
+	/* diagonal of offset c - r lives in slot c - r + rows - 1 */
+	slot = (uint64_t *) calloc(rows + cols - 1, sizeof(uint64_t));
+	ALLOC(slot);
+	for (r = 0; r < rows; ++r)
+		for (p = *(m->rowptr+r); p < *(m->rowptr+r+1); ++p)
+			*(slot+*(m->colidx+p)+rows-1-r) = 1;
+	nd = 0;
+	for (d = 0; d < rows + cols - 1; ++d)
+		if (*(slot+d))
+			*(slot+d) = ++nd;
+
+	out = _tensor_new_packed(QG8_PACKING_DIA, t->dimensions, nd, nd * len,
+	                         cplx);
+	re = (double *) out->redata;
+	im = (double *) out->imdata;
+	memset(re, 0, sizeof(double) * MAX(nd * len, 1));
+	if (cplx)
+		memset(im, 0, sizeof(double) * MAX(nd * len, 1));
+	for (d = 0; d < rows + cols - 1; ++d)
+	{
+		if (!*(slot+d))
+			continue;
+		k = *(slot+d) - 1;
+		*(*(out->indices)+k) = d < rows ? rows - 1 - d : 0;
+		*(*(out->indices+1)+k) = d < rows ? 0 : d - (rows - 1);
+	}
+	for (r = 0; r < rows; ++r)
+	{
+		for (p = *(m->rowptr+r); p < *(m->rowptr+r+1); ++p)
+		{
+			c = *(m->colidx+p);
+			k = (*(slot+c+rows-1-r) - 1) * len + MIN(r, c);
+			*(re+k) += *(m->re+p);
+			if (cplx)
+				*(im+k) += *(m->im+p);
+		}
+	}
+	free(slot);
+	_csr_destroy(m);
+	return out;
+}
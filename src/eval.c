@@ -0,0 +1,986 @@
+/*
+ * eval.c
+ * QG8 base library graph evaluation source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+#define STATE_NEW     0
+#define STATE_ACTIVE  1
+#define STATE_DONE    2
+
+/* largest JOIN factor that is densified by the circuit pass */
+#define CIRCUIT_GATE_MAX 10
+
+typedef struct
+eval_state_s
+{
+	qg8_dag *dag;
+	uint64_t target;
+	uint8_t max_fused;
+	qg8_tensor **values;
+	uint8_t *owned;
+	uint8_t *state;
+	uint64_t *pending; /* consumers which have not read the value yet */
+	uint8_t *keep;     /* values kept across the runs of a batch, or NULL */
+	qg8_tensor **bound; /* values of a batch run given to INPUT chunks */
+} eval_state;
+
+static qg8_tensor *_eval_node(eval_state *, uint64_t);
+
+static
+uint64_t
+_num_operands(eval_state *s,
+              uint64_t j)
+{
+	return *(s->dag->opptr+j+1) - *(s->dag->opptr+j);
+}
+
+/* called once per edge when a consumer is done with an operand */
+static
+void
+_release(eval_state *s,
+         uint64_t j)
+{
+	if (*(s->pending+j) > 0)
+		--*(s->pending+j);
+	if (s->keep && *(s->keep+j))
+		return;
+	if (*(s->pending+j) == 0 && j != s->target && *(s->owned+j) &&
+	    *(s->values+j))
+	{
+		qg8_tensor_destroy(*(s->values+j));
+		*(s->values+j) = NULL;
+	}
+}
+
+/*
+ * Collects the operands of a product chain. Operand nodes of the same type
+ * that feed nothing else are folded into the chain so that the planner sees
+ * the whole product at once.
+ */
+static
+void
+_gather_chain(eval_state *s,
+              uint64_t j,
+              uint16_t type,
+              uint64_t **list,
+              uint64_t *len,
+              uint64_t *cap)
+{
+	uint64_t p, o;
+
+	for (p = *(s->dag->opptr+j); p < *(s->dag->opptr+j+1); ++p)
+	{
+		o = *(s->dag->opsrc+p);
+		if ((*(s->dag->nodes+o))->type == type &&
+		    *(s->dag->consumers+o) == 1 && o != s->target &&
+		    *(s->state+o) == STATE_NEW && _num_operands(s, o) > 0)
+		{
+			*(s->state+o) = STATE_DONE;
+			_gather_chain(s, o, type, list, len, cap);
+			continue;
+		}
+		if (*len == *cap)
+		{
+			*cap *= 2;
+			*list = (uint64_t *) realloc(*list, sizeof(uint64_t) * *cap);
+			ALLOC(*list);
+		}
+		*(*list+(*len)++) = o;
+	}
+}
+
+/* tensor of a data chunk, or of the batch value bound to it, or NULL */
+static
+qg8_tensor *
+_data_tensor(eval_state *s,
+             uint64_t j)
+{
+	qg8_chunk *chunk;
+
+	chunk = *(s->dag->nodes+j);
+	if (chunk->type < QG8_TYPE_ADJACENCY || chunk->type > QG8_TYPE_NOISESPEC)
+		return NULL;
+	if (s->bound && *(s->bound+j))
+		return *(s->bound+j);
+	return chunk->tensor;
+}
+
+/* log2 of a square power of two matrix dimension, -1 otherwise */
+static
+int
+_qubits_of(qg8_tensor *t)
+{
+	int k;
+
+	if (t->rank != 2 || *(t->dimensions) != *(t->dimensions+1))
+		return -1;
+	for (k = 0; k < 63 && ((uint64_t) 1 << k) < *(t->dimensions); ++k)
+		;
+	return ((uint64_t) 1 << k) == *(t->dimensions) ? k : -1;
+}
+
+static
+int
+_is_identity(qg8_tensor *t)
+{
+	double *re, *im;
+	uint8_t *seen;
+	uint64_t e, r, c, n;
+	int ok;
+
+	/* entries of other packings are not at their coordinates */
+	if (t->packing != QG8_PACKING_FULL &&
+	    t->packing != QG8_PACKING_SPARSE_COO &&
+	    t->packing != QG8_PACKING_HALF_HERMITIAN)
+		return 0;
+	re = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(re);
+	im = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(im);
+	seen = (uint8_t *) calloc(*(t->dimensions), sizeof(uint8_t));
+	ALLOC(seen);
+	_tensor_to_double(t, re, im);
+	n = 0;
+	ok = 1;
+	for (e = 0; ok && e < t->num_elems; ++e)
+	{
+		r = *(*(t->indices)+e);
+		c = *(*(t->indices+1)+e);
+		if (r != c)
+			ok = *(re+e) == 0.0 && *(im+e) == 0.0;
+		else if (r >= *(t->dimensions) || *(seen+r))
+			ok = 0;
+		else
+		{
+			ok = *(re+e) == 1.0 && *(im+e) == 0.0;
+			*(seen+r) = 1;
+			++n;
+		}
+	}
+	free(re);
+	free(im);
+	free(seen);
+	return ok && n == *(t->dimensions);
+}
+
+/*
+ * Lists the data chunks a gate operand is the Kronecker product of: the
+ * factors of a tree of JOIN chunks feeding nothing else, or the operand
+ * itself. Returns 0 if a factor is not a square power of two data tensor.
+ */
+static
+int
+_gate_factors(eval_state *s,
+              uint64_t j,
+              uint64_t *list,
+              uint64_t *len,
+              uint64_t cap)
+{
+	qg8_chunk *chunk;
+	uint64_t p;
+
+	chunk = *(s->dag->nodes+j);
+	if (chunk->type == QG8_TYPE_JOIN && *(s->dag->consumers+j) == 1 &&
+	    j != s->target && *(s->state+j) == STATE_NEW &&
+	    _num_operands(s, j) > 0)
+	{
+		for (p = *(s->dag->opptr+j); p < *(s->dag->opptr+j+1); ++p)
+			if (!_gate_factors(s, *(s->dag->opsrc+p), list, len, cap))
+				return 0;
+		return 1;
+	}
+	if (!_data_tensor(s, j) || _qubits_of(_data_tensor(s, j)) < 0 ||
+	    *len == cap)
+		return 0;
+	*(list+(*len)++) = j;
+	return 1;
+}
+
+static
+void
+_free_gates(qg8_gate *gates,
+            uint64_t n)
+{
+	uint64_t i;
+
+	for (i = 0; i < n; ++i)
+	{
+		free((gates+i)->qubits);
+		free((gates+i)->re);
+		free((gates+i)->im);
+	}
+	free(gates);
+}
+
+/*
+ * Circuit pass: a MATMUL chain ending on a ket whose other operands are
+ * Kronecker products of small gates, identities and scalars is applied
+ * gate by gate to the ket, fusing neighbouring gates, instead of expanding
+ * every operand to the full state dimension. Gates wider than max_fused
+ * are only densified as JOIN factors; an operand that is one such gate is
+ * left to the sparse product. Returns NULL, having changed nothing but the
+ * evaluation of the ket, if the chain is not of that shape.
+ */
+static
+qg8_tensor *
+_eval_circuit(eval_state *s,
+              uint64_t *list,
+              uint64_t len)
+{
+	qg8_tensor *ket, *res, *t;
+	qg8_gate *gates;
+	uint64_t *factors, nf, cap, ng, nq, off, i, f, q, d, shape[2];
+	double sr, si, vr, vi, w;
+	int k;
+
+	if (!s->max_fused || len < 2)
+		return NULL;
+	ket = _eval_node(s, *(list+len-1));
+	if (ket->rank < 1 || ket->rank > 2 ||
+	    (ket->rank == 2 && *(ket->dimensions+1) != 1))
+		return NULL;
+	for (nq = 0; nq < 63 && ((uint64_t) 1 << nq) < *(ket->dimensions); ++nq)
+		;
+	if (((uint64_t) 1 << nq) != *(ket->dimensions))
+		return NULL;
+
+	/* every operand must split into gates covering exactly nq qubits */
+	cap = nq * (len - 1);
+	factors = (uint64_t *) malloc(sizeof(uint64_t) * MAX(cap, 1));
+	ALLOC(factors);
+	nf = 0;
+	for (i = len - 1; i-- > 0;)
+	{
+		off = 0;
+		f = nf;
+		if (!_gate_factors(s, *(list+i), factors, &nf, cap))
+			break;
+		for (; f < nf; ++f)
+		{
+			t = _data_tensor(s, *(factors+f));
+			k = _qubits_of(t);
+			off += k;
+			if (k > s->max_fused &&
+			    (k > CIRCUIT_GATE_MAX || *(factors+f) == *(list+i)) &&
+			    !_is_identity(t))
+				break;
+		}
+		if (f < nf || off != nq)
+			break;
+	}
+	if (i != (uint64_t) -1)
+	{
+		free(factors);
+		return NULL;
+	}
+
+	/*
+	 * densify the non-identity factors, in application order; scalars
+	 * commute with the gates and scale the result
+	 */
+	gates = (qg8_gate *) malloc(sizeof(qg8_gate) * MAX(nf, 1));
+	ALLOC(gates);
+	ng = 0;
+	off = 0;
+	sr = 1.0;
+	si = 0.0;
+	for (f = 0; f < nf; ++f)
+	{
+		t = _data_tensor(s, *(factors+f));
+		k = _qubits_of(t);
+		if (off == nq)
+			off = 0;
+		off += k;
+		if (k == 0)
+		{
+			_tensor_to_dense(t, &vr, &vi);
+			w = sr * vr - si * vi;
+			si = sr * vi + si * vr;
+			sr = w;
+			continue;
+		}
+		if (_is_identity(t))
+			continue;
+		d = (uint64_t) 1 << k;
+		(gates+ng)->k = k;
+		(gates+ng)->qubits = (uint64_t *) malloc(sizeof(uint64_t) * k);
+		ALLOC((gates+ng)->qubits);
+		for (q = 0; q < (uint64_t) k; ++q)
+			*((gates+ng)->qubits+q) = off - k + q;
+		(gates+ng)->re = (double *) malloc(sizeof(double) * d * d);
+		ALLOC((gates+ng)->re);
+		(gates+ng)->im = (double *) malloc(sizeof(double) * d * d);
+		ALLOC((gates+ng)->im);
+		_tensor_to_dense(t, (gates+ng)->re, (gates+ng)->im);
+		++ng;
+	}
+
+	shape[0] = *(ket->dimensions);
+	shape[1] = 1;
+	res = _tensor_new(QG8_PACKING_FULL, ket->rank, shape, shape[0], 1);
+	_tensor_fill_full_indices(res);
+	_tensor_to_dense(ket, (double *) res->redata, (double *) res->imdata);
+	_gate_fuse_apply(nq, (double *) res->redata, (double *) res->imdata,
+	                 gates, ng, s->max_fused);
+	if (sr != 1.0 || si != 0.0)
+		qg8_kernel_zscal(shape[0], sr, si, (double *) res->redata,
+		                 (double *) res->imdata);
+	_free_gates(gates, ng);
+	free(factors);
+
+	/*
+	 * the Kronecker products folded in are consumed without being
+	 * expanded; data operands may feed other chunks and are read as usual
+	 */
+	for (i = 0; i + 1 < len; ++i)
+	{
+		if (_data_tensor(s, *(list+i)))
+			_eval_node(s, *(list+i));
+		else
+			*(s->state+*(list+i)) = STATE_DONE;
+	}
+	return res;
+}
+
+static
+qg8_tensor *
+_eval_chain(eval_state *s,
+            uint64_t j)
+{
+	qg8_tensor **ops, *res;
+	qg8_plan *plan;
+	uint64_t *list, len, cap, i;
+	uint16_t type;
+
+	type = (*(s->dag->nodes+j))->type;
+	if (_num_operands(s, j) == 0)
+	{
+		DIE("Cannot evaluate a product chunk without operands.\n");
+	}
+	cap = 8;
+	len = 0;
+	list = (uint64_t *) malloc(sizeof(uint64_t) * cap);
+	ALLOC(list);
+	_gather_chain(s, j, type, &list, &len, &cap);
+
+	if (type == QG8_TYPE_MATMUL && (res = _eval_circuit(s, list, len)))
+	{
+		for (i = 0; i < len; ++i)
+			_release(s, *(list+i));
+		free(list);
+		return res;
+	}
+	ops = (qg8_tensor **) malloc(sizeof(qg8_tensor *) * len);
+	ALLOC(ops);
+	for (i = 0; i < len; ++i)
+		*(ops+i) = _eval_node(s, *(list+i));
+	plan = qg8_plan_create(type, ops, len);
+	res = qg8_plan_execute(plan, ops);
+	qg8_plan_destroy(plan);
+	for (i = 0; i < len; ++i)
+		_release(s, *(list+i));
+	free(ops);
+	free(list);
+	return res;
+}
+
+/*
+ * Expectation values take a ket and an observable in either order; the
+ * operand with more than one column is the observable.
+ */
+static
+qg8_tensor *
+_eval_expectation(eval_state *s,
+                  uint64_t j)
+{
+	qg8_tensor *a, *b, *res;
+	uint64_t oa, ob;
+
+	if (_num_operands(s, j) != 2)
+	{
+		DIE("Cannot evaluate an expectation value without two operands.\n");
+	}
+	oa = *(s->dag->opsrc+*(s->dag->opptr+j));
+	ob = *(s->dag->opsrc+*(s->dag->opptr+j)+1);
+	a = _eval_node(s, oa);
+	b = _eval_node(s, ob);
+	if (a->rank == 2 && *(a->dimensions+1) != 1)
+		res = qg8_tensor_expectation_value(a, b);
+	else
+		res = qg8_tensor_expectation_value(b, a);
+	_release(s, oa);
+	_release(s, ob);
+	return res;
+}
+
+/*
+ * Time evolution takes an operator, a ket and a TIME chunk giving the grid
+ * of times, see qg8_tensor_evolve. The operator is told from the ket by
+ * its number of columns.
+ */
+static
+qg8_tensor *
+_eval_solve(eval_state *s,
+            uint64_t j)
+{
+	qg8_tensor *t[3], *time, *op, *ket, *res;
+	double *grid, *gi;
+	uint64_t o[3], k, m;
+
+	if (_num_operands(s, j) != 3)
+	{
+		DIE("Cannot evaluate a solve without an operator, a ket and times.\n");
+	}
+	time = NULL;
+	m = 0;
+	for (k = 0; k < 3; ++k)
+	{
+		o[k] = *(s->dag->opsrc+*(s->dag->opptr+j)+k);
+		t[k] = _eval_node(s, o[k]);
+		if ((*(s->dag->nodes+o[k]))->type == QG8_TYPE_TIME && !time)
+			time = t[k];
+		else
+			t[m++] = t[k];
+	}
+	if (!time)
+	{
+		DIE("Cannot evaluate a solve without a TIME chunk.\n");
+	}
+	if (t[0]->rank == 2 && *(t[0]->dimensions+1) != 1)
+	{
+		op = t[0];
+		ket = t[1];
+	}
+	else
+	{
+		op = t[1];
+		ket = t[0];
+	}
+	grid = (double *) malloc(sizeof(double) * MAX(time->num_elems, 1));
+	ALLOC(grid);
+	gi = (double *) malloc(sizeof(double) * MAX(time->num_elems, 1));
+	ALLOC(gi);
+	_tensor_to_double(time, grid, gi);
+	res = qg8_tensor_evolve(op, ket, grid, time->num_elems, QG8_SOLVE_TOL);
+	free(grid);
+	free(gi);
+	for (k = 0; k < 3; ++k)
+		_release(s, o[k]);
+	return res;
+}
+
+/*
+ * Samples take a ket and a CONSTANT or INPUT chunk holding the number of
+ * shots, optionally followed by the seed of the random numbers.
+ */
+static
+qg8_tensor *
+_eval_sample(eval_state *s,
+             uint64_t j)
+{
+	qg8_tensor *ket, *par, *res;
+	double v[2], vi[2];
+	uint64_t o[2], k;
+	uint16_t type;
+
+	if (_num_operands(s, j) != 2)
+	{
+		DIE("Cannot evaluate a sample without two operands.\n");
+	}
+	o[0] = *(s->dag->opsrc+*(s->dag->opptr+j));
+	o[1] = *(s->dag->opsrc+*(s->dag->opptr+j)+1);
+	type = (*(s->dag->nodes+o[1]))->type;
+	k = type == QG8_TYPE_CONSTANT || type == QG8_TYPE_INPUT ? 1 : 0;
+	par = _eval_node(s, o[k]);
+	ket = _eval_node(s, o[1-k]);
+	if (par->num_elems < 1 || par->num_elems > 2)
+	{
+		DIE("Sample parameters must hold the shots and an optional seed.\n");
+	}
+	v[1] = 0.0;
+	_tensor_to_double(par, v, vi);
+	if (v[0] < 0.0 || v[1] < 0.0)
+	{
+		DIE("Sample parameters must not be negative.\n");
+	}
+	res = qg8_tensor_sample(ket, (uint64_t) v[0], (uint64_t) v[1]);
+	_release(s, o[0]);
+	_release(s, o[1]);
+	return res;
+}
+
+static
+qg8_tensor *
+_eval_node(eval_state *s,
+           uint64_t j)
+{
+	qg8_chunk *chunk;
+	qg8_tensor *res;
+
+	if (*(s->state+j) == STATE_DONE)
+	{
+		if (!*(s->values+j))
+		{
+			DIE("Chunk value was released before all consumers read it.\n");
+		}
+		return *(s->values+j);
+	}
+	if (*(s->state+j) == STATE_ACTIVE)
+	{
+		DIE("Cannot evaluate a graph with cycles.\n");
+	}
+	*(s->state+j) = STATE_ACTIVE;
+	chunk = *(s->dag->nodes+j);
+	switch (chunk->type)
+	{
+	case QG8_TYPE_ADJACENCY:
+	case QG8_TYPE_INPUT:
+	case QG8_TYPE_CONSTANT:
+	case QG8_TYPE_KET:
+	case QG8_TYPE_OPERATOR:
+	case QG8_TYPE_OBSERVABLE:
+	case QG8_TYPE_TIME:
+	case QG8_TYPE_TRACK:
+	case QG8_TYPE_NOISESPEC:
+	case QG8_TYPE_PERMUTATION:
+		res = s->bound && *(s->bound+j) ? *(s->bound+j) : chunk->tensor;
+		if (!res)
+		{
+			DIE("Cannot evaluate a data chunk without a tensor.\n");
+		}
+		*(s->owned+j) = 0;
+		break;
+	case QG8_TYPE_MATMUL:
+	case QG8_TYPE_JOIN:
+		res = _eval_chain(s, j);
+		*(s->owned+j) = 1;
+		break;
+	case QG8_TYPE_EXPECTATIONVALUE:
+		res = _eval_expectation(s, j);
+		*(s->owned+j) = 1;
+		break;
+	case QG8_TYPE_SAMPLE:
+		res = _eval_sample(s, j);
+		*(s->owned+j) = 1;
+		break;
+	case QG8_TYPE_SOLVE:
+		res = _eval_solve(s, j);
+		*(s->owned+j) = 1;
+		break;
+	default:
+		fprintf(stderr, "Cannot evaluate chunk of type %d.\n", chunk->type);
+		exit(EXIT_FAILURE);
+	}
+	*(s->values+j) = res;
+	*(s->state+j) = STATE_DONE;
+	return res;
+}
+
+static
+void
+_eval_init(eval_state *s,
+           qg8_graph *graph,
+           qg8_chunk *chunk)
+{
+	s->dag = _dag_build(graph);
+	s->target = _dag_find(s->dag, chunk);
+	s->max_fused = graph->max_fused;
+	s->values = (qg8_tensor **) calloc(s->dag->num_nodes,
+	                                   sizeof(qg8_tensor *));
+	ALLOC(s->values);
+	s->owned = (uint8_t *) calloc(s->dag->num_nodes, sizeof(uint8_t));
+	ALLOC(s->owned);
+	s->state = (uint8_t *) calloc(s->dag->num_nodes, sizeof(uint8_t));
+	ALLOC(s->state);
+	s->pending = (uint64_t *) malloc(sizeof(uint64_t) * s->dag->num_nodes);
+	ALLOC(s->pending);
+	memcpy(s->pending, s->dag->consumers,
+	       sizeof(uint64_t) * s->dag->num_nodes);
+	s->keep = NULL;
+	s->bound = NULL;
+}
+
+/* evaluates the target and hands its value over to the caller */
+static
+qg8_tensor *
+_eval_target(eval_state *s)
+{
+	qg8_tensor *res;
+
+	res = _eval_node(s, s->target);
+	if (!*(s->owned+s->target) || (s->keep && *(s->keep+s->target)))
+		return _tensor_copy(res);
+	*(s->values+s->target) = NULL;
+	return res;
+}
+
+static
+void
+_eval_free(eval_state *s)
+{
+	uint64_t i;
+
+	for (i = 0; i < s->dag->num_nodes; ++i)
+	{
+		if (*(s->owned+i) && *(s->values+i))
+			qg8_tensor_destroy(*(s->values+i));
+	}
+	free(s->values);
+	free(s->owned);
+	free(s->state);
+	free(s->pending);
+	if (s->keep)
+		free(s->keep);
+	if (s->bound)
+		free(s->bound);
+	_dag_destroy(s->dag);
+}
+
+/*
+ * Computes the value of a chunk from the operands given by the adjacency
+ * chunk of the graph. Product chains of MATMUL and JOIN chunks are planned
+ * as a whole before being executed, except for circuits of small gates
+ * applied to a ket, see qg8_graph_set_max_fused. Expectation values are
+ * computed without applying the observable to the ket, samples are
+ * histograms, see qg8_tensor_sample, and solves evolve a ket in time, see
+ * qg8_tensor_evolve. The returned tensor belongs to the
+ * caller.
+ */
+qg8_tensor *
+qg8_graph_evaluate(qg8_graph *graph,
+                   qg8_chunk *chunk)
+{
+	eval_state s;
+	qg8_tensor *res;
+
+	if (!graph)
+	{
+		DIE("Cannot evaluate a NULL graph.\n");
+	}
+	if (!chunk)
+	{
+		DIE("Cannot evaluate a NULL chunk.\n");
+	}
+	_eval_init(&s, graph, chunk);
+	res = _eval_target(&s);
+	_eval_free(&s);
+	return res;
+}
+
+/*
+ * Marks node j as depending on a batched input (3) or not (2). Inputs are
+ * marked beforehand; a node being visited (1) belongs to a cycle, which
+ * the evaluation reports.
+ */
+static
+int
+_batch_varies(eval_state *s,
+              uint64_t j,
+              uint8_t *mark)
+{
+	uint64_t p;
+	int v;
+
+	if (*(mark+j) == 1)
+		return 0;
+	if (*(mark+j) >= 2)
+		return *(mark+j) == 3;
+	*(mark+j) = 1;
+	v = 0;
+	for (p = *(s->dag->opptr+j); p < *(s->dag->opptr+j+1); ++p)
+		v |= _batch_varies(s, *(s->dag->opsrc+p), mark);
+	*(mark+j) = v ? 3 : 2;
+	return v;
+}
+
+/* ket k of a block of b kets of n amplitudes, see _csr_spmm */
+static
+qg8_tensor *
+_block_ket(const double *re,
+           const double *im,
+           uint64_t n,
+           uint64_t b,
+           uint64_t k,
+           uint16_t rank)
+{
+	qg8_tensor *t;
+	uint64_t shape[2], i;
+
+	shape[0] = n;
+	shape[1] = 1;
+	t = _tensor_new(QG8_PACKING_FULL, rank, shape, n, 1);
+	_tensor_fill_full_indices(t);
+	for (i = 0; i < n; ++i)
+	{
+		*((double *) t->redata+i) = *(re+i*b+k);
+		*((double *) t->imdata+i) = *(im+i*b+k);
+	}
+	return t;
+}
+
+/*
+ * Block form of a batch whose one input takes kets: a product chain of
+ * constant operators applied to the input, or the expectation value of a
+ * constant observable in such a chain. The kets are stacked side by side
+ * and every operator multiplies the whole block in one pass over its
+ * entries, see qg8_tensor_spmm. Returns 0, having computed nothing, for
+ * any other shape of batch.
+ */
+static
+int
+_batch_block(eval_state *s,
+             uint64_t in,
+             qg8_tensor **batch,
+             uint64_t b,
+             qg8_tensor **res)
+{
+	qg8_chunk *target;
+	qg8_tensor *t, *obs;
+	double *xr, *xi, *yr, *yi, *cr, *ci, *sw;
+	uint64_t *list, len, cap, ket, n, m, i, k;
+	uint16_t rank;
+
+	for (k = 0; k < b; ++k)
+	{
+		t = *(batch+k);
+		if (t->rank < 1 || t->rank > 2 ||
+		    (t->rank == 2 && *(t->dimensions+1) != 1) ||
+		    *(t->dimensions) != *((*batch)->dimensions))
+			return 0;
+	}
+	target = *(s->dag->nodes+s->target);
+	obs = NULL;
+	ket = s->target;
+	if (target->type == QG8_TYPE_EXPECTATIONVALUE &&
+	    _num_operands(s, s->target) == 2)
+	{
+		/* the observable is the operand computed before the runs */
+		ket = *(s->dag->opsrc+*(s->dag->opptr+s->target));
+		i = *(s->dag->opsrc+*(s->dag->opptr+s->target)+1);
+		if (*(s->keep+ket))
+		{
+			i = ket;
+			ket = *(s->dag->opsrc+*(s->dag->opptr+s->target)+1);
+		}
+		obs = *(s->keep+i) ? *(s->values+i) : NULL;
+		if (!obs || *(s->keep+ket) || obs->rank != 2 ||
+		    *(obs->dimensions+1) == 1)
+			return 0;
+	}
+	else if (target->type != QG8_TYPE_MATMUL)
+		return 0;
+
+	/* the operators, kept from before the runs, then the input */
+	cap = 8;
+	len = 0;
+	list = (uint64_t *) malloc(sizeof(uint64_t) * cap);
+	ALLOC(list);
+	if (ket == in)
+		*(list+len++) = in;
+	else if ((*(s->dag->nodes+ket))->type == QG8_TYPE_MATMUL)
+		_gather_chain(s, ket, QG8_TYPE_MATMUL, &list, &len, &cap);
+	for (i = 0; i + 1 < len; ++i)
+		if (!*(s->keep+*(list+i)) || !*(s->values+*(list+i)) ||
+		    (*(s->values+*(list+i)))->rank != 2)
+			break;
+	if (len == 0 || i + 1 < len || *(list+len-1) != in)
+	{
+		free(list);
+		return 0;
+	}
+
+	rank = (*batch)->rank;
+	n = *((*batch)->dimensions);
+	xr = (double *) malloc(sizeof(double) * MAX(n * b, 1));
+	ALLOC(xr);
+	xi = (double *) malloc(sizeof(double) * MAX(n * b, 1));
+	ALLOC(xi);
+	cr = (double *) malloc(sizeof(double) * MAX(n, 1));
+	ALLOC(cr);
+	ci = (double *) malloc(sizeof(double) * MAX(n, 1));
+	ALLOC(ci);
+	for (k = 0; k < b; ++k)
+	{
+		_tensor_to_dense(*(batch+k), cr, ci);
+		for (i = 0; i < n; ++i)
+		{
+			*(xr+i*b+k) = *(cr+i);
+			*(xi+i*b+k) = *(ci+i);
+		}
+	}
+	free(cr);
+	free(ci);
+	for (i = len - 1; i-- > 0;)
+	{
+		t = *(s->values+*(list+i));
+		if (*(t->dimensions+1) != n)
+		{
+			DIE("Cannot apply an operator to a ket of mismatched shape.\n");
+		}
+		m = *(t->dimensions);
+		yr = (double *) malloc(sizeof(double) * MAX(m * b, 1));
+		ALLOC(yr);
+		yi = (double *) malloc(sizeof(double) * MAX(m * b, 1));
+		ALLOC(yi);
+		qg8_tensor_spmm(t, b, xr, xi, yr, yi);
+		sw = xr;
+		xr = yr;
+		free(sw);
+		sw = xi;
+		xi = yi;
+		free(sw);
+		n = m;
+	}
+	for (k = 0; k < b; ++k)
+	{
+		*(res+k) = _block_ket(xr, xi, n, b, k, rank);
+		if (!obs)
+			continue;
+		t = *(res+k);
+		*(res+k) = qg8_tensor_expectation_value(obs, t);
+		qg8_tensor_destroy(t);
+	}
+	free(xr);
+	free(xi);
+	free(list);
+	return 1;
+}
+
+/*
+ * Evaluates chunk once for every set of values of the INPUT chunks in
+ * inputs: run k reads batch[k * num_inputs + i] for inputs[i], the chunks
+ * themselves are left as they are. Returns an array of batch_size tensors
+ * which, like the array, belong to the caller.
+ *
+ * The chunks which do not depend on the inputs and feed a chunk which does
+ * are computed once, before the first run, and kept with any cached form
+ * the kernels build for them; every run then only computes the chunks
+ * between the inputs and the target. Kronecker products feeding a
+ * circuit are left to the circuit pass of each run, which applies them
+ * without expanding them. A batch of kets given to one input and applied
+ * to constant operators, followed or not by an expectation value, is not
+ * run ket by ket: the kets are multiplied as one block, see _batch_block.
+ */
+qg8_tensor **
+qg8_graph_evaluate_batch(qg8_graph *graph,
+                         qg8_chunk *chunk,
+                         qg8_chunk **inputs,
+                         uint64_t num_inputs,
+                         qg8_tensor **batch,
+                         uint64_t batch_size)
+{
+	eval_state s;
+	qg8_tensor **res;
+	qg8_chunk *c;
+	uint8_t *mark;
+	uint64_t i, j, k, p, o;
+
+	if (!graph)
+	{
+		DIE("Cannot evaluate a NULL graph.\n");
+	}
+	if (!chunk)
+	{
+		DIE("Cannot evaluate a NULL chunk.\n");
+	}
+	if ((num_inputs && (!inputs || !batch)) || batch_size == 0)
+	{
+		DIE("Cannot evaluate an empty batch.\n");
+	}
+	_eval_init(&s, graph, chunk);
+	s.bound = (qg8_tensor **) calloc(s.dag->num_nodes, sizeof(qg8_tensor *));
+	ALLOC(s.bound);
+	mark = (uint8_t *) calloc(s.dag->num_nodes, sizeof(uint8_t));
+	ALLOC(mark);
+	for (i = 0; i < num_inputs; ++i)
+	{
+		if ((*(inputs+i))->type != QG8_TYPE_INPUT)
+		{
+			DIE("Batched values are given to INPUT chunks only.\n");
+		}
+		*(mark+_dag_find(s.dag, *(inputs+i))) = 3;
+	}
+	for (k = 0; k < batch_size * num_inputs; ++k)
+	{
+		if (!*(batch+k))
+		{
+			DIE("Cannot evaluate a batch with a NULL input.\n");
+		}
+	}
+
+	/* constant operands of varying chunks are hoisted out of the runs */
+	_batch_varies(&s, s.target, mark);
+	s.keep = (uint8_t *) calloc(s.dag->num_nodes, sizeof(uint8_t));
+	ALLOC(s.keep);
+	*(s.keep+s.target) = *(mark+s.target) == 2;
+	for (j = 0; j < s.dag->num_nodes; ++j)
+	{
+		if (*(mark+j) != 3)
+			continue;
+		c = *(s.dag->nodes+j);
+		for (p = *(s.dag->opptr+j); p < *(s.dag->opptr+j+1); ++p)
+		{
+			o = *(s.dag->opsrc+p);
+			if (*(mark+o) == 2 &&
+			    !(s.max_fused && c->type == QG8_TYPE_MATMUL &&
+			      (*(s.dag->nodes+o))->type == QG8_TYPE_JOIN))
+				*(s.keep+o) = 1;
+		}
+	}
+	for (j = 0; j < s.dag->num_nodes; ++j)
+		if (*(s.keep+j))
+			_eval_node(&s, j);
+
+	res = (qg8_tensor **) malloc(sizeof(qg8_tensor *) * batch_size);
+	ALLOC(res);
+	if (num_inputs == 1 && *(mark+s.target) == 3 &&
+	    _batch_block(&s, _dag_find(s.dag, *inputs), batch, batch_size, res))
+		batch_size = 0;
+	for (k = 0; k < batch_size; ++k)
+	{
+		for (j = 0; j < s.dag->num_nodes; ++j)
+		{
+			if (*(s.keep+j))
+				continue;
+			if (*(s.owned+j) && *(s.values+j))
+				qg8_tensor_destroy(*(s.values+j));
+			*(s.values+j) = NULL;
+			*(s.owned+j) = 0;
+			*(s.state+j) = STATE_NEW;
+			*(s.pending+j) = *(s.dag->consumers+j);
+		}
+		for (i = 0; i < num_inputs; ++i)
+			*(s.bound+_dag_find(s.dag, *(inputs+i))) =
+				*(batch+k*num_inputs+i);
+		*(res+k) = _eval_target(&s);
+	}
+
+	free(mark);
+	_eval_free(&s);
+	return res;
+}
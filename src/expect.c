@@ -0,0 +1,282 @@
+/*
+ * expect.c
+ * QG8 base library expectation value source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * <x|O|x> is summed straight from the stored entries of O:
+ *   sum_e conj(x[r_e]) O_e x[c_e]
+ * so O|x> is never formed. The entries are cut into blocks of a fixed size
+ * and each block gets its own partial sum; the partial sums are added in
+ * block order, so the result does not depend on the number of threads.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* stored entries, or dense elements, per partial sum */
+#define EXPV_BLOCK 8192
+
+/* adds conj(xr + i xi) (vr + i vi) (yr + i yi) to s */
+#define EXPV_TERM(s, vr, vi, xr, xi, yr, yi) \
+do { \
+	double _wr, _wi; \
+	_wr = (vr) * (yr) - (vi) * (yi); \
+	_wi = (vr) * (yi) + (vi) * (yr); \
+	*(s) += (xr) * _wr + (xi) * _wi; \
+	*((s)+1) += (xr) * _wi - (xi) * _wr; \
+} while (0)
+
+/* entries b..e-1 of a sparse operator */
+static
+void
+_expv_entries(qg8_tensor *o,
+              const double *vr,
+              const double *vi,
+              const double *xr,
+              const double *xi,
+              uint64_t b,
+              uint64_t e,
+              double *s)
+{
+	const uint64_t *ri, *ci;
+	double t[2], im;
+	uint64_t p, r, c;
+	int hh;
+
+	ri = *(o->indices);
+	ci = *(o->indices+1);
+	hh = o->packing == QG8_PACKING_HALF_HERMITIAN;
+	*s = 0.0;
+	*(s+1) = 0.0;
+	for (p = b; p < e; ++p)
+	{
+		r = *(ri+p);
+		c = *(ci+p);
+		im = vi ? *(vi+p) : 0.0;
+		if (hh && r != c)
+		{
+			/* the mirrored entry adds the conjugate term */
+			t[0] = 0.0;
+			t[1] = 0.0;
+			EXPV_TERM(t, *(vr+p), im, *(xr+r), *(xi+r), *(xr+c), *(xi+c));
+			*s += 2.0 * t[0];
+			continue;
+		}
+		EXPV_TERM(s, *(vr+p), im, *(xr+r), *(xi+r), *(xr+c), *(xi+c));
+	}
+}
+
+/* rows b..e-1 of a complete full operator with n columns */
+static
+void
+_expv_rows(const double *vr,
+           const double *vi,
+           const double *xr,
+           const double *xi,
+           uint64_t n,
+           uint64_t b,
+           uint64_t e,
+           double *s)
+{
+	const double *ar, *ai;
+	double wr, wi;
+	uint64_t r, c;
+
+	*s = 0.0;
+	*(s+1) = 0.0;
+	for (r = b; r < e; ++r)
+	{
+		ar = vr + r * n;
+		wr = 0.0;
+		wi = 0.0;
+		if (vi)
+		{
+			ai = vi + r * n;
+			for (c = 0; c < n; ++c)
+			{
+				wr += *(ar+c) * *(xr+c) - *(ai+c) * *(xi+c);
+				wi += *(ar+c) * *(xi+c) + *(ai+c) * *(xr+c);
+			}
+		}
+		else
+		{
+			for (c = 0; c < n; ++c)
+			{
+				wr += *(ar+c) * *(xr+c);
+				wi += *(ar+c) * *(xi+c);
+			}
+		}
+		*s += *(xr+r) * wr + *(xi+r) * wi;
+		*(s+1) += *(xr+r) * wi - *(xi+r) * wr;
+	}
+}
+
+/* sum over the stored entries of a sparse, half-Hermitian or full operator */
+static
+void
+_expv_operator(qg8_tensor *obs,
+               const double *xr,
+               const double *xi,
+               double *re,
+               double *im)
+{
+	double *vr, *vi, *part;
+	uint64_t n, len, span, nb, b;
+	int dense, own_v;
+
+	n = *(obs->dimensions);
+	own_v = obs->dtype_id != QG8_DTYPE_FLOAT64 &&
+	        obs->dtype_id != QG8_DTYPE_COMPLEX128;
+	if (own_v)
+	{
+		vr = (double *) malloc(sizeof(double) * MAX(obs->num_elems, 1));
+		ALLOC(vr);
+		vi = (double *) malloc(sizeof(double) * MAX(obs->num_elems, 1));
+		ALLOC(vi);
+		_tensor_to_double(obs, vr, vi);
+	}
+	else
+	{
+		vr = (double *) obs->redata;
+		vi = obs->dtype_id == QG8_DTYPE_COMPLEX128 ?
+		     (double *) obs->imdata : NULL;
+	}
+
+	/* complete full operators are walked by rows, without their indices */
+	dense = obs->packing == QG8_PACKING_FULL && obs->num_elems == n * n;
+	len = dense ? n : obs->num_elems;
+	span = dense ? MAX(EXPV_BLOCK / MAX(n, 1), 1) : EXPV_BLOCK;
+	nb = (len + span - 1) / span;
+	part = (double *) malloc(sizeof(double) * 2 * MAX(nb, 1));
+	ALLOC(part);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) if(nb > 1)
+#endif /* _OPENMP */
+	for (b = 0; b < nb; ++b)
+	{
+		if (dense)
+			_expv_rows(vr, vi, xr, xi, n, b * span,
+			           MIN((b + 1) * span, len), part + 2 * b);
+		else
+			_expv_entries(obs, vr, vi, xr, xi, b * span,
+			              MIN((b + 1) * span, len), part + 2 * b);
+	}
+	*re = 0.0;
+	*im = 0.0;
+	for (b = 0; b < nb; ++b)
+	{
+		*re += *(part+2*b);
+		*im += *(part+2*b+1);
+	}
+
+	free(part);
+	if (own_v)
+	{
+		free(vr);
+		free(vi);
+	}
+}
+
+/*
+ * Computes <ket|obs|ket> for a square rank 2 observable in any packing
+ * and a ket (rank 1, or rank 2 with one column). The operator is read once
+ * and no intermediate vector is allocated; DIA and BSR observables are
+ * expanded to their entries first.
+ */
+int
+qg8_tensor_expectation(qg8_tensor *obs,
+                       qg8_tensor *ket,
+                       double *re,
+                       double *im)
+{
+	qg8_tensor *coo;
+	double *xr, *xi;
+	uint64_t n;
+	int own_x;
+
+	if (!obs || !ket || !re || !im)
+	{
+		DIE("Cannot compute an expectation value of NULL tensors.\n");
+	}
+	if (obs->rank != 2 || ket->rank > 2 ||
+	    *(obs->dimensions) != *(obs->dimensions+1) ||
+	    (ket->rank == 2 && *(ket->dimensions+1) != 1) ||
+	    *(ket->dimensions) != *(obs->dimensions))
+	{
+		DIE("Cannot compute an expectation value of mismatched shapes.\n");
+	}
+	n = *(obs->dimensions);
+	own_x = ket->dtype_id != QG8_DTYPE_COMPLEX128 ||
+	        ket->packing != QG8_PACKING_FULL || ket->num_elems != n;
+	if (own_x)
+	{
+		xr = (double *) malloc(sizeof(double) * MAX(n, 1));
+		ALLOC(xr);
+		xi = (double *) malloc(sizeof(double) * MAX(n, 1));
+		ALLOC(xi);
+		_tensor_to_dense(ket, xr, xi);
+	}
+	else
+	{
+		xr = (double *) ket->redata;
+		xi = (double *) ket->imdata;
+	}
+
+	if (obs->packing == QG8_PACKING_PAULI)
+		_pauli_expectation(obs, xr, xi, re, im);
+	else if (_tensor_is_packed(obs))
+	{
+		coo = _tensor_expand(obs);
+		_expv_operator(coo, xr, xi, re, im);
+		qg8_tensor_destroy(coo);
+	}
+	else
+		_expv_operator(obs, xr, xi, re, im);
+
+	if (own_x)
+	{
+		free(xr);
+		free(xi);
+	}
+	return 1;
+}
+
+/*
+ * Returns <ket|obs|ket> as a full COMPLEX128 tensor holding one element.
+ */
+qg8_tensor *
+qg8_tensor_expectation_value(qg8_tensor *obs,
+                             qg8_tensor *ket)
+{
+	qg8_tensor *out;
+	uint64_t shape[1];
+
+	shape[0] = 1;
+	out = _tensor_new(QG8_PACKING_FULL, 1, shape, 1, 1);
+	_tensor_fill_full_indices(out);
+	qg8_tensor_expectation(obs, ket, (double *) out->redata,
+	                       (double *) out->imdata);
+	return out;
+}
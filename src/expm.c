@@ -0,0 +1,621 @@
+/*
+ * expm.c
+ * QG8 base library Krylov time evolution source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * exp(-iHt)|x> is computed without forming the exponential, following the
+ * time stepping of Sidje's Expokit. Each step builds an Arnoldi basis V of
+ * the Krylov space of A = -iH from the current state w, so that
+ *   exp(tA) w ~ beta V exp(t Hm) e1
+ * with Hm the small Hessenberg matrix of the projection. The exponential
+ * of Hm comes from a Pade approximant with scaling and squaring. Two more
+ * rows of the augmented matrix give the local error; the step grows or
+ * shrinks so that the error stays below tol per unit time.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* dimension of the Krylov spaces */
+#define KRYLOV_DIM    30
+/* rejected steps before giving up */
+#define KRYLOV_REJECT 10
+/* vectors shorter than this are handled by one thread */
+#define KRYLOV_PAR    16384
+/* degree of the Pade approximant */
+#define PADE_DEGREE   6
+
+/* sum conj(a) b */
+void
+_vdot(uint64_t n,
+      const double *ar,
+      const double *ai,
+      const double *br,
+      const double *bi,
+      double *re,
+      double *im)
+{
+	double sr, si;
+	uint64_t i;
+
+	sr = 0.0;
+	si = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:sr,si) if(n > KRYLOV_PAR)
+#endif /* _OPENMP */
+	for (i = 0; i < n; ++i)
+	{
+		sr += *(ar+i) * *(br+i) + *(ai+i) * *(bi+i);
+		si += *(ar+i) * *(bi+i) - *(ai+i) * *(br+i);
+	}
+	*re = sr;
+	*im = si;
+}
+
+double
+_vnorm(uint64_t n,
+       const double *re,
+       const double *im)
+{
+	double s, t;
+
+	_vdot(n, re, im, re, im, &s, &t);
+	return sqrt(s);
+}
+
+/* y += (ar + i ai) x */
+void
+_vaxpy(uint64_t n,
+       double ar,
+       double ai,
+       const double *xr,
+       const double *xi,
+       double *yr,
+       double *yi)
+{
+	uint64_t i;
+
+#ifdef _OPENMP
+#pragma omp parallel for if(n > KRYLOV_PAR)
+#endif /* _OPENMP */
+	for (i = 0; i < n; ++i)
+	{
+		*(yr+i) += ar * *(xr+i) - ai * *(xi+i);
+		*(yi+i) += ar * *(xi+i) + ai * *(xr+i);
+	}
+}
+
+void
+_vscale(uint64_t n,
+        double a,
+        const double *xr,
+        const double *xi,
+        double *yr,
+        double *yi)
+{
+	uint64_t i;
+
+#ifdef _OPENMP
+#pragma omp parallel for if(n > KRYLOV_PAR)
+#endif /* _OPENMP */
+	for (i = 0; i < n; ++i)
+	{
+		*(yr+i) = a * *(xr+i);
+		*(yi+i) = a * *(xi+i);
+	}
+}
+
+/* y = sgn * -i op x */
+static
+void
+_matvec(qg8_tensor *op,
+        double sgn,
+        uint64_t n,
+        const double *xr,
+        const double *xi,
+        double *yr,
+        double *yi)
+{
+	double t;
+	uint64_t i;
+
+	qg8_tensor_spmv(op, xr, xi, yr, yi);
+	for (i = 0; i < n; ++i)
+	{
+		t = *(yr+i);
+		*(yr+i) = sgn * *(yi+i);
+		*(yi+i) = -sgn * t;
+	}
+}
+
+/* c = a b for n*n row-major split complex matrices, c apart from a and b */
+static
+void
+_zmul(uint64_t n,
+      const double *ar,
+      const double *ai,
+      const double *br,
+      const double *bi,
+      double *cr,
+      double *ci)
+{
+	uint64_t i, j, k;
+	double xr, xi;
+
+	memset(cr, 0, sizeof(double) * n * n);
+	memset(ci, 0, sizeof(double) * n * n);
+	for (i = 0; i < n; ++i)
+	{
+		for (k = 0; k < n; ++k)
+		{
+			xr = *(ar+i*n+k);
+			xi = *(ai+i*n+k);
+			if (xr == 0.0 && xi == 0.0)
+				continue;
+			for (j = 0; j < n; ++j)
+			{
+				*(cr+i*n+j) += xr * *(br+k*n+j) - xi * *(bi+k*n+j);
+				*(ci+i*n+j) += xr * *(bi+k*n+j) + xi * *(br+k*n+j);
+			}
+		}
+	}
+}
+
+/* solves d x = b in place of b by Gaussian elimination with pivoting */
+static
+void
+_zsolve(uint64_t n,
+        double *dr,
+        double *di,
+        double *br,
+        double *bi)
+{
+	uint64_t i, j, k, p;
+	double best, mag, t, pr, pi, qr, qi, fr, fi;
+
+	for (k = 0; k < n; ++k)
+	{
+		p = k;
+		best = -1.0;
+		for (i = k; i < n; ++i)
+		{
+			mag = fabs(*(dr+i*n+k)) + fabs(*(di+i*n+k));
+			if (mag > best)
+			{
+				best = mag;
+				p = i;
+			}
+		}
+		if (best == 0.0)
+		{
+			DIE("Singular Pade denominator.\n");
+		}
+		if (p != k)
+		{
+			for (j = 0; j < n; ++j)
+			{
+				t = *(dr+k*n+j); *(dr+k*n+j) = *(dr+p*n+j); *(dr+p*n+j) = t;
+				t = *(di+k*n+j); *(di+k*n+j) = *(di+p*n+j); *(di+p*n+j) = t;
+				t = *(br+k*n+j); *(br+k*n+j) = *(br+p*n+j); *(br+p*n+j) = t;
+				t = *(bi+k*n+j); *(bi+k*n+j) = *(bi+p*n+j); *(bi+p*n+j) = t;
+			}
+		}
+		/* 1 / pivot */
+		mag = *(dr+k*n+k) * *(dr+k*n+k) + *(di+k*n+k) * *(di+k*n+k);
+		pr = *(dr+k*n+k) / mag;
+		pi = -*(di+k*n+k) / mag;
+		for (i = k + 1; i < n; ++i)
+		{
+			qr = *(dr+i*n+k);
+			qi = *(di+i*n+k);
+			fr = qr * pr - qi * pi;
+			fi = qr * pi + qi * pr;
+			for (j = k; j < n; ++j)
+			{
+				*(dr+i*n+j) -= fr * *(dr+k*n+j) - fi * *(di+k*n+j);
+				*(di+i*n+j) -= fr * *(di+k*n+j) + fi * *(dr+k*n+j);
+			}
+			for (j = 0; j < n; ++j)
+			{
+				*(br+i*n+j) -= fr * *(br+k*n+j) - fi * *(bi+k*n+j);
+				*(bi+i*n+j) -= fr * *(bi+k*n+j) + fi * *(br+k*n+j);
+			}
+		}
+	}
+	for (k = n; k-- > 0;)
+	{
+		mag = *(dr+k*n+k) * *(dr+k*n+k) + *(di+k*n+k) * *(di+k*n+k);
+		pr = *(dr+k*n+k) / mag;
+		pi = -*(di+k*n+k) / mag;
+		for (j = 0; j < n; ++j)
+		{
+			qr = *(br+k*n+j);
+			qi = *(bi+k*n+j);
+			for (i = k + 1; i < n; ++i)
+			{
+				qr -= *(dr+k*n+i) * *(br+i*n+j) - *(di+k*n+i) * *(bi+i*n+j);
+				qi -= *(dr+k*n+i) * *(bi+i*n+j) + *(di+k*n+i) * *(br+i*n+j);
+			}
+			*(br+k*n+j) = qr * pr - qi * pi;
+			*(bi+k*n+j) = qr * pi + qi * pr;
+		}
+	}
+}
+
+/*
+ * f = exp(a) for a small n*n matrix: the diagonal Pade approximant of
+ * PADE_DEGREE after scaling a below norm 1/2, then squared back.
+ */
+static
+void
+_zexpm(uint64_t n,
+       const double *ar,
+       const double *ai,
+       double *fr,
+       double *fi)
+{
+	double *sr, *si, *pr, *pi, *tr, *ti, *dr, *di, c, norm, row, scale;
+	uint64_t i, j, k, nn;
+	int sq, q;
+
+	nn = n * n;
+	sr = (double *) malloc(sizeof(double) * nn * 8);
+	ALLOC(sr);
+	si = sr + nn;
+	pr = si + nn;
+	pi = pr + nn;
+	tr = pi + nn;
+	ti = tr + nn;
+	dr = ti + nn;
+	di = dr + nn;
+
+	norm = 0.0;
+	for (i = 0; i < n; ++i)
+	{
+		row = 0.0;
+		for (j = 0; j < n; ++j)
+			row += fabs(*(ar+i*n+j)) + fabs(*(ai+i*n+j));
+		norm = MAX(norm, row);
+	}
+	sq = 0;
+	if (norm > 0.5)
+		sq = (int) ceil(log(norm / 0.5) / log(2.0));
+	scale = ldexp(1.0, -sq);
+	for (k = 0; k < nn; ++k)
+	{
+		*(sr+k) = *(ar+k) * scale;
+		*(si+k) = *(ai+k) * scale;
+	}
+
+	/* numerator in f, denominator in d, powers of s in p */
+	memset(fr, 0, sizeof(double) * nn);
+	memset(fi, 0, sizeof(double) * nn);
+	memset(dr, 0, sizeof(double) * nn);
+	memset(di, 0, sizeof(double) * nn);
+	for (i = 0; i < n; ++i)
+	{
+		*(fr+i*n+i) = 1.0;
+		*(dr+i*n+i) = 1.0;
+	}
+	memcpy(pr, sr, sizeof(double) * nn);
+	memcpy(pi, si, sizeof(double) * nn);
+	c = 1.0;
+	for (q = 1; q <= PADE_DEGREE; ++q)
+	{
+		c *= (double) (PADE_DEGREE - q + 1) /
+		     (double) (q * (2 * PADE_DEGREE - q + 1));
+		for (k = 0; k < nn; ++k)
+		{
+			*(fr+k) += c * *(pr+k);
+			*(fi+k) += c * *(pi+k);
+			*(dr+k) += (q % 2 ? -c : c) * *(pr+k);
+			*(di+k) += (q % 2 ? -c : c) * *(pi+k);
+		}
+		if (q == PADE_DEGREE)
+			break;
+		_zmul(n, pr, pi, sr, si, tr, ti);
+		memcpy(pr, tr, sizeof(double) * nn);
+		memcpy(pi, ti, sizeof(double) * nn);
+	}
+	_zsolve(n, dr, di, fr, fi);
+	for (; sq > 0; --sq)
+	{
+		_zmul(n, fr, fi, fr, fi, tr, ti);
+		memcpy(fr, tr, sizeof(double) * nn);
+		memcpy(fi, ti, sizeof(double) * nn);
+	}
+	free(sr);
+}
+
+/* infinity norm of an operator, from its row compressed form */
+static
+double
+_op_norm(qg8_tensor *op)
+{
+	qg8_csr *m;
+	double norm, row, *cr, *ci;
+	uint64_t r, p, e;
+
+	norm = 0.0;
+	if (op->packing == QG8_PACKING_PAULI)
+	{
+		/* every string is a permutation times a phase */
+		cr = (double *) malloc(sizeof(double) * MAX(op->num_elems, 1));
+		ALLOC(cr);
+		ci = (double *) malloc(sizeof(double) * MAX(op->num_elems, 1));
+		ALLOC(ci);
+		_tensor_to_double(op, cr, ci);
+		for (e = 0; e < op->num_elems; ++e)
+			norm += sqrt(*(cr+e) * *(cr+e) + *(ci+e) * *(ci+e));
+		free(cr);
+		free(ci);
+		return norm;
+	}
+	qg8_tensor_csr_build(op);
+	m = op->csr;
+	for (r = 0; r < m->rows; ++r)
+	{
+		row = 0.0;
+		for (p = *(m->rowptr+r); p < *(m->rowptr+r+1); ++p)
+			row += m->im ? sqrt(*(m->re+p) * *(m->re+p) +
+			                    *(m->im+p) * *(m->im+p)) : fabs(*(m->re+p));
+		norm = MAX(norm, row);
+	}
+	return norm;
+}
+
+/* two significant digits, rounded up */
+static
+double
+_round_step(double t)
+{
+	double s;
+
+	s = pow(10.0, floor(log10(t)) - 1.0);
+	return ceil(t / s) * s;
+}
+
+/*
+ * w = exp(-i op dt) w in place, with local errors below tol per unit of
+ * time. v holds KRYLOV_DIM + 2 vectors of n elements.
+ */
+static
+void
+_krylov(qg8_tensor *op,
+        uint64_t n,
+        double anorm,
+        double dt,
+        double tol,
+        double *wr,
+        double *wi,
+        double *vr,
+        double *vi)
+{
+	double hr[(KRYLOV_DIM+2)*(KRYLOV_DIM+2)], hi[(KRYLOV_DIM+2)*(KRYLOV_DIM+2)];
+	double ar[(KRYLOV_DIM+2)*(KRYLOV_DIM+2)], ai[(KRYLOV_DIM+2)*(KRYLOV_DIM+2)];
+	double fr[(KRYLOV_DIM+2)*(KRYLOV_DIM+2)], fi[(KRYLOV_DIM+2)*(KRYLOV_DIM+2)];
+	double sgn, tout, tnow, tnew, tstep, beta, btol, s, xm, avnorm, err, p1;
+	double p2, cr, ci;
+	uint64_t m, mb, mx, mh, i, j, k1, reject;
+
+	sgn = dt < 0.0 ? -1.0 : 1.0;
+	tout = fabs(dt);
+	m = MIN((uint64_t) KRYLOV_DIM, n);
+	beta = _vnorm(n, wr, wi);
+	if (beta == 0.0 || tout == 0.0 || anorm == 0.0)
+		return;
+	btol = 1e-12 * anorm;
+	xm = 1.0 / (double) m;
+	s = pow((double) (m + 1) / exp(1.0), (double) (m + 1)) *
+	    sqrt(2.0 * 3.14159265358979323846 * (double) (m + 1));
+	tnew = (1.0 / anorm) * pow((s * tol) / (4.0 * beta * anorm), xm);
+	tnew = _round_step(tnew);
+	tnow = 0.0;
+	err = 0.0;
+	mh = m + 2;
+
+	while (tnow < tout)
+	{
+		k1 = 2;
+		mb = m;
+		tstep = MIN(tout - tnow, tnew);
+		memset(hr, 0, sizeof(hr));
+		memset(hi, 0, sizeof(hi));
+		_vscale(n, 1.0 / beta, wr, wi, vr, vi);
+		/* Arnoldi with modified Gram-Schmidt */
+		for (j = 0; j < m; ++j)
+		{
+			_matvec(op, sgn, n, vr + j * n, vi + j * n,
+			        vr + (j + 1) * n, vi + (j + 1) * n);
+			for (i = 0; i <= j; ++i)
+			{
+				_vdot(n, vr + i * n, vi + i * n, vr + (j + 1) * n,
+				      vi + (j + 1) * n, &cr, &ci);
+				*(hr+i*mh+j) = cr;
+				*(hi+i*mh+j) = ci;
+				_vaxpy(n, -cr, -ci, vr + i * n, vi + i * n,
+				       vr + (j + 1) * n, vi + (j + 1) * n);
+			}
+			s = _vnorm(n, vr + (j + 1) * n, vi + (j + 1) * n);
+			if (s < btol)
+			{
+				/* happy breakdown: the space is invariant */
+				k1 = 0;
+				mb = j + 1;
+				tstep = tout - tnow;
+				break;
+			}
+			*(hr+(j+1)*mh+j) = s;
+			_vscale(n, 1.0 / s, vr + (j + 1) * n, vi + (j + 1) * n,
+			        vr + (j + 1) * n, vi + (j + 1) * n);
+		}
+		avnorm = 0.0;
+		if (k1 != 0)
+		{
+			*(hr+(m+1)*mh+m) = 1.0;
+			_matvec(op, sgn, n, vr + m * n, vi + m * n,
+			        vr + (m + 1) * n, vi + (m + 1) * n);
+			avnorm = _vnorm(n, vr + (m + 1) * n, vi + (m + 1) * n);
+		}
+
+		for (reject = 0;; ++reject)
+		{
+			mx = mb + k1;
+			for (i = 0; i < mx; ++i)
+			{
+				for (j = 0; j < mx; ++j)
+				{
+					*(ar+i*mx+j) = tstep * *(hr+i*mh+j);
+					*(ai+i*mx+j) = tstep * *(hi+i*mh+j);
+				}
+			}
+			_zexpm(mx, ar, ai, fr, fi);
+			if (k1 == 0)
+			{
+				err = btol;
+				break;
+			}
+			p1 = beta * sqrt(*(fr+m*mx) * *(fr+m*mx) +
+			                 *(fi+m*mx) * *(fi+m*mx));
+			p2 = beta * avnorm * sqrt(*(fr+(m+1)*mx) * *(fr+(m+1)*mx) +
+			                          *(fi+(m+1)*mx) * *(fi+(m+1)*mx));
+			if (p1 > 10.0 * p2)
+			{
+				err = p2;
+				xm = 1.0 / (double) m;
+			}
+			else if (p1 > p2)
+			{
+				err = p1 * p2 / (p1 - p2);
+				xm = 1.0 / (double) m;
+			}
+			else
+			{
+				err = p1;
+				xm = 1.0 / (double) (m - 1);
+			}
+			if (err <= 1.2 * tstep * tol)
+				break;
+			if (reject == KRYLOV_REJECT)
+			{
+				DIE("Krylov time step does not converge.\n");
+			}
+			tstep = _round_step(0.9 * tstep * pow(tstep * tol / err, xm));
+		}
+
+		/* w = beta V f e1 over the basis and, unless invariant, v_m */
+		mx = mb + (k1 > 0 ? 1 : 0);
+		memset(wr, 0, sizeof(double) * n);
+		memset(wi, 0, sizeof(double) * n);
+		for (i = 0; i < mx; ++i)
+			_vaxpy(n, beta * *(fr+i*(mb+k1)), beta * *(fi+i*(mb+k1)),
+			       vr + i * n, vi + i * n, wr, wi);
+		beta = _vnorm(n, wr, wi);
+		tnow += tstep;
+		tnew = _round_step(0.9 * tstep * pow(tstep * tol / MAX(err, 1e-300),
+		                                     xm));
+	}
+}
+
+/*
+ * Evolves a ket under a rank 2 operator to every time of the grid,
+ * computing exp(-i op t) ket with Krylov subspaces and sparse products
+ * only. Each time continues from the previous one, the first from 0.
+ * For one time the result is a ket shaped like the input, otherwise a
+ * rank 2 tensor whose row k is the state at times[k]; both are full
+ * COMPLEX128.
+ */
+qg8_tensor *
+qg8_tensor_evolve(qg8_tensor *op,
+                  qg8_tensor *ket,
+                  const double *times,
+                  uint64_t num_times,
+                  double tol)
+{
+	qg8_tensor *out;
+	double *wr, *wi, *vr, *vi, anorm, prev;
+	uint64_t n, k, shape[2];
+
+	if (!op || !ket || !times)
+	{
+		DIE("Cannot evolve NULL tensors.\n");
+	}
+	if (num_times == 0)
+	{
+		DIE("Cannot evolve without times.\n");
+	}
+	if (op->rank != 2 || ket->rank > 2 ||
+	    *(op->dimensions) != *(op->dimensions+1) ||
+	    (ket->rank == 2 && *(ket->dimensions+1) != 1) ||
+	    *(ket->dimensions) != *(op->dimensions))
+	{
+		DIE("Cannot evolve a ket of mismatched shape.\n");
+	}
+	if (tol <= 0.0)
+		tol = QG8_SOLVE_TOL;
+	n = *(op->dimensions);
+	anorm = _op_norm(op);
+
+	if (num_times == 1)
+	{
+		shape[0] = n;
+		shape[1] = 1;
+		out = _tensor_new(QG8_PACKING_FULL, ket->rank, shape, n, 1);
+	}
+	else
+	{
+		shape[0] = num_times;
+		shape[1] = n;
+		out = _tensor_new(QG8_PACKING_FULL, 2, shape, num_times * n, 1);
+	}
+	_tensor_fill_full_indices(out);
+	wr = (double *) malloc(sizeof(double) * n);
+	ALLOC(wr);
+	wi = (double *) malloc(sizeof(double) * n);
+	ALLOC(wi);
+	vr = (double *) malloc(sizeof(double) * n * (KRYLOV_DIM + 2));
+	ALLOC(vr);
+	vi = (double *) malloc(sizeof(double) * n * (KRYLOV_DIM + 2));
+	ALLOC(vi);
+	_tensor_to_dense(ket, wr, wi);
+
+	qg8_kernel_get_isa(); /* resolve the dispatch before the threads start */
+	prev = 0.0;
+	for (k = 0; k < num_times; ++k)
+	{
+		_krylov(op, n, anorm, *(times+k) - prev, tol, wr, wi, vr, vi);
+		prev = *(times+k);
+		memcpy((double *) out->redata + k * n, wr, sizeof(double) * n);
+		memcpy((double *) out->imdata + k * n, wi, sizeof(double) * n);
+	}
+
+	free(wr);
+	free(wi);
+	free(vr);
+	free(vi);
+	return out;
+}
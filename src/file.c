@@ -186,14 +186,15 @@ qg8_file_flush(qg8_file *qg8f)
 	uint64_t i;
 	uint16_t version;
 	uint8_t blank[8];
-	uint64_t tmp2, tmp3, tmp4;
+	uint64_t tmp2, tmp3, tmp4, nidx, plen, vlen;
+	uint8_t *packed, *values, tflags, compression;
 	uint32_t *shape32;
 	uint16_t *shape16;
 	uint8_t *shape8;
 	uint8_t data_size;
 	qg8_chunk_linkedlist *tlist;
 	qg8_chunk *chunk;
-	qg8_tensor *tensor;
+	qg8_tensor *tensor, *view;
 
 	if (!qg8f)
 	{
@@ -222,6 +223,12 @@ qg8_file_flush(qg8_file *qg8f)
 	{
 		chunk = tlist->chunk;
 		tensor = chunk->tensor;
+		/* flat indices are written from a LINEAR view, see linear.c */
+		view = NULL;
+		if (tensor && chunk->index_encoding == QG8_INDEX_LINEAR)
+			view = _linear_view(tensor);
+		if (view)
+			tensor = view;
 		data_size = _type_to_size(tensor->dtype_id);
 
 		/* chunk header */
@@ -229,7 +236,9 @@ qg8_file_flush(qg8_file *qg8f)
 		fwrite(&chunk->flags, sizeof(chunk->flags), 1, qg8f->fp);
 		if ((chunk->flags & QG8_FLAG_LABEL) == QG8_FLAG_LABEL)
 			fwrite(chunk->string_id, sizeof(uint8_t) * 16, 1, qg8f->fp);
-		fwrite(blank, 5, 1, qg8f->fp); /* _reserved */
+		compression = tensor ? chunk->compression : QG8_COMPRESS_NONE;
+		fwrite(&compression, sizeof(compression), 1, qg8f->fp);
+		fwrite(blank, 4, 1, qg8f->fp); /* _reserved */
 		tmp4 = _type_to_size(tensor->itype_id);
 		if (!tensor)
 		{
@@ -240,26 +249,50 @@ qg8_file_flush(qg8_file *qg8f)
 		else
 		{
 			/*
-			   (
-			   index type size * ranks
+			   index type size * ranks * index entries
 			   +
-			   data type size * re/im
-			   )
-			   *
-			   number of elements
+			   data type size * re/im * number of elements
 			   +
 			   index type size * ranks
 			   +
 			   bytes in the tensor header
+
+			   index entries are the number of elements except for
+			   DIA and BSR packing, see _tensor_index_len, and the
+			   LINEAR view stores a single index array
+
+			   canonical tensors replace the index arrays with their
+			   length in bytes and the packed arrays, see codec.c, and
+			   compressed chunks the values with their length in bytes
+			   and the compressed values, see compress.c
 		    */
-			if (tensor->dtype_id == QG8_DTYPE_COMPLEX64 ||
-			    tensor->dtype_id == QG8_DTYPE_COMPLEX128)
+			if (_tensor_is_complex(tensor))
 				tmp2 = 2;
 			else
 				tmp2 = 1;
-			tmp3 = (((tmp4 * tensor->rank) + (data_size * tmp2)) *
-			       tensor->num_elems) + (tmp4 * tensor->rank) +
-			       sizeof(qg8_tensor_header);
+			nidx = _tensor_index_len(tensor);
+			packed = _codec_encode(tensor, &plen);
+			tflags = tensor->flags & ~QG8_TENSOR_PACKED_INDEX;
+			if (packed)
+			{
+				tflags |= QG8_TENSOR_PACKED_INDEX;
+				tmp3 = sizeof(uint64_t) + plen;
+			}
+			else
+			{
+				tmp3 = tmp4 * _tensor_index_arrays(tensor) * nidx;
+			}
+			values = NULL;
+			if (compression == QG8_COMPRESS_SHUFFLE_LZ)
+			{
+				values = _compress_values(tensor, &vlen);
+				tmp3 += sizeof(uint64_t) + vlen;
+			}
+			else
+			{
+				tmp3 += data_size * tmp2 * tensor->num_elems;
+			}
+			tmp3 += (tmp4 * tensor->rank) + sizeof(qg8_tensor_header);
 			fwrite(&tmp3, sizeof(uint64_t), 1, qg8f->fp);
 
 			/* tensor header */
@@ -267,44 +300,46 @@ qg8_file_flush(qg8_file *qg8f)
 			fwrite(&tensor->itype_id, sizeof(uint8_t), 1, qg8f->fp);
 			fwrite(&tensor->dtype_id, sizeof(uint8_t), 1, qg8f->fp);
 			fwrite(&tensor->rank, sizeof(tensor->rank), 1, qg8f->fp);
-			fwrite(blank, 3, 1, qg8f->fp);
+			fwrite(&tflags, sizeof(tflags), 1, qg8f->fp);
+			fwrite(blank, 2, 1, qg8f->fp);
 			for (i = 0; i < tensor->rank; ++i)
 				fwrite(tensor->dimensions+i, tmp4, 1, qg8f->fp);
 			fwrite(&tensor->num_elems, sizeof(tensor->num_elems), 1, qg8f->fp);
+			if (values)
+				fwrite(&vlen, sizeof(vlen), 1, qg8f->fp);
 
 			/* tensor data */
-			for (i = 0; i < tensor->rank; ++i)
+			if (packed)
+			{
+				fwrite(&plen, sizeof(plen), 1, qg8f->fp);
+				fwrite(packed, 1, plen, qg8f->fp);
+			}
+			for (i = 0; !packed && i < _tensor_index_arrays(tensor); ++i)
 			{
 				if (tmp4 == QG8_SIZE_64)
 				{
-					fwrite(*(tensor->indices+i), tmp4,
-					       tensor->num_elems, qg8f->fp);
+					fwrite(*(tensor->indices+i), tmp4, nidx, qg8f->fp);
 				}
 				else if (tmp4 == QG8_SIZE_32)
 				{
-					shape32 = _shape64_32(*(tensor->indices+i),
-					                      tensor->num_elems);
-					fwrite(shape32, tmp4,
-					       tensor->num_elems, qg8f->fp);
+					shape32 = _shape64_32(*(tensor->indices+i), nidx);
+					fwrite(shape32, tmp4, nidx, qg8f->fp);
 					free(shape32);
 				}
 				else if (tmp4 == QG8_SIZE_16)
 				{
-					shape16 = _shape64_16(*(tensor->indices+i),
-					                      tensor->num_elems);
-					fwrite(shape16, tmp4,
-					       tensor->num_elems, qg8f->fp);
+					shape16 = _shape64_16(*(tensor->indices+i), nidx);
+					fwrite(shape16, tmp4, nidx, qg8f->fp);
 					free(shape16);
 				}
 				else if (tmp4 == QG8_SIZE_8)
 				{
-					shape8 = _shape64_8(*(tensor->indices+i),
-					                    tensor->num_elems);
-					fwrite(shape8, tmp4,
-					       tensor->num_elems, qg8f->fp);
+					shape8 = _shape64_8(*(tensor->indices+i), nidx);
+					fwrite(shape8, tmp4, nidx, qg8f->fp);
 					free(shape8);
 				}
 			}
+			free(packed);
 			switch (tensor->dtype_id)
 			{
 			case QG8_DTYPE_FLOAT32:
@@ -319,9 +354,18 @@ qg8_file_flush(qg8_file *qg8f)
 			case QG8_DTYPE_INT16:
 			case QG8_DTYPE_INT32:
 			case QG8_DTYPE_INT64:
+			case QG8_DTYPE_FLOAT16:
+			case QG8_DTYPE_BFLOAT16:
+			case QG8_DTYPE_COMPLEX32:
+			case QG8_DTYPE_BCOMPLEX32:
+				if (values)
+				{
+					fwrite(values, 1, vlen, qg8f->fp);
+					free(values);
+					break;
+				}
 				fwrite(tensor->redata, data_size, tensor->num_elems, qg8f->fp);
-				if (tensor->dtype_id == QG8_DTYPE_COMPLEX64 ||
-				    tensor->dtype_id == QG8_DTYPE_COMPLEX128)
+				if (_tensor_is_complex(tensor))
 				{
 					fwrite(tensor->imdata, data_size,
 					       tensor->num_elems, qg8f->fp);
@@ -333,6 +377,8 @@ qg8_file_flush(qg8_file *qg8f)
 				exit(EXIT_FAILURE);
 			}
 		}
+		if (view)
+			_linear_view_free(view);
 
 		tlist = tlist->next;
 	}
@@ -0,0 +1,466 @@
+/*
+ * gate.c
+ * QG8 base library gate application source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Qubits follow the order of JOIN: qubit 0 is the first Kronecker factor,
+ * the most significant bit of a basis state index, and qubit n-1 the least
+ * significant. For a k qubit gate, qubits[0] is likewise the most
+ * significant bit of the gate index, so applying G to qubits {q, q+1} is
+ * the same as applying I (x) G (x) I.
+ *
+ * The state is never expanded: for every setting of the untouched bits the
+ * 2^k amplitudes addressed by the gate are read, multiplied by G and
+ * written back. Untouched bits below the lowest gate bit give runs of
+ * contiguous amplitudes, which are processed a block at a time with the
+ * vector kernels.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* amplitudes held per thread, split between the 2^k rows of the gate */
+#define GATE_BLOCK 4096
+
+/* inserts a zero bit at every position of pos (ascending) into f */
+static
+uint64_t
+_deposit(uint64_t f,
+         const uint64_t *pos,
+         uint64_t k)
+{
+	uint64_t t;
+
+	for (t = 0; t < k; ++t)
+		f = ((f >> *(pos+t)) << (*(pos+t) + 1)) |
+		    (f & (((uint64_t) 1 << *(pos+t)) - 1));
+	return f;
+}
+
+/* one gate application per amplitude group, for gates on the lowest bits */
+static
+void
+_apply_scalar(uint64_t nq,
+              double *re,
+              double *im,
+              const double *gre,
+              const double *gim,
+              const uint64_t *off,
+              const uint64_t *pos,
+              uint64_t k)
+{
+	uint64_t g, groups, dim;
+
+	dim = (uint64_t) 1 << k;
+	groups = (uint64_t) 1 << (nq - k);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif /* _OPENMP */
+	{
+		double *vr, *vi, sr, si;
+		uint64_t base, i, j;
+		vr = (double *) malloc(sizeof(double) * dim);
+		ALLOC(vr);
+		vi = (double *) malloc(sizeof(double) * dim);
+		ALLOC(vi);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif /* _OPENMP */
+		for (g = 0; g < groups; ++g)
+		{
+			base = _deposit(g, pos, k);
+			for (j = 0; j < dim; ++j)
+			{
+				*(vr+j) = *(re+base+*(off+j));
+				*(vi+j) = *(im+base+*(off+j));
+			}
+			for (i = 0; i < dim; ++i)
+			{
+				sr = 0.0;
+				si = 0.0;
+				for (j = 0; j < dim; ++j)
+				{
+					sr += *(gre+i*dim+j) * *(vr+j) -
+					      *(gim+i*dim+j) * *(vi+j);
+					si += *(gre+i*dim+j) * *(vi+j) +
+					      *(gim+i*dim+j) * *(vr+j);
+				}
+				*(re+base+*(off+i)) = sr;
+				*(im+base+*(off+i)) = si;
+			}
+		}
+		free(vr);
+		free(vi);
+	}
+}
+
+/* gate bits above the lowest two: contiguous blocks through zaxpy */
+static
+void
+_apply_blocked(uint64_t nq,
+               double *re,
+               double *im,
+               const double *gre,
+               const double *gim,
+               const uint64_t *off,
+               const uint64_t *pos,
+               uint64_t k)
+{
+	uint64_t u, units, run, block, per_run, dim;
+
+	dim = (uint64_t) 1 << k;
+	run = (uint64_t) 1 << *pos;
+	block = MIN(run, MAX((uint64_t) GATE_BLOCK >> k, (uint64_t) 4));
+	per_run = run / block;
+	units = ((uint64_t) 1 << (nq - k - *pos)) * per_run;
+	qg8_kernel_get_isa(); /* resolve the dispatch before the threads start */
+#ifdef _OPENMP
+#pragma omp parallel
+#endif /* _OPENMP */
+	{
+		double *tr, *ti, ar, ai;
+		uint64_t start, i, j;
+		tr = (double *) malloc(sizeof(double) * dim * block);
+		ALLOC(tr);
+		ti = (double *) malloc(sizeof(double) * dim * block);
+		ALLOC(ti);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif /* _OPENMP */
+		for (u = 0; u < units; ++u)
+		{
+			start = _deposit(u / per_run * run, pos, k) +
+			        u % per_run * block;
+			for (j = 0; j < dim; ++j)
+			{
+				memcpy(tr+j*block, re+start+*(off+j), sizeof(double) * block);
+				memcpy(ti+j*block, im+start+*(off+j), sizeof(double) * block);
+			}
+			for (i = 0; i < dim; ++i)
+			{
+				memset(re+start+*(off+i), 0, sizeof(double) * block);
+				memset(im+start+*(off+i), 0, sizeof(double) * block);
+				for (j = 0; j < dim; ++j)
+				{
+					ar = *(gre+i*dim+j);
+					ai = *(gim+i*dim+j);
+					if (ar == 0.0 && ai == 0.0)
+						continue;
+					qg8_kernel_zaxpy(block, ar, ai, tr+j*block, ti+j*block,
+					                 re+start+*(off+i), im+start+*(off+i));
+				}
+			}
+		}
+		free(tr);
+		free(ti);
+	}
+}
+
+/*
+ * Applies the dense 2^k x 2^k gate (gre, gim) to qubits of the nq qubit
+ * state (re, im) in place. The qubits must be distinct and below nq.
+ */
+void
+_gate_apply(uint64_t nq,
+            double *re,
+            double *im,
+            const double *gre,
+            const double *gim,
+            const uint64_t *qubits,
+            uint64_t k)
+{
+	uint64_t *pos, *off, dim, t, j, p;
+
+	if (k == 0 || k > nq)
+	{
+		DIE("Cannot apply a gate on more qubits than the state holds.\n");
+	}
+	dim = (uint64_t) 1 << k;
+	pos = (uint64_t *) malloc(sizeof(uint64_t) * k);
+	ALLOC(pos);
+	off = (uint64_t *) malloc(sizeof(uint64_t) * dim);
+	ALLOC(off);
+	for (t = 0; t < k; ++t)
+	{
+		if (*(qubits+t) >= nq)
+		{
+			DIE("Gate qubit is out of range.\n");
+		}
+		*(pos+t) = nq - 1 - *(qubits+t);
+	}
+	/* offset of every gate basis state, qubits[0] most significant */
+	for (j = 0; j < dim; ++j)
+	{
+		*(off+j) = 0;
+		for (t = 0; t < k; ++t)
+			if (j >> (k - 1 - t) & 1)
+				*(off+j) |= (uint64_t) 1 << *(pos+t);
+	}
+	/* ascending bit positions for _deposit */
+	for (t = 1; t < k; ++t)
+	{
+		p = *(pos+t);
+		for (j = t; j > 0 && *(pos+j-1) > p; --j)
+			*(pos+j) = *(pos+j-1);
+		*(pos+j) = p;
+		if (j > 0 && *(pos+j-1) == p)
+		{
+			DIE("Gate qubits are not distinct.\n");
+		}
+	}
+	if (*pos >= 2)
+		_apply_blocked(nq, re, im, gre, gim, off, pos, k);
+	else
+		_apply_scalar(nq, re, im, gre, gim, off, pos, k);
+	free(pos);
+	free(off);
+}
+
+/* widens gate g to the qubits u, which hold all qubits of g */
+static
+void
+_gate_expand(const qg8_gate *g,
+             const uint64_t *u,
+             uint64_t ku,
+             double *re,
+             double *im)
+{
+	uint64_t bit[64], dim, gd, mask, i, j, gi, gj, t, p;
+
+	dim = (uint64_t) 1 << ku;
+	gd = (uint64_t) 1 << g->k;
+	mask = 0;
+	for (t = 0; t < g->k; ++t)
+	{
+		for (p = 0; *(u+p) != *(g->qubits+t); ++p)
+			;
+		bit[t] = ku - 1 - p;
+		mask |= (uint64_t) 1 << bit[t];
+	}
+	for (i = 0; i < dim; ++i)
+	{
+		for (j = 0; j < dim; ++j)
+		{
+			*(re+i*dim+j) = 0.0;
+			*(im+i*dim+j) = 0.0;
+			if ((i ^ j) & ~mask)
+				continue;
+			gi = 0;
+			gj = 0;
+			for (t = 0; t < g->k; ++t)
+			{
+				gi = gi << 1 | (i >> bit[t] & 1);
+				gj = gj << 1 | (j >> bit[t] & 1);
+			}
+			*(re+i*dim+j) = *(g->re+gi*gd+gj);
+			*(im+i*dim+j) = *(g->im+gi*gd+gj);
+		}
+	}
+}
+
+/* f = g*f, f growing to the union of both qubit sets */
+static
+void
+_gate_absorb(qg8_gate *f,
+             const qg8_gate *g)
+{
+	uint64_t u[64], ku, dim, t, p;
+	double *fr, *fi, *gr, *gi;
+
+	ku = f->k;
+	memcpy(u, f->qubits, sizeof(uint64_t) * f->k);
+	for (t = 0; t < g->k; ++t)
+	{
+		for (p = 0; p < ku && u[p] != *(g->qubits+t); ++p)
+			;
+		if (p == ku)
+			u[ku++] = *(g->qubits+t);
+	}
+	dim = (uint64_t) 1 << ku;
+	fr = (double *) malloc(sizeof(double) * dim * dim);
+	ALLOC(fr);
+	fi = (double *) malloc(sizeof(double) * dim * dim);
+	ALLOC(fi);
+	gr = (double *) malloc(sizeof(double) * dim * dim);
+	ALLOC(gr);
+	gi = (double *) malloc(sizeof(double) * dim * dim);
+	ALLOC(gi);
+	_gate_expand(f, u, ku, fr, fi);
+	_gate_expand(g, u, ku, gr, gi);
+	free(f->re);
+	free(f->im);
+	free(f->qubits);
+	f->re = (double *) malloc(sizeof(double) * dim * dim);
+	ALLOC(f->re);
+	f->im = (double *) malloc(sizeof(double) * dim * dim);
+	ALLOC(f->im);
+	qg8_kernel_zgemm(dim, dim, dim, gr, gi, fr, fi, f->re, f->im);
+	f->qubits = (uint64_t *) malloc(sizeof(uint64_t) * ku);
+	ALLOC(f->qubits);
+	memcpy(f->qubits, u, sizeof(uint64_t) * ku);
+	f->k = ku;
+	free(fr);
+	free(fi);
+	free(gr);
+	free(gi);
+}
+
+/* qubits of f and g together, without building the fused gate */
+static
+uint64_t
+_gate_union(const qg8_gate *f,
+            const qg8_gate *g)
+{
+	uint64_t n, t, p;
+
+	n = f->k;
+	for (t = 0; t < g->k; ++t)
+	{
+		for (p = 0; p < f->k && *(f->qubits+p) != *(g->qubits+t); ++p)
+			;
+		if (p == f->k)
+			++n;
+	}
+	return n;
+}
+
+/*
+ * Applies gates, in order, to the nq qubit state (re, im). Consecutive
+ * gates are multiplied together while their qubits fit in max_fused, so
+ * the state is streamed once per fused gate instead of once per gate.
+ * Gates on more qubits than max_fused are applied on their own.
+ */
+void
+_gate_fuse_apply(uint64_t nq,
+                 double *re,
+                 double *im,
+                 qg8_gate *gates,
+                 uint64_t num_gates,
+                 uint64_t max_fused)
+{
+	qg8_gate f, *g;
+	uint64_t i, d;
+	int open;
+
+	max_fused = MIN(max_fused, 63);
+	open = 0;
+	for (i = 0; i < num_gates; ++i)
+	{
+		g = gates + i;
+		if (open && _gate_union(&f, g) <= max_fused)
+		{
+			_gate_absorb(&f, g);
+			continue;
+		}
+		if (open)
+		{
+			_gate_apply(nq, re, im, f.re, f.im, f.qubits, f.k);
+			free(f.qubits);
+			free(f.re);
+			free(f.im);
+			open = 0;
+		}
+		if (g->k > max_fused)
+		{
+			_gate_apply(nq, re, im, g->re, g->im, g->qubits, g->k);
+			continue;
+		}
+		d = (uint64_t) 1 << g->k;
+		f.k = g->k;
+		f.qubits = (uint64_t *) malloc(sizeof(uint64_t) * g->k);
+		ALLOC(f.qubits);
+		f.re = (double *) malloc(sizeof(double) * d * d);
+		ALLOC(f.re);
+		f.im = (double *) malloc(sizeof(double) * d * d);
+		ALLOC(f.im);
+		memcpy(f.qubits, g->qubits, sizeof(uint64_t) * g->k);
+		memcpy(f.re, g->re, sizeof(double) * d * d);
+		memcpy(f.im, g->im, sizeof(double) * d * d);
+		open = 1;
+	}
+	if (open)
+	{
+		_gate_apply(nq, re, im, f.re, f.im, f.qubits, f.k);
+		free(f.qubits);
+		free(f.re);
+		free(f.im);
+	}
+}
+
+/*
+ * Applies a 2^k x 2^k gate to qubits of a ket in place, without building
+ * the operator on the whole state. The ket must be a complete full
+ * COMPLEX128 tensor of 2^n elements, rank 1 or a single column.
+ */
+int
+qg8_tensor_apply_gate(qg8_tensor *ket,
+                      qg8_tensor *gate,
+                      const uint64_t *qubits,
+                      uint64_t num_qubits)
+{
+	double *gre, *gim;
+	uint64_t dim, nq;
+
+	if (!ket || !gate || !qubits)
+	{
+		DIE("Cannot apply a NULL gate.\n");
+	}
+	if ((ket->rank != 1 && (ket->rank != 2 || *(ket->dimensions+1) != 1)) ||
+	    ket->packing != QG8_PACKING_FULL ||
+	    ket->dtype_id != QG8_DTYPE_COMPLEX128 ||
+	    ket->num_elems != *(ket->dimensions))
+	{
+		DIE("Gates apply to full COMPLEX128 kets only.\n");
+	}
+	for (nq = 0; ((uint64_t) 1 << nq) < *(ket->dimensions); ++nq)
+		;
+	if (((uint64_t) 1 << nq) != *(ket->dimensions))
+	{
+		DIE("Ket dimension is not a power of two.\n");
+	}
+	if (num_qubits == 0 || num_qubits > nq)
+	{
+		DIE("Cannot apply a gate on more qubits than the ket holds.\n");
+	}
+	dim = (uint64_t) 1 << num_qubits;
+	if (gate->rank != 2 || *(gate->dimensions) != dim ||
+	    *(gate->dimensions+1) != dim)
+	{
+		fprintf(stderr, "Gate on %lu qubits is not %lux%lu.\n",
+		        num_qubits, dim, dim);
+		exit(EXIT_FAILURE);
+	}
+	gre = (double *) malloc(sizeof(double) * dim * dim);
+	ALLOC(gre);
+	gim = (double *) malloc(sizeof(double) * dim * dim);
+	ALLOC(gim);
+	_tensor_to_dense(gate, gre, gim);
+	_gate_apply(nq, (double *) ket->redata, (double *) ket->imdata, gre, gim,
+	            qubits, num_qubits);
+	free(gre);
+	free(gim);
+	return 1;
+}
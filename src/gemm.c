@@ -0,0 +1,276 @@
+/*
+ * gemm.c
+ * QG8 base library dense matrix product source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Dense products of row-major matrices, following the usual blocked
+ * layout: a KCxNC block of b is packed once into panels of GEMM_NR
+ * columns, every MCxKC block of a into panels of GEMM_MR rows, and the
+ * register tile of kernel.c runs over the packed panels so that a stays in
+ * L2 and a b panel in L1. Complex products work on the split layout, with
+ * real products of the re and im parts.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* block sizes, multiples of the register tile */
+#define GEMM_MC 96
+#define GEMM_KC 256
+#define GEMM_NC 2048
+
+/* products below this many multiplications run on one thread */
+#define GEMM_PAR_MIN 262144
+
+/* complex products above this many multiplications use 3 real products */
+#define GEMM_3M_MIN 2097152
+
+/* packs rows of a into zero padded panels of GEMM_MR rows */
+static
+void
+_pack_a(uint64_t mc,
+        uint64_t kc,
+        const double *a,
+        uint64_t lda,
+        double *ap)
+{
+	uint64_t ir, p, i;
+
+	for (ir = 0; ir < mc; ir += GEMM_MR)
+	{
+		for (p = 0; p < kc; ++p)
+		{
+			for (i = 0; i < GEMM_MR; ++i)
+				*(ap++) = ir + i < mc ? *(a+(ir+i)*lda+p) : 0.0;
+		}
+	}
+}
+
+/* packs columns of b into zero padded panels of GEMM_NR columns */
+static
+void
+_pack_b(uint64_t kc,
+        uint64_t nc,
+        const double *b,
+        uint64_t ldb,
+        double *bp)
+{
+	uint64_t jr;
+
+#ifdef _OPENMP
+#pragma omp parallel for if(kc * nc >= GEMM_PAR_MIN / 8)
+#endif /* _OPENMP */
+	for (jr = 0; jr < nc; jr += GEMM_NR)
+	{
+		double *dst;
+		uint64_t p, j;
+		dst = bp + jr * kc;
+		for (p = 0; p < kc; ++p)
+		{
+			for (j = 0; j < GEMM_NR; ++j)
+				*(dst++) = jr + j < nc ? *(b+p*ldb+jr+j) : 0.0;
+		}
+	}
+}
+
+/*
+ * c += alpha * a*b for an mxk matrix a and a kxn matrix b, with leading
+ * dimensions lda, ldb and ldc. Row blocks of c are shared between threads,
+ * so the result does not depend on the thread count.
+ */
+void
+_dgemm(uint64_t m,
+       uint64_t n,
+       uint64_t k,
+       double alpha,
+       const double *a,
+       uint64_t lda,
+       const double *b,
+       uint64_t ldb,
+       double *c,
+       uint64_t ldc)
+{
+	qg8_gemm_tile tile;
+	double *bp;
+	uint64_t jc, pc, nc, kc;
+	int par;
+
+	if (!m || !n || !k)
+		return;
+	tile = _kernel_dgemm_tile();
+	par = m * n * k >= GEMM_PAR_MIN;
+	bp = (double *) malloc(sizeof(double) * GEMM_KC *
+	                       (MIN(n, GEMM_NC) + GEMM_NR));
+	ALLOC(bp);
+	for (jc = 0; jc < n; jc += GEMM_NC)
+	{
+		nc = MIN(GEMM_NC, n - jc);
+		for (pc = 0; pc < k; pc += GEMM_KC)
+		{
+			kc = MIN(GEMM_KC, k - pc);
+			_pack_b(kc, nc, b+pc*ldb+jc, ldb, bp);
+#ifdef _OPENMP
+#pragma omp parallel if(par)
+#endif /* _OPENMP */
+			{
+				double *ap, buf[GEMM_MR*GEMM_NR], *ct;
+				uint64_t ic, ir, jr, mc, i, j, mr, nr;
+				ap = (double *) malloc(sizeof(double) * GEMM_MC * kc);
+				ALLOC(ap);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif /* _OPENMP */
+				for (ic = 0; ic < m; ic += GEMM_MC)
+				{
+					mc = MIN(GEMM_MC, m - ic);
+					_pack_a(mc, kc, a+ic*lda+pc, lda, ap);
+					for (jr = 0; jr < nc; jr += GEMM_NR)
+					{
+						nr = MIN(GEMM_NR, nc - jr);
+						for (ir = 0; ir < mc; ir += GEMM_MR)
+						{
+							mr = MIN(GEMM_MR, mc - ir);
+							ct = c + (ic + ir) * ldc + jc + jr;
+							if (mr == GEMM_MR && nr == GEMM_NR)
+							{
+								tile(kc, ap+ir*kc, bp+jr*kc, alpha, ct, ldc);
+								continue;
+							}
+							/* edge tile, computed aside */
+							memset(buf, 0, sizeof(buf));
+							tile(kc, ap+ir*kc, bp+jr*kc, alpha, buf,
+							     GEMM_NR);
+							for (i = 0; i < mr; ++i)
+								for (j = 0; j < nr; ++j)
+									*(ct+i*ldc+j) += buf[i*GEMM_NR+j];
+						}
+					}
+				}
+				free(ap);
+			}
+		}
+	}
+	free(bp);
+	(void) par;
+}
+
+/* element-wise x + y into z */
+static
+double *
+_sum(uint64_t n,
+     const double *x,
+     const double *y)
+{
+	double *z;
+	uint64_t i;
+
+	z = (double *) malloc(sizeof(double) * MAX(n, 1));
+	ALLOC(z);
+	for (i = 0; i < n; ++i)
+		*(z+i) = *(x+i) + *(y+i);
+	return z;
+}
+
+/*
+ * Complex product on split storage. Small products take the four real
+ * products (4M). Large ones take three (3M):
+ *   t = ai*bi, cr = ar*br, ci = (ar+ai)(br+bi) - cr - t, cr -= t
+ * which saves a quarter of the work at a slightly larger rounding error.
+ */
+static
+void
+_zgemm(uint64_t m,
+       uint64_t n,
+       uint64_t k,
+       const double *ar,
+       const double *ai,
+       const double *br,
+       const double *bi,
+       double *cr,
+       double *ci)
+{
+	double *sa, *sb, *t;
+	uint64_t i;
+
+	memset(cr, 0, sizeof(double) * m * n);
+	memset(ci, 0, sizeof(double) * m * n);
+	_dgemm(m, n, k, 1.0, ar, k, br, n, cr, n);
+	if (ai && bi && m * n * k >= GEMM_3M_MIN)
+	{
+		sa = _sum(m * k, ar, ai);
+		sb = _sum(k * n, br, bi);
+		t = (double *) calloc(MAX(m * n, 1), sizeof(double));
+		ALLOC(t);
+		_dgemm(m, n, k, 1.0, ai, k, bi, n, t, n);
+		_dgemm(m, n, k, 1.0, sa, k, sb, n, ci, n);
+		for (i = 0; i < m * n; ++i)
+		{
+			*(ci+i) -= *(cr+i) + *(t+i);
+			*(cr+i) -= *(t+i);
+		}
+		free(sa);
+		free(sb);
+		free(t);
+		return;
+	}
+	if (ai && bi)
+		_dgemm(m, n, k, -1.0, ai, k, bi, n, cr, n);
+	if (bi)
+		_dgemm(m, n, k, 1.0, ar, k, bi, n, ci, n);
+	if (ai)
+		_dgemm(m, n, k, 1.0, ai, k, br, n, ci, n);
+}
+
+/* c = a*b for row-major mxk and kxn matrices */
+void
+qg8_kernel_dgemm(uint64_t m,
+                 uint64_t n,
+                 uint64_t k,
+                 const double *a,
+                 const double *b,
+                 double *c)
+{
+	memset(c, 0, sizeof(double) * m * n);
+	_dgemm(m, n, k, 1.0, a, k, b, n, c, n);
+}
+
+/*
+ * c = a*b for row-major complex mxk and kxn matrices in split storage. A
+ * NULL imaginary part of a or b is read as zero.
+ */
+void
+qg8_kernel_zgemm(uint64_t m,
+                 uint64_t n,
+                 uint64_t k,
+                 const double *ar,
+                 const double *ai,
+                 const double *br,
+                 const double *bi,
+                 double *cr,
+                 double *ci)
+{
+	_zgemm(m, n, k, ar, ai, br, bi, cr, ci);
+}
@@ -139,6 +139,14 @@ _qg8_graph_recalculate(qg8_graph *graph,
 
 qg8_graph *
 qg8_graph_load(const char *filename)
+{
+	return qg8_graph_load_as(filename, 0);
+}
+
+/* loads every chunk as qg8_file_extract_as, a dtype_id of 0 as stored */
+qg8_graph *
+qg8_graph_load_as(const char *filename,
+                  uint8_t dtype_id)
 {
 	qg8_file *file;
 	qg8_iter iter;
@@ -156,7 +164,7 @@ qg8_graph_load(const char *filename)
 	for (iter = qg8_file_iterator(file);
 	     qg8_file_has_next(&iter) == 1;)
 	{
-		chunk = qg8_file_extract(&iter);
+		chunk = qg8_file_extract_as(&iter, dtype_id);
 		if (!chunk || qg8_graph_add_chunk(g, chunk) != 1)
 		{
 			qg8_graph_destroy(g);
@@ -188,6 +196,7 @@ qg8_graph_create(void)
 	ALLOC(g);
 	g->chunks = NULL;
 	/*g->adjchunk = NULL;*/
+	g->max_fused = QG8_FUSE_DEFAULT;
 	return g;
 }
 
@@ -283,6 +292,33 @@ qg8_graph_get_chunk(qg8_graph *graph,
 	return NULL; /* fallback */
 }
 
+/*
+ * Sets how many qubits the gates of a circuit may be fused into when the
+ * graph is evaluated. 0 turns the circuit pass off, so operator products
+ * are expanded and multiplied like any other MATMUL chain.
+ */
+int
+qg8_graph_set_max_fused(qg8_graph *graph,
+                        uint8_t max_fused)
+{
+	if (!graph)
+	{
+		DIE("Cannot set fusion of a NULL graph.\n");
+	}
+	graph->max_fused = max_fused;
+	return 1;
+}
+
+uint8_t
+qg8_graph_get_max_fused(qg8_graph *graph)
+{
+	if (!graph)
+	{
+		DIE("Cannot get fusion of a NULL graph.\n");
+	}
+	return graph->max_fused;
+}
+
 int
 qg8_graph_add_chunk(qg8_graph *graph,
                     qg8_chunk *chunk)
@@ -364,3 +400,125 @@ qg8_graph_destroy(qg8_graph *graph)
 	return 1;
 }
 
+
+/*
+ * Resolves the operands of every chunk from the first adjacency chunk of the
+ * graph. An edge (i, j) makes chunk i an operand of chunk j, chunks being
+ * numbered as in qg8_graph_get_chunk. Operands are ordered by edge value,
+ * edges of equal value keeping the order in which they are stored.
+ */
+qg8_dag *
+_dag_build(qg8_graph *graph)
+{
+	qg8_dag *dag;
+	qg8_chunk_linkedlist *l;
+	qg8_tensor *adj;
+	uint64_t i, j, e, src, dst, *fill;
+	double *w, *ow, tw;
+
+	dag = (qg8_dag *) malloc(sizeof(qg8_dag));
+	ALLOC(dag);
+	dag->num_nodes = qg8_graph_get_number_chunks(graph);
+	dag->nodes = (qg8_chunk **) malloc(sizeof(qg8_chunk *) *
+	                                   MAX(dag->num_nodes, 1));
+	ALLOC(dag->nodes);
+	adj = NULL;
+	for (i = 0, l = graph->chunks; l; l = l->next, ++i)
+	{
+		*(dag->nodes+i) = l->chunk;
+		if (!adj && l->chunk->type == QG8_TYPE_ADJACENCY)
+			adj = l->chunk->tensor;
+	}
+	dag->opptr = (uint64_t *) calloc(dag->num_nodes + 1, sizeof(uint64_t));
+	ALLOC(dag->opptr);
+	dag->consumers = (uint64_t *) calloc(MAX(dag->num_nodes, 1),
+	                                     sizeof(uint64_t));
+	ALLOC(dag->consumers);
+	if (!adj)
+	{
+		dag->opsrc = (uint64_t *) malloc(sizeof(uint64_t));
+		ALLOC(dag->opsrc);
+		return dag;
+	}
+	if (adj->rank != 2)
+	{
+		DIE("Adjacency tensor is not of rank 2.\n");
+	}
+
+	for (e = 0; e < adj->num_elems; ++e)
+	{
+		src = *(*(adj->indices)+e);
+		dst = *(*(adj->indices+1)+e);
+		if (src >= dag->num_nodes || dst >= dag->num_nodes)
+		{
+			DIE("Adjacency tensor refers to a chunk outside the graph.\n");
+		}
+		++*(dag->opptr+dst+1);
+		++*(dag->consumers+src);
+	}
+	for (i = 0; i < dag->num_nodes; ++i)
+		*(dag->opptr+i+1) += *(dag->opptr+i);
+
+	w = (double *) malloc(sizeof(double) * MAX(adj->num_elems, 1));
+	ALLOC(w);
+	ow = (double *) malloc(sizeof(double) * MAX(adj->num_elems, 1));
+	ALLOC(ow);
+	_tensor_to_double(adj, w, NULL);
+	dag->opsrc = (uint64_t *) malloc(sizeof(uint64_t) *
+	                                 MAX(adj->num_elems, 1));
+	ALLOC(dag->opsrc);
+	fill = (uint64_t *) malloc(sizeof(uint64_t) * MAX(dag->num_nodes, 1));
+	ALLOC(fill);
+	memcpy(fill, dag->opptr, sizeof(uint64_t) * dag->num_nodes);
+	for (e = 0; e < adj->num_elems; ++e)
+	{
+		dst = *(*(adj->indices+1)+e);
+		*(dag->opsrc+*(fill+dst)) = *(*(adj->indices)+e);
+		*(ow+(*(fill+dst))++) = *(w+e);
+	}
+	/* operand lists are short, a stable insertion sort is enough */
+	for (i = 0; i < dag->num_nodes; ++i)
+	{
+		for (j = *(dag->opptr+i) + 1; j < *(dag->opptr+i+1); ++j)
+		{
+			src = *(dag->opsrc+j);
+			tw = *(ow+j);
+			for (e = j; e > *(dag->opptr+i) && *(ow+e-1) > tw; --e)
+			{
+				*(dag->opsrc+e) = *(dag->opsrc+e-1);
+				*(ow+e) = *(ow+e-1);
+			}
+			*(dag->opsrc+e) = src;
+			*(ow+e) = tw;
+		}
+	}
+	free(fill);
+	free(w);
+	free(ow);
+	return dag;
+}
+
+uint64_t
+_dag_find(qg8_dag *dag,
+          qg8_chunk *chunk)
+{
+	uint64_t i;
+
+	for (i = 0; i < dag->num_nodes; ++i)
+	{
+		if (*(dag->nodes+i) == chunk)
+			return i;
+	}
+	DIE("Chunk is not part of the graph.\n");
+	return 0; /* fallback */
+}
+
+void
+_dag_destroy(qg8_dag *dag)
+{
+	free(dag->nodes);
+	free(dag->opptr);
+	free(dag->opsrc);
+	free(dag->consumers);
+	free(dag);
+}
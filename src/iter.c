@@ -36,6 +36,7 @@ SHAPER(8_64,  uint64_t, uint8_t)
 static
 void
 _load_indices(qg8_tensor *t,
+              uint64_t n,
               FILE *f,
               qg8_iter *iter)
 {
@@ -46,45 +47,160 @@ _load_indices(qg8_tensor *t,
 	size_t i;
 
 	for (i = 0; i < t->rank; ++i)
+		*(t->indices+i) = NULL;
+	for (i = 0; i < _tensor_index_arrays(t); ++i)
 	{
 		if (t->itype_id == QG8_DTYPE_UINT8)
 		{
-			u8 = (uint8_t *) malloc(sizeof(uint8_t) * t->num_elems);
+			u8 = (uint8_t *) malloc(sizeof(uint8_t) * n);
 			ALLOC(u8);
-			READNN(u8, sizeof(uint8_t), t->num_elems, f);
-			*(t->indices+i) = _shape8_64(u8, t->num_elems);
-			iter->offset += sizeof(uint8_t) * t->num_elems;
+			READNN(u8, sizeof(uint8_t), n, f);
+			*(t->indices+i) = _shape8_64(u8, n);
+			iter->offset += sizeof(uint8_t) * n;
 			free(u8);
 		}
 		else if (t->itype_id == QG8_DTYPE_UINT16)
 		{
-			u16 = (uint16_t *) malloc(sizeof(uint16_t) * t->num_elems);
+			u16 = (uint16_t *) malloc(sizeof(uint16_t) * n);
 			ALLOC(u16);
-			READNN(u16, sizeof(uint16_t), t->num_elems, f);
-			*(t->indices+i) = _shape16_64(u16, t->num_elems);
-			iter->offset += sizeof(uint16_t) * t->num_elems;
+			READNN(u16, sizeof(uint16_t), n, f);
+			*(t->indices+i) = _shape16_64(u16, n);
+			iter->offset += sizeof(uint16_t) * n;
 			free(u16);
 		}
 		else if (t->itype_id == QG8_DTYPE_UINT32)
 		{
-			u32 = (uint32_t *) malloc(sizeof(uint32_t) * t->num_elems);
+			u32 = (uint32_t *) malloc(sizeof(uint32_t) * n);
 			ALLOC(u32);
-			READNN(u32, sizeof(uint32_t), t->num_elems, f);
-			*(t->indices+i) = _shape32_64(u32, t->num_elems);
-			iter->offset += sizeof(uint32_t) * t->num_elems;
+			READNN(u32, sizeof(uint32_t), n, f);
+			*(t->indices+i) = _shape32_64(u32, n);
+			iter->offset += sizeof(uint32_t) * n;
 			free(u32);
 		}
 		else
 		{
-			u64 = (uint64_t *) malloc(sizeof(uint64_t) * t->num_elems);
+			u64 = (uint64_t *) malloc(sizeof(uint64_t) * n);
 			ALLOC(u64);
-			READNN(u64, sizeof(uint64_t), t->num_elems, f);
-			iter->offset += sizeof(uint64_t) * t->num_elems;
+			READNN(u64, sizeof(uint64_t), n, f);
+			iter->offset += sizeof(uint64_t) * n;
 			*(t->indices+i) = u64;
 		}
 	}
 }
 
+/* index arrays packed by _codec_encode, at most max bytes of them */
+static
+void
+_load_packed(qg8_tensor *t,
+             uint64_t n,
+             uint64_t max,
+             FILE *f,
+             qg8_iter *iter)
+{
+	uint8_t *buf;
+	uint64_t len;
+
+	READ(&len, len, f);
+	iter->offset += sizeof(len);
+	if (len > max)
+	{
+		DIE("Packed indices do not match their chunk.\n");
+	}
+	/* zeroed tail for the vector unpacking, which reads ahead */
+	buf = (uint8_t *) malloc(len + 8);
+	ALLOC(buf);
+	READNN(buf, sizeof(uint8_t), len, f);
+	memset(buf + len, 0, 8);
+	iter->offset += len;
+	_codec_decode(t, buf, len, n);
+	free(buf);
+}
+
+/* values compressed by _compress_values, in len bytes, loaded as to */
+static
+void
+_load_compressed(qg8_tensor *t,
+                 uint64_t len,
+                 size_t dsize,
+                 uint8_t to,
+                 FILE *f,
+                 qg8_iter *iter)
+{
+	uint8_t *buf;
+
+	buf = (uint8_t *) malloc(MAX(len, 1));
+	ALLOC(buf);
+	READNN(buf, sizeof(uint8_t), len, f);
+	iter->offset += len;
+	_decompress_values(t, buf, len, dsize, to);
+	free(buf);
+}
+
+/* values read at once into the buffer of a converting load */
+#define LOAD_BLOCK 8192
+
+/*
+ * Plain values of dsize bytes, loaded as dtype to. A converting load reads
+ * LOAD_BLOCK values at a time and converts them straight into the value
+ * arrays, which are never held in the stored dtype.
+ */
+static
+void
+_load_values(qg8_tensor *t,
+             size_t dsize,
+             uint8_t to,
+             FILE *f,
+             qg8_iter *iter)
+{
+	uint8_t *buf, *dst;
+	uint64_t i, m, n;
+	size_t tsize;
+	int p, parts;
+
+	n = t->num_elems;
+	parts = _tensor_is_complex(t) ? 2 : 1;
+	tsize = _type_to_size(to);
+	buf = NULL;
+	if (to != t->dtype_id)
+	{
+		buf = (uint8_t *) malloc(dsize * LOAD_BLOCK);
+		ALLOC(buf);
+	}
+	for (p = 0; p < parts; ++p)
+	{
+		dst = (uint8_t *) malloc(MAX(tsize * n, 1));
+		ALLOC(dst);
+		if (p == 0)
+			t->redata = dst;
+		else
+			t->imdata = dst;
+		if (!buf)
+		{
+			READNN(dst, dsize, n, f);
+			continue;
+		}
+		for (i = 0; i < n; i += m)
+		{
+			m = MIN(LOAD_BLOCK, n - i);
+			READNN(buf, dsize, m, f);
+			_convert_values(buf, t->dtype_id, m, dst + tsize * i, to);
+		}
+	}
+	free(buf);
+	iter->offset += dsize * n * parts;
+	t->dtype_id = to;
+}
+
+/* chunk types whose tensors hold values rather than structure */
+static
+int
+_is_value_chunk(uint16_t type)
+{
+	return type == QG8_TYPE_INPUT || type == QG8_TYPE_CONSTANT ||
+	       type == QG8_TYPE_KET || type == QG8_TYPE_OPERATOR ||
+	       type == QG8_TYPE_OBSERVABLE || type == QG8_TYPE_NOISESPEC;
+}
+
 qg8_iter
 qg8_file_iterator(qg8_file *qg8f)
 {
@@ -155,12 +271,28 @@ qg8_file_next(qg8_iter *i)
 
 qg8_chunk *
 qg8_file_extract(qg8_iter *iter)
+{
+	return qg8_file_extract_as(iter, 0);
+}
+
+/*
+ * Extracts the next chunk with its values converted, while they are read,
+ * to the precision of the floating dtype dtype_id: FLOAT32 loads real data
+ * as FLOAT32 and complex data as COMPLEX64, whatever dtype they were
+ * stored in. Only INPUT, CONSTANT, KET, OPERATOR, OBSERVABLE and NOISESPEC
+ * chunks hold values; the others, such as the adjacency matrix or a
+ * PERMUTATION, keep their stored dtype, as every chunk does for a
+ * dtype_id of 0.
+ */
+qg8_chunk *
+qg8_file_extract_as(qg8_iter *iter,
+                    uint8_t dtype_id)
 {
 	qg8_chunk *chunk;
 	qg8_tensor *t;
 	uint16_t u16;
-	uint8_t u8buf[16], tmp;
-	uint64_t u64;
+	uint8_t u8buf[16], tmp, to;
+	uint64_t u64, n, data, head, vlen;
 	size_t i, dsize;
 
 	/* return nothing on no iterator */
@@ -173,6 +305,10 @@ qg8_file_extract(qg8_iter *iter)
 	{
 		DIE("Cannot iterate over file open in write mode.\n");
 	}
+	if (dtype_id && !_convert_dtype(QG8_DTYPE_FLOAT64, dtype_id))
+	{
+		DIE("Cannot load chunk values as a non floating dtype.\n");
+	}
 
 	fseek(iter->f->fp, iter->offset, SEEK_SET);
 	if (feof(iter->f->fp))
@@ -182,6 +318,7 @@ qg8_file_extract(qg8_iter *iter)
 	chunk = (qg8_chunk *) malloc(sizeof(qg8_chunk));
 	ALLOC(chunk);
 	chunk->tensor = NULL;
+	chunk->index_encoding = QG8_INDEX_PLAIN;
 	/* chunk header */
 	READ(&chunk->type, chunk->type, iter->f->fp);
 	READ(&chunk->flags, chunk->flags, iter->f->fp);
@@ -202,20 +339,28 @@ qg8_file_extract(qg8_iter *iter)
 	{
 		memset(chunk->string_id, 0, 16);
 	}
-	READN(u8buf, 5, iter->f->fp);
+	READ(&chunk->compression, chunk->compression, iter->f->fp);
+	READN(u8buf, 4, iter->f->fp);
 	READ(&u64, u64, iter->f->fp);
 #ifdef DEBUG
 	printf("skip: %lu\n", u64);
 #endif /* DEBUG */
-	/* type (u16), reserved + flags (6), skip (u64) */
+	if (chunk->compression != QG8_COMPRESS_NONE &&
+	    chunk->compression != QG8_COMPRESS_SHUFFLE_LZ)
+	{
+		DIE("Received unknown chunk compression.\n");
+	}
+	/* type (u16), flags (1), compression + reserved (5), skip (u64) */
 	iter->offset += sizeof(u16) + 1 + 5 + sizeof(u64);
 	/* if skip is 0, there's no tensor because the chunk is done */
 	if (u64 > 0)
 	{
 		/* tensor header */
 		t = (qg8_tensor *) malloc(sizeof(qg8_tensor));
-		t->loaded = 1;
 		ALLOC(t);
+		t->loaded = 1;
+		t->csr = NULL;
+		t->order = NULL;
 		READ(&t->packing, t->packing, iter->f->fp);
 		READ(&t->itype_id, t->itype_id, iter->f->fp);
 		READ(&t->dtype_id, t->dtype_id, iter->f->fp);
@@ -229,7 +374,8 @@ qg8_file_extract(qg8_iter *iter)
 #endif /* DEBUG */
 		iter->offset += sizeof(t->packing) + sizeof(t->itype_id) +
 		                sizeof(t->dtype_id) + sizeof(t->rank);
-		READN(u8buf, 3, iter->f->fp);
+		READ(&t->flags, t->flags, iter->f->fp);
+		READN(u8buf, 2, iter->f->fp);
 		iter->offset += 3;
 		t->dimensions = (uint64_t *) malloc(sizeof(uint64_t) * t->rank);
 		ALLOC(t->dimensions);
@@ -250,8 +396,13 @@ qg8_file_extract(qg8_iter *iter)
 		printf("num_elems: %lu\n", t->num_elems);
 #endif /* DEBUG */
 		iter->offset += sizeof(t->num_elems);
+		vlen = 0;
+		if (chunk->compression != QG8_COMPRESS_NONE)
+		{
+			READ(&vlen, vlen, iter->f->fp);
+			iter->offset += sizeof(vlen);
+		}
 		/* tensor data */
-		_load_indices(t, iter->f->fp, iter);
 		t->redata = NULL;
 		t->imdata = NULL;
 		switch (t->dtype_id)
@@ -268,6 +419,10 @@ qg8_file_extract(qg8_iter *iter)
 			dsize = sizeof(uint8_t);
 			break;
 		case QG8_DTYPE_UINT16:
+		case QG8_DTYPE_FLOAT16:
+		case QG8_DTYPE_BFLOAT16:
+		case QG8_DTYPE_COMPLEX32:
+		case QG8_DTYPE_BCOMPLEX32:
 			dsize = sizeof(uint16_t);
 			break;
 		case QG8_DTYPE_UINT32:
@@ -290,28 +445,72 @@ qg8_file_extract(qg8_iter *iter)
 			break;
 		default:
 			/* error on any other dtype_id */
+			fprintf(stderr,
+			        "Received unrecognised dtype_id %d for chunk tensor data.\n"
+			        , t->dtype_id);
 			free(t->indices);
 			free(t->dimensions);
 			free(t);
 			free(chunk);
-			fprintf(stderr,
-			        "Received unrecognised dtype_id %d for chunk tensor data.\n"
-			        , t->dtype_id);
 			exit(EXIT_FAILURE);
 		}
-		t->redata = malloc(dsize * t->num_elems);
-		ALLOC(t->redata);
-		READNN(t->redata, dsize, t->num_elems, iter->f->fp);
-		iter->offset += dsize * t->num_elems;
-		if (t->dtype_id == QG8_DTYPE_COMPLEX64 ||
-		    t->dtype_id == QG8_DTYPE_COMPLEX128)
+		to = t->dtype_id;
+		if (dtype_id && _is_value_chunk(chunk->type))
+			to = _convert_dtype(t->dtype_id, dtype_id);
+		n = t->num_elems;
+		data = dsize * t->num_elems * (_tensor_is_complex(t) ? 2 : 1);
+		if (chunk->compression != QG8_COMPRESS_NONE)
+			data = sizeof(uint64_t) + vlen;
+		if (u64 < data)
+		{
+			DIE("Chunk size does not match its tensor.\n");
+		}
+		/* the writer only flattens coordinates, see _linear_view */
+		if ((t->flags & QG8_TENSOR_LINEAR_INDEX) &&
+		    (_tensor_is_packed(t) ||
+		     t->packing == QG8_PACKING_HALF_HERMITIAN))
+		{
+			DIE("Linear indices do not match their packing.\n");
+		}
+		if (t->packing == QG8_PACKING_DIA || t->packing == QG8_PACKING_BSR)
 		{
-			/* also do imaginary part for complex numbers */
-			t->imdata = malloc(dsize * t->num_elems);
-			ALLOC(t->imdata);
-			READNN(t->imdata, dsize, t->num_elems, iter->f->fp);
-			iter->offset += dsize * t->num_elems;
+			/* the index arrays fill what the data leaves of the chunk */
+			head = sizeof(qg8_tensor_header) + tmp * t->rank;
+			if (t->rank == 0 || u64 < head + data ||
+			    (u64 - head - data) % (tmp * t->rank) != 0)
+			{
+				DIE("Chunk size does not match its tensor.\n");
+			}
+			n = (u64 - head - data) / (tmp * t->rank);
 		}
+		if (t->flags & QG8_TENSOR_PACKED_INDEX)
+		{
+			/* the packed indices fill what the data leaves */
+			head = sizeof(qg8_tensor_header) + tmp * t->rank +
+			       sizeof(uint64_t);
+			if (_tensor_is_packed(t) || u64 < head + data)
+			{
+				DIE("Packed indices do not match their chunk.\n");
+			}
+			t->flags &= ~QG8_TENSOR_PACKED_INDEX;
+			_load_packed(t, n, u64 - head - data, iter->f->fp, iter);
+		}
+		else
+		{
+			_load_indices(t, n, iter->f->fp, iter);
+		}
+		if (t->flags & QG8_TENSOR_LINEAR_INDEX)
+		{
+			_linear_unflatten(t);
+			chunk->index_encoding = QG8_INDEX_LINEAR;
+		}
+		/* row compressed views trust the flag, a file may not */
+		if ((t->flags & QG8_TENSOR_SORTED) && !_canon_is_sorted(t))
+			t->flags &= ~QG8_TENSOR_SORTED;
+		if (chunk->compression != QG8_COMPRESS_NONE)
+			_load_compressed(t, vlen, dsize, to, iter->f->fp, iter);
+		else
+			_load_values(t, dsize, to, iter->f->fp, iter);
 		chunk->tensor = t;
 	}
 	else
@@ -0,0 +1,1431 @@
+/*
+ * kernel.c
+ * QG8 base library vector kernel source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Kernels work on the split (structure of arrays) layout of qg8_tensor data:
+ * a complex vector is a pair of real arrays, so every kernel streams whole
+ * SIMD registers of real parts and of imaginary parts without shuffling.
+ * Names follow BLAS: z is complex double, c complex float, d double and s
+ * float. The fastest instruction set of the running CPU is chosen on the
+ * first call, or forced with qg8_kernel_set_isa outside of parallel
+ * regions.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define QG8_X86 1
+#include <immintrin.h>
+#endif /* __x86_64__ || __i386__ */
+
+/* portable versions, also used for the tails of the vector versions */
+#define SCALAR_KERNELS(T,CP,RP) \
+static \
+void \
+_##CP##axpy_scalar(uint64_t n, T ar, T ai, const T *xr, const T *xi, \
+                   T *yr, T *yi) \
+{ \
+	uint64_t i; \
+	for (i = 0; i < n; ++i) \
+	{ \
+		*(yr+i) += ar * *(xr+i) - ai * *(xi+i); \
+		*(yi+i) += ar * *(xi+i) + ai * *(xr+i); \
+	} \
+} \
+static \
+void \
+_##RP##axpy_scalar(uint64_t n, T a, const T *x, T *y) \
+{ \
+	uint64_t i; \
+	for (i = 0; i < n; ++i) \
+		*(y+i) += a * *(x+i); \
+} \
+static \
+void \
+_##CP##scal_scalar(uint64_t n, T ar, T ai, T *xr, T *xi) \
+{ \
+	uint64_t i; \
+	T r; \
+	for (i = 0; i < n; ++i) \
+	{ \
+		r = ar * *(xr+i) - ai * *(xi+i); \
+		*(xi+i) = ar * *(xi+i) + ai * *(xr+i); \
+		*(xr+i) = r; \
+	} \
+} \
+static \
+void \
+_##RP##scal_scalar(uint64_t n, T a, T *x) \
+{ \
+	uint64_t i; \
+	for (i = 0; i < n; ++i) \
+		*(x+i) *= a; \
+} \
+static \
+void \
+_##CP##mul_scalar(uint64_t n, const T *xr, const T *xi, T *yr, T *yi) \
+{ \
+	uint64_t i; \
+	T r; \
+	for (i = 0; i < n; ++i) \
+	{ \
+		r = *(xr+i) * *(yr+i) - *(xi+i) * *(yi+i); \
+		*(yi+i) = *(xr+i) * *(yi+i) + *(xi+i) * *(yr+i); \
+		*(yr+i) = r; \
+	} \
+} \
+static \
+void \
+_##RP##mul_scalar(uint64_t n, const T *x, T *y) \
+{ \
+	uint64_t i; \
+	for (i = 0; i < n; ++i) \
+		*(y+i) *= *(x+i); \
+} \
+static \
+void \
+_##CP##conj_scalar(uint64_t n, T *xi) \
+{ \
+	uint64_t i; \
+	for (i = 0; i < n; ++i) \
+		*(xi+i) = -*(xi+i); \
+} \
+static \
+void \
+_##CP##dotc_scalar(uint64_t n, const T *xr, const T *xi, const T *yr, \
+                   const T *yi, double *re, double *im) \
+{ \
+	uint64_t i; \
+	double sr, si; \
+	sr = 0.0; \
+	si = 0.0; \
+	for (i = 0; i < n; ++i) \
+	{ \
+		sr += (double) *(xr+i) * *(yr+i) + (double) *(xi+i) * *(yi+i); \
+		si += (double) *(xr+i) * *(yi+i) - (double) *(xi+i) * *(yr+i); \
+	} \
+	*re = sr; \
+	*im = si; \
+} \
+static \
+double \
+_##RP##dot_scalar(uint64_t n, const T *x, const T *y) \
+{ \
+	uint64_t i; \
+	double s; \
+	s = 0.0; \
+	for (i = 0; i < n; ++i) \
+		s += (double) *(x+i) * *(y+i); \
+	return s; \
+} \
+static \
+double \
+_##CP##sqnrm_scalar(uint64_t n, const T *xr, const T *xi) \
+{ \
+	uint64_t i; \
+	double s; \
+	s = 0.0; \
+	for (i = 0; i < n; ++i) \
+		s += (double) *(xr+i) * *(xr+i) + (double) *(xi+i) * *(xi+i); \
+	return s; \
+} \
+static \
+void \
+_##RP##lassq_scalar(uint64_t n, const T *x, double *scale, double *ssq) \
+{ \
+	uint64_t i; \
+	double a; \
+	for (i = 0; i < n; ++i) \
+	{ \
+		a = fabs((double) *(x+i)); \
+		if (a == 0.0) \
+			continue; \
+		if (*scale < a) \
+		{ \
+			*ssq = 1.0 + *ssq * (*scale / a) * (*scale / a); \
+			*scale = a; \
+		} \
+		else \
+		{ \
+			*ssq += (a / *scale) * (a / *scale); \
+		} \
+	} \
+}
+
+SCALAR_KERNELS(double, z, d)
+SCALAR_KERNELS(float, c, s)
+
+/*
+ * Row dot products of a row compressed matrix with a dense split complex
+ * vector, over the entries e0..e1 of one row. Real matrices (im == NULL)
+ * skip the imaginary products.
+ */
+static
+void
+_zcsrrow_scalar(const qg8_csr *m, uint64_t e0, uint64_t e1,
+                const double *xr, const double *xi, double *sr, double *si)
+{
+	uint64_t e, c;
+	double ar, ai;
+
+	for (e = e0; e < e1; ++e)
+	{
+		c = *(m->colidx+e);
+		ar = *(m->re+e);
+		ai = m->im ? *(m->im+e) : 0.0;
+		*sr += ar * *(xr+c) - ai * *(xi+c);
+		*si += ar * *(xi+c) + ai * *(xr+c);
+	}
+}
+
+/* register tile of the dense product, kept in locals by the compiler */
+static
+void
+_dgemm_tile_scalar(uint64_t kc, const double *a, const double *b,
+                   double alpha, double *c, uint64_t ldc)
+{
+	double acc[GEMM_MR*GEMM_NR];
+	uint64_t p;
+	int i, j;
+
+	for (i = 0; i < GEMM_MR * GEMM_NR; ++i)
+		acc[i] = 0.0;
+	for (p = 0; p < kc; ++p, a += GEMM_MR, b += GEMM_NR)
+		for (i = 0; i < GEMM_MR; ++i)
+			for (j = 0; j < GEMM_NR; ++j)
+				acc[i*GEMM_NR+j] += a[i] * b[j];
+	for (i = 0; i < GEMM_MR; ++i)
+		for (j = 0; j < GEMM_NR; ++j)
+			*(c+i*ldc+j) += alpha * acc[i*GEMM_NR+j];
+}
+
+static
+void
+_zcsrmv_scalar(const qg8_csr *m, uint64_t r0, uint64_t r1,
+               const double *xr, const double *xi, double *yr, double *yi)
+{
+	uint64_t r;
+	double sr, si;
+
+	for (r = r0; r < r1; ++r)
+	{
+		sr = 0.0;
+		si = 0.0;
+		_zcsrrow_scalar(m, *(m->rowptr+r), *(m->rowptr+r+1), xr, xi,
+		                &sr, &si);
+		*(yr+r) = sr;
+		*(yi+r) = si;
+	}
+}
+
+/*
+ * n values of b bits packed least significant bit first from p, see
+ * codec.c. Whole bytes are gathered so any width up to 64 works.
+ */
+static
+void
+_unpack_scalar(const uint8_t *p, uint64_t n, int b, uint64_t *out)
+{
+	uint64_t i, bit, v, mask;
+	int got, sh;
+
+	mask = b == 64 ? UINT64_MAX : ((uint64_t) 1 << b) - 1;
+	for (i = 0; i < n; ++i)
+	{
+		if (b == 0)
+		{
+			*(out+i) = 0;
+			continue;
+		}
+		bit = i * b;
+		sh = (int) (bit & 7);
+		v = (uint64_t) *(p+(bit>>3)) >> sh;
+		for (got = 8 - sh; got < b; got += 8)
+			v |= (uint64_t) *(p+(bit>>3)+(got+sh)/8) << got;
+		*(out+i) = v & mask;
+	}
+}
+
+/*
+ * IEEE half precision and bfloat16 to and from float, rounding to nearest
+ * even as the F16C instructions do. NaNs stay NaNs, quietened.
+ */
+float
+_half_to_float(uint16_t h)
+{
+	uint32_t x, exp, mant;
+	float f;
+
+	x = (uint32_t) (h & 0x8000) << 16;
+	exp = (h >> 10) & 0x1f;
+	mant = h & 0x3ff;
+	if (exp == 0x1f)
+	{
+		x |= 0x7f800000 | (mant << 13) | (mant ? 0x400000 : 0);
+	}
+	else if (exp != 0)
+	{
+		x |= ((exp + 112) << 23) | (mant << 13);
+	}
+	else if (mant != 0)
+	{
+		/* subnormal, normalised as a float */
+		for (exp = 113; !(mant & 0x400); --exp)
+			mant <<= 1;
+		x |= (exp << 23) | ((mant & 0x3ff) << 13);
+	}
+	memcpy(&f, &x, sizeof(f));
+	return f;
+}
+
+uint16_t
+_float_to_half(float f)
+{
+	uint32_t x, sign, mant, rem, half;
+	int32_t exp;
+	uint16_t h;
+	int shift;
+
+	memcpy(&x, &f, sizeof(x));
+	sign = (x >> 16) & 0x8000;
+	exp = (int32_t) ((x >> 23) & 0xff);
+	mant = x & 0x7fffff;
+	if (exp == 0xff)
+		return (uint16_t) (sign | 0x7c00 | (mant ? 0x200 | (mant >> 13) : 0));
+	exp -= 112;
+	if (exp >= 0x1f)
+		return (uint16_t) (sign | 0x7c00);
+	if (exp <= 0)
+	{
+		/* subnormal, or zero below half of the smallest one */
+		if (exp < -10)
+			return (uint16_t) sign;
+		mant |= 0x800000;
+		shift = 14 - exp;
+		h = (uint16_t) (mant >> shift);
+		rem = mant & (((uint32_t) 1 << shift) - 1);
+		half = (uint32_t) 1 << (shift - 1);
+		if (rem > half || (rem == half && (h & 1)))
+			++h;
+		return (uint16_t) (sign | h);
+	}
+	/* a carry out of the mantissa rounds up the exponent, up to infinity */
+	h = (uint16_t) (sign | ((uint32_t) exp << 10) | (mant >> 13));
+	rem = mant & 0x1fff;
+	if (rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+		++h;
+	return h;
+}
+
+float
+_bf16_to_float(uint16_t b)
+{
+	uint32_t x;
+	float f;
+
+	x = (uint32_t) b << 16;
+	memcpy(&f, &x, sizeof(f));
+	return f;
+}
+
+uint16_t
+_float_to_bf16(float f)
+{
+	uint32_t x;
+
+	memcpy(&x, &f, sizeof(x));
+	if ((x & 0x7fffffff) > 0x7f800000)
+		return (uint16_t) ((x >> 16) | 0x40);
+	x += 0x7fff + ((x >> 16) & 1);
+	return (uint16_t) (x >> 16);
+}
+
+/*
+ * Doubles rounded once to a 16 bit format of mbits mantissa and ebits
+ * exponent bits; through float they would round twice.
+ */
+static
+uint16_t
+_double_to_16(double d,
+              int mbits,
+              int ebits)
+{
+	uint64_t x, mant, rem, half;
+	uint32_t sign, top;
+	int32_t exp;
+	uint16_t h;
+	int shift;
+
+	memcpy(&x, &d, sizeof(x));
+	sign = (uint32_t) (x >> 48) & 0x8000;
+	exp = (int32_t) ((x >> 52) & 0x7ff);
+	mant = x & (((uint64_t) 1 << 52) - 1);
+	top = ((uint32_t) 1 << ebits) - 1;
+	if (exp == 0x7ff)
+		return (uint16_t) (sign | top << mbits |
+		                   (mant ? (uint32_t) 1 << (mbits - 1) |
+		                           (uint32_t) (mant >> (52 - mbits)) : 0));
+	exp -= 1023 - (int32_t) (top >> 1);
+	if (exp >= (int32_t) top)
+		return (uint16_t) (sign | top << mbits);
+	if (exp <= 0)
+	{
+		if (exp < -mbits)
+			return (uint16_t) sign;
+		mant |= (uint64_t) 1 << 52;
+		shift = 53 - mbits - exp;
+		h = (uint16_t) (mant >> shift);
+		rem = mant & (((uint64_t) 1 << shift) - 1);
+		half = (uint64_t) 1 << (shift - 1);
+		if (rem > half || (rem == half && (h & 1)))
+			++h;
+		return (uint16_t) (sign | h);
+	}
+	h = (uint16_t) (sign | (uint32_t) exp << mbits |
+	                (uint32_t) (mant >> (52 - mbits)));
+	rem = mant & (((uint64_t) 1 << (52 - mbits)) - 1);
+	half = (uint64_t) 1 << (51 - mbits);
+	if (rem > half || (rem == half && (h & 1)))
+		++h;
+	return h;
+}
+
+uint16_t
+_double_to_half(double d)
+{
+	return _double_to_16(d, 10, 5);
+}
+
+uint16_t
+_double_to_bf16(double d)
+{
+	return _double_to_16(d, 7, 8);
+}
+
+#define CONVERT_SCALAR(NAME,TI,TO,F) \
+static \
+void \
+_##NAME##_scalar(uint64_t n, const TI *x, TO *y) \
+{ \
+	uint64_t i; \
+	for (i = 0; i < n; ++i) \
+		*(y+i) = F(*(x+i)); \
+}
+
+CONVERT_SCALAR(h2s, uint16_t, float, _half_to_float)
+CONVERT_SCALAR(s2h, float, uint16_t, _float_to_half)
+CONVERT_SCALAR(b2s, uint16_t, float, _bf16_to_float)
+CONVERT_SCALAR(s2b, float, uint16_t, _float_to_bf16)
+
+#ifdef QG8_X86
+
+/*
+ * Vector versions, expanded once per instruction set and precision with the
+ * VT (register type), W (lanes) and V* (intrinsic) macros defined below.
+ * Reductions keep two accumulators per component to hide the FMA latency,
+ * in double precision as the portable versions do: AT (register type), AW
+ * (lanes) and the A* macros, with ALOAD widening single precision values.
+ */
+#define SIMD_KERNELS(ISA,TARGET,T,CP,RP) \
+__attribute__((target(TARGET))) \
+static \
+void \
+_##CP##axpy_##ISA(uint64_t n, T ar, T ai, const T *xr, const T *xi, \
+                  T *yr, T *yi) \
+{ \
+	VT var, vai, vxr, vxi, vyr, vyi; \
+	uint64_t i; \
+	var = VSET1(ar); \
+	vai = VSET1(ai); \
+	for (i = 0; i + W <= n; i += W) \
+	{ \
+		vxr = VLOAD(xr+i); \
+		vxi = VLOAD(xi+i); \
+		vyr = VFMADD(var, vxr, VLOAD(yr+i)); \
+		vyi = VFMADD(var, vxi, VLOAD(yi+i)); \
+		VSTORE(yr+i, VFNMADD(vai, vxi, vyr)); \
+		VSTORE(yi+i, VFMADD(vai, vxr, vyi)); \
+	} \
+	_##CP##axpy_scalar(n - i, ar, ai, xr+i, xi+i, yr+i, yi+i); \
+} \
+__attribute__((target(TARGET))) \
+static \
+void \
+_##RP##axpy_##ISA(uint64_t n, T a, const T *x, T *y) \
+{ \
+	VT va; \
+	uint64_t i; \
+	va = VSET1(a); \
+	for (i = 0; i + W <= n; i += W) \
+		VSTORE(y+i, VFMADD(va, VLOAD(x+i), VLOAD(y+i))); \
+	_##RP##axpy_scalar(n - i, a, x+i, y+i); \
+} \
+__attribute__((target(TARGET))) \
+static \
+void \
+_##CP##scal_##ISA(uint64_t n, T ar, T ai, T *xr, T *xi) \
+{ \
+	VT var, vai, vxr, vxi; \
+	uint64_t i; \
+	var = VSET1(ar); \
+	vai = VSET1(ai); \
+	for (i = 0; i + W <= n; i += W) \
+	{ \
+		vxr = VLOAD(xr+i); \
+		vxi = VLOAD(xi+i); \
+		VSTORE(xr+i, VFNMADD(vai, vxi, VMUL(var, vxr))); \
+		VSTORE(xi+i, VFMADD(vai, vxr, VMUL(var, vxi))); \
+	} \
+	_##CP##scal_scalar(n - i, ar, ai, xr+i, xi+i); \
+} \
+__attribute__((target(TARGET))) \
+static \
+void \
+_##RP##scal_##ISA(uint64_t n, T a, T *x) \
+{ \
+	VT va; \
+	uint64_t i; \
+	va = VSET1(a); \
+	for (i = 0; i + W <= n; i += W) \
+		VSTORE(x+i, VMUL(va, VLOAD(x+i))); \
+	_##RP##scal_scalar(n - i, a, x+i); \
+} \
+__attribute__((target(TARGET))) \
+static \
+void \
+_##CP##mul_##ISA(uint64_t n, const T *xr, const T *xi, T *yr, T *yi) \
+{ \
+	VT vxr, vxi, vyr, vyi; \
+	uint64_t i; \
+	for (i = 0; i + W <= n; i += W) \
+	{ \
+		vxr = VLOAD(xr+i); \
+		vxi = VLOAD(xi+i); \
+		vyr = VLOAD(yr+i); \
+		vyi = VLOAD(yi+i); \
+		VSTORE(yr+i, VFNMADD(vxi, vyi, VMUL(vxr, vyr))); \
+		VSTORE(yi+i, VFMADD(vxi, vyr, VMUL(vxr, vyi))); \
+	} \
+	_##CP##mul_scalar(n - i, xr+i, xi+i, yr+i, yi+i); \
+} \
+__attribute__((target(TARGET))) \
+static \
+void \
+_##RP##mul_##ISA(uint64_t n, const T *x, T *y) \
+{ \
+	uint64_t i; \
+	for (i = 0; i + W <= n; i += W) \
+		VSTORE(y+i, VMUL(VLOAD(x+i), VLOAD(y+i))); \
+	_##RP##mul_scalar(n - i, x+i, y+i); \
+} \
+__attribute__((target(TARGET))) \
+static \
+void \
+_##CP##conj_##ISA(uint64_t n, T *xi) \
+{ \
+	VT zero; \
+	uint64_t i; \
+	zero = VSET1(0); \
+	for (i = 0; i + W <= n; i += W) \
+		VSTORE(xi+i, VSUB(zero, VLOAD(xi+i))); \
+	_##CP##conj_scalar(n - i, xi+i); \
+} \
+__attribute__((target(TARGET))) \
+static \
+void \
+_##CP##dotc_##ISA(uint64_t n, const T *xr, const T *xi, const T *yr, \
+                  const T *yi, double *re, double *im) \
+{ \
+	AT sr0, sr1, si0, si1, vxr, vxi, vyr, vyi; \
+	double tr, ti; \
+	uint64_t i; \
+	sr0 = ASET1(0); \
+	sr1 = ASET1(0); \
+	si0 = ASET1(0); \
+	si1 = ASET1(0); \
+	for (i = 0; i + AW <= n; i += AW) \
+	{ \
+		vxr = ALOAD(xr+i); \
+		vxi = ALOAD(xi+i); \
+		vyr = ALOAD(yr+i); \
+		vyi = ALOAD(yi+i); \
+		sr0 = AFMADD(vxr, vyr, sr0); \
+		sr1 = AFMADD(vxi, vyi, sr1); \
+		si0 = AFMADD(vxr, vyi, si0); \
+		si1 = AFNMADD(vxi, vyr, si1); \
+	} \
+	_##CP##dotc_scalar(n - i, xr+i, xi+i, yr+i, yi+i, &tr, &ti); \
+	*re = AHSUM(AADD(sr0, sr1)) + tr; \
+	*im = AHSUM(AADD(si0, si1)) + ti; \
+} \
+__attribute__((target(TARGET))) \
+static \
+double \
+_##RP##dot_##ISA(uint64_t n, const T *x, const T *y) \
+{ \
+	AT s0, s1; \
+	uint64_t i; \
+	s0 = ASET1(0); \
+	s1 = ASET1(0); \
+	for (i = 0; i + 2 * AW <= n; i += 2 * AW) \
+	{ \
+		s0 = AFMADD(ALOAD(x+i), ALOAD(y+i), s0); \
+		s1 = AFMADD(ALOAD(x+i+AW), ALOAD(y+i+AW), s1); \
+	} \
+	return AHSUM(AADD(s0, s1)) + _##RP##dot_scalar(n - i, x+i, y+i); \
+} \
+__attribute__((target(TARGET))) \
+static \
+double \
+_##CP##sqnrm_##ISA(uint64_t n, const T *xr, const T *xi) \
+{ \
+	AT s0, s1, vxr, vxi; \
+	uint64_t i; \
+	s0 = ASET1(0); \
+	s1 = ASET1(0); \
+	for (i = 0; i + AW <= n; i += AW) \
+	{ \
+		vxr = ALOAD(xr+i); \
+		vxi = ALOAD(xi+i); \
+		s0 = AFMADD(vxr, vxr, s0); \
+		s1 = AFMADD(vxi, vxi, s1); \
+	} \
+	return AHSUM(AADD(s0, s1)) + _##CP##sqnrm_scalar(n - i, xr+i, xi+i); \
+}
+
+__attribute__((target("avx2,fma")))
+static
+double
+_hsum_avx2_pd(__m256d v)
+{
+	__m128d s;
+	s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+#define VT      __m256d
+#define W       4
+#define VLOAD   _mm256_loadu_pd
+#define VSTORE  _mm256_storeu_pd
+#define VSET1   _mm256_set1_pd
+#define VADD    _mm256_add_pd
+#define VSUB    _mm256_sub_pd
+#define VMUL    _mm256_mul_pd
+#define VFMADD  _mm256_fmadd_pd
+#define VFNMADD _mm256_fnmadd_pd
+#define AT      __m256d
+#define AW      4
+#define ALOAD   _mm256_loadu_pd
+#define ASET1   _mm256_set1_pd
+#define AADD    _mm256_add_pd
+#define AFMADD  _mm256_fmadd_pd
+#define AFNMADD _mm256_fnmadd_pd
+#define AHSUM   _hsum_avx2_pd
+SIMD_KERNELS(avx2, "avx2,fma", double, z, d)
+#undef VT
+#undef W
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VFMADD
+#undef VFNMADD
+#undef AT
+#undef AW
+#undef ALOAD
+#undef ASET1
+#undef AADD
+#undef AFMADD
+#undef AFNMADD
+#undef AHSUM
+
+#define VT      __m256
+#define W       8
+#define VLOAD   _mm256_loadu_ps
+#define VSTORE  _mm256_storeu_ps
+#define VSET1   _mm256_set1_ps
+#define VADD    _mm256_add_ps
+#define VSUB    _mm256_sub_ps
+#define VMUL    _mm256_mul_ps
+#define VFMADD  _mm256_fmadd_ps
+#define VFNMADD _mm256_fnmadd_ps
+#define AT      __m256d
+#define AW      4
+#define ALOAD(p) _mm256_cvtps_pd(_mm_loadu_ps(p))
+#define ASET1   _mm256_set1_pd
+#define AADD    _mm256_add_pd
+#define AFMADD  _mm256_fmadd_pd
+#define AFNMADD _mm256_fnmadd_pd
+#define AHSUM   _hsum_avx2_pd
+SIMD_KERNELS(avx2, "avx2,fma", float, c, s)
+#undef VT
+#undef W
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VFMADD
+#undef VFNMADD
+#undef AT
+#undef AW
+#undef ALOAD
+#undef ASET1
+#undef AADD
+#undef AFMADD
+#undef AFNMADD
+#undef AHSUM
+
+#define VT      __m512d
+#define W       8
+#define VLOAD   _mm512_loadu_pd
+#define VSTORE  _mm512_storeu_pd
+#define VSET1   _mm512_set1_pd
+#define VADD    _mm512_add_pd
+#define VSUB    _mm512_sub_pd
+#define VMUL    _mm512_mul_pd
+#define VFMADD  _mm512_fmadd_pd
+#define VFNMADD _mm512_fnmadd_pd
+#define AT      __m512d
+#define AW      8
+#define ALOAD   _mm512_loadu_pd
+#define ASET1   _mm512_set1_pd
+#define AADD    _mm512_add_pd
+#define AFMADD  _mm512_fmadd_pd
+#define AFNMADD _mm512_fnmadd_pd
+#define AHSUM   _mm512_reduce_add_pd
+SIMD_KERNELS(avx512, "avx512f", double, z, d)
+#undef VT
+#undef W
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VFMADD
+#undef VFNMADD
+#undef AT
+#undef AW
+#undef ALOAD
+#undef ASET1
+#undef AADD
+#undef AFMADD
+#undef AFNMADD
+#undef AHSUM
+
+#define VT      __m512
+#define W       16
+#define VLOAD   _mm512_loadu_ps
+#define VSTORE  _mm512_storeu_ps
+#define VSET1   _mm512_set1_ps
+#define VADD    _mm512_add_ps
+#define VSUB    _mm512_sub_ps
+#define VMUL    _mm512_mul_ps
+#define VFMADD  _mm512_fmadd_ps
+#define VFNMADD _mm512_fnmadd_ps
+#define AT      __m512d
+#define AW      8
+#define ALOAD(p) _mm512_cvtps_pd(_mm256_loadu_ps(p))
+#define ASET1   _mm512_set1_pd
+#define AADD    _mm512_add_pd
+#define AFMADD  _mm512_fmadd_pd
+#define AFNMADD _mm512_fnmadd_pd
+#define AHSUM   _mm512_reduce_add_pd
+SIMD_KERNELS(avx512, "avx512f", float, c, s)
+#undef VT
+#undef W
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VFMADD
+#undef VFNMADD
+#undef AT
+#undef AW
+#undef ALOAD
+#undef ASET1
+#undef AADD
+#undef AFMADD
+#undef AFNMADD
+#undef AHSUM
+
+/*
+ * Sparse rows gather the vector entries by column index. The indices are
+ * 64 bit, which matches the gather instructions for doubles directly.
+ */
+#define CSRMV_KERNEL(ISA,TARGET) \
+__attribute__((target(TARGET))) \
+static \
+void \
+_zcsrmv_##ISA(const qg8_csr *m, uint64_t r0, uint64_t r1, \
+              const double *xr, const double *xi, double *yr, double *yi) \
+{ \
+	uint64_t r, e, e1; \
+	VT sr, si, ar, ai, vr, vi; \
+	VI c; \
+	double hr, hi; \
+	for (r = r0; r < r1; ++r) \
+	{ \
+		e = *(m->rowptr+r); \
+		e1 = *(m->rowptr+r+1); \
+		sr = VSET1(0.0); \
+		si = VSET1(0.0); \
+		if (m->im) \
+		{ \
+			for (; e + W <= e1; e += W) \
+			{ \
+				c = VILOAD(m->colidx+e); \
+				vr = VGATHER(xr, c); \
+				vi = VGATHER(xi, c); \
+				ar = VLOAD(m->re+e); \
+				ai = VLOAD(m->im+e); \
+				sr = VFMADD(ar, vr, sr); \
+				sr = VFNMADD(ai, vi, sr); \
+				si = VFMADD(ar, vi, si); \
+				si = VFMADD(ai, vr, si); \
+			} \
+		} \
+		else \
+		{ \
+			for (; e + W <= e1; e += W) \
+			{ \
+				c = VILOAD(m->colidx+e); \
+				ar = VLOAD(m->re+e); \
+				sr = VFMADD(ar, VGATHER(xr, c), sr); \
+				si = VFMADD(ar, VGATHER(xi, c), si); \
+			} \
+		} \
+		hr = VHSUM(sr); \
+		hi = VHSUM(si); \
+		_zcsrrow_scalar(m, e, e1, xr, xi, &hr, &hi); \
+		*(yr+r) = hr; \
+		*(yi+r) = hi; \
+	} \
+}
+
+#define VT      __m256d
+#define VI      __m256i
+#define W       4
+#define VLOAD   _mm256_loadu_pd
+#define VILOAD(p) _mm256_loadu_si256((const __m256i *) (p))
+#define VGATHER(b,c) _mm256_i64gather_pd(b, c, 8)
+#define VSET1   _mm256_set1_pd
+#define VFMADD  _mm256_fmadd_pd
+#define VFNMADD _mm256_fnmadd_pd
+#define VHSUM   _hsum_avx2_pd
+CSRMV_KERNEL(avx2, "avx2,fma")
+#undef VT
+#undef VI
+#undef W
+#undef VLOAD
+#undef VILOAD
+#undef VGATHER
+#undef VSET1
+#undef VFMADD
+#undef VFNMADD
+#undef VHSUM
+
+#define VT      __m512d
+#define VI      __m512i
+#define W       8
+#define VLOAD   _mm512_loadu_pd
+#define VILOAD(p) _mm512_loadu_si512((const void *) (p))
+#define VGATHER(b,c) _mm512_i64gather_pd(c, b, 8)
+#define VSET1   _mm512_set1_pd
+#define VFMADD  _mm512_fmadd_pd
+#define VFNMADD _mm512_fnmadd_pd
+#define VHSUM   _mm512_reduce_add_pd
+CSRMV_KERNEL(avx512, "avx512f")
+#undef VT
+#undef VI
+#undef W
+#undef VLOAD
+#undef VILOAD
+#undef VGATHER
+#undef VSET1
+#undef VFMADD
+#undef VFNMADD
+#undef VHSUM
+
+/*
+ * 4x8 tile held in eight ymm accumulators: each step broadcasts one element
+ * of the a panel and multiplies it with two registers of the b panel. The
+ * AVX-512 dispatch uses this tile too, the 8 wide rows of b already fit.
+ */
+__attribute__((target("avx2,fma")))
+static
+void
+_dgemm_tile_avx2(uint64_t kc, const double *a, const double *b,
+                 double alpha, double *c, uint64_t ldc)
+{
+	__m256d c00, c01, c10, c11, c20, c21, c30, c31, a0, b0, b1, va;
+	uint64_t p;
+
+	c00 = _mm256_setzero_pd();
+	c01 = _mm256_setzero_pd();
+	c10 = _mm256_setzero_pd();
+	c11 = _mm256_setzero_pd();
+	c20 = _mm256_setzero_pd();
+	c21 = _mm256_setzero_pd();
+	c30 = _mm256_setzero_pd();
+	c31 = _mm256_setzero_pd();
+	for (p = 0; p < kc; ++p, a += GEMM_MR, b += GEMM_NR)
+	{
+		b0 = _mm256_loadu_pd(b);
+		b1 = _mm256_loadu_pd(b+4);
+		a0 = _mm256_broadcast_sd(a);
+		c00 = _mm256_fmadd_pd(a0, b0, c00);
+		c01 = _mm256_fmadd_pd(a0, b1, c01);
+		a0 = _mm256_broadcast_sd(a+1);
+		c10 = _mm256_fmadd_pd(a0, b0, c10);
+		c11 = _mm256_fmadd_pd(a0, b1, c11);
+		a0 = _mm256_broadcast_sd(a+2);
+		c20 = _mm256_fmadd_pd(a0, b0, c20);
+		c21 = _mm256_fmadd_pd(a0, b1, c21);
+		a0 = _mm256_broadcast_sd(a+3);
+		c30 = _mm256_fmadd_pd(a0, b0, c30);
+		c31 = _mm256_fmadd_pd(a0, b1, c31);
+	}
+	va = _mm256_set1_pd(alpha);
+	_mm256_storeu_pd(c, _mm256_fmadd_pd(va, c00, _mm256_loadu_pd(c)));
+	_mm256_storeu_pd(c+4, _mm256_fmadd_pd(va, c01, _mm256_loadu_pd(c+4)));
+	c += ldc;
+	_mm256_storeu_pd(c, _mm256_fmadd_pd(va, c10, _mm256_loadu_pd(c)));
+	_mm256_storeu_pd(c+4, _mm256_fmadd_pd(va, c11, _mm256_loadu_pd(c+4)));
+	c += ldc;
+	_mm256_storeu_pd(c, _mm256_fmadd_pd(va, c20, _mm256_loadu_pd(c)));
+	_mm256_storeu_pd(c+4, _mm256_fmadd_pd(va, c21, _mm256_loadu_pd(c+4)));
+	c += ldc;
+	_mm256_storeu_pd(c, _mm256_fmadd_pd(va, c30, _mm256_loadu_pd(c)));
+	_mm256_storeu_pd(c+4, _mm256_fmadd_pd(va, c31, _mm256_loadu_pd(c+4)));
+}
+
+/*
+ * Four values per step: each lane loads the 8 bytes holding its value with
+ * one gather at byte offsets and shifts it down, which holds the whole
+ * value for widths up to 57 bits. Reads up to 8 bytes past the last value.
+ */
+__attribute__((target("avx2")))
+static
+void
+_unpack_avx2(const uint8_t *p, uint64_t n, int b, uint64_t *out)
+{
+	__m256i bits, step, seven, mask, v;
+	uint64_t i;
+
+	if (b == 0 || b > 57)
+	{
+		_unpack_scalar(p, n, b, out);
+		return;
+	}
+	bits = _mm256_set_epi64x(3 * b, 2 * b, b, 0);
+	step = _mm256_set1_epi64x(4 * b);
+	seven = _mm256_set1_epi64x(7);
+	mask = _mm256_set1_epi64x(((uint64_t) 1 << b) - 1);
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		v = _mm256_i64gather_epi64((const void *) p,
+		                           _mm256_srli_epi64(bits, 3), 1);
+		v = _mm256_srlv_epi64(v, _mm256_and_si256(bits, seven));
+		_mm256_storeu_si256((__m256i *) (out+i), _mm256_and_si256(v, mask));
+		bits = _mm256_add_epi64(bits, step);
+	}
+	/* restart the tail on a whole byte, rewriting at most 4 values */
+	i &= ~(uint64_t) 7;
+	_unpack_scalar(p + i * b / 8, n - i, b, out + i);
+}
+
+/* eight halves per step, with the F16C conversions */
+__attribute__((target("avx2,f16c")))
+static
+void
+_h2s_avx2(uint64_t n, const uint16_t *x, float *y)
+{
+	uint64_t i;
+
+	for (i = 0; i + 8 <= n; i += 8)
+		_mm256_storeu_ps(y+i, _mm256_cvtph_ps(
+		                 _mm_loadu_si128((const __m128i *) (x+i))));
+	_h2s_scalar(n - i, x + i, y + i);
+}
+
+__attribute__((target("avx2,f16c")))
+static
+void
+_s2h_avx2(uint64_t n, const float *x, uint16_t *y)
+{
+	uint64_t i;
+
+	for (i = 0; i + 8 <= n; i += 8)
+		_mm_storeu_si128((__m128i *) (y+i),
+		                 _mm256_cvtps_ph(_mm256_loadu_ps(x+i),
+		                                 _MM_FROUND_TO_NEAREST_INT));
+	_s2h_scalar(n - i, x + i, y + i);
+}
+
+/* bfloat16 is the upper half of a float, widened by a shift */
+__attribute__((target("avx2")))
+static
+void
+_b2s_avx2(uint64_t n, const uint16_t *x, float *y)
+{
+	__m256i v;
+	uint64_t i;
+
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		v = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) (x+i)));
+		_mm256_storeu_si256((__m256i *) (y+i), _mm256_slli_epi32(v, 16));
+	}
+	_b2s_scalar(n - i, x + i, y + i);
+}
+
+/* as _float_to_bf16, eight lanes at a time */
+__attribute__((target("avx2")))
+static
+void
+_s2b_avx2(uint64_t n, const float *x, uint16_t *y)
+{
+	__m256i v, r, nan, one, bias, quiet;
+	__m256 f;
+	uint64_t i;
+
+	one = _mm256_set1_epi32(1);
+	bias = _mm256_set1_epi32(0x7fff);
+	quiet = _mm256_set1_epi32(0x40);
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		f = _mm256_loadu_ps(x+i);
+		v = _mm256_castps_si256(f);
+		nan = _mm256_castps_si256(_mm256_cmp_ps(f, f, _CMP_UNORD_Q));
+		r = _mm256_and_si256(_mm256_srli_epi32(v, 16), one);
+		r = _mm256_srli_epi32(_mm256_add_epi32(v, _mm256_add_epi32(r, bias)),
+		                      16);
+		r = _mm256_blendv_epi8(r, _mm256_or_si256(_mm256_srli_epi32(v, 16),
+		                                          quiet), nan);
+		/* the packing works per 128 bit lane, gather both in the low one */
+		r = _mm256_permute4x64_epi64(_mm256_packus_epi32(r, r), 0x08);
+		_mm_storeu_si128((__m128i *) (y+i), _mm256_castsi256_si128(r));
+	}
+	_s2b_scalar(n - i, x + i, y + i);
+}
+
+__attribute__((target("avx512f")))
+static
+void
+_h2s_avx512(uint64_t n, const uint16_t *x, float *y)
+{
+	uint64_t i;
+
+	for (i = 0; i + 16 <= n; i += 16)
+		_mm512_storeu_ps(y+i, _mm512_cvtph_ps(
+		                 _mm256_loadu_si256((const __m256i *) (x+i))));
+	_h2s_scalar(n - i, x + i, y + i);
+}
+
+__attribute__((target("avx512f")))
+static
+void
+_s2h_avx512(uint64_t n, const float *x, uint16_t *y)
+{
+	uint64_t i;
+
+	for (i = 0; i + 16 <= n; i += 16)
+		_mm256_storeu_si256((__m256i *) (y+i),
+		                    _mm512_cvtps_ph(_mm512_loadu_ps(x+i),
+		                                    _MM_FROUND_TO_NEAREST_INT));
+	_s2h_scalar(n - i, x + i, y + i);
+}
+
+#endif /* QG8_X86 */
+
+/* dispatch table, filled on first use */
+#define KERNEL_POINTERS(T,CP,RP) \
+static void (*_##CP##axpy)(uint64_t, T, T, const T *, const T *, T *, T *); \
+static void (*_##RP##axpy)(uint64_t, T, const T *, T *); \
+static void (*_##CP##scal)(uint64_t, T, T, T *, T *); \
+static void (*_##RP##scal)(uint64_t, T, T *); \
+static void (*_##CP##mul)(uint64_t, const T *, const T *, T *, T *); \
+static void (*_##RP##mul)(uint64_t, const T *, T *); \
+static void (*_##CP##conj)(uint64_t, T *); \
+static void (*_##CP##dotc)(uint64_t, const T *, const T *, const T *, \
+                           const T *, double *, double *); \
+static double (*_##RP##dot)(uint64_t, const T *, const T *); \
+static double (*_##CP##sqnrm)(uint64_t, const T *, const T *);
+
+KERNEL_POINTERS(double, z, d)
+KERNEL_POINTERS(float, c, s)
+static void (*_zcsrmv)(const qg8_csr *, uint64_t, uint64_t, const double *,
+                       const double *, double *, double *);
+static qg8_gemm_tile _dgemm_tile;
+static void (*_unpack)(const uint8_t *, uint64_t, int, uint64_t *);
+static void (*_h2s)(uint64_t, const uint16_t *, float *);
+static void (*_s2h)(uint64_t, const float *, uint16_t *);
+static void (*_b2s)(uint64_t, const uint16_t *, float *);
+static void (*_s2b)(uint64_t, const float *, uint16_t *);
+
+#define KERNEL_SELECT(ISA,CP,RP) \
+	_##CP##axpy = _##CP##axpy_##ISA; \
+	_##RP##axpy = _##RP##axpy_##ISA; \
+	_##CP##scal = _##CP##scal_##ISA; \
+	_##RP##scal = _##RP##scal_##ISA; \
+	_##CP##mul = _##CP##mul_##ISA; \
+	_##RP##mul = _##RP##mul_##ISA; \
+	_##CP##conj = _##CP##conj_##ISA; \
+	_##CP##dotc = _##CP##dotc_##ISA; \
+	_##RP##dot = _##RP##dot_##ISA; \
+	_##CP##sqnrm = _##CP##sqnrm_##ISA;
+
+static int _isa = 0;
+
+static
+int
+_isa_supported(int isa)
+{
+	switch (isa)
+	{
+	case QG8_ISA_SCALAR:
+		return 1;
+#ifdef QG8_X86
+	case QG8_ISA_AVX2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") &&
+		       __builtin_cpu_supports("fma") &&
+		       __builtin_cpu_supports("f16c");
+	case QG8_ISA_AVX512:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx512f");
+#endif /* QG8_X86 */
+	default:
+		return 0;
+	}
+}
+
+static
+void
+_select(int isa)
+{
+	switch (isa)
+	{
+#ifdef QG8_X86
+	case QG8_ISA_AVX512:
+		KERNEL_SELECT(avx512, z, d)
+		KERNEL_SELECT(avx512, c, s)
+		_zcsrmv = _zcsrmv_avx512;
+		_dgemm_tile = _dgemm_tile_avx2;
+		_unpack = _unpack_avx2;
+		_h2s = _h2s_avx512;
+		_s2h = _s2h_avx512;
+		_b2s = _b2s_avx2;
+		_s2b = _s2b_avx2;
+		break;
+	case QG8_ISA_AVX2:
+		KERNEL_SELECT(avx2, z, d)
+		KERNEL_SELECT(avx2, c, s)
+		_zcsrmv = _zcsrmv_avx2;
+		_dgemm_tile = _dgemm_tile_avx2;
+		_unpack = _unpack_avx2;
+		_h2s = _h2s_avx2;
+		_s2h = _s2h_avx2;
+		_b2s = _b2s_avx2;
+		_s2b = _s2b_avx2;
+		break;
+#endif /* QG8_X86 */
+	default:
+		KERNEL_SELECT(scalar, z, d)
+		KERNEL_SELECT(scalar, c, s)
+		_zcsrmv = _zcsrmv_scalar;
+		_dgemm_tile = _dgemm_tile_scalar;
+		_unpack = _unpack_scalar;
+		_h2s = _h2s_scalar;
+		_s2h = _s2h_scalar;
+		_b2s = _b2s_scalar;
+		_s2b = _s2b_scalar;
+		isa = QG8_ISA_SCALAR;
+		break;
+	}
+	/* the table is complete before _isa says so */
+#ifdef _OPENMP
+#pragma omp flush
+#endif /* _OPENMP */
+	_isa = isa;
+}
+
+/*
+ * Threads calling a kernel first at the same time select one after the
+ * other. The library resolves the table with qg8_kernel_get_isa before its
+ * own parallel regions, so their threads only ever read it.
+ */
+static
+void
+_kernel_init(void)
+{
+	if (_isa)
+		return;
+#ifdef _OPENMP
+#pragma omp critical (qg8_kernel_select)
+#endif /* _OPENMP */
+	{
+		if (!_isa)
+		{
+			if (_isa_supported(QG8_ISA_AVX512))
+				_select(QG8_ISA_AVX512);
+			else if (_isa_supported(QG8_ISA_AVX2))
+				_select(QG8_ISA_AVX2);
+			else
+				_select(QG8_ISA_SCALAR);
+		}
+	}
+}
+
+int
+qg8_kernel_get_isa(void)
+{
+	_kernel_init();
+	return _isa;
+}
+
+/*
+ * Forces an instruction set, mostly useful to compare the vector paths with
+ * the portable one. Returns 0 if the CPU does not support it.
+ */
+int
+qg8_kernel_set_isa(int isa)
+{
+	if (!_isa_supported(isa))
+		return 0;
+#ifdef _OPENMP
+#pragma omp critical (qg8_kernel_select)
+#endif /* _OPENMP */
+	_select(isa);
+	return 1;
+}
+
+/*
+ * Norms take the plain sum of squares unless it overflowed or is small
+ * enough for underflowed squares to matter, in which case they are summed
+ * again scaled by the largest magnitude, as LAPACK's dlassq does.
+ */
+#define NRM2_TINY (DBL_MIN / DBL_EPSILON)
+
+#define KERNEL_API(T,CP,RP) \
+void \
+qg8_kernel_##CP##axpy(uint64_t n, \
+                      T ar, \
+                      T ai, \
+                      const T *xr, \
+                      const T *xi, \
+                      T *yr, \
+                      T *yi) \
+{ \
+	_kernel_init(); \
+	_##CP##axpy(n, ar, ai, xr, xi, yr, yi); \
+} \
+void \
+qg8_kernel_##RP##axpy(uint64_t n, \
+                      T a, \
+                      const T *x, \
+                      T *y) \
+{ \
+	_kernel_init(); \
+	_##RP##axpy(n, a, x, y); \
+} \
+void \
+qg8_kernel_##CP##scal(uint64_t n, \
+                      T ar, \
+                      T ai, \
+                      T *xr, \
+                      T *xi) \
+{ \
+	_kernel_init(); \
+	_##CP##scal(n, ar, ai, xr, xi); \
+} \
+void \
+qg8_kernel_##RP##scal(uint64_t n, \
+                      T a, \
+                      T *x) \
+{ \
+	_kernel_init(); \
+	_##RP##scal(n, a, x); \
+} \
+void \
+qg8_kernel_##CP##mul(uint64_t n, \
+                     const T *xr, \
+                     const T *xi, \
+                     T *yr, \
+                     T *yi) \
+{ \
+	_kernel_init(); \
+	_##CP##mul(n, xr, xi, yr, yi); \
+} \
+void \
+qg8_kernel_##RP##mul(uint64_t n, \
+                     const T *x, \
+                     T *y) \
+{ \
+	_kernel_init(); \
+	_##RP##mul(n, x, y); \
+} \
+void \
+qg8_kernel_##CP##conj(uint64_t n, \
+                      T *xi) \
+{ \
+	_kernel_init(); \
+	_##CP##conj(n, xi); \
+} \
+void \
+qg8_kernel_##CP##dotc(uint64_t n, \
+                      const T *xr, \
+                      const T *xi, \
+                      const T *yr, \
+                      const T *yi, \
+                      double *re, \
+                      double *im) \
+{ \
+	_kernel_init(); \
+	_##CP##dotc(n, xr, xi, yr, yi, re, im); \
+} \
+double \
+qg8_kernel_##RP##dot(uint64_t n, \
+                     const T *x, \
+                     const T *y) \
+{ \
+	_kernel_init(); \
+	return _##RP##dot(n, x, y); \
+} \
+double \
+qg8_kernel_##CP##nrm2(uint64_t n, \
+                      const T *xr, \
+                      const T *xi) \
+{ \
+	double s, scale, ssq; \
+	_kernel_init(); \
+	s = _##CP##sqnrm(n, xr, xi); \
+	if (s < DBL_MAX && s >= (double) n * NRM2_TINY) \
+		return sqrt(s); \
+	scale = 0.0; \
+	ssq = 1.0; \
+	_##RP##lassq_scalar(n, xr, &scale, &ssq); \
+	_##RP##lassq_scalar(n, xi, &scale, &ssq); \
+	return scale * sqrt(ssq); \
+} \
+double \
+qg8_kernel_##RP##nrm2(uint64_t n, \
+                      const T *x) \
+{ \
+	double s, scale, ssq; \
+	_kernel_init(); \
+	s = _##RP##dot(n, x, x); \
+	if (s < DBL_MAX && s >= (double) n * NRM2_TINY) \
+		return sqrt(s); \
+	scale = 0.0; \
+	ssq = 1.0; \
+	_##RP##lassq_scalar(n, x, &scale, &ssq); \
+	return scale * sqrt(ssq); \
+}
+
+KERNEL_API(double, z, d)
+KERNEL_API(float, c, s)
+
+/* y = x converted between half precision or bfloat16 and float */
+void
+qg8_kernel_half_to_float(uint64_t n,
+                         const uint16_t *x,
+                         float *y)
+{
+	_kernel_init();
+	_h2s(n, x, y);
+}
+
+void
+qg8_kernel_float_to_half(uint64_t n,
+                         const float *x,
+                         uint16_t *y)
+{
+	_kernel_init();
+	_s2h(n, x, y);
+}
+
+void
+qg8_kernel_bf16_to_float(uint64_t n,
+                         const uint16_t *x,
+                         float *y)
+{
+	_kernel_init();
+	_b2s(n, x, y);
+}
+
+void
+qg8_kernel_float_to_bf16(uint64_t n,
+                         const float *x,
+                         uint16_t *y)
+{
+	_kernel_init();
+	_s2b(n, x, y);
+}
+
+/* y[r0..r1) = m*x, see _csr_spmv */
+void
+_kernel_zcsrmv(qg8_csr *m,
+               uint64_t r0,
+               uint64_t r1,
+               const double *xr,
+               const double *xi,
+               double *yr,
+               double *yi)
+{
+	_kernel_init();
+	_zcsrmv(m, r0, r1, xr, xi, yr, yi);
+}
+
+/* tile of the selected instruction set, resolved once per product */
+qg8_gemm_tile
+_kernel_dgemm_tile(void)
+{
+	_kernel_init();
+	return _dgemm_tile;
+}
+
+/* n values of b bits from p, see codec.c */
+void
+_kernel_unpack(const uint8_t *p,
+               uint64_t n,
+               int b,
+               uint64_t *out)
+{
+	_kernel_init();
+	_unpack(p, n, b, out);
+}
@@ -0,0 +1,251 @@
+/*
+ * kron.c
+ * QG8 base library Kronecker view source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A Kronecker view stands for A1 (x) A2 (x) ... (x) Am without building it.
+ * Applied to a ket x of A1.cols * ... * Am.cols elements, x is read as a
+ * tensor with one mode per factor and every factor is applied to its own
+ * mode in turn:
+ *   y[l, r, k] = sum_c Ai[r, c] x[l, c, k]
+ * where l runs over the modes before i and k over the modes after it. The
+ * k axis is contiguous, so each stored entry of Ai is one axpy over it.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* below this many contiguous elements the axpy is written out */
+#define KRON_AXPY_MIN 8
+
+static
+int
+_csr_is_identity(qg8_csr *m)
+{
+	uint64_t r;
+
+	if (m->rows != m->cols)
+		return 0;
+	for (r = 0; r < m->rows; ++r)
+	{
+		if (*(m->rowptr+r+1) - *(m->rowptr+r) != 1 ||
+		    *(m->colidx+*(m->rowptr+r)) != r ||
+		    *(m->re+*(m->rowptr+r)) != 1.0 ||
+		    (m->im && *(m->im+*(m->rowptr+r)) != 0.0))
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * Creates a view of the Kronecker product of rank 2 factors. The factors
+ * are borrowed and must outlive the view; their row compressed forms are
+ * built once here.
+ */
+qg8_kron *
+qg8_kron_create(qg8_tensor **factors,
+                uint64_t num_factors)
+{
+	qg8_kron *k;
+	uint64_t i;
+
+	if (!factors || num_factors == 0)
+	{
+		DIE("Cannot create a Kronecker view without factors.\n");
+	}
+	k = (qg8_kron *) malloc(sizeof(qg8_kron));
+	ALLOC(k);
+	k->num_factors = num_factors;
+	k->factors = (qg8_tensor **) malloc(sizeof(qg8_tensor *) * num_factors);
+	ALLOC(k->factors);
+	k->csr = (qg8_csr **) malloc(sizeof(qg8_csr *) * num_factors);
+	ALLOC(k->csr);
+	k->rows = 1;
+	k->cols = 1;
+	for (i = 0; i < num_factors; ++i)
+	{
+		if (!*(factors+i) || (*(factors+i))->rank != 2)
+		{
+			DIE("Kronecker factors must be tensors of rank 2.\n");
+		}
+		*(k->factors+i) = *(factors+i);
+		*(k->csr+i) = _csr_from_tensor(*(factors+i), 0);
+		k->rows *= (*(k->csr+i))->rows;
+		k->cols *= (*(k->csr+i))->cols;
+		if (_csr_is_identity(*(k->csr+i)))
+		{
+			_csr_destroy(*(k->csr+i));
+			*(k->csr+i) = NULL;
+		}
+	}
+	return k;
+}
+
+/* applies m to mode (l, c, k) of x, giving (l, m->rows, k) in y */
+static
+void
+_kron_mode(qg8_csr *m,
+           uint64_t left,
+           uint64_t right,
+           const double *xr,
+           const double *xi,
+           double *yr,
+           double *yi)
+{
+	uint64_t u;
+
+	qg8_kernel_get_isa(); /* resolve the dispatch before the threads start */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(left * m->rows * right > 4096)
+#endif /* _OPENMP */
+	for (u = 0; u < left * m->rows; ++u)
+	{
+		uint64_t l, r, p, c, t;
+		double ar, ai, *or, *oi;
+		const double *sr, *si;
+		l = u / m->rows;
+		r = u % m->rows;
+		or = yr + u * right;
+		oi = yi + u * right;
+		memset(or, 0, sizeof(double) * right);
+		memset(oi, 0, sizeof(double) * right);
+		for (p = *(m->rowptr+r); p < *(m->rowptr+r+1); ++p)
+		{
+			c = *(m->colidx+p);
+			ar = *(m->re+p);
+			ai = m->im ? *(m->im+p) : 0.0;
+			sr = xr + (l * m->cols + c) * right;
+			si = xi + (l * m->cols + c) * right;
+			if (right >= KRON_AXPY_MIN)
+			{
+				qg8_kernel_zaxpy(right, ar, ai, sr, si, or, oi);
+				continue;
+			}
+			for (t = 0; t < right; ++t)
+			{
+				*(or+t) += ar * *(sr+t) - ai * *(si+t);
+				*(oi+t) += ar * *(si+t) + ai * *(sr+t);
+			}
+		}
+	}
+}
+
+/*
+ * Returns the product of the view with a ket (rank 1, or rank 2 with one
+ * column) as a full COMPLEX128 ket. Identity factors cost nothing.
+ */
+qg8_tensor *
+qg8_kron_apply(qg8_kron *k,
+               qg8_tensor *ket)
+{
+	qg8_tensor *out;
+	double *xr, *xi, *yr, *yi, *swap;
+	uint64_t *dims, shape[2], i, left, right, size, peak;
+
+	if (!k || !ket)
+	{
+		DIE("Cannot apply a NULL Kronecker view.\n");
+	}
+	if (ket->rank > 2 || (ket->rank == 2 && *(ket->dimensions+1) != 1) ||
+	    *(ket->dimensions) != k->cols)
+	{
+		DIE("Cannot apply a Kronecker view to a ket of mismatched shape.\n");
+	}
+
+	/* current extent of every mode, starting from the factor columns */
+	dims = (uint64_t *) malloc(sizeof(uint64_t) * k->num_factors);
+	ALLOC(dims);
+	peak = k->cols;
+	size = k->cols;
+	for (i = 0; i < k->num_factors; ++i)
+	{
+		*(dims+i) = *((*(k->factors+i))->dimensions+1);
+		size = size / *((*(k->factors+i))->dimensions+1) *
+		       *((*(k->factors+i))->dimensions);
+		peak = MAX(peak, size);
+	}
+	xr = (double *) malloc(sizeof(double) * MAX(peak, 1));
+	ALLOC(xr);
+	xi = (double *) malloc(sizeof(double) * MAX(peak, 1));
+	ALLOC(xi);
+	yr = (double *) malloc(sizeof(double) * MAX(peak, 1));
+	ALLOC(yr);
+	yi = (double *) malloc(sizeof(double) * MAX(peak, 1));
+	ALLOC(yi);
+	_tensor_to_dense(ket, xr, xi);
+
+	/* modes in order, so each step only grows or shrinks one extent */
+	for (i = 0; i < k->num_factors; ++i)
+	{
+		if (!*(k->csr+i))
+			continue;
+		left = 1;
+		right = 1;
+		for (size = 0; size < i; ++size)
+			left *= *(dims+size);
+		for (size = i + 1; size < k->num_factors; ++size)
+			right *= *(dims+size);
+		_kron_mode(*(k->csr+i), left, right, xr, xi, yr, yi);
+		*(dims+i) = (*(k->csr+i))->rows;
+		swap = xr;
+		xr = yr;
+		yr = swap;
+		swap = xi;
+		xi = yi;
+		yi = swap;
+	}
+
+	shape[0] = k->rows;
+	shape[1] = 1;
+	out = _tensor_new(QG8_PACKING_FULL, ket->rank, shape, k->rows, 1);
+	_tensor_fill_full_indices(out);
+	memcpy(out->redata, xr, sizeof(double) * k->rows);
+	memcpy(out->imdata, xi, sizeof(double) * k->rows);
+	free(xr);
+	free(xi);
+	free(yr);
+	free(yi);
+	free(dims);
+	return out;
+}
+
+int
+qg8_kron_destroy(qg8_kron *k)
+{
+	uint64_t i;
+
+	if (!k)
+	{
+		DIE("Cannot destroy a NULL Kronecker view.\n");
+	}
+	for (i = 0; i < k->num_factors; ++i)
+		if (*(k->csr+i))
+			_csr_destroy(*(k->csr+i));
+	free(k->csr);
+	free(k->factors);
+	free(k);
+	return 1;
+}
@@ -0,0 +1,454 @@
+/*
+ * lanczos.c
+ * QG8 base library Lanczos eigensolver source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The lowest eigenpairs come from thick restarted Lanczos (Wu and Simon).
+ * A basis V of m vectors is grown with H v_j, fully reorthogonalised, so
+ * that V^H H V = T is real symmetric: tridiagonal apart from the first row
+ * and column of the kept vectors. The Ritz pairs of T are found by Jacobi
+ * rotations; the residual of Ritz pair i is |beta_m y_(m-1,i)|. When the
+ * wanted pairs are not all below tol, the basis shrinks to its lowest
+ * Ritz vectors plus the last Lanczos vector and grows again.
+ *
+ * The products H v go through qg8_tensor_spmv, so every packing it reads
+ * is accepted, with the compressed row cache used when it is built.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* basis vectors beyond the 2k kept ones */
+#define LANCZOS_EXTRA    20
+/* restarts before giving up */
+#define LANCZOS_RESTARTS 1000
+/* relative size of a residual taken as an invariant subspace */
+#define LANCZOS_BREAK    1e-12
+/* vectors shorter than this are combined by one thread */
+#define LANCZOS_PAR      16384
+/* sweeps of the Jacobi eigensolver */
+#define JACOBI_SWEEPS    64
+
+/* deterministic start vector, in [-1/2, 1/2) + i [-1/2, 1/2) */
+static
+void
+_lanczos_random(uint64_t n,
+                uint64_t seed,
+                double *xr,
+                double *xi)
+{
+	uint64_t i, s;
+
+	s = seed * 0x9e3779b97f4a7c15UL + 0x2545f4914f6cdd1dUL;
+	for (i = 0; i < n; ++i)
+	{
+		s = s * 6364136223846793005UL + 1442695040888963407UL;
+		*(xr+i) = (double) (s >> 11) * (1.0 / 9007199254740992.0) - 0.5;
+		s = s * 6364136223846793005UL + 1442695040888963407UL;
+		*(xi+i) = (double) (s >> 11) * (1.0 / 9007199254740992.0) - 0.5;
+	}
+}
+
+/* removes from w its components along the first j vectors of v, twice */
+static
+void
+_lanczos_orthogonalise(uint64_t n,
+                       uint64_t j,
+                       const double *vr,
+                       const double *vi,
+                       double *wr,
+                       double *wi)
+{
+	double cr, ci;
+	uint64_t i;
+	int pass;
+
+	for (pass = 0; pass < 2; ++pass)
+	{
+		for (i = 0; i < j; ++i)
+		{
+			_vdot(n, vr + i * n, vi + i * n, wr, wi, &cr, &ci);
+			_vaxpy(n, -cr, -ci, vr + i * n, vi + i * n, wr, wi);
+		}
+	}
+}
+
+/*
+ * Eigenvalues w, increasing, and orthonormal eigenvectors, the columns of
+ * y, of the symmetric m*m row-major matrix a, which is overwritten.
+ */
+static
+void
+_jacobi(uint64_t m,
+        double *a,
+        double *y,
+        double *w)
+{
+	double off, total, th, t, c, s, x, z;
+	uint64_t p, q, r, best;
+	int sweep;
+
+	memset(y, 0, sizeof(double) * m * m);
+	total = 0.0;
+	for (p = 0; p < m; ++p)
+	{
+		*(y+p*m+p) = 1.0;
+		for (q = 0; q < m; ++q)
+			total += *(a+p*m+q) * *(a+p*m+q);
+	}
+	for (sweep = 0; sweep < JACOBI_SWEEPS; ++sweep)
+	{
+		off = 0.0;
+		for (p = 0; p < m; ++p)
+			for (q = p + 1; q < m; ++q)
+				off += *(a+p*m+q) * *(a+p*m+q);
+		if (off <= 1e-32 * total)
+			break;
+		for (p = 0; p < m; ++p)
+		{
+			for (q = p + 1; q < m; ++q)
+			{
+				if (*(a+p*m+q) == 0.0)
+					continue;
+				th = (*(a+q*m+q) - *(a+p*m+p)) / (2.0 * *(a+p*m+q));
+				t = (th >= 0.0 ? 1.0 : -1.0) /
+				    (fabs(th) + sqrt(th * th + 1.0));
+				c = 1.0 / sqrt(t * t + 1.0);
+				s = t * c;
+				for (r = 0; r < m; ++r)
+				{
+					x = *(a+r*m+p);
+					z = *(a+r*m+q);
+					*(a+r*m+p) = c * x - s * z;
+					*(a+r*m+q) = s * x + c * z;
+				}
+				for (r = 0; r < m; ++r)
+				{
+					x = *(a+p*m+r);
+					z = *(a+q*m+r);
+					*(a+p*m+r) = c * x - s * z;
+					*(a+q*m+r) = s * x + c * z;
+				}
+				for (r = 0; r < m; ++r)
+				{
+					x = *(y+r*m+p);
+					z = *(y+r*m+q);
+					*(y+r*m+p) = c * x - s * z;
+					*(y+r*m+q) = s * x + c * z;
+				}
+			}
+		}
+	}
+
+	for (p = 0; p < m; ++p)
+		*(w+p) = *(a+p*m+p);
+	/* selection sort, the columns of y follow */
+	for (p = 0; p < m; ++p)
+	{
+		best = p;
+		for (q = p + 1; q < m; ++q)
+			if (*(w+q) < *(w+best))
+				best = q;
+		if (best == p)
+			continue;
+		x = *(w+p);
+		*(w+p) = *(w+best);
+		*(w+best) = x;
+		for (r = 0; r < m; ++r)
+		{
+			x = *(y+r*m+p);
+			*(y+r*m+p) = *(y+r*m+best);
+			*(y+r*m+best) = x;
+		}
+	}
+}
+
+/* the first l columns of y, of height m, combine the vectors v into x */
+static
+void
+_lanczos_ritz(uint64_t n,
+              uint64_t m,
+              uint64_t l,
+              const double *y,
+              const double *vr,
+              const double *vi,
+              double *xr,
+              double *xi)
+{
+	uint64_t p;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(n > LANCZOS_PAR)
+#endif /* _OPENMP */
+	for (p = 0; p < n; ++p)
+	{
+		double c;
+		uint64_t i, j;
+
+		for (i = 0; i < l; ++i)
+		{
+			*(xr+i*n+p) = 0.0;
+			*(xi+i*n+p) = 0.0;
+		}
+		for (j = 0; j < m; ++j)
+		{
+			for (i = 0; i < l; ++i)
+			{
+				c = *(y+j*m+i);
+				*(xr+i*n+p) += c * *(vr+j*n+p);
+				*(xi+i*n+p) += c * *(vi+j*n+p);
+			}
+		}
+	}
+}
+
+/* ket of x, with its largest element made real and positive */
+static
+qg8_tensor *
+_lanczos_ket(uint64_t n,
+             const double *xr,
+             const double *xi)
+{
+	qg8_tensor *ket;
+	double *re, *im, mag, best, cr, ci;
+	uint64_t p, top, shape[1];
+
+	top = 0;
+	best = -1.0;
+	for (p = 0; p < n; ++p)
+	{
+		mag = *(xr+p) * *(xr+p) + *(xi+p) * *(xi+p);
+		if (mag > best)
+		{
+			best = mag;
+			top = p;
+		}
+	}
+	mag = sqrt(best);
+	cr = *(xr+top) / mag;
+	ci = -*(xi+top) / mag;
+	shape[0] = n;
+	ket = _tensor_new(QG8_PACKING_FULL, 1, shape, n, 1);
+	_tensor_fill_full_indices(ket);
+	re = (double *) ket->redata;
+	im = (double *) ket->imdata;
+	for (p = 0; p < n; ++p)
+	{
+		*(re+p) = cr * *(xr+p) - ci * *(xi+p);
+		*(im+p) = cr * *(xi+p) + ci * *(xr+p);
+	}
+	*(im+top) = 0.0;
+	return ket;
+}
+
+/*
+ * Finds the k lowest eigenvalues of a Hermitian rank 2 operator, in
+ * increasing order in values, and their eigenvectors as new full
+ * COMPLEX128 kets in kets. An eigenpair is accepted once its residual
+ * |H x - l x| is below tol max(1, |l|). The operator is only read through
+ * qg8_tensor_spmv; its Hermiticity is assumed, not checked.
+ */
+int
+qg8_tensor_eigen(qg8_tensor *op,
+                 uint64_t k,
+                 double tol,
+                 double *values,
+                 qg8_tensor **kets)
+{
+	double *vr, *vi, *xr, *xi, *t, *y, *theta, *s;
+	double alpha, beta, scale, im, res;
+	uint64_t n, m, l, i, j, conv;
+	int restart;
+
+	if (!op || !values || !kets)
+	{
+		DIE("Cannot compute the eigenpairs of a NULL tensor.\n");
+	}
+	if (op->rank != 2 || *(op->dimensions) != *(op->dimensions+1))
+	{
+		DIE("Cannot compute the eigenpairs of a non square operator.\n");
+	}
+	n = *(op->dimensions);
+	if (k == 0 || k > n)
+	{
+		fprintf(stderr, "Cannot compute %lu eigenpairs of an operator of "
+		        "dimension %lu.\n", (unsigned long) k, (unsigned long) n);
+		exit(EXIT_FAILURE);
+	}
+	m = MIN(n, 2 * k + LANCZOS_EXTRA);
+
+	/* m + 1 basis vectors and up to m Ritz vectors */
+	vr = (double *) malloc(sizeof(double) * (m + 1) * n);
+	ALLOC(vr);
+	vi = (double *) malloc(sizeof(double) * (m + 1) * n);
+	ALLOC(vi);
+	xr = (double *) malloc(sizeof(double) * m * n);
+	ALLOC(xr);
+	xi = (double *) malloc(sizeof(double) * m * n);
+	ALLOC(xi);
+	t = (double *) malloc(sizeof(double) * m * m);
+	ALLOC(t);
+	y = (double *) malloc(sizeof(double) * m * m);
+	ALLOC(y);
+	theta = (double *) malloc(sizeof(double) * m);
+	ALLOC(theta);
+	s = (double *) malloc(sizeof(double) * m);
+	ALLOC(s);
+
+	qg8_kernel_get_isa();
+	_lanczos_random(n, 0, vr, vi);
+	_vscale(n, 1.0 / _vnorm(n, vr, vi), vr, vi, vr, vi);
+	l = 0;
+	scale = 0.0;
+	beta = 0.0;
+	for (restart = 0; ; ++restart)
+	{
+		/* kept Ritz values on the diagonal, their couplings on row l */
+		memset(t, 0, sizeof(double) * m * m);
+		for (i = 0; i < l; ++i)
+		{
+			*(t+i*m+i) = *(theta+i);
+			*(t+i*m+l) = *(s+i);
+			*(t+l*m+i) = *(s+i);
+		}
+		for (j = l; j < m; ++j)
+		{
+			double *wr, *wi;
+
+			wr = vr + (j + 1) * n;
+			wi = vi + (j + 1) * n;
+			qg8_tensor_spmv(op, vr + j * n, vi + j * n, wr, wi);
+			_vdot(n, vr + j * n, vi + j * n, wr, wi, &alpha, &im);
+			*(t+j*m+j) = alpha;
+			_lanczos_orthogonalise(n, j + 1, vr, vi, wr, wi);
+			beta = _vnorm(n, wr, wi);
+			scale = MAX(scale, fabs(alpha) + beta);
+			if (beta <= LANCZOS_BREAK * scale)
+			{
+				/* invariant subspace, carry on along a new direction */
+				beta = 0.0;
+				if (j + 1 < m)
+				{
+					_lanczos_random(n, (uint64_t) restart * m + j + 1,
+					                wr, wi);
+					_lanczos_orthogonalise(n, j + 1, vr, vi, wr, wi);
+					_vscale(n, 1.0 / _vnorm(n, wr, wi), wr, wi, wr, wi);
+				}
+				continue;
+			}
+			_vscale(n, 1.0 / beta, wr, wi, wr, wi);
+			if (j + 1 < m)
+			{
+				*(t+j*m+j+1) = beta;
+				*(t+(j+1)*m+j) = beta;
+			}
+		}
+
+		_jacobi(m, t, y, theta);
+		conv = 0;
+		for (i = 0; i < k; ++i)
+		{
+			res = fabs(beta * *(y+(m-1)*m+i));
+			if (res <= tol * MAX(1.0, fabs(*(theta+i))))
+				++conv;
+		}
+		if (conv == k)
+			break;
+		if (restart == LANCZOS_RESTARTS)
+		{
+			DIE("Lanczos iterations did not converge.\n");
+		}
+
+		/* thick restart on the lowest Ritz vectors */
+		l = MIN(k + (m - k) / 2, m - 1);
+		_lanczos_ritz(n, m, l, y, vr, vi, xr, xi);
+		memcpy(vr, xr, sizeof(double) * l * n);
+		memcpy(vi, xi, sizeof(double) * l * n);
+		memcpy(vr + l * n, vr + m * n, sizeof(double) * n);
+		memcpy(vi + l * n, vi + m * n, sizeof(double) * n);
+		for (i = 0; i < l; ++i)
+			*(s+i) = beta * *(y+(m-1)*m+i);
+	}
+
+	_lanczos_ritz(n, m, k, y, vr, vi, xr, xi);
+	for (i = 0; i < k; ++i)
+	{
+		*(values+i) = *(theta+i);
+		*(kets+i) = _lanczos_ket(n, xr + i * n, xi + i * n);
+	}
+
+	free(vr);
+	free(vi);
+	free(xr);
+	free(xi);
+	free(t);
+	free(y);
+	free(theta);
+	free(s);
+	return 1;
+}
+
+/*
+ * Returns the k lowest eigenvectors of a Hermitian operator as an array of
+ * KET chunks labelled eigen0, eigen1, ..., solved to QG8_EIGEN_TOL. The
+ * eigenvalues go to values when it is not NULL. The array is freed by the
+ * caller; the chunks belong to whichever graph or file they are added to.
+ */
+qg8_chunk **
+qg8_tensor_eigenkets(qg8_tensor *op,
+                     uint64_t k,
+                     double *values)
+{
+	qg8_chunk **chunks;
+	qg8_tensor **kets;
+	double *w;
+	char label[32];
+	uint64_t i;
+
+	if (k == 0)
+	{
+		DIE("Cannot compute 0 eigenpairs.\n");
+	}
+	w = values ? values : (double *) malloc(sizeof(double) * k);
+	ALLOC(w);
+	kets = (qg8_tensor **) malloc(sizeof(qg8_tensor *) * k);
+	ALLOC(kets);
+	chunks = (qg8_chunk **) malloc(sizeof(qg8_chunk *) * k);
+	ALLOC(chunks);
+	qg8_tensor_eigen(op, k, QG8_EIGEN_TOL, w, kets);
+	for (i = 0; i < k; ++i)
+	{
+		sprintf(label, "eigen%lu", (unsigned long) i);
+		*(chunks+i) = qg8_chunk_create(QG8_TYPE_KET, 0, (uint8_t *) label,
+		                               *(kets+i));
+	}
+	free(kets);
+	if (!values)
+		free(w);
+	return chunks;
+}
@@ -0,0 +1,189 @@
+/*
+ * linear.c
+ * QG8 base library linear index packing source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * QG8_TENSOR_LINEAR_INDEX flags an encoding of the index arrays in
+ * files, asked for with qg8_chunk_set_index_encoding. The coordinates of
+ * entry e are written as the single row-major index
+ *   ((c[0] * dims[1] + c[1]) * dims[2] + c[2]) ...
+ * in an index type fitting the product of the dimensions rather than every
+ * axis rounded up to a whole type: a NOISESPEC stack of 4 Kraus operators
+ * of dimension 2^10 costs 4 bytes of index per entry instead of 3 x 2.
+ * Canonical tensors stay sorted on this one key, which codec.c packs as a
+ * single array. The packing is written as it is and the loader expands the
+ * flat indices back to one array per axis, so tensors in memory never hold
+ * the flag.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* entries decoded or encoded per parallel task */
+#define LINEAR_BLOCK 65536
+
+/* number of elements of the tensor, which must fit a 64 bit index */
+uint64_t
+_linear_size(qg8_tensor *t)
+{
+	uint64_t n;
+	uint16_t k;
+
+	n = 1;
+	for (k = 0; k < t->rank; ++k)
+	{
+		if (*(t->dimensions+k) != 0 &&
+		    n > UINT64_MAX / *(t->dimensions+k))
+		{
+			DIE("Tensor is too large for a linear index.\n");
+		}
+		n *= *(t->dimensions+k);
+	}
+	return n;
+}
+
+/*
+ * LINEAR view of t for the writer: its single index array is new, and its
+ * dimensions and values are those of t. Returns NULL for Pauli, DIA, BSR
+ * and half Hermitian tensors, whose index arrays are not coordinates or
+ * carry a mirrored triangle, and which are written as they are.
+ */
+qg8_tensor *
+_linear_view(qg8_tensor *t)
+{
+	qg8_tensor *v;
+	uint64_t nb, b;
+	uint16_t k;
+	int bad;
+
+	if (_tensor_is_packed(t) || t->packing == QG8_PACKING_HALF_HERMITIAN)
+		return NULL;
+	v = (qg8_tensor *) malloc(sizeof(qg8_tensor));
+	ALLOC(v);
+	memcpy(v, t, sizeof(qg8_tensor));
+	v->loaded = 0;
+	v->flags = (t->flags & QG8_TENSOR_SORTED) | QG8_TENSOR_LINEAR_INDEX;
+	v->csr = NULL;
+	v->order = NULL;
+	v->itype_id = _tensor_index_size(v);
+	v->indices = (uint64_t **) malloc(sizeof(uint64_t *) * t->rank);
+	ALLOC(v->indices);
+	for (k = 0; k < t->rank; ++k)
+		*(v->indices+k) = NULL;
+	*(v->indices) = (uint64_t *) malloc(sizeof(uint64_t) *
+	                                    MAX(t->num_elems, 1));
+	ALLOC(*(v->indices));
+	nb = (t->num_elems + LINEAR_BLOCK - 1) / LINEAR_BLOCK;
+	bad = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(nb > 1) reduction(|:bad)
+#endif /* _OPENMP */
+	for (b = 0; b < nb; ++b)
+	{
+		uint64_t e, hi, lin, x;
+		uint16_t a;
+
+		hi = MIN(t->num_elems, (b + 1) * LINEAR_BLOCK);
+		for (e = b * LINEAR_BLOCK; e < hi; ++e)
+		{
+			lin = 0;
+			for (a = 0; a < t->rank; ++a)
+			{
+				x = *(*(t->indices+a)+e);
+				bad |= x >= *(t->dimensions+a);
+				lin = lin * *(t->dimensions+a) + x;
+			}
+			*(*(v->indices)+e) = lin;
+		}
+	}
+	if (bad)
+	{
+		DIE("Tensor index is out of bounds.\n");
+	}
+	return v;
+}
+
+void
+_linear_view_free(qg8_tensor *v)
+{
+	free(*(v->indices));
+	free(v->indices);
+	free(v);
+}
+
+/*
+ * Expands the flat indices of a tensor read with LINEAR indices into one
+ * index array per axis, in place, leaving its packing and its order, and
+ * so its canonical flag, unchanged.
+ */
+void
+_linear_unflatten(qg8_tensor *t)
+{
+	uint64_t *flat, nb, b, size;
+	uint16_t k;
+	int bad;
+
+	flat = *(t->indices);
+	size = _linear_size(t);
+	bad = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(|:bad)
+#endif /* _OPENMP */
+	for (b = 0; b < t->num_elems; ++b)
+		bad |= *(flat+b) >= size;
+	if (bad)
+	{
+		DIE("Tensor index is out of bounds.\n");
+	}
+	for (k = 0; k < t->rank; ++k)
+	{
+		*(t->indices+k) = (uint64_t *) malloc(sizeof(uint64_t) *
+		                                      MAX(t->num_elems, 1));
+		ALLOC(*(t->indices+k));
+	}
+	nb = (t->num_elems + LINEAR_BLOCK - 1) / LINEAR_BLOCK;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(nb > 1)
+#endif /* _OPENMP */
+	for (b = 0; b < nb; ++b)
+	{
+		uint64_t e, hi, lin;
+		uint16_t a;
+
+		hi = MIN(t->num_elems, (b + 1) * LINEAR_BLOCK);
+		for (e = b * LINEAR_BLOCK; e < hi; ++e)
+		{
+			lin = *(flat+e);
+			for (a = t->rank; a > 0; --a)
+			{
+				*(*(t->indices+a-1)+e) = lin % *(t->dimensions+a-1);
+				lin /= *(t->dimensions+a-1);
+			}
+		}
+	}
+	free(flat);
+	t->flags &= ~QG8_TENSOR_LINEAR_INDEX;
+}
@@ -0,0 +1,266 @@
+/*
+ * lookup.c
+ * QG8 base library element lookup source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Lookups binary search the entries of a tensor in coordinate order. A
+ * canonical tensor, see canon.c, is searched as stored. Any other one gets
+ * its sorted order on the first lookup, which is kept in the tensor until
+ * qg8_tensor_lookup_release or qg8_tensor_destroy, and must be released
+ * after changing the indices. As with the CSR cache, the first lookup
+ * must not race with another one on the same tensor.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* storage position of the entry at sorted position p */
+#define ENTRY(t,p) ((t)->order ? *((t)->order+(p)) : (p))
+
+static
+void
+_lookup_prepare(qg8_tensor *t)
+{
+	if (_tensor_is_packed(t))
+	{
+		DIE("Cannot look up entries of a packed tensor.\n");
+	}
+	if (!t->order && !(t->flags & QG8_TENSOR_SORTED))
+		t->order = _canon_order(t);
+}
+
+/*
+ * First sorted position in a..b-1 whose first nk coordinates are not
+ * lexicographically below key, or b if there is none.
+ */
+static
+uint64_t
+_lower_bound(qg8_tensor *t,
+             uint64_t a,
+             uint64_t b,
+             const uint64_t *key,
+             uint16_t nk)
+{
+	uint64_t mid, e, x;
+	uint16_t k;
+	int below;
+
+	while (a < b)
+	{
+		mid = a + (b - a) / 2;
+		e = ENTRY(t, mid);
+		below = 0;
+		for (k = 0; k < nk; ++k)
+		{
+			x = *(*(t->indices+k)+e);
+			if (x != *(key+k))
+			{
+				below = x < *(key+k);
+				break;
+			}
+		}
+		if (below)
+			a = mid + 1;
+		else
+			b = mid;
+	}
+	return a;
+}
+
+/* adds the entries stored at coord to *re and *im, returns their count */
+static
+int
+_lookup_sum(qg8_tensor *t,
+            const uint64_t *coord,
+            double *re,
+            double *im)
+{
+	uint64_t p, e;
+	double vr, vi;
+	uint16_t k;
+	int found;
+
+	found = 0;
+	for (p = _lower_bound(t, 0, t->num_elems, coord, t->rank);
+	     p < t->num_elems; ++p)
+	{
+		e = ENTRY(t, p);
+		for (k = 0; k < t->rank; ++k)
+			if (*(*(t->indices+k)+e) != *(coord+k))
+				return found;
+		_tensor_element(t, e, &vr, &vi);
+		*re += vr;
+		*im += vi;
+		++found;
+	}
+	return found;
+}
+
+/*
+ * Reads the element of t at coord, one index per axis, into *re and *im,
+ * the imaginary part being zero for real data. Entries stored more than
+ * once are summed, and half Hermitian tensors also count the conjugate of
+ * the mirrored entry. Returns the number of stored entries found, 0 for
+ * an element which is not stored and reads as zero.
+ */
+int
+qg8_tensor_get_element(qg8_tensor *t,
+                       const uint64_t *coord,
+                       double *re,
+                       double *im)
+{
+	uint64_t mirror[2];
+	double mr, mi;
+	uint16_t k;
+	int found;
+
+	if (!t || !coord || !re || !im)
+	{
+		DIE("Cannot look up an element with NULL arguments.\n");
+	}
+	for (k = 0; k < t->rank; ++k)
+	{
+		if (*(coord+k) >= *(t->dimensions+k))
+		{
+			DIE("Element lies outside of the tensor.\n");
+		}
+	}
+	_lookup_prepare(t);
+	*re = 0.0;
+	*im = 0.0;
+	found = _lookup_sum(t, coord, re, im);
+	if (t->packing == QG8_PACKING_HALF_HERMITIAN && t->rank == 2 &&
+	    *coord != *(coord+1))
+	{
+		mirror[0] = *(coord+1);
+		mirror[1] = *coord;
+		mr = 0.0;
+		mi = 0.0;
+		found += _lookup_sum(t, mirror, &mr, &mi);
+		*re += mr;
+		*im -= mi;
+	}
+	return found;
+}
+
+/* entries inside [lo, hi), written to out unless it is NULL */
+static
+uint64_t
+_range_walk(qg8_tensor *t,
+            const uint64_t *lo,
+            const uint64_t *hi,
+            uint64_t *out)
+{
+	uint64_t key[2], n, p, end, a, b, q, e, cnt;
+	uint16_t k;
+	int inside;
+
+	n = t->num_elems;
+	p = _lower_bound(t, 0, n, lo, 1);
+	end = _lower_bound(t, p, n, hi, 1);
+	if (t->rank == 1)
+	{
+		for (q = p; q < end; ++q)
+			if (out)
+				*(out+q-p) = ENTRY(t, q);
+		return end - p;
+	}
+
+	/* one pair of searches per first index, then a scan of the others */
+	cnt = 0;
+	while (p < end)
+	{
+		key[0] = *(*(t->indices)+ENTRY(t, p));
+		key[1] = *(lo+1);
+		a = _lower_bound(t, p, end, key, 2);
+		key[1] = *(hi+1);
+		b = _lower_bound(t, a, end, key, 2);
+		for (q = a; q < b; ++q)
+		{
+			e = ENTRY(t, q);
+			inside = 1;
+			for (k = 2; inside && k < t->rank; ++k)
+				inside = *(*(t->indices+k)+e) >= *(lo+k) &&
+				         *(*(t->indices+k)+e) < *(hi+k);
+			if (!inside)
+				continue;
+			if (out)
+				*(out+cnt) = e;
+			++cnt;
+		}
+		++key[0];
+		p = _lower_bound(t, b, end, key, 1);
+	}
+	return cnt;
+}
+
+/*
+ * Finds the stored entries of t whose index lies in [lo[k], hi[k]) on
+ * every axis k, for instance row i of a matrix with lo = (i, 0) and
+ * hi = (i + 1, cols). Sets *entries to a new array of their storage
+ * positions in coordinate order, for qg8_tensor_get_re and
+ * qg8_tensor_get_indices, which the caller frees. Returns their number.
+ */
+uint64_t
+qg8_tensor_find_range(qg8_tensor *t,
+                      const uint64_t *lo,
+                      const uint64_t *hi,
+                      uint64_t **entries)
+{
+	uint64_t cnt;
+	uint16_t k;
+
+	if (!t || !lo || !hi || !entries)
+	{
+		DIE("Cannot find a range with NULL arguments.\n");
+	}
+	_lookup_prepare(t);
+	cnt = 0;
+	for (k = 0; k < t->rank; ++k)
+		if (*(lo+k) >= *(hi+k))
+			break;
+	if (k == t->rank)
+		cnt = _range_walk(t, lo, hi, NULL);
+	*entries = (uint64_t *) malloc(sizeof(uint64_t) * MAX(cnt, 1));
+	ALLOC(*entries);
+	if (cnt > 0)
+		_range_walk(t, lo, hi, *entries);
+	return cnt;
+}
+
+/* drops the sorted order kept by the lookups */
+int
+qg8_tensor_lookup_release(qg8_tensor *t)
+{
+	if (!t)
+	{
+		DIE("Cannot release the lookups of a NULL tensor.\n");
+	}
+	if (t->order)
+		free(t->order);
+	t->order = NULL;
+	return 1;
+}
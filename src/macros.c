@@ -53,6 +53,10 @@ _type_to_size(uint8_t type)
 		return QG8_SIZE_8;
 	case QG8_DTYPE_UINT16:
 	case QG8_DTYPE_INT16:
+	case QG8_DTYPE_FLOAT16:
+	case QG8_DTYPE_BFLOAT16:
+	case QG8_DTYPE_COMPLEX32:
+	case QG8_DTYPE_BCOMPLEX32:
 		return QG8_SIZE_16;
 	case QG8_DTYPE_UINT32:
 	case QG8_DTYPE_INT32:
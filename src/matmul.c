@@ -0,0 +1,664 @@
+/*
+ * matmul.c
+ * QG8 base library tensor product source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+static
+int
+_cmp_u64(const void *a,
+         const void *b)
+{
+	uint64_t x, y;
+	x = *((const uint64_t *) a);
+	y = *((const uint64_t *) b);
+	return (x > y) - (x < y);
+}
+
+/* above this many output columns, rows accumulate in a hash table */
+#define DENSE_ACC_MAX 65536
+
+/* per-thread accumulator of one output row */
+typedef struct spgemm_acc_s
+{
+	uint64_t *key;     /* dense: row stamp per column, hash: column per slot */
+	uint64_t *touched; /* columns of the current row */
+	uint64_t *slot;    /* hash slots of the current row */
+	double *re;
+	double *im;
+	uint64_t cap;      /* slots, hash mode only */
+	int bits;          /* log2 of cap, hash mode only */
+	int hash;
+} spgemm_acc;
+
+static
+void
+_acc_init(spgemm_acc *acc,
+          uint64_t cols,
+          int hash)
+{
+	uint64_t c;
+
+	acc->hash = hash;
+	acc->cap = hash ? 0 : cols;
+	acc->bits = 0;
+	acc->key = NULL;
+	acc->touched = NULL;
+	acc->slot = NULL;
+	acc->re = NULL;
+	acc->im = NULL;
+	if (hash)
+		return;
+	acc->key = (uint64_t *) malloc(sizeof(uint64_t) * MAX(cols, 1));
+	ALLOC(acc->key);
+	acc->touched = (uint64_t *) malloc(sizeof(uint64_t) * MAX(cols, 1));
+	ALLOC(acc->touched);
+	acc->re = (double *) calloc(MAX(cols, 1), sizeof(double));
+	ALLOC(acc->re);
+	acc->im = (double *) calloc(MAX(cols, 1), sizeof(double));
+	ALLOC(acc->im);
+	for (c = 0; c < cols; ++c)
+		*(acc->key+c) = UINT64_MAX;
+}
+
+/* grows the hash table to hold a row of at most flops products */
+static
+void
+_acc_reserve(spgemm_acc *acc,
+             uint64_t flops)
+{
+	uint64_t size, i;
+	int bits;
+
+	for (size = 16, bits = 4; size < 2 * flops; size <<= 1, ++bits)
+		;
+	if (size <= acc->cap)
+		return;
+	free(acc->key);
+	free(acc->touched);
+	free(acc->slot);
+	free(acc->re);
+	free(acc->im);
+	acc->cap = size;
+	acc->bits = bits;
+	acc->key = (uint64_t *) malloc(sizeof(uint64_t) * size);
+	ALLOC(acc->key);
+	acc->touched = (uint64_t *) malloc(sizeof(uint64_t) * size);
+	ALLOC(acc->touched);
+	acc->slot = (uint64_t *) malloc(sizeof(uint64_t) * size);
+	ALLOC(acc->slot);
+	acc->re = (double *) calloc(size, sizeof(double));
+	ALLOC(acc->re);
+	acc->im = (double *) calloc(size, sizeof(double));
+	ALLOC(acc->im);
+	for (i = 0; i < size; ++i)
+		*(acc->key+i) = UINT64_MAX;
+}
+
+static
+void
+_acc_destroy(spgemm_acc *acc)
+{
+	free(acc->key);
+	free(acc->touched);
+	free(acc->slot);
+	free(acc->re);
+	free(acc->im);
+}
+
+/*
+ * Returns the accumulator slot of column c in row r, registering the column
+ * in touched on first sight. Fibonacci hashing keeps the top bits of the
+ * product, so strided columns still spread over the table that
+ * _acc_reserve sized for the row.
+ */
+static
+uint64_t
+_acc_slot(spgemm_acc *acc,
+          uint64_t r,
+          uint64_t c,
+          uint64_t *cnt)
+{
+	uint64_t h, mask;
+
+	if (!acc->hash)
+	{
+		if (*(acc->key+c) != r)
+		{
+			*(acc->key+c) = r;
+			*(acc->touched+(*cnt)++) = c;
+		}
+		return c;
+	}
+	mask = acc->cap - 1;
+	h = (c * 11400714819323198485UL) >> (64 - acc->bits);
+	while (*(acc->key+h) != c)
+	{
+		if (*(acc->key+h) == UINT64_MAX)
+		{
+			*(acc->key+h) = c;
+			*(acc->slot+*cnt) = h;
+			*(acc->touched+(*cnt)++) = c;
+			break;
+		}
+		h = (h + 1) & mask;
+	}
+	return h;
+}
+
+/* multiplications needed by row r of a*b, an upper bound of its nnz */
+static
+uint64_t
+_row_flops(qg8_csr *a,
+           qg8_csr *b,
+           uint64_t r)
+{
+	uint64_t p, k, f;
+
+	f = 0;
+	for (p = *(a->rowptr+r); p < *(a->rowptr+r+1); ++p)
+	{
+		k = *(a->colidx+p);
+		f += *(b->rowptr+k+1) - *(b->rowptr+k);
+	}
+	return f;
+}
+
+/* distinct columns of row r of a*b */
+static
+uint64_t
+_row_symbolic(spgemm_acc *acc,
+              qg8_csr *a,
+              qg8_csr *b,
+              uint64_t r)
+{
+	uint64_t p, q, k, cnt, i;
+
+	if (acc->hash)
+		_acc_reserve(acc, _row_flops(a, b, r));
+	cnt = 0;
+	for (p = *(a->rowptr+r); p < *(a->rowptr+r+1); ++p)
+	{
+		k = *(a->colidx+p);
+		for (q = *(b->rowptr+k); q < *(b->rowptr+k+1); ++q)
+			_acc_slot(acc, r, *(b->colidx+q), &cnt);
+	}
+	if (acc->hash)
+		for (i = 0; i < cnt; ++i)
+			*(acc->key+*(acc->slot+i)) = UINT64_MAX;
+	return cnt;
+}
+
+/*
+ * Computes row r of a*b into the output from position pos, columns in
+ * ascending order. A full row emits every column, zeros included.
+ */
+static
+void
+_row_numeric(spgemm_acc *acc,
+             qg8_csr *a,
+             qg8_csr *b,
+             uint64_t r,
+             int full,
+             uint64_t *cols,
+             double *ore,
+             double *oim)
+{
+	uint64_t p, q, k, c, h, cnt, i;
+	double are, aim, bre, bim;
+
+	if (acc->hash)
+		_acc_reserve(acc, _row_flops(a, b, r));
+	cnt = 0;
+	for (p = *(a->rowptr+r); p < *(a->rowptr+r+1); ++p)
+	{
+		k = *(a->colidx+p);
+		are = *(a->re+p);
+		aim = a->im ? *(a->im+p) : 0.0;
+		for (q = *(b->rowptr+k); q < *(b->rowptr+k+1); ++q)
+		{
+			h = _acc_slot(acc, r, *(b->colidx+q), &cnt);
+			bre = *(b->re+q);
+			bim = b->im ? *(b->im+q) : 0.0;
+			*(acc->re+h) += are * bre - aim * bim;
+			*(acc->im+h) += are * bim + aim * bre;
+		}
+	}
+	if (full)
+	{
+		/* dense accumulator, zero columns were never touched */
+		for (c = 0; c < b->cols; ++c)
+		{
+			if (cols)
+				*(cols+c) = c;
+			*(ore+c) = *(acc->re+c);
+			if (oim)
+				*(oim+c) = *(acc->im+c);
+			*(acc->re+c) = 0.0;
+			*(acc->im+c) = 0.0;
+		}
+		return;
+	}
+	qsort(acc->touched, cnt, sizeof(uint64_t), _cmp_u64);
+	for (i = 0; i < cnt; ++i)
+	{
+		c = *(acc->touched+i);
+		h = acc->hash ? _acc_slot(acc, r, c, &cnt) : c;
+		*(cols+i) = c;
+		*(ore+i) = *(acc->re+h);
+		if (oim)
+			*(oim+i) = *(acc->im+h);
+		*(acc->re+h) = 0.0;
+		*(acc->im+h) = 0.0;
+	}
+	if (acc->hash)
+		for (i = 0; i < cnt; ++i)
+			*(acc->key+*(acc->slot+i)) = UINT64_MAX;
+}
+
+/*
+ * Row-by-row (Gustavson) product of two row compressed matrices. A first
+ * symbolic pass sizes every output row so that the numeric pass can write
+ * straight into the result tensor. Both passes run rows in parallel, each
+ * thread owning an accumulator: a dense one for narrow results and a hash
+ * table sized to the row otherwise, so memory does not grow with the
+ * matrix dimension. Columns are emitted in ascending order and every entry
+ * is summed in the same order whatever the thread count.
+ */
+static
+qg8_tensor *
+_spgemm(qg8_csr *a,
+        qg8_csr *b,
+        uint16_t rank,
+        uint64_t *shape,
+        int full,
+        int row_out)
+{
+	qg8_tensor *out;
+	uint64_t *offset, *cols, r;
+	double *ore, *oim;
+	int hash;
+
+	hash = !full && b->cols > DENSE_ACC_MAX;
+	offset = (uint64_t *) calloc(a->rows + 1, sizeof(uint64_t));
+	ALLOC(offset);
+
+	/* symbolic pass */
+	if (full)
+	{
+		for (r = 0; r < a->rows; ++r)
+			*(offset+r+1) = b->cols;
+	}
+	else
+	{
+#ifdef _OPENMP
+#pragma omp parallel
+#endif /* _OPENMP */
+		{
+			spgemm_acc acc;
+			uint64_t i;
+			_acc_init(&acc, b->cols, hash);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif /* _OPENMP */
+			for (i = 0; i < a->rows; ++i)
+				*(offset+i+1) = _row_symbolic(&acc, a, b, i);
+			_acc_destroy(&acc);
+		}
+	}
+	_csr_scan(offset+1, a->rows);
+
+	out = _tensor_new(full ? QG8_PACKING_FULL : QG8_PACKING_SPARSE_COO,
+	                  rank, shape, *(offset+a->rows), a->im || b->im);
+	ore = (double *) out->redata;
+	oim = (double *) out->imdata;
+	cols = *(out->indices+rank-1);
+
+	/* numeric pass */
+#ifdef _OPENMP
+#pragma omp parallel
+#endif /* _OPENMP */
+	{
+		spgemm_acc acc;
+		uint64_t i, e;
+		_acc_init(&acc, b->cols, hash);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif /* _OPENMP */
+		for (i = 0; i < a->rows; ++i)
+		{
+			e = *(offset+i);
+			_row_numeric(&acc, a, b, i, full, cols+e, ore+e,
+			             oim ? oim+e : NULL);
+			/* the row index, unless a row vector keeps only columns */
+			if (rank == 2 || !row_out)
+				for (; e < *(offset+i+1); ++e)
+					*(*(out->indices)+e) = i;
+		}
+		_acc_destroy(&acc);
+	}
+
+	free(offset);
+	return out;
+}
+
+/* product of two complete full matrices, without the row compressed views */
+static
+qg8_tensor *
+_gemm(qg8_tensor *a,
+      qg8_tensor *b)
+{
+	qg8_tensor *out;
+	double *are, *aim, *bre, *bim;
+	uint64_t shape[2], m, n, k;
+	int cplx;
+
+	m = *(a->dimensions);
+	k = *(a->dimensions+1);
+	n = *(b->dimensions+1);
+	cplx = _tensor_is_complex(a) || _tensor_is_complex(b);
+	are = (double *) malloc(sizeof(double) * MAX(m * k, 1));
+	ALLOC(are);
+	bre = (double *) malloc(sizeof(double) * MAX(k * n, 1));
+	ALLOC(bre);
+	aim = NULL;
+	bim = NULL;
+	if (_tensor_is_complex(a))
+	{
+		aim = (double *) malloc(sizeof(double) * MAX(m * k, 1));
+		ALLOC(aim);
+	}
+	if (_tensor_is_complex(b))
+	{
+		bim = (double *) malloc(sizeof(double) * MAX(k * n, 1));
+		ALLOC(bim);
+	}
+	_tensor_to_dense(a, are, aim);
+	_tensor_to_dense(b, bre, bim);
+	shape[0] = m;
+	shape[1] = n;
+	out = _tensor_new(QG8_PACKING_FULL, 2, shape, m * n, cplx);
+	_tensor_fill_full_indices(out);
+	if (cplx)
+		qg8_kernel_zgemm(m, n, k, are, aim, bre, bim,
+		                 (double *) out->redata, (double *) out->imdata);
+	else
+		qg8_kernel_dgemm(m, n, k, are, bre, (double *) out->redata);
+	free(are);
+	free(bre);
+	if (aim)
+		free(aim);
+	if (bim)
+		free(bim);
+	return out;
+}
+
+/*
+ * Matrix product a*b of two rank 1 or rank 2 tensors. A rank 1 left operand
+ * is a row vector and a rank 1 right operand is a column vector, so applying
+ * an operator to a ket returns a ket. The result is COMPLEX128 if either
+ * operand is complex and FLOAT64 otherwise, in full packing when both
+ * operands are full and in sparse COO packing otherwise.
+ */
+qg8_tensor *
+qg8_tensor_matmul(qg8_tensor *a,
+                  qg8_tensor *b)
+{
+	qg8_csr *ma, *mb;
+	qg8_tensor *out;
+	uint64_t shape[2];
+	uint16_t rank;
+
+	if (!a || !b)
+	{
+		DIE("Cannot multiply a NULL tensor.\n");
+	}
+	/* dense matrices: blocked product */
+	if (a->rank == 2 && b->rank == 2 &&
+	    a->packing == QG8_PACKING_FULL && b->packing == QG8_PACKING_FULL &&
+	    a->num_elems == _tensor_full_size(a) &&
+	    b->num_elems == _tensor_full_size(b) &&
+	    *(a->dimensions+1) == *(b->dimensions))
+		return _gemm(a, b);
+	/* operator on a dense complex ket: matrix-vector product */
+	if (a->rank == 2 && b->rank == 1 && b->packing == QG8_PACKING_FULL &&
+	    (_tensor_is_complex(a) || _tensor_is_complex(b) ||
+	     _tensor_is_packed(a)) &&
+	    *(a->dimensions+1) == *(b->dimensions))
+		return qg8_tensor_apply(a, b);
+	/* reuse the cached views of operators, see qg8_tensor_csr_build */
+	ma = a->csr ? a->csr : _csr_from_tensor(a, 1);
+	mb = b->csr ? b->csr : _csr_from_tensor(b, 0);
+	if (ma->cols != mb->rows)
+	{
+		fprintf(stderr, "Cannot multiply a %lux%lu matrix by a %lux%lu matrix.\n",
+		        ma->rows, ma->cols, mb->rows, mb->cols);
+		exit(EXIT_FAILURE);
+	}
+	if (a->rank == 1 && b->rank == 1)
+	{
+		rank = 1;
+		shape[0] = 1;
+	}
+	else if (a->rank == 1)
+	{
+		rank = 1;
+		shape[0] = mb->cols;
+	}
+	else if (b->rank == 1)
+	{
+		rank = 1;
+		shape[0] = ma->rows;
+	}
+	else
+	{
+		rank = 2;
+		shape[0] = ma->rows;
+		shape[1] = mb->cols;
+	}
+	out = _spgemm(ma, mb, rank, shape,
+	              a->packing == QG8_PACKING_FULL &&
+	              b->packing == QG8_PACKING_FULL, a->rank == 1);
+	if (ma != a->csr)
+		_csr_destroy(ma);
+	if (mb != b->csr)
+		_csr_destroy(mb);
+	return out;
+}
+
+/*
+ * Entries of a join operand widened to double. Half-Hermitian tensors are
+ * expanded to both triangles since the product of two stored triangles is
+ * not the stored triangle of the product.
+ */
+static
+uint64_t
+_join_entries(qg8_tensor *t,
+              uint64_t ***indices,
+              double **re,
+              double **im)
+{
+	uint64_t n, e, m, r, c;
+	double *vr, *vi;
+
+	vr = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(vr);
+	vi = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(vi);
+	_tensor_to_double(t, vr, vi);
+	if (t->packing != QG8_PACKING_HALF_HERMITIAN || t->rank != 2)
+	{
+		*indices = t->indices;
+		*re = vr;
+		*im = vi;
+		return t->num_elems;
+	}
+	n = t->num_elems;
+	for (e = 0; e < t->num_elems; ++e)
+		if (*(*(t->indices)+e) != *(*(t->indices+1)+e))
+			++n;
+	*indices = (uint64_t **) malloc(sizeof(uint64_t *) * 2);
+	ALLOC(*indices);
+	**indices = (uint64_t *) malloc(sizeof(uint64_t) * n);
+	ALLOC(**indices);
+	*(*indices+1) = (uint64_t *) malloc(sizeof(uint64_t) * n);
+	ALLOC(*(*indices+1));
+	*re = (double *) malloc(sizeof(double) * n);
+	ALLOC(*re);
+	*im = (double *) malloc(sizeof(double) * n);
+	ALLOC(*im);
+	for (e = 0, m = 0; e < t->num_elems; ++e)
+	{
+		r = *(*(t->indices)+e);
+		c = *(*(t->indices+1)+e);
+		*(**indices+m) = r;
+		*(*(*indices+1)+m) = c;
+		*(*re+m) = *(vr+e);
+		*(*im+m++) = *(vi+e);
+		if (r == c)
+			continue;
+		*(**indices+m) = c;
+		*(*(*indices+1)+m) = r;
+		*(*re+m) = *(vr+e);
+		*(*im+m++) = -*(vi+e);
+	}
+	free(vr);
+	free(vi);
+	return n;
+}
+
+static
+void
+_join_entries_free(qg8_tensor *t,
+                   uint64_t **indices,
+                   double *re,
+                   double *im)
+{
+	if (indices != t->indices)
+	{
+		free(*indices);
+		free(*(indices+1));
+		free(indices);
+	}
+	free(re);
+	free(im);
+}
+
+/*
+ * Kronecker product of two tensors of equal rank. Every dimension of the
+ * result is the product of the matching operand dimensions. Output
+ * positions are computed arithmetically, so the entries are filled in
+ * parallel, one entry of a at a time.
+ */
+qg8_tensor *
+qg8_tensor_join(qg8_tensor *a,
+                qg8_tensor *b)
+{
+	qg8_tensor *out, *pa, *pb;
+	uint64_t **ai, **bi, *shape, na, nb, ea;
+	double *are, *aim, *bre, *bim, *ore, *oim;
+	size_t i;
+	int full, cplx;
+
+	if (!a || !b)
+	{
+		DIE("Cannot join a NULL tensor.\n");
+	}
+	if (a->rank != b->rank)
+	{
+		fprintf(stderr, "Cannot join tensors of rank %d and %d.\n",
+		        a->rank, b->rank);
+		exit(EXIT_FAILURE);
+	}
+	/*
+	 * Pauli sums stay Pauli sums, mixed with other packings they are
+	 * expanded like DIA and BSR tensors
+	 */
+	if (a->packing == QG8_PACKING_PAULI && b->packing == QG8_PACKING_PAULI)
+		return _pauli_join(a, b);
+	if (_tensor_is_packed(a) || _tensor_is_packed(b))
+	{
+		pa = _tensor_is_packed(a) ? _tensor_expand(a) : a;
+		pb = _tensor_is_packed(b) ? _tensor_expand(b) : b;
+		out = qg8_tensor_join(pa, pb);
+		if (pa != a)
+			qg8_tensor_destroy(pa);
+		if (pb != b)
+			qg8_tensor_destroy(pb);
+		return out;
+	}
+	shape = (uint64_t *) malloc(sizeof(uint64_t) * a->rank);
+	ALLOC(shape);
+	for (i = 0; i < a->rank; ++i)
+		*(shape+i) = *(a->dimensions+i) * *(b->dimensions+i);
+	full = a->packing == QG8_PACKING_FULL && b->packing == QG8_PACKING_FULL;
+	cplx = _tensor_is_complex(a) || _tensor_is_complex(b);
+	na = _join_entries(a, &ai, &are, &aim);
+	nb = _join_entries(b, &bi, &bre, &bim);
+	out = _tensor_new(full ? QG8_PACKING_FULL : QG8_PACKING_SPARSE_COO,
+	                  a->rank, shape, na * nb, cplx);
+	free(shape);
+	ore = (double *) out->redata;
+	oim = (double *) out->imdata;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(na * nb > 65536)
+#endif /* _OPENMP */
+	for (ea = 0; ea < na; ++ea)
+	{
+		uint64_t eb, pos, lin;
+		size_t d;
+		for (eb = 0; eb < nb; ++eb)
+		{
+			/* full results are laid out row-major, sparse ones a-major */
+			pos = ea * nb + eb;
+			if (full)
+			{
+				lin = 0;
+				for (d = 0; d < a->rank; ++d)
+				{
+					lin = lin * *(out->dimensions+d) +
+					      *(*(ai+d)+ea) * *(b->dimensions+d) +
+					      *(*(bi+d)+eb);
+				}
+				pos = lin;
+			}
+			for (d = 0; d < a->rank; ++d)
+			{
+				*(*(out->indices+d)+pos) =
+					*(*(ai+d)+ea) * *(b->dimensions+d) + *(*(bi+d)+eb);
+			}
+			*(ore+pos) = *(are+ea) * *(bre+eb) - *(aim+ea) * *(bim+eb);
+			if (oim)
+				*(oim+pos) = *(are+ea) * *(bim+eb) + *(aim+ea) * *(bre+eb);
+		}
+	}
+
+	_join_entries_free(a, ai, are, aim);
+	_join_entries_free(b, bi, bre, bim);
+	return out;
+}
@@ -0,0 +1,434 @@
+/*
+ * pauli.c
+ * QG8 base library Pauli string source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A tensor in QG8_PACKING_PAULI packing is a 2^n x 2^n operator stored as a
+ * sum of Pauli strings. Entry e holds the X mask in indices[0][e], the Z
+ * mask in indices[1][e] and the coefficient in the data. Bit n-1-q of a
+ * mask belongs to qubit q, so qubit 0 is the most significant bit of a
+ * basis state like everywhere else. A qubit with only X set carries X, only
+ * Z set Z, both Y; since Y = iXZ, a string acts on a basis state as
+ *   P|b> = i^|x&z| (-1)^|b&z| |b^x>
+ * where |.| counts the set bits.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* basis states, or state pairs, per partial sum */
+#define PAULI_BLOCK 4096
+
+static
+uint64_t
+_popcount(uint64_t v)
+{
+	v = v - ((v >> 1) & 0x5555555555555555UL);
+	v = (v & 0x3333333333333333UL) + ((v >> 2) & 0x3333333333333333UL);
+	v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fUL;
+	return (v * 0x0101010101010101UL) >> 56;
+}
+
+static
+uint64_t
+_parity(uint64_t v)
+{
+	v ^= v >> 32;
+	v ^= v >> 16;
+	v ^= v >> 8;
+	v ^= v >> 4;
+	return (0x6996 >> (v & 0xf)) & 1;
+}
+
+static
+uint64_t
+_high_bit(uint64_t v)
+{
+	uint64_t h;
+
+	h = 1;
+	while (v >>= 1)
+		h <<= 1;
+	return h;
+}
+
+/*
+ * Number of qubits of a Pauli sum. The operator must be square with a
+ * power of two dimension and every mask must fit in it.
+ */
+uint64_t
+_pauli_qubits(qg8_tensor *t)
+{
+	uint64_t d, n, e;
+
+	d = *(t->dimensions);
+	if (t->rank != 2 || d != *(t->dimensions+1) || (d & (d - 1)) != 0)
+	{
+		DIE("Pauli sum is not a square operator on qubits.\n");
+	}
+	for (e = 0; e < t->num_elems; ++e)
+	{
+		if (*(*(t->indices)+e) >= d || *(*(t->indices+1)+e) >= d)
+		{
+			DIE("Pauli mask is out of bounds.\n");
+		}
+	}
+	for (n = 0; (1UL << n) < d; ++n)
+		;
+	return n;
+}
+
+/* coefficients with the i^|x&z| of the strings folded in */
+static
+void
+_pauli_phases(qg8_tensor *t,
+              double *pr,
+              double *pi)
+{
+	double r, i;
+	uint64_t e;
+
+	_tensor_to_double(t, pr, pi);
+	for (e = 0; e < t->num_elems; ++e)
+	{
+		r = *(pr+e);
+		i = *(pi+e);
+		switch (_popcount(*(*(t->indices)+e) & *(*(t->indices+1)+e)) & 3)
+		{
+		case 1:
+			*(pr+e) = -i;
+			*(pi+e) = r;
+			break;
+		case 2:
+			*(pr+e) = -r;
+			*(pi+e) = -i;
+			break;
+		case 3:
+			*(pr+e) = i;
+			*(pi+e) = -r;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+/*
+ * y = sum_e c_e P_e x. Every output element gathers from the basis states
+ * x[a^x_e], so blocks of y are filled independently and without atomics.
+ */
+void
+_pauli_apply(qg8_tensor *t,
+             const double *xr,
+             const double *xi,
+             double *yr,
+             double *yi)
+{
+	double *pr, *pi;
+	uint64_t d, nb, blk;
+
+	_pauli_qubits(t);
+	d = *(t->dimensions);
+	pr = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(pr);
+	pi = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(pi);
+	_pauli_phases(t, pr, pi);
+
+	nb = (d + PAULI_BLOCK - 1) / PAULI_BLOCK;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(nb > 1)
+#endif /* _OPENMP */
+	for (blk = 0; blk < nb; ++blk)
+	{
+		uint64_t a, b, lo, hi, e, x, z;
+		double cr, ci, sr, si;
+		int neg;
+
+		lo = blk * PAULI_BLOCK;
+		hi = MIN(lo + PAULI_BLOCK, d);
+		for (a = lo; a < hi; ++a)
+		{
+			*(yr+a) = 0.0;
+			*(yi+a) = 0.0;
+		}
+		for (e = 0; e < t->num_elems; ++e)
+		{
+			x = *(*(t->indices)+e);
+			z = *(*(t->indices+1)+e);
+			for (a = lo; a < hi; ++a)
+			{
+				b = a ^ x;
+				neg = (int) _parity(b & z);
+				cr = neg ? -*(pr+e) : *(pr+e);
+				ci = neg ? -*(pi+e) : *(pi+e);
+				sr = *(xr+b);
+				si = *(xi+b);
+				*(yr+a) += cr * sr - ci * si;
+				*(yi+a) += cr * si + ci * sr;
+			}
+		}
+	}
+	free(pr);
+	free(pi);
+}
+
+/*
+ * <x|sum_e c_e P_e|x>. For a string with x != 0 the states b and b^x are
+ * visited as one pair, taking b with the highest bit of x clear, and the
+ * pair adds A + (-1)^|x&z| conj(A) with A = conj(x[b^x]) (-1)^|b&z| x[b].
+ * Times i^|x&z| that sum is real, so only half the states are read per
+ * string. Partial sums are kept per block of pairs and added in order.
+ */
+void
+_pauli_expectation(qg8_tensor *t,
+                   const double *xr,
+                   const double *xi,
+                   double *re,
+                   double *im)
+{
+	double *cr, *ci, *part;
+	uint64_t d, half, nb, blk;
+
+	_pauli_qubits(t);
+	d = *(t->dimensions);
+	half = MAX(d / 2, 1);
+	cr = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(cr);
+	ci = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(ci);
+	_tensor_to_double(t, cr, ci);
+
+	nb = (half + PAULI_BLOCK - 1) / PAULI_BLOCK;
+	part = (double *) malloc(sizeof(double) * 2 * nb);
+	ALLOC(part);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(nb > 1)
+#endif /* _OPENMP */
+	for (blk = 0; blk < nb; ++blk)
+	{
+		uint64_t j, lo, hi, e, x, z, h, b, c;
+		double ar, ai, r, s;
+
+		lo = blk * PAULI_BLOCK;
+		hi = MIN(lo + PAULI_BLOCK, half);
+		*(part+2*blk) = 0.0;
+		*(part+2*blk+1) = 0.0;
+		for (e = 0; e < t->num_elems; ++e)
+		{
+			x = *(*(t->indices)+e);
+			z = *(*(t->indices+1)+e);
+			if (x == 0)
+			{
+				/* diagonal string: pairs are (2j, 2j+1) */
+				r = 0.0;
+				for (b = 2 * lo; b < MIN(2 * hi, d); ++b)
+				{
+					s = *(xr+b) * *(xr+b) + *(xi+b) * *(xi+b);
+					r += _parity(b & z) ? -s : s;
+				}
+				*(part+2*blk) += *(cr+e) * r;
+				*(part+2*blk+1) += *(ci+e) * r;
+				continue;
+			}
+			h = _high_bit(x);
+			ar = 0.0;
+			ai = 0.0;
+			for (j = lo; j < hi; ++j)
+			{
+				b = ((j & ~(h - 1)) << 1) | (j & (h - 1));
+				c = b ^ x;
+				s = _parity(b & z) ? -1.0 : 1.0;
+				ar += s * (*(xr+c) * *(xr+b) + *(xi+c) * *(xi+b));
+				ai += s * (*(xr+c) * *(xi+b) - *(xi+c) * *(xr+b));
+			}
+			switch (_popcount(x & z) & 3)
+			{
+			case 0:
+				r = 2.0 * ar;
+				break;
+			case 1:
+				r = -2.0 * ai;
+				break;
+			case 2:
+				r = -2.0 * ar;
+				break;
+			default:
+				r = 2.0 * ai;
+				break;
+			}
+			*(part+2*blk) += *(cr+e) * r;
+			*(part+2*blk+1) += *(ci+e) * r;
+		}
+	}
+	*re = 0.0;
+	*im = 0.0;
+	for (blk = 0; blk < nb; ++blk)
+	{
+		*re += *(part+2*blk);
+		*im += *(part+2*blk+1);
+	}
+	free(part);
+	free(cr);
+	free(ci);
+}
+
+/* explicit sparse COO form, one entry per string and basis state */
+qg8_tensor *
+_pauli_expand(qg8_tensor *t)
+{
+	qg8_tensor *out;
+	double *pr, *pi;
+	uint64_t d, e, b, x, z, p;
+	int neg;
+
+	_pauli_qubits(t);
+	d = *(t->dimensions);
+	pr = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(pr);
+	pi = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(pi);
+	_pauli_phases(t, pr, pi);
+	out = _tensor_new(QG8_PACKING_SPARSE_COO, 2, t->dimensions,
+	                  t->num_elems * d, 1);
+	for (e = 0; e < t->num_elems; ++e)
+	{
+		x = *(*(t->indices)+e);
+		z = *(*(t->indices+1)+e);
+		for (b = 0; b < d; ++b)
+		{
+			p = e * d + b;
+			neg = (int) _parity(b & z);
+			*(*(out->indices)+p) = b ^ x;
+			*(*(out->indices+1)+p) = b;
+			*((double *) out->redata+p) = neg ? -*(pr+e) : *(pr+e);
+			*((double *) out->imdata+p) = neg ? -*(pi+e) : *(pi+e);
+		}
+	}
+	free(pr);
+	free(pi);
+	return out;
+}
+
+/*
+ * Kronecker product of two Pauli sums, itself a Pauli sum: the masks of
+ * every pair of strings are concatenated and the coefficients multiplied.
+ */
+qg8_tensor *
+_pauli_join(qg8_tensor *a,
+            qg8_tensor *b)
+{
+	qg8_tensor *out;
+	double *ar, *ai, *br, *bi;
+	uint64_t shape[2], na, nb, e, f, p;
+
+	na = _pauli_qubits(a);
+	nb = _pauli_qubits(b);
+	if (na + nb > 63)
+	{
+		DIE("Pauli sum has too many qubits.\n");
+	}
+	ar = (double *) malloc(sizeof(double) * MAX(a->num_elems, 1));
+	ALLOC(ar);
+	ai = (double *) malloc(sizeof(double) * MAX(a->num_elems, 1));
+	ALLOC(ai);
+	br = (double *) malloc(sizeof(double) * MAX(b->num_elems, 1));
+	ALLOC(br);
+	bi = (double *) malloc(sizeof(double) * MAX(b->num_elems, 1));
+	ALLOC(bi);
+	_tensor_to_double(a, ar, ai);
+	_tensor_to_double(b, br, bi);
+	shape[0] = *(a->dimensions) * *(b->dimensions);
+	shape[1] = shape[0];
+	out = _tensor_new(QG8_PACKING_PAULI, 2, shape,
+	                  a->num_elems * b->num_elems, 1);
+	for (e = 0; e < a->num_elems; ++e)
+	{
+		for (f = 0; f < b->num_elems; ++f)
+		{
+			p = e * b->num_elems + f;
+			*(*(out->indices)+p) = (*(*(a->indices)+e) << nb) |
+			                       *(*(b->indices)+f);
+			*(*(out->indices+1)+p) = (*(*(a->indices+1)+e) << nb) |
+			                         *(*(b->indices+1)+f);
+			*((double *) out->redata+p) = *(ar+e) * *(br+f) -
+			                              *(ai+e) * *(bi+f);
+			*((double *) out->imdata+p) = *(ar+e) * *(bi+f) +
+			                              *(ai+e) * *(br+f);
+		}
+	}
+	free(ar);
+	free(ai);
+	free(br);
+	free(bi);
+	return out;
+}
+
+/*
+ * Reads a Pauli string such as "XIZY", qubit 0 first, into its X and Z
+ * masks.
+ */
+int
+qg8_pauli_parse(const char *s,
+                uint64_t *x,
+                uint64_t *z)
+{
+	int n;
+
+	if (!s || !x || !z)
+	{
+		DIE("Cannot parse a NULL Pauli string.\n");
+	}
+	*x = 0;
+	*z = 0;
+	for (n = 0; *s; ++s, ++n)
+	{
+		if (n == 63)
+		{
+			DIE("Pauli string has too many qubits.\n");
+		}
+		*x <<= 1;
+		*z <<= 1;
+		switch (*s)
+		{
+		case 'I':
+			break;
+		case 'X':
+			*x |= 1;
+			break;
+		case 'Y':
+			*x |= 1;
+			*z |= 1;
+			break;
+		case 'Z':
+			*z |= 1;
+			break;
+		default:
+			fprintf(stderr, "Invalid Pauli operator '%c'.\n", *s);
+			exit(EXIT_FAILURE);
+		}
+	}
+	return 1;
+}
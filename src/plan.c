@@ -0,0 +1,294 @@
+/*
+ * plan.c
+ * QG8 base library product chain planner source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* cell of the n*n interval tables for the sub-chain i..j */
+#define CELL(i,j) ((i) * n + (j))
+
+/* stored entries of a tensor once half-Hermitian or Pauli packing is expanded */
+static
+double
+_effective_nnz(qg8_tensor *t)
+{
+	if (t->packing == QG8_PACKING_HALF_HERMITIAN)
+		return 2.0 * (double) t->num_elems;
+	if (t->packing == QG8_PACKING_PAULI)
+		return (double) t->num_elems * (double) *(t->dimensions);
+	return (double) t->num_elems;
+}
+
+/*
+ * Expected cost of multiplying an m*k matrix holding nnza entries by a k*n
+ * matrix holding nnzb entries, assuming uniformly scattered entries. Every
+ * entry of the left operand meets nnzb/k entries of the right one, and an
+ * output cell stays empty only if all k candidate products miss it.
+ */
+static
+void
+_estimate_matmul(double m,
+                 double k,
+                 double n,
+                 double nnza,
+                 double nnzb,
+                 double *nnzc,
+                 double *cost)
+{
+	double flops, p;
+
+	flops = nnza * nnzb / k;
+	p = (nnza / (m * k)) * (nnzb / (k * n));
+	if (p * k < 1e-6)
+		*nnzc = m * n * p * k;
+	else
+		*nnzc = m * n * (1.0 - pow(1.0 - p, k));
+	*nnzc = MIN(*nnzc, m * n);
+	*cost = flops + *nnzc;
+}
+
+static
+uint64_t
+_emit_steps(qg8_plan *plan,
+            uint64_t *split,
+            uint64_t n,
+            uint64_t i,
+            uint64_t j,
+            uint64_t *step)
+{
+	uint64_t l, r;
+
+	if (i == j)
+		return i;
+	l = _emit_steps(plan, split, n, i, *(split+CELL(i,j)), step);
+	r = _emit_steps(plan, split, n, *(split+CELL(i,j)) + 1, j, step);
+	*(plan->steps+2*(*step)) = l;
+	*(plan->steps+2*(*step)+1) = r;
+	return n + (*step)++;
+}
+
+/*
+ * Chooses the cheapest association order of a product chain with the
+ * classic O(n^3) interval dynamic program. Matrix products are costed from
+ * the operand shapes and entry counts; Kronecker products always yield the
+ * same final tensor, so for them the program minimises the entries of the
+ * intermediates instead.
+ */
+qg8_plan *
+qg8_plan_create(uint16_t type,
+                qg8_tensor **operands,
+                uint64_t num)
+{
+	qg8_plan *plan;
+	double *rows, *cols, *nnz, *cost, nnzc, c;
+	uint64_t *split, n, i, j, k, len, step;
+
+	if (!operands)
+	{
+		DIE("Cannot plan a chain with NULL operands.\n");
+	}
+	if (type != QG8_TYPE_MATMUL && type != QG8_TYPE_JOIN)
+	{
+		fprintf(stderr, "Cannot plan a chain of chunk type %d.\n", type);
+		exit(EXIT_FAILURE);
+	}
+	if (num < 1)
+	{
+		DIE("Cannot plan a chain without operands.\n");
+	}
+
+	n = num;
+	rows = (double *) malloc(sizeof(double) * n * n);
+	ALLOC(rows);
+	cols = (double *) malloc(sizeof(double) * n * n);
+	ALLOC(cols);
+	nnz = (double *) malloc(sizeof(double) * n * n);
+	ALLOC(nnz);
+	cost = (double *) malloc(sizeof(double) * n * n);
+	ALLOC(cost);
+	split = (uint64_t *) malloc(sizeof(uint64_t) * n * n);
+	ALLOC(split);
+
+	for (i = 0; i < n; ++i)
+	{
+		if (!*(operands+i))
+		{
+			DIE("Cannot plan a chain with a NULL operand.\n");
+		}
+		if (type == QG8_TYPE_JOIN)
+		{
+			if ((*(operands+i))->rank != (*operands)->rank)
+			{
+				DIE("Cannot plan a join of tensors with different ranks.\n");
+			}
+			*(rows+CELL(i,i)) = 0;
+			*(cols+CELL(i,i)) = 0;
+		}
+		else if ((*(operands+i))->rank == 2)
+		{
+			*(rows+CELL(i,i)) = (double) *((*(operands+i))->dimensions);
+			*(cols+CELL(i,i)) = (double) *((*(operands+i))->dimensions+1);
+		}
+		else if ((*(operands+i))->rank == 1 && (i == 0 || i == n - 1))
+		{
+			/* a leading vector is a bra, a trailing vector a ket */
+			*(rows+CELL(i,i)) = i == 0 && n > 1 ? 1.0 :
+			                    (double) *((*(operands+i))->dimensions);
+			*(cols+CELL(i,i)) = i == 0 && n > 1 ?
+			                    (double) *((*(operands+i))->dimensions) : 1.0;
+		}
+		else
+		{
+			DIE("Cannot plan a product with a vector inside the chain.\n");
+		}
+		if (type == QG8_TYPE_MATMUL && i > 0 &&
+		    *(cols+CELL(i-1,i-1)) != *(rows+CELL(i,i)))
+		{
+			fprintf(stderr, "Cannot plan a product with mismatched "
+			        "dimensions at operand %lu.\n", i);
+			exit(EXIT_FAILURE);
+		}
+		*(nnz+CELL(i,i)) = _effective_nnz(*(operands+i));
+		*(cost+CELL(i,i)) = 0.0;
+	}
+
+	for (len = 2; len <= n; ++len)
+	{
+		for (i = 0; i + len <= n; ++i)
+		{
+			j = i + len - 1;
+			*(rows+CELL(i,j)) = *(rows+CELL(i,i));
+			*(cols+CELL(i,j)) = *(cols+CELL(j,j));
+			*(cost+CELL(i,j)) = HUGE_VAL;
+			for (k = i; k < j; ++k)
+			{
+				if (type == QG8_TYPE_MATMUL)
+				{
+					_estimate_matmul(*(rows+CELL(i,k)), *(cols+CELL(i,k)),
+					                 *(cols+CELL(k+1,j)), *(nnz+CELL(i,k)),
+					                 *(nnz+CELL(k+1,j)), &nnzc, &c);
+				}
+				else
+				{
+					nnzc = *(nnz+CELL(i,k)) * *(nnz+CELL(k+1,j));
+					c = nnzc;
+				}
+				c += *(cost+CELL(i,k)) + *(cost+CELL(k+1,j));
+				if (c < *(cost+CELL(i,j)))
+				{
+					*(cost+CELL(i,j)) = c;
+					*(nnz+CELL(i,j)) = nnzc;
+					*(split+CELL(i,j)) = k;
+				}
+			}
+		}
+	}
+
+	plan = (qg8_plan *) malloc(sizeof(qg8_plan));
+	ALLOC(plan);
+	plan->type = type;
+	plan->num_operands = n;
+	plan->cost = *(cost+CELL(0,n-1));
+	plan->steps = (uint64_t *) malloc(sizeof(uint64_t) * 2 * MAX(n - 1, 1));
+	ALLOC(plan->steps);
+	step = 0;
+	_emit_steps(plan, split, n, 0, n - 1, &step);
+
+	free(rows);
+	free(cols);
+	free(nnz);
+	free(cost);
+	free(split);
+	return plan;
+}
+
+/*
+ * Runs the planned steps in order. Operands keep their ownership, every
+ * intermediate is released as soon as it has been consumed.
+ */
+qg8_tensor *
+qg8_plan_execute(qg8_plan *plan,
+                 qg8_tensor **operands)
+{
+	qg8_tensor **slots, *res;
+	uint64_t n, s, l, r;
+
+	if (!plan)
+	{
+		DIE("Cannot execute a NULL plan.\n");
+	}
+	if (!operands)
+	{
+		DIE("Cannot execute a plan with NULL operands.\n");
+	}
+	n = plan->num_operands;
+	if (n == 1)
+		return _tensor_copy(*operands);
+
+	slots = (qg8_tensor **) malloc(sizeof(qg8_tensor *) * (2 * n - 1));
+	ALLOC(slots);
+	memcpy(slots, operands, sizeof(qg8_tensor *) * n);
+	for (s = 0; s < n - 1; ++s)
+	{
+		l = *(plan->steps+2*s);
+		r = *(plan->steps+2*s+1);
+		if (plan->type == QG8_TYPE_MATMUL)
+			*(slots+n+s) = qg8_tensor_matmul(*(slots+l), *(slots+r));
+		else
+			*(slots+n+s) = qg8_tensor_join(*(slots+l), *(slots+r));
+		if (l >= n)
+			qg8_tensor_destroy(*(slots+l));
+		if (r >= n)
+			qg8_tensor_destroy(*(slots+r));
+	}
+	res = *(slots+2*n-2);
+	free(slots);
+	return res;
+}
+
+double
+qg8_plan_get_cost(qg8_plan *plan)
+{
+	if (!plan)
+	{
+		DIE("Cannot get cost from a NULL plan.\n");
+	}
+	return plan->cost;
+}
+
+int
+qg8_plan_destroy(qg8_plan *plan)
+{
+	if (!plan)
+	{
+		DIE("Cannot destroy a NULL plan.\n");
+	}
+	free(plan->steps);
+	free(plan);
+	return 1;
+}
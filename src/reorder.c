@@ -0,0 +1,563 @@
+/*
+ * reorder.c
+ * QG8 base library bandwidth reducing reordering source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A permutation perm of n basis states sends new state i to old state
+ * perm[i]: a ket x becomes x'[i] = x[perm[i]] and an operator A becomes
+ * A'[i][j] = A[perm[i]][perm[j]], so A'x' is the relabelled Ax.
+ *
+ * qg8_tensor_rcm finds such a permutation with reverse Cuthill-McKee on the
+ * pattern of A + A^T: every connected component is walked breadth first
+ * from a pseudo-peripheral state, neighbours in increasing degree, and the
+ * whole order is reversed. The entries then gather near the diagonal, so
+ * the rows of a product read x over a short window instead of all of it.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* sweeps looking for a pseudo-peripheral starting state */
+#define RCM_SWEEPS 8
+
+/* element count above which relabelling runs in parallel */
+#define PERM_PAR   16384
+
+/* symmetric pattern of a square matrix, without the diagonal */
+typedef struct
+rcm_graph_s
+{
+	uint64_t n;
+	uint64_t *ptr;
+	uint64_t *adj;
+	uint64_t *deg;
+} rcm_graph;
+
+static
+int
+_rcm_compare(const void *a,
+             const void *b)
+{
+	uint64_t x, y;
+
+	x = *((const uint64_t *) a);
+	y = *((const uint64_t *) b);
+	return x < y ? -1 : x > y;
+}
+
+/* rows of the pattern of A + A^T, sorted and without duplicates */
+static
+void
+_rcm_graph(qg8_tensor *t,
+           rcm_graph *g)
+{
+	qg8_csr *m;
+	uint64_t *fill, r, p, c, q, k;
+
+	m = _csr_from_tensor(t, 0);
+	g->n = m->rows;
+	g->ptr = (uint64_t *) calloc(g->n + 1, sizeof(uint64_t));
+	ALLOC(g->ptr);
+	for (r = 0; r < g->n; ++r)
+	{
+		for (p = *(m->rowptr+r); p < *(m->rowptr+r+1); ++p)
+		{
+			c = *(m->colidx+p);
+			if (c == r)
+				continue;
+			(*(g->ptr+r+1))++;
+			(*(g->ptr+c+1))++;
+		}
+	}
+	for (r = 0; r < g->n; ++r)
+		*(g->ptr+r+1) += *(g->ptr+r);
+	g->adj = (uint64_t *) malloc(sizeof(uint64_t) * MAX(*(g->ptr+g->n), 1));
+	ALLOC(g->adj);
+	fill = (uint64_t *) malloc(sizeof(uint64_t) * MAX(g->n, 1));
+	ALLOC(fill);
+	memcpy(fill, g->ptr, sizeof(uint64_t) * g->n);
+	for (r = 0; r < g->n; ++r)
+	{
+		for (p = *(m->rowptr+r); p < *(m->rowptr+r+1); ++p)
+		{
+			c = *(m->colidx+p);
+			if (c == r)
+				continue;
+			*(g->adj+(*(fill+r))++) = c;
+			*(g->adj+(*(fill+c))++) = r;
+		}
+	}
+	_csr_destroy(m);
+
+	/* squeeze the duplicates out, rows move down in place */
+	g->deg = fill;
+	q = 0;
+	for (r = 0; r < g->n; ++r)
+	{
+		p = *(g->ptr+r);
+		k = *(g->ptr+r+1);
+		qsort(g->adj + p, k - p, sizeof(uint64_t), _rcm_compare);
+		*(g->ptr+r) = q;
+		for (; p < k; ++p)
+			if (q == *(g->ptr+r) || *(g->adj+q-1) != *(g->adj+p))
+				*(g->adj+q++) = *(g->adj+p);
+		*(g->deg+r) = q - *(g->ptr+r);
+	}
+	*(g->ptr+g->n) = q;
+}
+
+/* sorts the states a..b-1 of a level by degree, then by index */
+static
+void
+_rcm_sort(rcm_graph *g,
+          uint64_t *order,
+          uint64_t a,
+          uint64_t b)
+{
+	uint64_t i, j, v;
+
+	/* levels are short next to the cost of building them */
+	for (i = a + 1; i < b; ++i)
+	{
+		v = *(order+i);
+		for (j = i; j > a && (*(g->deg+*(order+j-1)) > *(g->deg+v) ||
+		     (*(g->deg+*(order+j-1)) == *(g->deg+v) &&
+		      *(order+j-1) > v)); --j)
+			*(order+j) = *(order+j-1);
+		*(order+j) = v;
+	}
+}
+
+/*
+ * Breadth first walk of the component of s, appended to order from pos
+ * in Cuthill-McKee order. mark holds stamp for visited states. Returns
+ * the end of the walk and sets *depth and *last to the number of levels
+ * and a least degree state of the last one.
+ */
+static
+uint64_t
+_rcm_walk(rcm_graph *g,
+          uint64_t s,
+          uint64_t *order,
+          uint64_t pos,
+          uint64_t *mark,
+          uint64_t stamp,
+          uint64_t *depth,
+          uint64_t *last)
+{
+	uint64_t head, end, lvl, v, p, w, i;
+
+	*(order+pos) = s;
+	*(mark+s) = stamp;
+	head = pos;
+	end = pos + 1;
+	*depth = 0;
+	while (head < end)
+	{
+		/* the current level is order[head..lvl-1] */
+		lvl = end;
+		*last = *(order+head);
+		for (i = head; i < lvl; ++i)
+			if (*(g->deg+*(order+i)) < *(g->deg+*last))
+				*last = *(order+i);
+		for (; head < lvl; ++head)
+		{
+			v = *(order+head);
+			i = end;
+			for (p = *(g->ptr+v); p < *(g->ptr+v+1); ++p)
+			{
+				w = *(g->adj+p);
+				if (*(mark+w) == stamp)
+					continue;
+				*(mark+w) = stamp;
+				*(order+end++) = w;
+			}
+			_rcm_sort(g, order, i, end);
+		}
+		++*depth;
+	}
+	return end;
+}
+
+/*
+ * Returns a reverse Cuthill-McKee permutation of a square rank 2 tensor
+ * in any packing, as an array of its dimension which the caller frees.
+ */
+uint64_t *
+qg8_tensor_rcm(qg8_tensor *t)
+{
+	rcm_graph g;
+	uint64_t *order, *mark, *perm, pos, end, s, v, depth, best, last, i;
+	uint64_t stamp, sweep;
+
+	if (!t)
+	{
+		DIE("Cannot reorder a NULL tensor.\n");
+	}
+	if (t->rank != 2 || *(t->dimensions) != *(t->dimensions+1))
+	{
+		DIE("Cannot reorder a tensor which is not a square matrix.\n");
+	}
+	_rcm_graph(t, &g);
+	order = (uint64_t *) malloc(sizeof(uint64_t) * MAX(g.n, 1));
+	ALLOC(order);
+	mark = (uint64_t *) calloc(MAX(g.n, 1), sizeof(uint64_t));
+	ALLOC(mark);
+	stamp = 1;
+	pos = 0;
+	for (v = 0; v < g.n; ++v)
+	{
+		if (*(mark+v))
+			continue;
+		/* a deeper walk from the far end, while the depth grows */
+		s = v;
+		end = _rcm_walk(&g, s, order, pos, mark, ++stamp, &best, &last);
+		for (i = pos; i < end; ++i)
+			if (*(g.deg+*(order+i)) < *(g.deg+s))
+				s = *(order+i);
+		for (sweep = 0; sweep < RCM_SWEEPS; ++sweep)
+		{
+			_rcm_walk(&g, s, order, pos, mark, ++stamp, &depth, &last);
+			if (depth <= best && sweep > 0)
+				break;
+			best = depth;
+			s = last;
+		}
+		end = _rcm_walk(&g, s, order, pos, mark, ++stamp, &depth, &last);
+		/* marks stay positive, so later components skip this one */
+		pos = end;
+	}
+	perm = (uint64_t *) malloc(sizeof(uint64_t) * MAX(g.n, 1));
+	ALLOC(perm);
+	for (i = 0; i < g.n; ++i)
+		*(perm+i) = *(order+g.n-1-i);
+	free(order);
+	free(mark);
+	free(g.ptr);
+	free(g.adj);
+	free(g.deg);
+	return perm;
+}
+
+/* the axes a permutation applies to, see qg8_tensor_permute */
+static
+uint64_t
+_perm_axes(qg8_tensor *t,
+           int *axes)
+{
+	uint64_t n;
+
+	axes[0] = 0;
+	axes[1] = 0;
+	axes[2] = 0;
+	if (t->rank == 1 || (t->rank == 2 && *(t->dimensions+1) == 1))
+	{
+		axes[0] = 1;
+		return *(t->dimensions);
+	}
+	n = *(t->dimensions+t->rank-1);
+	if ((t->rank == 2 && *(t->dimensions) == n) ||
+	    (t->rank == 3 && *(t->dimensions+1) == n))
+	{
+		axes[t->rank-2] = 1;
+		axes[t->rank-1] = 1;
+		return n;
+	}
+	return 0;
+}
+
+/*
+ * Returns a copy of t with its basis states relabelled by perm, or by its
+ * inverse. t is a ket (rank 1, or rank 2 with one column), a square
+ * operator or a NOISESPEC stack of m n x n Kraus operators, perm holds n
+ * states. Pauli, DIA and BSR tensors come back in sparse COO packing,
+ * the others keep their packing and dtype.
+ */
+qg8_tensor *
+qg8_tensor_permute(qg8_tensor *t,
+                   const uint64_t *perm,
+                   int inverse)
+{
+	qg8_tensor *src, *out;
+	const uint64_t *fwd, *back;
+	uint64_t *inv, n, i, e, dsize;
+	int axes[3];
+
+	if (!t || !perm)
+	{
+		DIE("Cannot permute a NULL tensor.\n");
+	}
+	n = _perm_axes(t, axes);
+	if (n == 0)
+	{
+		DIE("Cannot permute a tensor which is not a ket or an "
+		    "operator.\n");
+	}
+	inv = (uint64_t *) malloc(sizeof(uint64_t) * n);
+	ALLOC(inv);
+	for (i = 0; i < n; ++i)
+		*(inv+i) = n;
+	for (i = 0; i < n; ++i)
+	{
+		if (*(perm+i) >= n || *(inv+*(perm+i)) != n)
+		{
+			DIE("Permutation does not hold every state once.\n");
+		}
+		*(inv+*(perm+i)) = i;
+	}
+	/* fwd sends new states to old ones, back old states to new ones */
+	fwd = inverse ? inv : perm;
+	back = inverse ? perm : inv;
+	src = _tensor_is_packed(t) ? _tensor_expand(t) : t;
+	out = _tensor_copy(src);
+	dsize = _type_to_size(src->dtype_id);
+
+	if (src->packing == QG8_PACKING_FULL &&
+	    src->num_elems == _tensor_full_size(src))
+	{
+		/* dense: the coordinates stay, the values are gathered */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(src->num_elems > PERM_PAR)
+#endif /* _OPENMP */
+		for (e = 0; e < src->num_elems; ++e)
+		{
+			uint64_t f, x;
+			uint16_t k;
+
+			f = 0;
+			for (k = 0; k < src->rank; ++k)
+			{
+				x = *(*(src->indices+k)+e);
+				f = f * *(src->dimensions+k) + (axes[k] ? *(fwd+x) : x);
+			}
+			memcpy((uint8_t *) out->redata + e * dsize,
+			       (uint8_t *) src->redata + f * dsize, dsize);
+			if (out->imdata)
+				memcpy((uint8_t *) out->imdata + e * dsize,
+				       (uint8_t *) src->imdata + f * dsize, dsize);
+		}
+	}
+	else
+	{
+		/* sparse: the values stay, the coordinates are relabelled */
+		out->flags &= ~QG8_TENSOR_SORTED;
+		for (i = 0; i < src->rank; ++i)
+		{
+			if (!axes[i])
+				continue;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(src->num_elems > PERM_PAR)
+#endif /* _OPENMP */
+			for (e = 0; e < src->num_elems; ++e)
+				*(*(out->indices+i)+e) = *(back+*(*(src->indices+i)+e));
+		}
+	}
+	if (src != t)
+		qg8_tensor_destroy(src);
+	free(inv);
+	return out;
+}
+
+/* chunks holding states or operators, relabelled by qg8_graph_reorder */
+static
+int
+_is_relabelled(qg8_chunk *c,
+               uint64_t n)
+{
+	int axes[3];
+
+	return (c->type == QG8_TYPE_KET || c->type == QG8_TYPE_OPERATOR ||
+	        c->type == QG8_TYPE_OBSERVABLE ||
+	        c->type == QG8_TYPE_NOISESPEC) && c->tensor &&
+	       _perm_axes(c->tensor, axes) == n;
+}
+
+/*
+ * Number of basis states the value of node j acts on, 0 for scalars and
+ * anything unknown. JOIN multiplies those of its factors, the other
+ * operations keep the one of their operands.
+ */
+static
+uint64_t
+_state_dim(qg8_dag *dag,
+           uint64_t j,
+           uint64_t *dim,
+           uint8_t *seen)
+{
+	qg8_chunk *c;
+	uint64_t p, d;
+	int axes[3];
+
+	if (*(seen+j))
+		return *(dim+j);
+	*(seen+j) = 1;
+	c = *(dag->nodes+j);
+	d = 0;
+	if (c->type >= QG8_TYPE_INPUT && c->type <= QG8_TYPE_NOISESPEC)
+	{
+		if (c->tensor && c->type != QG8_TYPE_TIME &&
+		    c->type != QG8_TYPE_TRACK)
+			d = _perm_axes(c->tensor, axes);
+	}
+	else if (c->type == QG8_TYPE_JOIN)
+	{
+		d = 1;
+		for (p = *(dag->opptr+j); p < *(dag->opptr+j+1); ++p)
+			d *= _state_dim(dag, *(dag->opsrc+p), dim, seen);
+	}
+	else if (c->type != QG8_TYPE_EXPECTATIONVALUE &&
+	         c->type != QG8_TYPE_SAMPLE && c->type != QG8_TYPE_ADJACENCY &&
+	         c->type != QG8_TYPE_PERMUTATION)
+	{
+		for (p = *(dag->opptr+j); p < *(dag->opptr+j+1) && !d; ++p)
+			d = _state_dim(dag, *(dag->opsrc+p), dim, seen);
+	}
+	*(dim+j) = d;
+	return d;
+}
+
+/*
+ * Dies if relabelling the chunks of n states would leave the graph
+ * computing something else: an INPUT or CONSTANT operand of n states, or
+ * a JOIN building n states from factors the permutation cannot apply to.
+ */
+static
+void
+_reorder_check(qg8_graph *graph,
+               uint64_t n)
+{
+	qg8_dag *dag;
+	qg8_chunk *c, *o;
+	uint64_t *dim, j, p;
+	uint8_t *seen;
+
+	dag = _dag_build(graph);
+	dim = (uint64_t *) calloc(MAX(dag->num_nodes, 1), sizeof(uint64_t));
+	ALLOC(dim);
+	seen = (uint8_t *) calloc(MAX(dag->num_nodes, 1), sizeof(uint8_t));
+	ALLOC(seen);
+	for (j = 0; j < dag->num_nodes; ++j)
+	{
+		c = *(dag->nodes+j);
+		if (c->type < QG8_TYPE_ADD || c->type == QG8_TYPE_PERMUTATION)
+			continue;
+		if (c->type == QG8_TYPE_JOIN && _state_dim(dag, j, dim, seen) == n)
+		{
+			DIE("Cannot reorder a graph which builds operators of that "
+			    "dimension with JOIN.\n");
+		}
+		for (p = *(dag->opptr+j); p < *(dag->opptr+j+1); ++p)
+		{
+			o = *(dag->nodes+*(dag->opsrc+p));
+			if ((o->type == QG8_TYPE_INPUT ||
+			     o->type == QG8_TYPE_CONSTANT) &&
+			    _state_dim(dag, *(dag->opsrc+p), dim, seen) == n)
+			{
+				DIE("Cannot reorder a graph with INPUT or CONSTANT "
+				    "operands of that dimension.\n");
+			}
+		}
+	}
+	free(dim);
+	free(seen);
+	_dag_destroy(dag);
+}
+
+/*
+ * Relabels the basis of a graph with a reverse Cuthill-McKee permutation
+ * of the square operator held by op. The KET, OPERATOR, OBSERVABLE and
+ * NOISESPEC chunks the permutation applies to, see qg8_tensor_permute,
+ * get relabelled tensors, so the graph evaluates to the relabelled
+ * results. Graphs feeding INPUT or CONSTANT chunks of that dimension to
+ * an operation, or building such operators with JOIN, are refused. The
+ * replaced tensors are destroyed if they were loaded from a file; those
+ * the caller created stay theirs to destroy. The permutation is kept in a
+ * PERMUTATION chunk, a full UINT64 rank 1 tensor, added after all others
+ * so the adjacency indices stay valid; reordering again composes the new
+ * permutation into it. Results map back to the original basis with
+ * qg8_tensor_permute(result, perm, 1). Returns the PERMUTATION chunk.
+ */
+qg8_chunk *
+qg8_graph_reorder(qg8_graph *graph,
+                  qg8_chunk *op)
+{
+	qg8_chunk_linkedlist *l, *last;
+	qg8_chunk *pc;
+	qg8_tensor *t;
+	uint64_t *perm, *total, n, i;
+
+	if (!graph || !op || !op->tensor)
+	{
+		DIE("Cannot reorder a NULL graph or operator.\n");
+	}
+	n = *(op->tensor->dimensions);
+	_reorder_check(graph, n);
+	perm = qg8_tensor_rcm(op->tensor);
+	pc = NULL;
+	last = NULL;
+	for (l = graph->chunks; l; l = l->next)
+	{
+		last = l;
+		t = l->chunk->tensor;
+		if (l->chunk->type == QG8_TYPE_PERMUTATION && t &&
+		    t->dtype_id == QG8_DTYPE_UINT64 &&
+		    t->packing == QG8_PACKING_FULL && t->rank == 1 &&
+		    t->num_elems == n)
+			pc = l->chunk;
+		if (!_is_relabelled(l->chunk, n))
+			continue;
+		l->chunk->tensor = qg8_tensor_permute(t, perm, 0);
+		if (t->loaded)
+			qg8_tensor_destroy(t);
+	}
+
+	if (pc)
+	{
+		/* new state i was perm[i], which was total[perm[i]] */
+		total = (uint64_t *) pc->tensor->redata;
+		for (i = 0; i < n; ++i)
+			*(perm+i) = *(total+*(perm+i));
+		memcpy(total, perm, sizeof(uint64_t) * n);
+		free(perm);
+		return pc;
+	}
+	t = _tensor_new(QG8_PACKING_FULL, 1, &n, n, 0);
+	_tensor_fill_full_indices(t);
+	/* the data buffer holds n doubles, as wide as n UINT64 */
+	memcpy(t->redata, perm, sizeof(uint64_t) * n);
+	t->dtype_id = QG8_DTYPE_UINT64;
+	free(perm);
+	pc = qg8_chunk_create(QG8_TYPE_PERMUTATION, 0, NULL, t);
+	l = (qg8_chunk_linkedlist *) malloc(sizeof(qg8_chunk_linkedlist));
+	ALLOC(l);
+	l->chunk = pc;
+	l->next = NULL;
+	if (last)
+		last->next = l;
+	else
+		graph->chunks = l;
+	return pc;
+}
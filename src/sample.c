@@ -0,0 +1,306 @@
+/*
+ * sample.c
+ * QG8 base library measurement sampling source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Shots are drawn with Walker alias tables in two levels. The basis states
+ * are cut into blocks of ALIAS_BLOCK states, every block gets its own table
+ * over its states and one more table picks the block from the block masses.
+ * The block tables are independent and are built in parallel; a shot costs
+ * two table lookups whatever the size of the ket.
+ *
+ * The random numbers of shot s are the words 4s..4s+3 of a SplitMix64
+ * sequence, computed from the counter alone, so every shot sees the same
+ * numbers whichever thread draws it.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif /* _OPENMP */
+
+#include "macros.h"
+#include "qg8.h"
+
+/* basis states per second level table, fits the uint32_t aliases */
+#define ALIAS_BLOCK    65536
+/* kets up to this size are counted per thread instead of atomically */
+#define SAMPLE_PRIVATE 65536
+/* fewer shots are drawn by one thread */
+#define SAMPLE_PAR_MIN 16384
+
+SPLITMIX()
+
+static
+uint64_t
+_below(double u,
+       uint64_t n)
+{
+	uint64_t i;
+
+	i = (uint64_t) (u * (double) n);
+	return i < n ? i : n - 1;
+}
+
+/*
+ * Vose's construction of an alias table over n weights. prob holds the
+ * weights over their mean on return of the loop and the acceptance
+ * thresholds at the end; work needs n elements. The mean is summed from
+ * w/n so that it stays finite for any finite weights.
+ */
+static
+void
+_alias_build(const double *w,
+             uint64_t n,
+             double *prob,
+             uint32_t *alias,
+             uint32_t *work)
+{
+	uint64_t i, ns, nl, s, l, some;
+	double mean;
+
+	mean = 0.0;
+	for (i = 0; i < n; ++i)
+		mean += *(w+i) / (double) n;
+	if (!(mean > 0.0))
+	{
+		for (i = 0; i < n; ++i)
+		{
+			*(prob+i) = 1.0;
+			*(alias+i) = (uint32_t) i;
+		}
+		return;
+	}
+	/* small entries from the front of work, large ones from the back */
+	ns = 0;
+	nl = 0;
+	for (i = 0; i < n; ++i)
+	{
+		*(prob+i) = *(w+i) / mean;
+		*(alias+i) = (uint32_t) i;
+		if (*(prob+i) < 1.0)
+			*(work+ns++) = (uint32_t) i;
+		else
+			*(work+n-1-nl++) = (uint32_t) i;
+	}
+	while (ns > 0 && nl > 0)
+	{
+		s = *(work+--ns);
+		l = *(work+n-nl);
+		*(alias+s) = (uint32_t) l;
+		*(prob+l) = (*(prob+l) + *(prob+s)) - 1.0;
+		if (*(prob+l) < 1.0)
+		{
+			--nl;
+			*(work+ns++) = (uint32_t) l;
+		}
+	}
+	/*
+	 * left overs are full up to rounding, except those weighing nothing,
+	 * which always go to a state of some weight
+	 */
+	for (some = 0; some + 1 < n && !(*(w+some) > 0.0); ++some)
+		;
+	while (ns > 0 || nl > 0)
+	{
+		i = ns > 0 ? *(work+--ns) : *(work+n-nl--);
+		*(prob+i) = *(w+i) > 0.0 ? 1.0 : 0.0;
+		if (!(*(w+i) > 0.0))
+			*(alias+i) = (uint32_t) some;
+	}
+}
+
+/*
+ * Draws shots measurements of a ket in the computational basis and returns
+ * how often each basis state came up, as a sparse rank 1 UINT64 tensor of
+ * the ket dimension with increasing indices. The ket need not be
+ * normalised. The same seed gives the same histogram for any number of
+ * threads.
+ */
+qg8_tensor *
+qg8_tensor_sample(qg8_tensor *ket,
+                  uint64_t shots,
+                  uint64_t seed)
+{
+	qg8_tensor *out;
+	double *re, *im, *w, *mass, *prob, *bprob, total;
+	uint32_t *alias, *balias, *work;
+	uint64_t *counts, d, nb, b, i, key, nnz, shape[1];
+	int own;
+
+	if (!ket)
+	{
+		DIE("Cannot sample a NULL ket.\n");
+	}
+	if (ket->rank > 2 || (ket->rank == 2 && *(ket->dimensions+1) != 1))
+	{
+		DIE("Cannot sample a tensor which is not a ket.\n");
+	}
+	d = *(ket->dimensions);
+	own = ket->dtype_id != QG8_DTYPE_COMPLEX128 ||
+	      ket->packing != QG8_PACKING_FULL || ket->num_elems != d;
+	if (own)
+	{
+		re = (double *) malloc(sizeof(double) * d);
+		ALLOC(re);
+		im = (double *) malloc(sizeof(double) * d);
+		ALLOC(im);
+		_tensor_to_dense(ket, re, im);
+	}
+	else
+	{
+		re = (double *) ket->redata;
+		im = (double *) ket->imdata;
+	}
+
+	/*
+	 * weights and block masses, the latter over ALIAS_BLOCK so that they
+	 * stay finite; the tables are built in parallel
+	 */
+	nb = (d + ALIAS_BLOCK - 1) / ALIAS_BLOCK;
+	w = (double *) malloc(sizeof(double) * d);
+	ALLOC(w);
+	prob = (double *) malloc(sizeof(double) * d);
+	ALLOC(prob);
+	alias = (uint32_t *) malloc(sizeof(uint32_t) * d);
+	ALLOC(alias);
+	mass = (double *) malloc(sizeof(double) * nb);
+	ALLOC(mass);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) if(nb > 1)
+#endif /* _OPENMP */
+	for (b = 0; b < nb; ++b)
+	{
+		uint32_t *bw;
+		uint64_t lo, n, j;
+		double m;
+
+		lo = b * ALIAS_BLOCK;
+		n = MIN(ALIAS_BLOCK, d - lo);
+		m = 0.0;
+		for (j = lo; j < lo + n; ++j)
+		{
+			*(w+j) = *(re+j) * *(re+j) + *(im+j) * *(im+j);
+			m += *(w+j) / (double) ALIAS_BLOCK;
+		}
+		*(mass+b) = m;
+		bw = (uint32_t *) malloc(sizeof(uint32_t) * n);
+		ALLOC(bw);
+		_alias_build(w + lo, n, prob + lo, alias + lo, bw);
+		free(bw);
+	}
+	total = 0.0;
+	for (b = 0; b < nb; ++b)
+		total += *(mass+b);
+	if (total <= 0.0)
+	{
+		DIE("Cannot sample a ket of norm 0.\n");
+	}
+	bprob = (double *) malloc(sizeof(double) * nb);
+	ALLOC(bprob);
+	balias = (uint32_t *) malloc(sizeof(uint32_t) * nb);
+	ALLOC(balias);
+	work = (uint32_t *) malloc(sizeof(uint32_t) * nb);
+	ALLOC(work);
+	_alias_build(mass, nb, bprob, balias, work);
+	free(work);
+	free(w);
+	if (own)
+	{
+		free(re);
+		free(im);
+	}
+
+	counts = (uint64_t *) calloc(d, sizeof(uint64_t));
+	ALLOC(counts);
+	key = _mix(seed);
+#ifdef _OPENMP
+#pragma omp parallel if(shots > SAMPLE_PAR_MIN)
+#endif /* _OPENMP */
+	{
+		uint64_t *local, s, blk, k, n;
+
+		local = counts;
+#ifdef _OPENMP
+		if (d <= SAMPLE_PRIVATE && omp_get_num_threads() > 1)
+		{
+			local = (uint64_t *) calloc(d, sizeof(uint64_t));
+			ALLOC(local);
+		}
+#pragma omp for schedule(static)
+#endif /* _OPENMP */
+		for (s = 0; s < shots; ++s)
+		{
+			blk = _below(_unit(key, 4 * s), nb);
+			if (_unit(key, 4 * s + 1) >= *(bprob+blk))
+				blk = *(balias+blk);
+			n = MIN(ALIAS_BLOCK, d - blk * ALIAS_BLOCK);
+			k = blk * ALIAS_BLOCK + _below(_unit(key, 4 * s + 2), n);
+			if (_unit(key, 4 * s + 3) >= *(prob+k))
+				k = blk * ALIAS_BLOCK + *(alias+k);
+			if (local != counts)
+			{
+				++*(local+k);
+				continue;
+			}
+#ifdef _OPENMP
+#pragma omp atomic
+#endif /* _OPENMP */
+			++*(counts+k);
+		}
+		if (local != counts)
+		{
+#ifdef _OPENMP
+#pragma omp critical
+#endif /* _OPENMP */
+			for (k = 0; k < d; ++k)
+				*(counts+k) += *(local+k);
+			free(local);
+		}
+	}
+	free(prob);
+	free(alias);
+	free(mass);
+	free(bprob);
+	free(balias);
+
+	/* histogram, the counts are stored in the 8 byte data slots */
+	nnz = 0;
+	for (i = 0; i < d; ++i)
+		if (*(counts+i))
+			++nnz;
+	shape[0] = d;
+	out = _tensor_new(QG8_PACKING_SPARSE_COO, 1, shape, nnz, 0);
+	out->dtype_id = QG8_DTYPE_UINT64;
+	nnz = 0;
+	for (i = 0; i < d; ++i)
+	{
+		if (!*(counts+i))
+			continue;
+		*(*(out->indices)+nnz) = i;
+		*((uint64_t *) out->redata+nnz++) = *(counts+i);
+	}
+	free(counts);
+	return out;
+}
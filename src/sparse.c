@@ -0,0 +1,633 @@
+/*
+ * sparse.c
+ * QG8 base library sparse matrix source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif /* _OPENMP */
+
+#include "macros.h"
+#include "qg8.h"
+
+/* rows shorter than this are sorted by insertion */
+#define SORT_CUTOFF 32
+
+/* row partitions per thread, for load balance on skewed rows */
+#define PARTS_PER_THREAD 4
+
+static
+int
+_max_threads(void)
+{
+#ifdef _OPENMP
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif /* _OPENMP */
+}
+
+/* in-place inclusive prefix sum, one block per thread */
+void
+_csr_scan(uint64_t *a,
+          uint64_t n)
+{
+	uint64_t *partial;
+	int nt;
+
+	nt = _max_threads();
+	partial = (uint64_t *) calloc(nt + 1, sizeof(uint64_t));
+	ALLOC(partial);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nt)
+#endif /* _OPENMP */
+	{
+		uint64_t i, lo, hi, sum;
+		int tid, k;
+#ifdef _OPENMP
+		tid = omp_get_thread_num();
+		nt = omp_get_num_threads();
+#else
+		tid = 0;
+#endif /* _OPENMP */
+		lo = n * tid / nt;
+		hi = n * (tid + 1) / nt;
+		for (i = lo + 1; i < hi; ++i)
+			*(a+i) += *(a+i-1);
+		*(partial+tid+1) = hi > lo ? *(a+hi-1) : 0;
+#ifdef _OPENMP
+#pragma omp barrier
+#endif /* _OPENMP */
+		sum = 0;
+		for (k = 0; k <= tid; ++k)
+			sum += *(partial+k);
+		for (i = lo; i < hi && sum; ++i)
+			*(a+i) += sum;
+	}
+	free(partial);
+}
+
+static
+void
+_swap_entry(uint64_t *col,
+            double *re,
+            double *im,
+            uint64_t i,
+            uint64_t j)
+{
+	uint64_t c;
+	double v;
+
+	c = *(col+i);
+	*(col+i) = *(col+j);
+	*(col+j) = c;
+	v = *(re+i);
+	*(re+i) = *(re+j);
+	*(re+j) = v;
+	if (im)
+	{
+		v = *(im+i);
+		*(im+i) = *(im+j);
+		*(im+j) = v;
+	}
+}
+
+static
+void
+_sift_down(uint64_t *col,
+           double *re,
+           double *im,
+           uint64_t root,
+           uint64_t n)
+{
+	uint64_t child;
+
+	while ((child = 2 * root + 1) < n)
+	{
+		if (child + 1 < n && *(col+child+1) > *(col+child))
+			++child;
+		if (*(col+root) >= *(col+child))
+			return;
+		_swap_entry(col, re, im, root, child);
+		root = child;
+	}
+}
+
+/* sorts the entries of one row by column, carrying the values along */
+static
+void
+_sort_row(uint64_t *col,
+          double *re,
+          double *im,
+          uint64_t n)
+{
+	uint64_t i, j;
+
+	if (n < SORT_CUTOFF)
+	{
+		for (i = 1; i < n; ++i)
+			for (j = i; j > 0 && *(col+j-1) > *(col+j); --j)
+				_swap_entry(col, re, im, j - 1, j);
+		return;
+	}
+	for (i = n / 2; i-- > 0;)
+		_sift_down(col, re, im, i, n);
+	for (i = n; i-- > 1;)
+	{
+		_swap_entry(col, re, im, 0, i);
+		_sift_down(col, re, im, 0, i);
+	}
+}
+
+/* splits the rows into ranges holding about the same number of entries */
+static
+void
+_partition(qg8_csr *m)
+{
+	uint64_t p, lo, hi, mid, target, nnz;
+
+	m->nparts = MAX(MIN((uint64_t) _max_threads() * PARTS_PER_THREAD,
+	                    m->rows), 1);
+	m->parts = (uint64_t *) malloc(sizeof(uint64_t) * (m->nparts + 1));
+	ALLOC(m->parts);
+	nnz = *(m->rowptr+m->rows);
+	*(m->parts) = 0;
+	for (p = 1; p < m->nparts; ++p)
+	{
+		/* first row whose entries start at or after the target */
+		target = nnz / m->nparts * p + nnz % m->nparts * p / m->nparts;
+		lo = *(m->parts+p-1);
+		hi = m->rows;
+		while (lo < hi)
+		{
+			mid = lo + (hi - lo) / 2;
+			if (*(m->rowptr+mid) < target)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		*(m->parts+p) = lo;
+	}
+	*(m->parts+m->nparts) = m->rows;
+}
+
+/*
+ * Builds a row compressed view of a rank 1 or rank 2 tensor. Rank 1 tensors
+ * are read as a 1xN row when row_vector is set and as an Nx1 column
+ * otherwise. Half-Hermitian tensors are expanded to both triangles.
+ *
+ * Entries are counted and scattered in parallel with atomic row counters,
+ * then every row is sorted by column, so the result does not depend on
+ * the thread count nor on the order of the COO entries. Canonical tensors,
+ * see canon.c, are scattered in place and their rows are not sorted.
+ */
+qg8_csr *
+_csr_from_tensor(qg8_tensor *t,
+                 int row_vector)
+{
+	qg8_csr *m;
+	qg8_tensor *coo;
+	uint64_t *rows, *cols, *fill;
+	double *re, *im;
+	uint64_t e, r, n;
+	int mirror, sorted, bad;
+
+	if (t->rank != 1 && t->rank != 2)
+	{
+		fprintf(stderr, "Cannot view a rank %d tensor as a matrix.\n",
+		        t->rank);
+		exit(EXIT_FAILURE);
+	}
+	if (_tensor_is_packed(t))
+	{
+		coo = _tensor_expand(t);
+		m = _csr_from_tensor(coo, row_vector);
+		qg8_tensor_destroy(coo);
+		return m;
+	}
+	m = (qg8_csr *) malloc(sizeof(qg8_csr));
+	ALLOC(m);
+	rows = NULL;
+	cols = NULL;
+	if (t->rank == 2)
+	{
+		m->rows = *(t->dimensions);
+		m->cols = *(t->dimensions+1);
+		rows = *(t->indices);
+		cols = *(t->indices+1);
+	}
+	else if (row_vector)
+	{
+		m->rows = 1;
+		m->cols = *(t->dimensions);
+		cols = *(t->indices);
+	}
+	else
+	{
+		m->rows = *(t->dimensions);
+		m->cols = 1;
+		rows = *(t->indices);
+	}
+	mirror = t->rank == 2 && t->packing == QG8_PACKING_HALF_HERMITIAN;
+	/* canonical entries already lie in row order, see canon.c */
+	sorted = !mirror && (t->flags & QG8_TENSOR_SORTED);
+	if (mirror && m->rows != m->cols)
+	{
+		DIE("Half-Hermitian tensor is not square.\n");
+	}
+
+	re = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(re);
+	im = NULL;
+	if (_tensor_is_complex(t))
+	{
+		im = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+		ALLOC(im);
+	}
+	_tensor_to_double(t, re, im);
+
+	/* count the entries of every row, mirrored entries included */
+	m->rowptr = (uint64_t *) calloc(m->rows + 1, sizeof(uint64_t));
+	ALLOC(m->rowptr);
+	n = 0;
+	bad = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:n) reduction(|:bad)
+#endif /* _OPENMP */
+	for (e = 0; e < t->num_elems; ++e)
+	{
+		uint64_t er, ec;
+		er = rows ? *(rows+e) : 0;
+		ec = cols ? *(cols+e) : 0;
+		if (er >= m->rows || ec >= m->cols)
+		{
+			bad = 1;
+			continue;
+		}
+#ifdef _OPENMP
+#pragma omp atomic
+#endif /* _OPENMP */
+		(*(m->rowptr+er+1))++;
+		++n;
+		if (mirror && er != ec)
+		{
+#ifdef _OPENMP
+#pragma omp atomic
+#endif /* _OPENMP */
+			(*(m->rowptr+ec+1))++;
+			++n;
+		}
+	}
+	if (bad)
+	{
+		DIE("Tensor index is out of bounds.\n");
+	}
+	_csr_scan(m->rowptr+1, m->rows);
+
+	m->colidx = (uint64_t *) malloc(sizeof(uint64_t) * MAX(n, 1));
+	ALLOC(m->colidx);
+	m->re = (double *) malloc(sizeof(double) * MAX(n, 1));
+	ALLOC(m->re);
+	m->im = NULL;
+	if (im)
+	{
+		m->im = (double *) malloc(sizeof(double) * MAX(n, 1));
+		ALLOC(m->im);
+	}
+	fill = (uint64_t *) malloc(sizeof(uint64_t) * MAX(m->rows, 1));
+	ALLOC(fill);
+	memcpy(fill, m->rowptr, sizeof(uint64_t) * m->rows);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif /* _OPENMP */
+	for (e = 0; e < t->num_elems; ++e)
+	{
+		uint64_t er, ec, pos;
+		er = rows ? *(rows+e) : 0;
+		ec = cols ? *(cols+e) : 0;
+		if (sorted)
+		{
+			pos = e;
+		}
+		else
+		{
+#ifdef _OPENMP
+#pragma omp atomic capture
+#endif /* _OPENMP */
+			pos = (*(fill+er))++;
+		}
+		*(m->colidx+pos) = ec;
+		*(m->re+pos) = *(re+e);
+		if (im)
+			*(m->im+pos) = *(im+e);
+		if (mirror && er != ec)
+		{
+#ifdef _OPENMP
+#pragma omp atomic capture
+#endif /* _OPENMP */
+			pos = (*(fill+ec))++;
+			*(m->colidx+pos) = er;
+			*(m->re+pos) = *(re+e);
+			if (im)
+				*(m->im+pos) = -*(im+e);
+		}
+	}
+	free(fill);
+	free(re);
+	if (im)
+		free(im);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 256) if(!sorted)
+#endif /* _OPENMP */
+	for (r = 0; r < (sorted ? 0 : m->rows); ++r)
+	{
+		_sort_row(m->colidx+*(m->rowptr+r), m->re+*(m->rowptr+r),
+		          m->im ? m->im+*(m->rowptr+r) : NULL,
+		          *(m->rowptr+r+1) - *(m->rowptr+r));
+	}
+	_partition(m);
+	return m;
+}
+
+/* y = m*x on dense split complex vectors, one row range per task */
+void
+_csr_spmv(qg8_csr *m,
+          const double *xre,
+          const double *xim,
+          double *yre,
+          double *yim)
+{
+	uint64_t p;
+
+	qg8_kernel_get_isa(); /* resolve the dispatch before the threads start */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif /* _OPENMP */
+	for (p = 0; p < m->nparts; ++p)
+	{
+		_kernel_zcsrmv(m, *(m->parts+p), *(m->parts+p+1),
+		               xre, xim, yre, yim);
+	}
+}
+
+/*
+ * Y = m*X for b split complex kets stored side by side, amplitude c of
+ * ket k at X[c*b+k]. Every stored entry is read once for the whole block.
+ */
+void
+_csr_spmm(qg8_csr *m,
+          uint64_t b,
+          const double *xre,
+          const double *xim,
+          double *yre,
+          double *yim)
+{
+	uint64_t p;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif /* _OPENMP */
+	for (p = 0; p < m->nparts; ++p)
+	{
+		const double *xr, *xi;
+		double *yr, *yi, ar, ai;
+		uint64_t r, q, k;
+
+		for (r = *(m->parts+p); r < *(m->parts+p+1); ++r)
+		{
+			yr = yre + r * b;
+			yi = yim + r * b;
+			memset(yr, 0, sizeof(double) * b);
+			memset(yi, 0, sizeof(double) * b);
+			for (q = *(m->rowptr+r); q < *(m->rowptr+r+1); ++q)
+			{
+				xr = xre + *(m->colidx+q) * b;
+				xi = xim + *(m->colidx+q) * b;
+				ar = *(m->re+q);
+				ai = m->im ? *(m->im+q) : 0.0;
+				for (k = 0; k < b; ++k)
+				{
+					*(yr+k) += ar * *(xr+k) - ai * *(xi+k);
+					*(yi+k) += ar * *(xi+k) + ai * *(xr+k);
+				}
+			}
+		}
+	}
+}
+
+void
+_csr_destroy(qg8_csr *m)
+{
+	free(m->rowptr);
+	free(m->colidx);
+	free(m->re);
+	if (m->im)
+		free(m->im);
+	free(m->parts);
+	free(m);
+}
+
+/*
+ * Caches the row compressed view of a rank 2 tensor so that repeated
+ * products skip the COO conversion. The cache is dropped with the tensor or
+ * by qg8_tensor_csr_release, which must be called after changing the data.
+ */
+int
+qg8_tensor_csr_build(qg8_tensor *t)
+{
+	if (!t)
+	{
+		DIE("Cannot build CSR of a NULL tensor.\n");
+	}
+	if (t->rank != 2)
+	{
+		DIE("Cannot build CSR of a tensor that is not of rank 2.\n");
+	}
+	if (!t->csr)
+		t->csr = _csr_from_tensor(t, 0);
+	return 1;
+}
+
+int
+qg8_tensor_csr_release(qg8_tensor *t)
+{
+	if (!t)
+	{
+		DIE("Cannot release CSR of a NULL tensor.\n");
+	}
+	if (t->csr)
+		_csr_destroy(t->csr);
+	t->csr = NULL;
+	return 1;
+}
+
+/*
+ * y = t*x for a rank 2 operator and dense split complex vectors, x having
+ * dims[1] and y dims[0] elements. Builds the CSR cache on first use,
+ * except for Pauli, DIA and BSR packings which have their own kernels.
+ */
+int
+qg8_tensor_spmv(qg8_tensor *t,
+                const double *xre,
+                const double *xim,
+                double *yre,
+                double *yim)
+{
+	if (!t || !xre || !xim || !yre || !yim)
+	{
+		DIE("Cannot multiply NULL vectors.\n");
+	}
+	if (t->rank != 2)
+	{
+		DIE("Cannot multiply by a tensor that is not of rank 2.\n");
+	}
+	if (t->packing == QG8_PACKING_PAULI)
+	{
+		_pauli_apply(t, xre, xim, yre, yim);
+		return 1;
+	}
+	if (t->packing == QG8_PACKING_DIA)
+	{
+		_dia_apply(t, xre, xim, yre, yim);
+		return 1;
+	}
+	if (t->packing == QG8_PACKING_BSR)
+	{
+		_bsr_apply(t, xre, xim, yre, yim);
+		return 1;
+	}
+	qg8_tensor_csr_build(t);
+	_csr_spmv(t->csr, xre, xim, yre, yim);
+	return 1;
+}
+
+/*
+ * Y = t*X for a rank 2 operator and b dense split complex kets stored side
+ * by side, see _csr_spmm: X has dims[1] rows of b values and Y dims[0].
+ * Pauli, DIA and BSR packings are applied one ket at a time.
+ */
+int
+qg8_tensor_spmm(qg8_tensor *t,
+                uint64_t b,
+                const double *xre,
+                const double *xim,
+                double *yre,
+                double *yim)
+{
+	double *cr, *ci, *dr, *di;
+	uint64_t n, m, i, k;
+
+	if (!t || !xre || !xim || !yre || !yim)
+	{
+		DIE("Cannot multiply NULL blocks.\n");
+	}
+	if (t->rank != 2)
+	{
+		DIE("Cannot multiply by a tensor that is not of rank 2.\n");
+	}
+	if (t->packing != QG8_PACKING_PAULI && t->packing != QG8_PACKING_DIA &&
+	    t->packing != QG8_PACKING_BSR)
+	{
+		qg8_tensor_csr_build(t);
+		_csr_spmm(t->csr, b, xre, xim, yre, yim);
+		return 1;
+	}
+	m = *(t->dimensions);
+	n = *(t->dimensions+1);
+	cr = (double *) malloc(sizeof(double) * MAX(n, 1));
+	ALLOC(cr);
+	ci = (double *) malloc(sizeof(double) * MAX(n, 1));
+	ALLOC(ci);
+	dr = (double *) malloc(sizeof(double) * MAX(m, 1));
+	ALLOC(dr);
+	di = (double *) malloc(sizeof(double) * MAX(m, 1));
+	ALLOC(di);
+	for (k = 0; k < b; ++k)
+	{
+		for (i = 0; i < n; ++i)
+		{
+			*(cr+i) = *(xre+i*b+k);
+			*(ci+i) = *(xim+i*b+k);
+		}
+		qg8_tensor_spmv(t, cr, ci, dr, di);
+		for (i = 0; i < m; ++i)
+		{
+			*(yre+i*b+k) = *(dr+i);
+			*(yim+i*b+k) = *(di+i);
+		}
+	}
+	free(cr);
+	free(ci);
+	free(dr);
+	free(di);
+	return 1;
+}
+
+/*
+ * Applies a rank 2 operator to a ket (rank 1, or rank 2 with one column)
+ * and returns the resulting ket in full COMPLEX128 packing.
+ */
+qg8_tensor *
+qg8_tensor_apply(qg8_tensor *op,
+                 qg8_tensor *ket)
+{
+	qg8_tensor *out;
+	double *xre, *xim;
+	uint64_t shape[2];
+
+	if (!op || !ket)
+	{
+		DIE("Cannot apply a NULL tensor.\n");
+	}
+	if (op->rank != 2 || ket->rank > 2 ||
+	    (ket->rank == 2 && *(ket->dimensions+1) != 1) ||
+	    *(ket->dimensions) != *(op->dimensions+1))
+	{
+		DIE("Cannot apply an operator to a ket of mismatched shape.\n");
+	}
+	shape[0] = *(op->dimensions);
+	shape[1] = 1;
+	out = _tensor_new(QG8_PACKING_FULL, ket->rank, shape, shape[0], 1);
+	_tensor_fill_full_indices(out);
+	if (ket->dtype_id == QG8_DTYPE_COMPLEX128 &&
+	    ket->packing == QG8_PACKING_FULL &&
+	    ket->num_elems == *(ket->dimensions))
+	{
+		qg8_tensor_spmv(op, (double *) ket->redata, (double *) ket->imdata,
+		                (double *) out->redata, (double *) out->imdata);
+		return out;
+	}
+	xre = (double *) malloc(sizeof(double) * MAX(*(ket->dimensions), 1));
+	ALLOC(xre);
+	xim = (double *) malloc(sizeof(double) * MAX(*(ket->dimensions), 1));
+	ALLOC(xim);
+	_tensor_to_dense(ket, xre, xim);
+	qg8_tensor_spmv(op, xre, xim, (double *) out->redata,
+	                (double *) out->imdata);
+	free(xre);
+	free(xim);
+	return out;
+}
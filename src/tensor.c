@@ -62,7 +62,7 @@ _num_bytes(uint64_t val)
 	return QG8_DTYPE_UINT64;
 }
 
-static
+/* index dtype fitting the dimensions, and the flat indices of LINEAR */
 int
 _tensor_index_size(qg8_tensor *t)
 {
@@ -75,6 +75,9 @@ _tensor_index_size(qg8_tensor *t)
 		if (max == 0 || *(t->dimensions+i) > max)
 			max = *(t->dimensions+i);
 	}
+	/* linear indices and the dimensions share the type */
+	if (t->flags & QG8_TENSOR_LINEAR_INDEX)
+		max = MAX(max, _linear_size(t) - 1);
 	return _num_bytes(max);
 }
 
@@ -90,6 +93,7 @@ _common_create(qg8_tensor *t,
 {
 	size_t i;
 	t->loaded = 0;
+	t->flags = 0;
 	if (!indices)
 	{
 		DIE("Cannot create tensor with NULL indices.\n");
@@ -121,6 +125,8 @@ _common_create(qg8_tensor *t,
 	t->itype_id = _tensor_index_size(t);
 	t->redata = NULL;
 	t->imdata = NULL;
+	t->csr = NULL;
+	t->order = NULL;
 }
 
 qg8_tensor *
@@ -181,6 +187,65 @@ qg8_tensor_create_double(uint64_t **indices,
 	return t;
 }
 
+/* 16 bit floats, as qg8_tensor_create_float with their raw bits */
+qg8_tensor *
+qg8_tensor_create_half(uint64_t **indices,
+                       uint16_t *re,
+                       uint16_t *im,
+                       uint64_t length,
+                       uint64_t *shape,
+                       uint8_t rank,
+                       uint8_t packing)
+{
+	qg8_tensor *t;
+
+	t = (qg8_tensor *) malloc(sizeof(qg8_tensor));
+	ALLOC(t);
+	_common_create(t, re, indices, length, shape, rank, packing);
+
+	t->redata = re;
+	if (im)
+	{
+		t->imdata = im;
+		t->dtype_id = QG8_DTYPE_COMPLEX32;
+	}
+	else
+	{
+		t->dtype_id = QG8_DTYPE_FLOAT16;
+	}
+
+	return t;
+}
+
+qg8_tensor *
+qg8_tensor_create_bfloat16(uint64_t **indices,
+                           uint16_t *re,
+                           uint16_t *im,
+                           uint64_t length,
+                           uint64_t *shape,
+                           uint8_t rank,
+                           uint8_t packing)
+{
+	qg8_tensor *t;
+
+	t = (qg8_tensor *) malloc(sizeof(qg8_tensor));
+	ALLOC(t);
+	_common_create(t, re, indices, length, shape, rank, packing);
+
+	t->redata = re;
+	if (im)
+	{
+		t->imdata = im;
+		t->dtype_id = QG8_DTYPE_BCOMPLEX32;
+	}
+	else
+	{
+		t->dtype_id = QG8_DTYPE_BFLOAT16;
+	}
+
+	return t;
+}
+
 /* fat macro expander */
 CREATE_FUNC(uint8, uint8_t, QG8_DTYPE_UINT8)
 CREATE_FUNC(uint16, uint16_t, QG8_DTYPE_UINT16)
@@ -201,6 +266,11 @@ qg8_tensor_destroy(qg8_tensor *t)
 		DIE("Cannot destroy a NULL tensor.\n");
 	}
 
+	/* the caches belong to the library even for user buffers */
+	if (t->csr)
+		_csr_destroy(t->csr);
+	if (t->order)
+		free(t->order);
 	if (t->loaded)
 	{
 		free(t->dimensions);
@@ -297,6 +367,10 @@ qg8_tensor_get_re(qg8_tensor *t)
 	case QG8_DTYPE_INT16:
 	case QG8_DTYPE_INT32:
 	case QG8_DTYPE_INT64:
+	case QG8_DTYPE_FLOAT16:
+	case QG8_DTYPE_BFLOAT16:
+	case QG8_DTYPE_COMPLEX32:
+	case QG8_DTYPE_BCOMPLEX32:
 		return t->redata;
 	default:
 		return NULL;
@@ -314,9 +388,590 @@ qg8_tensor_get_im(qg8_tensor *t)
 	{
 	case QG8_DTYPE_COMPLEX64:
 	case QG8_DTYPE_COMPLEX128:
+	case QG8_DTYPE_COMPLEX32:
+	case QG8_DTYPE_BCOMPLEX32:
 		return t->imdata;
 	default:
 		return NULL;
 	}
 }
 
+
+int
+_tensor_is_complex(qg8_tensor *t)
+{
+	return t->dtype_id == QG8_DTYPE_COMPLEX64 ||
+	       t->dtype_id == QG8_DTYPE_COMPLEX128 ||
+	       t->dtype_id == QG8_DTYPE_COMPLEX32 ||
+	       t->dtype_id == QG8_DTYPE_BCOMPLEX32;
+}
+
+#define WIDEN(x,y) \
+	case x: \
+		for (i = e0; i < e1; ++i) \
+			*(out+i) = (double) *(((const y *) x_)+i); \
+		break;
+
+/* number of elements widened per parallel task */
+#define WIDEN_BLOCK 65536
+/* 16 bit floats converted at once, through a buffer of floats */
+#define WIDEN_HALF  256
+
+static
+void
+_widen_half(const uint16_t *x,
+            int bf16,
+            uint64_t e0,
+            uint64_t e1,
+            double *out)
+{
+	float buf[WIDEN_HALF];
+	uint64_t i, j, n;
+
+	for (i = e0; i < e1; i += n)
+	{
+		n = MIN(WIDEN_HALF, e1 - i);
+		if (bf16)
+			qg8_kernel_bf16_to_float(n, x + i, buf);
+		else
+			qg8_kernel_half_to_float(n, x + i, buf);
+		for (j = 0; j < n; ++j)
+			*(out+i+j) = (double) buf[j];
+	}
+}
+
+/* widens elements e0 to e1 of one value array of the given dtype */
+static
+void
+_widen_part(const void *x_,
+            uint8_t dtype_id,
+            uint64_t e0,
+            uint64_t e1,
+            double *out)
+{
+	uint64_t i;
+
+	switch (dtype_id)
+	{
+	WIDEN(QG8_DTYPE_BOOL, uint8_t)
+	WIDEN(QG8_DTYPE_CHAR, int8_t)
+	WIDEN(QG8_DTYPE_UINT8, uint8_t)
+	WIDEN(QG8_DTYPE_UINT16, uint16_t)
+	WIDEN(QG8_DTYPE_UINT32, uint32_t)
+	WIDEN(QG8_DTYPE_UINT64, uint64_t)
+	WIDEN(QG8_DTYPE_INT8, int8_t)
+	WIDEN(QG8_DTYPE_INT16, int16_t)
+	WIDEN(QG8_DTYPE_INT32, int32_t)
+	WIDEN(QG8_DTYPE_INT64, int64_t)
+	WIDEN(QG8_DTYPE_FLOAT32, float)
+	WIDEN(QG8_DTYPE_COMPLEX64, float)
+	WIDEN(QG8_DTYPE_FLOAT64, double)
+	WIDEN(QG8_DTYPE_COMPLEX128, double)
+	case QG8_DTYPE_FLOAT16:
+	case QG8_DTYPE_COMPLEX32:
+		_widen_half((const uint16_t *) x_, 0, e0, e1, out);
+		break;
+	case QG8_DTYPE_BFLOAT16:
+	case QG8_DTYPE_BCOMPLEX32:
+		_widen_half((const uint16_t *) x_, 1, e0, e1, out);
+		break;
+	default:
+		break;
+	}
+}
+
+static
+void
+_widen(qg8_tensor *t,
+       uint64_t e0,
+       uint64_t e1,
+       double *re,
+       double *im)
+{
+	_widen_part(t->redata, t->dtype_id, e0, e1, re);
+	if (!im)
+		return;
+	if (_tensor_is_complex(t))
+		_widen_part(t->imdata, t->dtype_id, e0, e1, im);
+	else
+		memset(im+e0, 0, sizeof(double) * (e1 - e0));
+}
+
+/* dtype of either part of a complex dtype, others are their own */
+static
+uint8_t
+_part_dtype(uint8_t dtype_id)
+{
+	switch (dtype_id)
+	{
+	case QG8_DTYPE_COMPLEX128:
+		return QG8_DTYPE_FLOAT64;
+	case QG8_DTYPE_COMPLEX64:
+		return QG8_DTYPE_FLOAT32;
+	case QG8_DTYPE_COMPLEX32:
+		return QG8_DTYPE_FLOAT16;
+	case QG8_DTYPE_BCOMPLEX32:
+		return QG8_DTYPE_BFLOAT16;
+	default:
+		return dtype_id;
+	}
+}
+
+/*
+ * Floating dtype that values of dtype from are loaded as when to is asked
+ * for: to names the precision, and complex data keeps complex parts of it.
+ * Returns 0 if to is not a floating dtype.
+ */
+uint8_t
+_convert_dtype(uint8_t from,
+               uint8_t to)
+{
+	int cplx;
+
+	cplx = _part_dtype(from) != from;
+	switch (to)
+	{
+	case QG8_DTYPE_FLOAT64:
+	case QG8_DTYPE_COMPLEX128:
+		return cplx ? QG8_DTYPE_COMPLEX128 : QG8_DTYPE_FLOAT64;
+	case QG8_DTYPE_FLOAT32:
+	case QG8_DTYPE_COMPLEX64:
+		return cplx ? QG8_DTYPE_COMPLEX64 : QG8_DTYPE_FLOAT32;
+	case QG8_DTYPE_FLOAT16:
+	case QG8_DTYPE_COMPLEX32:
+		return cplx ? QG8_DTYPE_COMPLEX32 : QG8_DTYPE_FLOAT16;
+	case QG8_DTYPE_BFLOAT16:
+	case QG8_DTYPE_BCOMPLEX32:
+		return cplx ? QG8_DTYPE_BCOMPLEX32 : QG8_DTYPE_BFLOAT16;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Converts n values of one value array from dtype from to the floating
+ * dtype to, a block at a time through buffers on the stack. Values float
+ * does not hold exactly narrow to 16 bits straight from double, so that
+ * they round once.
+ */
+void
+_convert_values(const void *src,
+                uint8_t from,
+                uint64_t n,
+                void *dst,
+                uint8_t to)
+{
+	double wide[WIDEN_HALF];
+	float buf[WIDEN_HALF], *f;
+	const uint8_t *s;
+	uint64_t i, j, m;
+	size_t ssize;
+
+	from = _part_dtype(from);
+	to = _part_dtype(to);
+	ssize = _type_to_size(from);
+	if (from == to)
+	{
+		memcpy(dst, src, ssize * n);
+		return;
+	}
+	for (i = 0; i < n; i += m)
+	{
+		m = MIN(WIDEN_HALF, n - i);
+		s = (const uint8_t *) src + ssize * i;
+		if (to == QG8_DTYPE_FLOAT64)
+		{
+			_widen_part(s, from, 0, m, (double *) dst + i);
+			continue;
+		}
+		f = to == QG8_DTYPE_FLOAT32 ? (float *) dst + i : buf;
+		if (from == QG8_DTYPE_FLOAT16)
+		{
+			qg8_kernel_half_to_float(m, (const uint16_t *) s, f);
+		}
+		else if (from == QG8_DTYPE_BFLOAT16)
+		{
+			qg8_kernel_bf16_to_float(m, (const uint16_t *) s, f);
+		}
+		else if (to == QG8_DTYPE_FLOAT32 || from == QG8_DTYPE_FLOAT32)
+		{
+			_widen_part(s, from, 0, m, wide);
+			for (j = 0; j < m; ++j)
+				*(f+j) = (float) wide[j];
+		}
+		else
+		{
+			_widen_part(s, from, 0, m, wide);
+			for (j = 0; j < m; ++j)
+				*((uint16_t *) dst+i+j) = to == QG8_DTYPE_FLOAT16 ?
+				                          _double_to_half(wide[j]) :
+				                          _double_to_bf16(wide[j]);
+			continue;
+		}
+		if (to == QG8_DTYPE_FLOAT16)
+			qg8_kernel_float_to_half(m, f, (uint16_t *) dst + i);
+		else if (to == QG8_DTYPE_BFLOAT16)
+			qg8_kernel_float_to_bf16(m, f, (uint16_t *) dst + i);
+	}
+}
+
+#define ELEMENT(x,y) \
+	case x: \
+		*re = (double) *(((y *) t->redata)+e); \
+		break;
+
+/* widens element e to double, as _tensor_to_double */
+void
+_tensor_element(qg8_tensor *t,
+                uint64_t e,
+                double *re,
+                double *im)
+{
+	switch (t->dtype_id)
+	{
+	ELEMENT(QG8_DTYPE_BOOL, uint8_t)
+	ELEMENT(QG8_DTYPE_CHAR, int8_t)
+	ELEMENT(QG8_DTYPE_UINT8, uint8_t)
+	ELEMENT(QG8_DTYPE_UINT16, uint16_t)
+	ELEMENT(QG8_DTYPE_UINT32, uint32_t)
+	ELEMENT(QG8_DTYPE_UINT64, uint64_t)
+	ELEMENT(QG8_DTYPE_INT8, int8_t)
+	ELEMENT(QG8_DTYPE_INT16, int16_t)
+	ELEMENT(QG8_DTYPE_INT32, int32_t)
+	ELEMENT(QG8_DTYPE_INT64, int64_t)
+	ELEMENT(QG8_DTYPE_FLOAT32, float)
+	ELEMENT(QG8_DTYPE_COMPLEX64, float)
+	ELEMENT(QG8_DTYPE_FLOAT64, double)
+	ELEMENT(QG8_DTYPE_COMPLEX128, double)
+	case QG8_DTYPE_FLOAT16:
+	case QG8_DTYPE_COMPLEX32:
+		*re = (double) _half_to_float(*(((uint16_t *) t->redata)+e));
+		break;
+	case QG8_DTYPE_BFLOAT16:
+	case QG8_DTYPE_BCOMPLEX32:
+		*re = (double) _bf16_to_float(*(((uint16_t *) t->redata)+e));
+		break;
+	default:
+		fprintf(stderr, "Cannot widen dtype %d to double.\n", t->dtype_id);
+		exit(EXIT_FAILURE);
+	}
+	if (t->dtype_id == QG8_DTYPE_COMPLEX64)
+		*im = (double) *(((float *) t->imdata)+e);
+	else if (t->dtype_id == QG8_DTYPE_COMPLEX128)
+		*im = *(((double *) t->imdata)+e);
+	else if (t->dtype_id == QG8_DTYPE_COMPLEX32)
+		*im = (double) _half_to_float(*(((uint16_t *) t->imdata)+e));
+	else if (t->dtype_id == QG8_DTYPE_BCOMPLEX32)
+		*im = (double) _bf16_to_float(*(((uint16_t *) t->imdata)+e));
+	else
+		*im = 0.0;
+}
+
+/* widens every element to double, imaginary parts are zero for real data */
+void
+_tensor_to_double(qg8_tensor *t,
+                  double *re,
+                  double *im)
+{
+	uint64_t b, nb;
+
+	if (t->dtype_id < QG8_DTYPE_BOOL || t->dtype_id > QG8_DTYPE_BCOMPLEX32)
+	{
+		fprintf(stderr, "Cannot widen dtype %d to double.\n", t->dtype_id);
+		exit(EXIT_FAILURE);
+	}
+	qg8_kernel_get_isa(); /* resolve the dispatch before the threads start */
+	nb = (t->num_elems + WIDEN_BLOCK - 1) / WIDEN_BLOCK;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif /* _OPENMP */
+	for (b = 0; b < nb; ++b)
+	{
+		_widen(t, b * WIDEN_BLOCK, MIN((b + 1) * WIDEN_BLOCK, t->num_elems),
+		       re, im);
+	}
+}
+
+/*
+ * Allocates a loaded FLOAT64 or COMPLEX128 tensor owning all of its buffers,
+ * so that qg8_tensor_destroy releases them. The shape is copied.
+ */
+qg8_tensor *
+_tensor_new(uint8_t packing,
+            uint16_t rank,
+            uint64_t *shape,
+            uint64_t length,
+            int is_complex)
+{
+	qg8_tensor *t;
+	size_t i, n;
+
+	n = MAX(length, 1); /* malloc(0) may legally return NULL */
+	t = (qg8_tensor *) malloc(sizeof(qg8_tensor));
+	ALLOC(t);
+	t->dimensions = (uint64_t *) malloc(sizeof(uint64_t) * rank);
+	ALLOC(t->dimensions);
+	memcpy(t->dimensions, shape, sizeof(uint64_t) * rank);
+	t->indices = (uint64_t **) malloc(sizeof(uint64_t *) * rank);
+	ALLOC(t->indices);
+	for (i = 0; i < rank; ++i)
+	{
+		*(t->indices+i) = (uint64_t *) malloc(sizeof(uint64_t) * n);
+		ALLOC(*(t->indices+i));
+	}
+	t->redata = malloc(sizeof(double) * n);
+	ALLOC(t->redata);
+	t->imdata = NULL;
+	if (is_complex)
+	{
+		t->imdata = malloc(sizeof(double) * n);
+		ALLOC(t->imdata);
+	}
+	t->csr = NULL;
+	t->order = NULL;
+	t->loaded = 1;
+	t->flags = 0;
+	t->rank = rank;
+	t->num_elems = length;
+	t->packing = packing;
+	t->itype_id = _tensor_index_size(t);
+	t->dtype_id = is_complex ? QG8_DTYPE_COMPLEX128 : QG8_DTYPE_FLOAT64;
+	return t;
+}
+
+/*
+ * As _tensor_new for a rank 2 tensor in DIA or BSR packing, whose index
+ * arrays hold len_idx entries and whose data holds length elements.
+ */
+qg8_tensor *
+_tensor_new_packed(uint8_t packing,
+                   uint64_t *shape,
+                   uint64_t len_idx,
+                   uint64_t length,
+                   int is_complex)
+{
+	qg8_tensor *t;
+
+	t = _tensor_new(packing, 2, shape, len_idx, is_complex);
+	t->redata = realloc(t->redata, sizeof(double) * MAX(length, 1));
+	ALLOC(t->redata);
+	if (is_complex)
+	{
+		t->imdata = realloc(t->imdata, sizeof(double) * MAX(length, 1));
+		ALLOC(t->imdata);
+	}
+	t->num_elems = length;
+	return t;
+}
+
+/*
+ * Entries of every index array: one per element, except for DIA packing
+ * with one per diagonal and BSR packing with one per block plus the block
+ * shape.
+ */
+uint64_t
+_tensor_index_len(qg8_tensor *t)
+{
+	if (t->packing == QG8_PACKING_DIA)
+		return t->num_elems / _dia_length(t);
+	if (t->packing == QG8_PACKING_BSR)
+		return _bsr_blocks(t) + 1;
+	return t->num_elems;
+}
+
+/* index arrays stored, the others being NULL: one for LINEAR indices */
+uint16_t
+_tensor_index_arrays(qg8_tensor *t)
+{
+	return (t->flags & QG8_TENSOR_LINEAR_INDEX) ? 1 : t->rank;
+}
+
+qg8_tensor *
+_tensor_copy(qg8_tensor *t)
+{
+	qg8_tensor *c;
+	size_t i, n, dsize;
+	uint64_t len;
+
+	n = MAX(t->num_elems, 1);
+	len = _tensor_index_len(t);
+	dsize = _type_to_size(t->dtype_id);
+	c = (qg8_tensor *) malloc(sizeof(qg8_tensor));
+	ALLOC(c);
+	memcpy(c, t, sizeof(qg8_tensor));
+	c->loaded = 1;
+	c->csr = NULL;
+	c->order = NULL;
+	c->dimensions = (uint64_t *) malloc(sizeof(uint64_t) * t->rank);
+	ALLOC(c->dimensions);
+	memcpy(c->dimensions, t->dimensions, sizeof(uint64_t) * t->rank);
+	c->indices = (uint64_t **) malloc(sizeof(uint64_t *) * t->rank);
+	ALLOC(c->indices);
+	for (i = 0; i < t->rank; ++i)
+		*(c->indices+i) = NULL;
+	for (i = 0; i < _tensor_index_arrays(t); ++i)
+	{
+		*(c->indices+i) = (uint64_t *) malloc(sizeof(uint64_t) *
+		                                      MAX(len, 1));
+		ALLOC(*(c->indices+i));
+		memcpy(*(c->indices+i), *(t->indices+i), sizeof(uint64_t) * len);
+	}
+	c->redata = malloc(dsize * n);
+	ALLOC(c->redata);
+	memcpy(c->redata, t->redata, dsize * t->num_elems);
+	c->imdata = NULL;
+	if (_tensor_is_complex(t))
+	{
+		c->imdata = malloc(dsize * n);
+		ALLOC(c->imdata);
+		memcpy(c->imdata, t->imdata, dsize * t->num_elems);
+	}
+	return c;
+}
+
+/* product of all dimensions, i.e. the element count of a full packing */
+uint64_t
+_tensor_full_size(qg8_tensor *t)
+{
+	uint64_t n;
+	size_t i;
+
+	n = 1;
+	for (i = 0; i < t->rank; ++i)
+		n *= *(t->dimensions+i);
+	return n;
+}
+
+/* writes row-major coordinates for every element of a full tensor */
+void
+_tensor_fill_full_indices(qg8_tensor *t)
+{
+	uint64_t e, rem;
+	size_t i;
+
+	for (e = 0; e < t->num_elems; ++e)
+	{
+		rem = e;
+		for (i = t->rank; i-- > 0;)
+		{
+			*(*(t->indices+i)+e) = rem % *(t->dimensions+i);
+			rem /= *(t->dimensions+i);
+		}
+	}
+}
+
+/*
+ * Points vr and vi at the data of t as doubles, widened into new buffers
+ * for dtypes other than FLOAT64 and COMPLEX128. vi is NULL for real data.
+ * Returns whether the buffers must be freed.
+ */
+int
+_tensor_as_double(qg8_tensor *t,
+                  double **vr,
+                  double **vi)
+{
+	if (t->dtype_id == QG8_DTYPE_FLOAT64 ||
+	    t->dtype_id == QG8_DTYPE_COMPLEX128)
+	{
+		*vr = (double *) t->redata;
+		*vi = t->dtype_id == QG8_DTYPE_COMPLEX128 ?
+		      (double *) t->imdata : NULL;
+		return 0;
+	}
+	*vr = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(*vr);
+	*vi = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(*vi);
+	_tensor_to_double(t, *vr, *vi);
+	if (!_tensor_is_complex(t))
+	{
+		free(*vi);
+		*vi = NULL;
+	}
+	return 1;
+}
+
+/* packings whose index arrays are not the coordinates of the elements */
+int
+_tensor_is_packed(qg8_tensor *t)
+{
+	return t->packing == QG8_PACKING_PAULI ||
+	       t->packing == QG8_PACKING_DIA ||
+	       t->packing == QG8_PACKING_BSR;
+}
+
+/* sparse COO copy of a tensor in Pauli, DIA or BSR packing */
+qg8_tensor *
+_tensor_expand(qg8_tensor *t)
+{
+	if (t->packing == QG8_PACKING_PAULI)
+		return _pauli_expand(t);
+	if (t->packing == QG8_PACKING_DIA)
+		return _dia_expand(t);
+	if (t->packing == QG8_PACKING_BSR)
+		return _bsr_expand(t);
+	fprintf(stderr, "Cannot expand a tensor in packing %d.\n", t->packing);
+	exit(EXIT_FAILURE);
+}
+
+/*
+ * Scatters a tensor into row-major dense arrays of _tensor_full_size
+ * elements, summing duplicate coordinates and expanding half-Hermitian,
+ * Pauli, DIA and BSR packing. Full tensors are already in that order and
+ * are only widened.
+ */
+void
+_tensor_to_dense(qg8_tensor *t,
+                 double *re,
+                 double *im)
+{
+	qg8_tensor *coo;
+	double *vr, *vi;
+	uint64_t n, e, lin, tr;
+	size_t i;
+
+	n = _tensor_full_size(t);
+	if (t->packing == QG8_PACKING_FULL && t->num_elems == n)
+	{
+		_tensor_to_double(t, re, im);
+		return;
+	}
+	if (_tensor_is_packed(t))
+	{
+		coo = _tensor_expand(t);
+		_tensor_to_dense(coo, re, im);
+		qg8_tensor_destroy(coo);
+		return;
+	}
+	vr = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(vr);
+	vi = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(vi);
+	_tensor_to_double(t, vr, vi);
+	memset(re, 0, sizeof(double) * n);
+	memset(im, 0, sizeof(double) * n);
+	for (e = 0; e < t->num_elems; ++e)
+	{
+		lin = 0;
+		for (i = 0; i < t->rank; ++i)
+		{
+			if (*(*(t->indices+i)+e) >= *(t->dimensions+i))
+			{
+				DIE("Tensor index is out of bounds.\n");
+			}
+			lin = lin * *(t->dimensions+i) + *(*(t->indices+i)+e);
+		}
+		*(re+lin) += *(vr+e);
+		*(im+lin) += *(vi+e);
+		if (t->packing == QG8_PACKING_HALF_HERMITIAN && t->rank == 2 &&
+		    *(*(t->indices)+e) != *(*(t->indices+1)+e))
+		{
+			tr = *(*(t->indices+1)+e) * *(t->dimensions+1) +
+			     *(*(t->indices)+e);
+			*(re+tr) += *(vr+e);
+			*(im+tr) -= *(vi+e);
+		}
+	}
+	free(vr);
+	free(vi);
+}
@@ -0,0 +1,355 @@
+/*
+ * trace.c
+ * QG8 base library partial trace source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The reduced density matrix of k kept qubits is
+ *   rho[a][b] = sum_e x[i(a, e)] conj(x[i(b, e)])
+ * over the 2^(n-k) states e of the other qubits, with i(a, e) the basis
+ * state putting the bits of a on the kept qubits and those of e on the
+ * others. For each e the 2^k amplitudes x[i(., e)] are gathered at their
+ * stride and their outer product added, so |x><x| is never formed. A
+ * density matrix is reduced the same way from its blocks, or entry by
+ * entry when it is sparse.
+ *
+ * The environment states, or the entries, are cut into a fixed number of
+ * blocks with one partial sum each; the partial sums are added in block
+ * order so the result does not depend on the number of threads.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* most partial sums */
+#define RDM_BLOCKS  64
+/* elements of all partial sums together */
+#define RDM_PARTIAL (1 << 22)
+
+/* bit cnt-1-k of v goes to bit pos[k] */
+static
+uint64_t
+_rdm_deposit(uint64_t v,
+             const uint64_t *pos,
+             uint64_t cnt)
+{
+	uint64_t i, k;
+
+	i = 0;
+	for (k = 0; k < cnt; ++k)
+		i |= ((v >> (cnt - 1 - k)) & 1) << *(pos+k);
+	return i;
+}
+
+/* inverse of _rdm_deposit */
+static
+uint64_t
+_rdm_extract(uint64_t i,
+             const uint64_t *pos,
+             uint64_t cnt)
+{
+	uint64_t v, k;
+
+	v = 0;
+	for (k = 0; k < cnt; ++k)
+		v |= ((i >> *(pos+k)) & 1) << (cnt - 1 - k);
+	return v;
+}
+
+/* upper triangle of the outer products of the environment states b..e-1 */
+static
+void
+_rdm_ket(const double *xr,
+         const double *xi,
+         const uint64_t *off,
+         const uint64_t *epos,
+         uint64_t ne,
+         uint64_t dk,
+         uint64_t b,
+         uint64_t e,
+         double *pr,
+         double *pi)
+{
+	double *gr, *gi;
+	uint64_t env, base, a, c;
+
+	gr = (double *) malloc(sizeof(double) * dk);
+	ALLOC(gr);
+	gi = (double *) malloc(sizeof(double) * dk);
+	ALLOC(gi);
+	for (env = b; env < e; ++env)
+	{
+		base = _rdm_deposit(env, epos, ne);
+		for (a = 0; a < dk; ++a)
+		{
+			*(gr+a) = *(xr+(base|*(off+a)));
+			*(gi+a) = *(xi+(base|*(off+a)));
+		}
+		for (a = 0; a < dk; ++a)
+		{
+			for (c = a; c < dk; ++c)
+			{
+				*(pr+a*dk+c) += *(gr+a) * *(gr+c) + *(gi+a) * *(gi+c);
+				*(pi+a*dk+c) += *(gi+a) * *(gr+c) - *(gr+a) * *(gi+c);
+			}
+		}
+	}
+	free(gr);
+	free(gi);
+}
+
+/* diagonal blocks of the environment states b..e-1 of a dense matrix */
+static
+void
+_rdm_dense(const double *vr,
+           const double *vi,
+           uint64_t n,
+           const uint64_t *off,
+           const uint64_t *epos,
+           uint64_t ne,
+           uint64_t dk,
+           uint64_t b,
+           uint64_t e,
+           double *pr,
+           double *pi)
+{
+	uint64_t env, base, a, c, p;
+
+	for (env = b; env < e; ++env)
+	{
+		base = _rdm_deposit(env, epos, ne);
+		for (a = 0; a < dk; ++a)
+		{
+			for (c = 0; c < dk; ++c)
+			{
+				p = (base | *(off+a)) * n + (base | *(off+c));
+				*(pr+a*dk+c) += *(vr+p);
+				if (vi)
+					*(pi+a*dk+c) += *(vi+p);
+			}
+		}
+	}
+}
+
+/* stored entries b..e-1 of a sparse matrix joining equal environments */
+static
+void
+_rdm_entries(qg8_tensor *t,
+             const double *vr,
+             const double *vi,
+             uint64_t emask,
+             const uint64_t *kpos,
+             uint64_t nk,
+             uint64_t dk,
+             uint64_t b,
+             uint64_t e,
+             double *pr,
+             double *pi)
+{
+	const uint64_t *ri, *ci;
+	uint64_t p, r, c, a, d;
+	double im;
+	int hh;
+
+	ri = *(t->indices);
+	ci = *(t->indices+1);
+	hh = t->packing == QG8_PACKING_HALF_HERMITIAN;
+	for (p = b; p < e; ++p)
+	{
+		r = *(ri+p);
+		c = *(ci+p);
+		if ((r ^ c) & emask)
+			continue;
+		a = _rdm_extract(r, kpos, nk);
+		d = _rdm_extract(c, kpos, nk);
+		im = vi ? *(vi+p) : 0.0;
+		*(pr+a*dk+d) += *(vr+p);
+		*(pi+a*dk+d) += im;
+		if (hh && r != c)
+		{
+			*(pr+d*dk+a) += *(vr+p);
+			*(pi+d*dk+a) -= im;
+		}
+	}
+}
+
+/*
+ * Returns the reduced density matrix of the qubits listed in qubits, the
+ * first being the most significant, as a full COMPLEX128 2^k x 2^k tensor.
+ * t is a ket (rank 1, or rank 2 with one column) or a rank 2 density
+ * matrix in any packing; the other qubits are traced out.
+ */
+qg8_tensor *
+qg8_tensor_partial_trace(qg8_tensor *t,
+                         const uint64_t *qubits,
+                         uint64_t num_qubits)
+{
+	qg8_tensor *out, *src;
+	double *xr, *xi, *part, *re, *im;
+	uint64_t kpos[64], epos[64], *off, n, nq, ne, dk, dd, len, nb, b, a, c;
+	uint64_t kmask, q, k, shape[2];
+	int ket, dense, own_x;
+
+	if (!t || !qubits)
+	{
+		DIE("Cannot take the partial trace of a NULL tensor.\n");
+	}
+	n = *(t->dimensions);
+	ket = t->rank == 1 || (t->rank == 2 && *(t->dimensions+1) == 1);
+	if (!ket && (t->rank != 2 || *(t->dimensions+1) != n))
+	{
+		DIE("Partial traces apply to kets and square matrices only.\n");
+	}
+	for (nq = 0; ((uint64_t) 1 << nq) < n; ++nq)
+		;
+	if (((uint64_t) 1 << nq) != n)
+	{
+		DIE("Dimension is not a power of two.\n");
+	}
+	if (num_qubits == 0 || num_qubits > nq)
+	{
+		DIE("Cannot keep more qubits than the state holds.\n");
+	}
+	kmask = 0;
+	for (k = 0; k < num_qubits; ++k)
+	{
+		q = *(qubits+k);
+		if (q >= nq || (kmask >> (nq - 1 - q)) & 1)
+		{
+			fprintf(stderr, "Cannot keep qubit %lu twice or out of "
+			        "range.\n", (unsigned long) q);
+			exit(EXIT_FAILURE);
+		}
+		kpos[k] = nq - 1 - q;
+		kmask |= (uint64_t) 1 << kpos[k];
+	}
+	ne = 0;
+	for (q = 0; q < nq; ++q)
+		if (!((kmask >> (nq - 1 - q)) & 1))
+			epos[ne++] = nq - 1 - q;
+	dk = (uint64_t) 1 << num_qubits;
+	dd = dk * dk;
+	off = (uint64_t *) malloc(sizeof(uint64_t) * dk);
+	ALLOC(off);
+	for (a = 0; a < dk; ++a)
+		*(off+a) = _rdm_deposit(a, kpos, num_qubits);
+
+	src = t;
+	if (_tensor_is_packed(t))
+		src = _tensor_expand(t);
+	dense = ket || (src->packing == QG8_PACKING_FULL &&
+	                src->num_elems == n * n);
+	if (ket)
+		own_x = src->dtype_id != QG8_DTYPE_COMPLEX128 ||
+		        src->packing != QG8_PACKING_FULL || src->num_elems != n;
+	else
+		own_x = src->dtype_id != QG8_DTYPE_COMPLEX128 &&
+		        src->dtype_id != QG8_DTYPE_FLOAT64;
+	if (own_x)
+	{
+		len = ket ? n : dense ? n * n : MAX(src->num_elems, 1);
+		xr = (double *) malloc(sizeof(double) * len);
+		ALLOC(xr);
+		xi = (double *) malloc(sizeof(double) * len);
+		ALLOC(xi);
+		if (dense)
+			_tensor_to_dense(src, xr, xi);
+		else
+			_tensor_to_double(src, xr, xi);
+	}
+	else
+	{
+		xr = (double *) src->redata;
+		xi = src->dtype_id == QG8_DTYPE_COMPLEX128 ?
+		     (double *) src->imdata : NULL;
+	}
+
+	/* environment states, or entries, shared out between the blocks */
+	len = dense ? (uint64_t) 1 << ne : src->num_elems;
+	nb = MAX(MIN(MIN(len, RDM_BLOCKS), MAX(RDM_PARTIAL / dd, 1)), 1);
+	part = (double *) calloc(nb * 2 * dd, sizeof(double));
+	ALLOC(part);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) if(nb > 1)
+#endif /* _OPENMP */
+	for (b = 0; b < nb; ++b)
+	{
+		uint64_t lo, hi;
+
+		lo = len * b / nb;
+		hi = len * (b + 1) / nb;
+		if (ket)
+			_rdm_ket(xr, xi, off, epos, ne, dk, lo, hi, part + b * 2 * dd,
+			         part + b * 2 * dd + dd);
+		else if (dense)
+			_rdm_dense(xr, xi, n, off, epos, ne, dk, lo, hi,
+			           part + b * 2 * dd, part + b * 2 * dd + dd);
+		else
+			_rdm_entries(src, xr, xi, ~kmask & (n - 1), kpos, num_qubits,
+			             dk, lo, hi, part + b * 2 * dd,
+			             part + b * 2 * dd + dd);
+	}
+
+	shape[0] = dk;
+	shape[1] = dk;
+	out = _tensor_new(QG8_PACKING_FULL, 2, shape, dd, 1);
+	_tensor_fill_full_indices(out);
+	re = (double *) out->redata;
+	im = (double *) out->imdata;
+	memset(re, 0, sizeof(double) * dd);
+	memset(im, 0, sizeof(double) * dd);
+	for (b = 0; b < nb; ++b)
+	{
+		for (a = 0; a < dd; ++a)
+		{
+			*(re+a) += *(part+b*2*dd+a);
+			*(im+a) += *(part+b*2*dd+dd+a);
+		}
+	}
+	if (ket)
+	{
+		/* only the upper triangle was summed */
+		for (a = 0; a < dk; ++a)
+		{
+			for (c = 0; c < a; ++c)
+			{
+				*(re+a*dk+c) = *(re+c*dk+a);
+				*(im+a*dk+c) = -*(im+c*dk+a);
+			}
+		}
+	}
+
+	free(part);
+	free(off);
+	if (own_x)
+	{
+		free(xr);
+		free(xi);
+	}
+	if (src != t)
+		qg8_tensor_destroy(src);
+	return out;
+}
@@ -0,0 +1,390 @@
+/*
+ * trajectory.c
+ * QG8 base library quantum trajectory source.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Noisy circuits are simulated by Monte Carlo wavefunction trajectories
+ * instead of density matrices. A NOISESPEC tensor of shape {m, n, n} holds
+ * m Kraus operators K_j; a trajectory in state x moves to K_j x / |K_j x|
+ * with probability |K_j x|^2. Averaging an observable over trajectories
+ * converges to its value on the density matrix at the memory cost of a
+ * few kets per thread.
+ *
+ * The trajectories are independent and are handed out to the threads in
+ * blocks of TRAJ_BLOCK. The random number of trajectory t at step i is word
+ * t * len + i of the stream of the seed, so a trajectory takes the same
+ * path whichever thread runs it. Observables are summed per block and the
+ * block sums added in block order, so the averages do not depend on the
+ * number of threads either.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "qg8.h"
+
+/* trajectories per partial sum */
+#define TRAJ_BLOCK 16
+
+SPLITMIX()
+
+typedef struct
+traj_step_s
+{
+	uint16_t type;
+	uint64_t num;      /* Kraus operators of a NOISESPEC step, 1 otherwise */
+	qg8_tensor **ops;
+	int owned;         /* ops were split off a NOISESPEC tensor */
+} traj_step;
+
+/* splits the {m, n, n} Kraus tensor t into m sparse operators */
+static
+void
+_kraus_split(qg8_tensor *t,
+             uint64_t n,
+             traj_step *st)
+{
+	double *re, *im;
+	uint64_t *cnt, *pos, e, k, shape[2];
+	qg8_tensor *o;
+
+	if (t->rank != 3 || *(t->dimensions+1) != n || *(t->dimensions+2) != n)
+	{
+		DIE("Cannot read Kraus operators from a NOISESPEC tensor of this "
+		    "shape.\n");
+	}
+	st->num = *(t->dimensions);
+	st->owned = 1;
+	re = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(re);
+	im = (double *) malloc(sizeof(double) * MAX(t->num_elems, 1));
+	ALLOC(im);
+	_tensor_to_double(t, re, im);
+	cnt = (uint64_t *) calloc(st->num, sizeof(uint64_t));
+	ALLOC(cnt);
+	pos = (uint64_t *) calloc(st->num, sizeof(uint64_t));
+	ALLOC(pos);
+	for (e = 0; e < t->num_elems; ++e)
+	{
+		if (*(*(t->indices)+e) >= st->num)
+		{
+			DIE("Kraus operator index out of bounds.\n");
+		}
+		++*(cnt+*(*(t->indices)+e));
+	}
+
+	shape[0] = n;
+	shape[1] = n;
+	st->ops = (qg8_tensor **) malloc(sizeof(qg8_tensor *) * st->num);
+	ALLOC(st->ops);
+	for (k = 0; k < st->num; ++k)
+	{
+		if (!*(cnt+k))
+		{
+			DIE("Cannot use an empty Kraus operator.\n");
+		}
+		*(st->ops+k) = _tensor_new(QG8_PACKING_SPARSE_COO, 2, shape,
+		                           *(cnt+k), 1);
+	}
+	for (e = 0; e < t->num_elems; ++e)
+	{
+		k = *(*(t->indices)+e);
+		o = *(st->ops+k);
+		*(*(o->indices)+*(pos+k)) = *(*(t->indices+1)+e);
+		*(*(o->indices+1)+*(pos+k)) = *(*(t->indices+2)+e);
+		*((double *) o->redata+*(pos+k)) = *(re+e);
+		*((double *) o->imdata+*(pos+k)) = *(im+e);
+		++*(pos+k);
+	}
+	for (k = 0; k < st->num; ++k)
+		qg8_tensor_csr_build(*(st->ops+k));
+
+	free(re);
+	free(im);
+	free(cnt);
+	free(pos);
+}
+
+/* squared norm of x */
+static
+double
+_traj_norm2(uint64_t n,
+            const double *xr,
+            const double *xi)
+{
+	double s;
+	uint64_t i;
+
+	s = 0.0;
+	for (i = 0; i < n; ++i)
+		s += *(xr+i) * *(xr+i) + *(xi+i) * *(xi+i);
+	return s;
+}
+
+/* y = x / sqrt(w) */
+static
+void
+_traj_normalise(uint64_t n,
+                double w,
+                const double *xr,
+                const double *xi,
+                double *yr,
+                double *yi)
+{
+	double a;
+	uint64_t i;
+
+	if (w <= 0.0)
+	{
+		DIE("Cannot continue a trajectory from a ket of norm 0.\n");
+	}
+	a = 1.0 / sqrt(w);
+	for (i = 0; i < n; ++i)
+	{
+		*(yr+i) = a * *(xr+i);
+		*(yi+i) = a * *(xi+i);
+	}
+}
+
+/*
+ * Runs trajectories through the chunks of seq in order, starting from
+ * ket: OPERATOR chunks are applied and the ket renormalised, NOISESPEC
+ * chunks pick one of their Kraus operators at random and OBSERVABLE chunks
+ * record <x|O|x>. Returns the averages over the trajectories as a full
+ * COMPLEX128 rank 1 tensor with one element per OBSERVABLE chunk, in
+ * order. The same seed gives the same averages for any number of threads.
+ */
+qg8_tensor *
+qg8_tensor_trajectories(qg8_tensor *ket,
+                        qg8_chunk **seq,
+                        uint64_t len,
+                        uint64_t trajectories,
+                        uint64_t seed)
+{
+	qg8_tensor *out, *t;
+	traj_step *steps, *st;
+	double *xr, *xi, *part, *re, *im;
+	uint64_t n, i, b, o, nb, nobs, key, *idx, shape[1];
+
+	if (!ket || !seq)
+	{
+		DIE("Cannot run trajectories from NULL arguments.\n");
+	}
+	if (ket->rank > 2 || (ket->rank == 2 && *(ket->dimensions+1) != 1))
+	{
+		DIE("Cannot run trajectories from a tensor which is not a ket.\n");
+	}
+	if (trajectories == 0)
+	{
+		DIE("Cannot average over 0 trajectories.\n");
+	}
+	n = *(ket->dimensions);
+	xr = (double *) malloc(sizeof(double) * n);
+	ALLOC(xr);
+	xi = (double *) malloc(sizeof(double) * n);
+	ALLOC(xi);
+	_tensor_to_dense(ket, xr, xi);
+	_traj_normalise(n, _traj_norm2(n, xr, xi), xr, xi, xr, xi);
+
+	/* every operator gets its row compressed form before the threads run */
+	steps = (traj_step *) malloc(sizeof(traj_step) * MAX(len, 1));
+	ALLOC(steps);
+	nobs = 0;
+	for (i = 0; i < len; ++i)
+	{
+		st = steps + i;
+		st->type = qg8_chunk_get_type(*(seq+i));
+		t = qg8_chunk_get_tensor(*(seq+i));
+		if (!t)
+		{
+			DIE("Cannot run trajectories through a chunk without a "
+			    "tensor.\n");
+		}
+		if (st->type == QG8_TYPE_NOISESPEC)
+		{
+			_kraus_split(t, n, st);
+			continue;
+		}
+		if (st->type != QG8_TYPE_OPERATOR && st->type != QG8_TYPE_OBSERVABLE)
+		{
+			fprintf(stderr, "Cannot run trajectories through a chunk of "
+			        "type %d.\n", st->type);
+			exit(EXIT_FAILURE);
+		}
+		if (t->rank != 2 || *(t->dimensions) != n ||
+		    *(t->dimensions+1) != n)
+		{
+			DIE("Cannot run trajectories through an operator of "
+			    "mismatched shape.\n");
+		}
+		st->num = 1;
+		st->owned = 0;
+		st->ops = (qg8_tensor **) malloc(sizeof(qg8_tensor *));
+		ALLOC(st->ops);
+		*(st->ops) = t;
+		if (st->type == QG8_TYPE_OBSERVABLE)
+			++nobs;
+		else if (!_tensor_is_packed(t))
+			qg8_tensor_csr_build(t);
+	}
+	if (nobs == 0)
+	{
+		DIE("Cannot average trajectories without an OBSERVABLE chunk.\n");
+	}
+
+	idx = (uint64_t *) malloc(sizeof(uint64_t) * n);
+	ALLOC(idx);
+	for (i = 0; i < n; ++i)
+		*(idx+i) = i;
+	nb = (trajectories + TRAJ_BLOCK - 1) / TRAJ_BLOCK;
+	part = (double *) calloc(nb * 2 * nobs, sizeof(double));
+	ALLOC(part);
+	key = _mix(seed);
+	qg8_kernel_get_isa();
+#ifdef _OPENMP
+#pragma omp parallel if(nb > 1)
+#endif /* _OPENMP */
+	{
+		qg8_tensor *psi;
+		traj_step *s;
+		double *pr, *pi, *qr, *qi, *acc, u, w, cum, er, ei;
+		uint64_t *ind[1], kdims[1], bb, tr, j, k, pick, last, ob;
+
+		pr = (double *) malloc(sizeof(double) * n);
+		ALLOC(pr);
+		pi = (double *) malloc(sizeof(double) * n);
+		ALLOC(pi);
+		qr = (double *) malloc(sizeof(double) * n);
+		ALLOC(qr);
+		qi = (double *) malloc(sizeof(double) * n);
+		ALLOC(qi);
+		*ind = idx;
+		*kdims = n;
+		psi = qg8_tensor_create_double(ind, pr, pi, n, kdims, 1,
+		                               QG8_PACKING_FULL);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif /* _OPENMP */
+		for (bb = 0; bb < nb; ++bb)
+		{
+			acc = part + bb * 2 * nobs;
+			for (tr = bb * TRAJ_BLOCK;
+			     tr < MIN((bb + 1) * TRAJ_BLOCK, trajectories); ++tr)
+			{
+				memcpy(pr, xr, sizeof(double) * n);
+				memcpy(pi, xi, sizeof(double) * n);
+				ob = 0;
+				for (j = 0; j < len; ++j)
+				{
+					s = steps + j;
+					if (s->type == QG8_TYPE_OBSERVABLE)
+					{
+						qg8_tensor_expectation(*(s->ops), psi, &er, &ei);
+						*(acc+2*ob) += er;
+						*(acc+2*ob+1) += ei;
+						++ob;
+						continue;
+					}
+					if (s->type == QG8_TYPE_OPERATOR)
+					{
+						qg8_tensor_spmv(*(s->ops), pr, pi, qr, qi);
+						_traj_normalise(n, _traj_norm2(n, qr, qi), qr, qi,
+						                pr, pi);
+						continue;
+					}
+					/* the first Kraus operator whose weights pass u */
+					u = _unit(key, tr * len + j);
+					w = 0.0;
+					cum = 0.0;
+					pick = s->num;
+					last = s->num;
+					for (k = 0; k < s->num; ++k)
+					{
+						qg8_tensor_spmv(*(s->ops+k), pr, pi, qr, qi);
+						w = _traj_norm2(n, qr, qi);
+						cum += w;
+						if (w > 0.0)
+							last = k;
+						if (w > 0.0 && cum > u)
+						{
+							pick = k;
+							break;
+						}
+					}
+					if (pick == s->num)
+					{
+						/* weights short of 1 by rounding */
+						if (last == s->num)
+						{
+							DIE("Kraus operators annihilate the ket.\n");
+						}
+						qg8_tensor_spmv(*(s->ops+last), pr, pi, qr, qi);
+						w = _traj_norm2(n, qr, qi);
+					}
+					_traj_normalise(n, w, qr, qi, pr, pi);
+				}
+			}
+		}
+		qg8_tensor_destroy(psi);
+		free(pr);
+		free(pi);
+		free(qr);
+		free(qi);
+	}
+
+	shape[0] = nobs;
+	out = _tensor_new(QG8_PACKING_FULL, 1, shape, nobs, 1);
+	_tensor_fill_full_indices(out);
+	re = (double *) out->redata;
+	im = (double *) out->imdata;
+	for (o = 0; o < nobs; ++o)
+	{
+		*(re+o) = 0.0;
+		*(im+o) = 0.0;
+		for (b = 0; b < nb; ++b)
+		{
+			*(re+o) += *(part+b*2*nobs+2*o);
+			*(im+o) += *(part+b*2*nobs+2*o+1);
+		}
+		*(re+o) /= (double) trajectories;
+		*(im+o) /= (double) trajectories;
+	}
+
+	for (i = 0; i < len; ++i)
+	{
+		st = steps + i;
+		if (st->owned)
+			for (o = 0; o < st->num; ++o)
+				qg8_tensor_destroy(*(st->ops+o));
+		free(st->ops);
+	}
+	free(steps);
+	free(part);
+	free(idx);
+	free(xr);
+	free(xi);
+	return out;
+}
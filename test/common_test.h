@@ -46,6 +46,8 @@
 #include <stdlib.h>
 #include <time.h>
 
+#include "qg8.h"
+
 #define RED    "\x1b[1;31m"
 #define YELLOW "\x1b[1;33m"
 #define GREEN  "\x1b[1;32m"
@@ -61,7 +63,8 @@
                (void) totaltime;\
                (void) besttime;\
                (void) worsttime;\
-               (void) avgtime;
+               (void) avgtime;\
+               (void) _test_helpers;
 
 #define FAIL(x,y) if (!(x)) {\
                       fprintf(stdout, "\r" RED "FAILURE: " RESET "%s\n", y);\
@@ -91,6 +94,115 @@
                             BOLD "%fs" RESET ", iters: %d\n",\
                             y, totaltime, avgtime, besttime, worsttime, z);
 
+
+/* linear congruential numbers, the same on every platform */
+static unsigned long test_seed = 1;
+
+static
+void
+_rand_seed(unsigned long seed)
+{
+	test_seed = seed;
+}
+
+/* 23 random bits */
+static
+unsigned long
+_rand_int(void)
+{
+	test_seed = (test_seed * 1103515245 + 12345) % 2147483648UL;
+	return test_seed >> 8;
+}
+
+/* uniform in [-0.5, 0.5) */
+static
+double
+_rand(void)
+{
+	test_seed = (test_seed * 1103515245 + 12345) % 2147483648UL;
+	return (double) test_seed / 2147483648.0 - 0.5;
+}
+
+/* position of c in the chunks of g, as the adjacency chunk counts them */
+static
+uint64_t
+_index_of(qg8_graph *g,
+          qg8_chunk *c)
+{
+	uint64_t i;
+
+	for (i = 0; qg8_graph_get_chunk(g, i) != c; ++i)
+		;
+	return i;
+}
+
+/*
+ * Writes the nt tensors of ts to fname as chunks of the given type,
+ * compression and index encoding, without giving the tensors to them, and
+ * reads the chunks back into back, converted to dtype_id unless it is 0.
+ * Returns the number of bytes the file takes.
+ */
+static
+long
+_round_trip(const char *fname,
+            uint16_t type,
+            qg8_tensor **ts,
+            int nt,
+            uint8_t compression,
+            uint8_t encoding,
+            uint8_t dtype_id,
+            qg8_chunk **back)
+{
+	qg8_chunk **c;
+	qg8_file *f;
+	qg8_iter iter;
+	FILE *fp;
+	long size;
+	int i;
+
+	/* the file writes its chunks when flushed */
+	c = (qg8_chunk **) malloc(sizeof(qg8_chunk *) * (nt > 0 ? nt : 1));
+	f = qg8_file_open(fname, QG8_MODE_WRITE);
+	for (i = 0; i < nt; ++i)
+	{
+		c[i] = qg8_chunk_create(type, 0, NULL, ts[i]);
+		qg8_chunk_set_compression(c[i], compression);
+		qg8_chunk_set_index_encoding(c[i], encoding);
+		qg8_file_write_chunk(f, c[i]);
+	}
+	qg8_file_flush(f);
+	qg8_file_close(f);
+	for (i = 0; i < nt; ++i)
+	{
+		c[i]->tensor = NULL;
+		qg8_chunk_destroy(c[i]);
+	}
+	free(c);
+	fp = fopen(fname, "rb");
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fclose(fp);
+	f = qg8_file_open(fname, QG8_MODE_READ);
+	iter = qg8_file_iterator(f);
+	for (i = 0; i < nt; ++i)
+		back[i] = qg8_file_has_next(&iter) ?
+		          qg8_file_extract_as(&iter, dtype_id) : NULL;
+	qg8_file_close(f);
+	return size;
+}
+
+/* referenced by INIT() so that a test need not use every helper */
+static
+void
+_test_helpers(void)
+{
+	(void) _rand_seed;
+	(void) _rand_int;
+	(void) _rand;
+	(void) _index_of;
+	(void) _round_trip;
+}
+
 #define PASS() exit(EXIT_SUCCESS);
 
 #endif /* _RAYMENT_FR_TEST_COMMON_TEST_H */
@@ -0,0 +1,182 @@
+/*
+ * compress_test.c
+ * Compressed tensor values in files.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define N     100000
+#define M     512
+#define FNAME "file/compress_test.qg8"
+
+/* same packing, indices and bit for bit the same values */
+static
+int
+_same(qg8_tensor *a,
+      qg8_tensor *b)
+{
+	size_t dsize;
+	uint64_t len;
+	uint16_t k;
+
+	if (!b || a->num_elems != b->num_elems || a->rank != b->rank ||
+	    a->packing != b->packing || a->dtype_id != b->dtype_id)
+		return 0;
+	len = _tensor_index_len(a);
+	for (k = 0; k < _tensor_index_arrays(a); ++k)
+		if (memcmp(a->indices[k], b->indices[k], sizeof(uint64_t) * len))
+			return 0;
+	dsize = _type_to_size(a->dtype_id);
+	if (memcmp(a->redata, b->redata, dsize * a->num_elems))
+		return 0;
+	if (a->imdata && memcmp(a->imdata, b->imdata, dsize * a->num_elems))
+		return 0;
+	return 1;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *ci[1], *ni[1], *oi[2], dims[1], odims[2], i;
+	double *cre;
+	float *nre, *nim;
+	double ore[3*M];
+	qg8_tensor *ts[3], *cal, *noise, *op, *dia, *canon;
+	qg8_chunk *back[3];
+	long plain_size, lz_size;
+	int ok, j;
+
+	INIT();
+	_rand_seed(48);
+	(void) argc;
+	(void) argv;
+
+	/* a calibration table: few distinct, slowly drifting readings */
+	dims[0] = N;
+	ci[0] = (uint64_t *) malloc(sizeof(uint64_t) * N);
+	cre = (double *) malloc(sizeof(double) * N);
+	for (i = 0; i < N; ++i)
+	{
+		ci[0][i] = i;
+		cre[i] = 1.0 + (double) ((i / 64) % 200) * 0.125;
+	}
+	cal = qg8_tensor_create_double(ci, cre, NULL, N, dims, 1,
+	                               QG8_PACKING_FULL);
+
+	/* measurement noise, which does not compress */
+	ni[0] = ci[0];
+	nre = (float *) malloc(sizeof(float) * N);
+	nim = (float *) malloc(sizeof(float) * N);
+	for (i = 0; i < N; ++i)
+	{
+		nre[i] = (float) _rand_int() / 8388608.0f;
+		nim[i] = (float) _rand_int() / 8388608.0f;
+	}
+	noise = qg8_tensor_create_float(ni, nre, nim, N, dims, 1,
+	                                QG8_PACKING_FULL);
+
+	TEST(
+		ts[0] = cal;
+		plain_size = _round_trip(FNAME, QG8_TYPE_CONSTANT, ts, 1,
+		                         QG8_COMPRESS_NONE, QG8_INDEX_PLAIN, 0,
+		                         back);
+		ok = _same(cal, back[0]->tensor) &&
+		     qg8_chunk_get_compression(back[0]) == QG8_COMPRESS_NONE;
+		qg8_chunk_destroy(back[0]);
+		lz_size = _round_trip(FNAME, QG8_TYPE_CONSTANT, ts, 1,
+		                      QG8_COMPRESS_SHUFFLE_LZ, QG8_INDEX_PLAIN, 0,
+		                      back);
+		ok = ok && _same(cal, back[0]->tensor) &&
+		     qg8_chunk_get_compression(back[0]) == QG8_COMPRESS_SHUFFLE_LZ;
+		qg8_chunk_destroy(back[0]);
+	, ok && plain_size - lz_size > N * 8 / 4 * 3,
+	  "compressed calibration table"
+	);
+
+	TEST(
+		ts[0] = noise;
+		plain_size = _round_trip(FNAME, QG8_TYPE_CONSTANT, ts, 1,
+		                         QG8_COMPRESS_NONE, QG8_INDEX_PLAIN, 0,
+		                         back);
+		qg8_chunk_destroy(back[0]);
+		lz_size = _round_trip(FNAME, QG8_TYPE_CONSTANT, ts, 1,
+		                      QG8_COMPRESS_SHUFFLE_LZ, QG8_INDEX_PLAIN, 0,
+		                      back);
+		ok = _same(noise, back[0]->tensor);
+		qg8_chunk_destroy(back[0]);
+	, ok && lz_size <= plain_size + 8 + 4 * (N * 8 / 65536 + 2),
+	  "incompressible values"
+	);
+
+	/* a banded operator, compressed with packed indices and as DIA */
+	odims[0] = M;
+	odims[1] = M;
+	oi[0] = (uint64_t *) malloc(sizeof(uint64_t) * 3 * M);
+	oi[1] = (uint64_t *) malloc(sizeof(uint64_t) * 3 * M);
+	for (i = 0; i < 3 * M; ++i)
+	{
+		oi[0][i] = i / 3;
+		oi[1][i] = (i / 3 + M + i % 3 - 1) % M;
+		ore[i] = i % 3 == 1 ? -2.0 : 1.0;
+	}
+	op = qg8_tensor_create_double(oi, ore, NULL, 3 * M, odims, 2,
+	                              QG8_PACKING_SPARSE_COO);
+	canon = qg8_tensor_canonical(op);
+	dia = qg8_tensor_to_dia(op);
+
+	TEST(
+		ts[0] = canon;
+		ts[1] = dia;
+		ts[2] = noise;
+		_round_trip(FNAME, QG8_TYPE_CONSTANT, ts, 3,
+		            QG8_COMPRESS_SHUFFLE_LZ, QG8_INDEX_PLAIN, 0, back);
+		ok = 1;
+		for (j = 0; j < 3; ++j)
+		{
+			ok = ok && back[j] && _same(ts[j], back[j]->tensor);
+			if (back[j])
+				qg8_chunk_destroy(back[j]);
+		}
+		remove(FNAME);
+	, ok, "compressed COO, DIA and complex chunks"
+	);
+
+	qg8_tensor_destroy(cal);
+	qg8_tensor_destroy(noise);
+	qg8_tensor_destroy(op);
+	qg8_tensor_destroy(canon);
+	qg8_tensor_destroy(dia);
+	free(ci[0]);
+	free(cre);
+	free(nre);
+	free(nim);
+	free(oi[0]);
+	free(oi[1]);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+/*
+ * convert_test.c
+ * Chunk values converted to another dtype while they are read.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+/* more values than a read block or a compressed block holds */
+#define N     20011
+#define FNAME "file/convert_test.qg8"
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *ind[1], dims[1], pdims[1], perm[4], i;
+	double *re, *im;
+	int32_t *iv;
+	float *fre, *fim;
+	uint16_t *h;
+	qg8_tensor *z, *n, *p;
+	qg8_chunk *c;
+	qg8_graph *g;
+	int ok, k;
+
+	INIT();
+	_rand_seed(50);
+	(void) argc;
+	(void) argv;
+
+	dims[0] = N;
+	ind[0] = (uint64_t *) malloc(sizeof(uint64_t) * N);
+	re = (double *) malloc(sizeof(double) * N);
+	im = (double *) malloc(sizeof(double) * N);
+	iv = (int32_t *) malloc(sizeof(int32_t) * N);
+	fre = (float *) malloc(sizeof(float) * N);
+	fim = (float *) malloc(sizeof(float) * N);
+	h = (uint16_t *) malloc(sizeof(uint16_t) * N);
+	for (i = 0; i < N; ++i)
+	{
+		ind[0][i] = i;
+		re[i] = (double) _rand_int() / 3.0 - 1e6;
+		im[i] = (double) (i % 77) / 7.0;
+		iv[i] = (int32_t) _rand_int() - 4000000;
+	}
+	z = qg8_tensor_create_double(ind, re, im, N, dims, 1, QG8_PACKING_FULL);
+	n = qg8_tensor_create_int32(ind, iv, N, dims, 1, QG8_PACKING_FULL);
+	pdims[0] = 4;
+	for (i = 0; i < 4; ++i)
+		perm[i] = (i + 3) % 4;
+	p = qg8_tensor_create_uint64(ind, perm, 4, pdims, 1, QG8_PACKING_FULL);
+
+	/* double precision amplitudes loaded as single precision */
+	TEST(
+		ok = 1;
+		for (k = 0; k < 2; ++k)
+		{
+			_round_trip(FNAME, QG8_TYPE_CONSTANT, &z, 1,
+			            k ? QG8_COMPRESS_SHUFFLE_LZ : QG8_COMPRESS_NONE,
+			            QG8_INDEX_PLAIN, QG8_DTYPE_FLOAT32, &c);
+			ok = ok && c && c->tensor->dtype_id == QG8_DTYPE_COMPLEX64 &&
+			     c->tensor->num_elems == N;
+			for (i = 0; ok && i < N; ++i)
+				ok = ((float *) c->tensor->redata)[i] == (float) re[i] &&
+				     ((float *) c->tensor->imdata)[i] == (float) im[i];
+			if (c)
+				qg8_chunk_destroy(c);
+		}
+	, ok, "COMPLEX128 loaded as COMPLEX64"
+	);
+
+	TEST(
+		ok = 1;
+		for (k = 0; k < 2; ++k)
+		{
+			_round_trip(FNAME, QG8_TYPE_CONSTANT, &n, 1,
+			            k ? QG8_COMPRESS_SHUFFLE_LZ : QG8_COMPRESS_NONE,
+			            QG8_INDEX_PLAIN, QG8_DTYPE_FLOAT64, &c);
+			ok = ok && c && c->tensor->dtype_id == QG8_DTYPE_FLOAT64 &&
+			     !c->tensor->imdata;
+			for (i = 0; ok && i < N; ++i)
+				ok = ((double *) c->tensor->redata)[i] == (double) iv[i];
+			if (c)
+				qg8_chunk_destroy(c);
+		}
+	, ok, "INT32 loaded as FLOAT64"
+	);
+
+	/* narrowed to 16 bits straight from double */
+	TEST(
+		_round_trip(FNAME, QG8_TYPE_CONSTANT, &z, 1,
+		            QG8_COMPRESS_SHUFFLE_LZ, QG8_INDEX_PLAIN,
+		            QG8_DTYPE_BFLOAT16, &c);
+		ok = c && c->tensor->dtype_id == QG8_DTYPE_BCOMPLEX32;
+		for (i = 0; ok && i < N; ++i)
+			ok = ((uint16_t *) c->tensor->redata)[i] ==
+			     _double_to_bf16(re[i]) &&
+			     ((uint16_t *) c->tensor->imdata)[i] ==
+			     _double_to_bf16(im[i]);
+		if (c)
+			qg8_chunk_destroy(c);
+	, ok, "COMPLEX128 loaded as BCOMPLEX32"
+	);
+
+	/* just above a tie of half precision, which float rounds onto it */
+	TEST(
+		qg8_tensor_destroy(z);
+		for (i = 0; i < N; ++i)
+		{
+			re[i] = (double) (i % 1024 + 1024) + 0.5 + 1e-9;
+			fre[i] = (float) re[i];
+			fim[i] = (float) im[i];
+		}
+		z = qg8_tensor_create_double(ind, re, NULL, N, dims, 1,
+		                             QG8_PACKING_FULL);
+		_round_trip(FNAME, QG8_TYPE_CONSTANT, &z, 1, QG8_COMPRESS_NONE,
+		            QG8_INDEX_PLAIN, QG8_DTYPE_FLOAT16, &c);
+		qg8_kernel_float_to_half(N, fre, h);
+		ok = c && c->tensor->dtype_id == QG8_DTYPE_FLOAT16;
+		for (i = 0; ok && i < N; ++i)
+			ok = ((uint16_t *) c->tensor->redata)[i] ==
+			     _float_to_half((float) (i % 1024 + 1025)) &&
+			     (i % 2 || h[i] != ((uint16_t *) c->tensor->redata)[i]);
+		if (c)
+			qg8_chunk_destroy(c);
+	, ok, "FLOAT64 loaded as FLOAT16 (rounded once)"
+	);
+
+	/* and half precision widened back */
+	TEST(
+		qg8_tensor_destroy(z);
+		qg8_kernel_float_to_half(N, fim, h);
+		z = qg8_tensor_create_half(ind, h, h, N, dims, 1, QG8_PACKING_FULL);
+		_round_trip(FNAME, QG8_TYPE_CONSTANT, &z, 1, QG8_COMPRESS_NONE,
+		            QG8_INDEX_PLAIN, QG8_DTYPE_COMPLEX128, &c);
+		ok = c && c->tensor->dtype_id == QG8_DTYPE_COMPLEX128;
+		for (i = 0; ok && i < N; ++i)
+			ok = ((double *) c->tensor->redata)[i] ==
+			     (double) _half_to_float(h[i]) &&
+			     ((double *) c->tensor->imdata)[i] ==
+			     (double) _half_to_float(h[i]);
+		if (c)
+			qg8_chunk_destroy(c);
+	, ok, "COMPLEX32 loaded as COMPLEX128"
+	);
+
+	TEST(
+		_round_trip(FNAME, QG8_TYPE_CONSTANT, &n, 1, QG8_COMPRESS_NONE,
+		            QG8_INDEX_PLAIN, 0, &c);
+		ok = c && c->tensor->dtype_id == QG8_DTYPE_INT32 &&
+		     !memcmp(c->tensor->redata, iv, sizeof(int32_t) * N);
+		if (c)
+			qg8_chunk_destroy(c);
+	, ok, "stored dtype kept"
+	);
+
+	TEST(
+		g = qg8_graph_create();
+		qg8_graph_add_chunk(g, qg8_chunk_create(QG8_TYPE_CONSTANT, 0, NULL,
+		                                        _tensor_copy(z)));
+		qg8_graph_add_chunk(g, qg8_chunk_create(QG8_TYPE_CONSTANT, 0, NULL,
+		                                        _tensor_copy(n)));
+		qg8_graph_add_chunk(g, qg8_chunk_create(QG8_TYPE_PERMUTATION, 0,
+		                                        NULL, _tensor_copy(p)));
+		qg8_graph_write(FNAME, g);
+		qg8_graph_destroy(g);
+		g = qg8_graph_load_as(FNAME, QG8_DTYPE_FLOAT32);
+		remove(FNAME);
+		ok = qg8_graph_get_number_chunks(g) == 3 &&
+		     qg8_graph_get_chunk(g, 0)->tensor->dtype_id ==
+		     QG8_DTYPE_COMPLEX64 &&
+		     qg8_graph_get_chunk(g, 1)->tensor->dtype_id ==
+		     QG8_DTYPE_FLOAT32 &&
+		     qg8_graph_get_chunk(g, 2)->tensor->dtype_id ==
+		     QG8_DTYPE_UINT64 &&
+		     !memcmp(qg8_graph_get_chunk(g, 2)->tensor->redata, perm,
+		             sizeof(perm));
+		qg8_graph_destroy(g);
+	, ok, "qg8_graph_load_as (permutation kept)"
+	);
+
+	qg8_tensor_destroy(z);
+	qg8_tensor_destroy(n);
+	qg8_tensor_destroy(p);
+	free(ind[0]);
+	free(re);
+	free(im);
+	free(iv);
+	free(fre);
+	free(fim);
+	free(h);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,359 @@
+/*
+ * fusion_test.c
+ * Circuit evaluation with gate fusion against the expanded products.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define NQ     6
+#define DIM    (1 << NQ)
+#define EDGES  24
+#define BUFFERS 96
+
+static void *buffers[BUFFERS];
+static int num_buffers = 0;
+
+static
+void *
+_keep(void *p)
+{
+	buffers[num_buffers++] = p;
+	return p;
+}
+
+/* dense square operator from row-major values, im may be NULL */
+static
+qg8_tensor *
+_dense(uint64_t d,
+       const double *re,
+       const double *im)
+{
+	uint64_t **ind, *dims, i;
+	double *r, *m;
+
+	ind = (uint64_t **) _keep(malloc(sizeof(uint64_t *) * 2));
+	ind[0] = (uint64_t *) _keep(malloc(sizeof(uint64_t) * d * d));
+	ind[1] = (uint64_t *) _keep(malloc(sizeof(uint64_t) * d * d));
+	dims = (uint64_t *) _keep(malloc(sizeof(uint64_t) * 2));
+	r = (double *) _keep(malloc(sizeof(double) * d * d));
+	m = (double *) _keep(malloc(sizeof(double) * d * d));
+	dims[0] = d;
+	dims[1] = d;
+	for (i = 0; i < d * d; ++i)
+	{
+		ind[0][i] = i / d;
+		ind[1][i] = i % d;
+		r[i] = re[i];
+		m[i] = im ? im[i] : 0.0;
+	}
+	return qg8_tensor_create_double(ind, r, m, d * d, dims, 2,
+	                                QG8_PACKING_FULL);
+}
+
+/* sparse identity of dimension d */
+static
+qg8_tensor *
+_identity(uint64_t d)
+{
+	uint64_t **ind, *dims, i;
+	double *r;
+
+	ind = (uint64_t **) _keep(malloc(sizeof(uint64_t *) * 2));
+	ind[0] = (uint64_t *) _keep(malloc(sizeof(uint64_t) * d));
+	ind[1] = ind[0];
+	dims = (uint64_t *) _keep(malloc(sizeof(uint64_t) * 2));
+	r = (double *) _keep(malloc(sizeof(double) * d));
+	dims[0] = d;
+	dims[1] = d;
+	for (i = 0; i < d; ++i)
+	{
+		ind[0][i] = i;
+		r[i] = 1.0;
+	}
+	return qg8_tensor_create_double(ind, r, NULL, d, dims, 2,
+	                                QG8_PACKING_SPARSE_COO);
+}
+
+static qg8_chunk *from[EDGES], *to[EDGES];
+static int num_edges = 0;
+
+/* operands in order */
+static
+void
+_link(qg8_chunk *node,
+      int n,
+      qg8_chunk **ops)
+{
+	int i;
+	for (i = 0; i < n; ++i)
+	{
+		from[num_edges] = ops[i];
+		to[num_edges++] = node;
+	}
+}
+
+static
+qg8_chunk *
+_node(qg8_graph *g,
+      uint16_t type,
+      qg8_tensor *t)
+{
+	qg8_chunk *c;
+	c = qg8_chunk_create(type, 0, NULL, t);
+	qg8_graph_add_chunk(g, c);
+	return c;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	double hre[4], tre[4], tim[4], zre[4], cre[16], gre[64], gim[64];
+	double vre[DIM];
+	double vim[DIM], ere[EDGES], *rre, *rim, *ore, *oim;
+	uint64_t **inde, edims[2], vdims[1], *vind[1], i;
+	qg8_chunk *h, *t, *cx, *g3, *id[6], *v, *j[7], *m, *ops[7];
+	qg8_tensor *ref, *res;
+	qg8_graph *g;
+	int fused, ok;
+
+	INIT();
+
+	(void) argc;
+	(void) argv;
+
+	for (i = 0; i < 4; ++i)
+	{
+		hre[i] = i == 3 ? -sqrt(0.5) : sqrt(0.5);
+		tre[i] = i == 0 ? 1.0 : i == 3 ? sqrt(0.5) : 0.0;
+		tim[i] = i == 3 ? sqrt(0.5) : 0.0;
+	}
+	for (i = 0; i < 16; ++i)
+		cre[i] = i == 0 || i == 5 || i == 11 || i == 14 ? 1.0 : 0.0;
+	for (i = 0; i < 64; ++i)
+	{
+		gre[i] = (double) ((i * 13) % 11) / 11.0 - 0.5;
+		gim[i] = (double) ((i * 7) % 5) / 5.0 - 0.5;
+	}
+	vind[0] = (uint64_t *) _keep(malloc(sizeof(uint64_t) * DIM));
+	for (i = 0; i < DIM; ++i)
+	{
+		vind[0][i] = i;
+		vre[i] = (double) ((i * 37) % 101) / 101.0;
+		vim[i] = (double) ((i * 53) % 97) / 97.0;
+	}
+	vdims[0] = DIM;
+
+	g = qg8_graph_create();
+	h = _node(g, QG8_TYPE_OPERATOR, _dense(2, hre, NULL));
+	t = _node(g, QG8_TYPE_OPERATOR, _dense(2, tre, tim));
+	cx = _node(g, QG8_TYPE_OPERATOR, _dense(4, cre, NULL));
+	g3 = _node(g, QG8_TYPE_OPERATOR, _dense(8, gre, gim));
+	for (i = 1; i < 6; ++i)
+		id[i] = _node(g, QG8_TYPE_OPERATOR, _identity(1 << i));
+	v = _node(g, QG8_TYPE_KET,
+	          qg8_tensor_create_double(vind, vre, vim, DIM, vdims, 1,
+	                                   QG8_PACKING_FULL));
+	for (i = 0; i < 7; ++i)
+		j[i] = _node(g, QG8_TYPE_JOIN, NULL);
+	m = _node(g, QG8_TYPE_MATMUL, NULL);
+
+	/* H(0), CX(0,1), T(1), G3(3,4,5), H(0) T(2), CX(2,3) nested */
+	ops[0] = h; ops[1] = id[5];
+	_link(j[0], 2, ops);
+	ops[0] = cx; ops[1] = id[4];
+	_link(j[1], 2, ops);
+	ops[0] = id[1]; ops[1] = t; ops[2] = id[4];
+	_link(j[2], 3, ops);
+	ops[0] = id[3]; ops[1] = g3;
+	_link(j[3], 2, ops);
+	ops[0] = h; ops[1] = id[1]; ops[2] = t; ops[3] = id[3];
+	_link(j[4], 4, ops);
+	ops[0] = id[2]; ops[1] = cx;
+	_link(j[6], 2, ops);
+	ops[0] = j[6]; ops[1] = id[2];
+	_link(j[5], 2, ops);
+	for (i = 0; i < 6; ++i)
+		ops[i] = j[5 - i];
+	ops[6] = v;
+	_link(m, 7, ops);
+
+	inde = (uint64_t **) _keep(malloc(sizeof(uint64_t *) * 2));
+	inde[0] = (uint64_t *) _keep(malloc(sizeof(uint64_t) * EDGES));
+	inde[1] = (uint64_t *) _keep(malloc(sizeof(uint64_t) * EDGES));
+	edims[0] = 32;
+	edims[1] = 32;
+	_node(g, QG8_TYPE_ADJACENCY,
+	      qg8_tensor_create_double(inde, ere, NULL, EDGES, edims, 2,
+	                               QG8_PACKING_SPARSE_COO));
+	for (i = 0; i < EDGES; ++i)
+	{
+		inde[0][i] = _index_of(g, from[i]);
+		inde[1][i] = _index_of(g, to[i]);
+		ere[i] = (double) (i + 1);
+	}
+
+	TEST(
+		;
+	, qg8_graph_get_max_fused(g) == QG8_FUSE_DEFAULT,
+	  "qg8_graph_get_max_fused (default)"
+	);
+
+	/* reference: every JOIN expanded and multiplied */
+	qg8_graph_set_max_fused(g, 0);
+	ref = qg8_graph_evaluate(g, m);
+	rre = (double *) ref->redata;
+	rim = (double *) ref->imdata;
+
+	for (fused = 1; fused <= 6; ++fused)
+	{
+		TEST(
+			qg8_graph_set_max_fused(g, fused);
+			res = qg8_graph_evaluate(g, m);
+			ore = (double *) res->redata;
+			oim = (double *) res->imdata;
+			ok = res->rank == 1 && res->num_elems == DIM &&
+			     res->packing == QG8_PACKING_FULL;
+			for (i = 0; ok && i < DIM; ++i)
+				ok = fabs(ore[i] - rre[i]) < 1e-12 &&
+				     fabs(oim[i] - rim[i]) < 1e-12;
+		, ok, "qg8_graph_evaluate (fused circuit)"
+		);
+		qg8_tensor_destroy(res);
+	}
+
+	qg8_tensor_destroy(ref);
+	qg8_graph_destroy(g);
+
+	/* <Z v|Z|Z v>: the gate also feeds the expectation value */
+	num_edges = 0;
+	g = qg8_graph_create();
+	zre[0] = 1.0;
+	zre[1] = 0.0;
+	zre[2] = 0.0;
+	zre[3] = -1.0;
+	t = _node(g, QG8_TYPE_OPERATOR, _dense(2, zre, NULL));
+	vdims[0] = 2;
+	vre[0] = 0.6;
+	vre[1] = 0.8;
+	vim[0] = 0.0;
+	vim[1] = 0.0;
+	v = _node(g, QG8_TYPE_KET,
+	          qg8_tensor_create_double(vind, vre, vim, 2, vdims, 1,
+	                                   QG8_PACKING_FULL));
+	m = _node(g, QG8_TYPE_MATMUL, NULL);
+	h = _node(g, QG8_TYPE_EXPECTATIONVALUE, NULL);
+	ops[0] = t; ops[1] = v;
+	_link(m, 2, ops);
+	ops[0] = m; ops[1] = t;
+	_link(h, 2, ops);
+	edims[0] = 5;
+	edims[1] = 5;
+	_node(g, QG8_TYPE_ADJACENCY,
+	      qg8_tensor_create_double(inde, ere, NULL, num_edges, edims, 2,
+	                               QG8_PACKING_SPARSE_COO));
+	for (i = 0; i < (uint64_t) num_edges; ++i)
+	{
+		inde[0][i] = _index_of(g, from[i]);
+		inde[1][i] = _index_of(g, to[i]);
+	}
+
+	TEST(
+		qg8_graph_set_max_fused(g, 0);
+		ref = qg8_graph_evaluate(g, h);
+		qg8_graph_set_max_fused(g, QG8_FUSE_DEFAULT);
+		res = qg8_graph_evaluate(g, h);
+		ok = ref->num_elems == 1 && res->num_elems == 1 &&
+		     fabs(((double *) ref->redata)[0] + 0.28) < 1e-12 &&
+		     fabs(((double *) res->redata)[0] + 0.28) < 1e-12;
+		qg8_tensor_destroy(ref);
+		qg8_tensor_destroy(res);
+	, ok, "qg8_graph_evaluate (gate with two consumers)"
+	);
+
+	qg8_graph_destroy(g);
+
+	/* CX (2+i)(X x I)|00> = (2+i)|11>: the 1x1 factor scales the state */
+	num_edges = 0;
+	g = qg8_graph_create();
+	zre[0] = 0.0;
+	zre[1] = 1.0;
+	zre[2] = 1.0;
+	zre[3] = 0.0;
+	tre[0] = 2.0;
+	tim[0] = 1.0;
+	cx = _node(g, QG8_TYPE_OPERATOR, _dense(4, cre, NULL));
+	t = _node(g, QG8_TYPE_OPERATOR, _dense(1, tre, tim));
+	h = _node(g, QG8_TYPE_OPERATOR, _dense(2, zre, NULL));
+	id[1] = _node(g, QG8_TYPE_OPERATOR, _identity(2));
+	vdims[0] = 4;
+	for (i = 0; i < 4; ++i)
+	{
+		vre[i] = i == 0 ? 1.0 : 0.0;
+		vim[i] = 0.0;
+	}
+	v = _node(g, QG8_TYPE_KET,
+	          qg8_tensor_create_double(vind, vre, vim, 4, vdims, 1,
+	                                   QG8_PACKING_FULL));
+	j[0] = _node(g, QG8_TYPE_JOIN, NULL);
+	m = _node(g, QG8_TYPE_MATMUL, NULL);
+	ops[0] = t; ops[1] = h; ops[2] = id[1];
+	_link(j[0], 3, ops);
+	ops[0] = cx; ops[1] = j[0]; ops[2] = v;
+	_link(m, 3, ops);
+	edims[0] = 7;
+	edims[1] = 7;
+	_node(g, QG8_TYPE_ADJACENCY,
+	      qg8_tensor_create_double(inde, ere, NULL, num_edges, edims, 2,
+	                               QG8_PACKING_SPARSE_COO));
+	for (i = 0; i < (uint64_t) num_edges; ++i)
+	{
+		inde[0][i] = _index_of(g, from[i]);
+		inde[1][i] = _index_of(g, to[i]);
+	}
+
+	for (fused = 0; fused <= 2; fused += 2)
+	{
+		TEST(
+			qg8_graph_set_max_fused(g, fused);
+			res = qg8_graph_evaluate(g, m);
+			ore = (double *) res->redata;
+			oim = (double *) res->imdata;
+			ok = res->num_elems == 4;
+			for (i = 0; ok && i < 4; ++i)
+				ok = fabs(ore[i] - (i == 3 ? 2.0 : 0.0)) < 1e-12 &&
+				     fabs(oim[i] - (i == 3 ? 1.0 : 0.0)) < 1e-12;
+			qg8_tensor_destroy(res);
+		, ok, "qg8_graph_evaluate (scalar JOIN factor)"
+		);
+	}
+
+	qg8_graph_destroy(g);
+	while (num_buffers > 0)
+		free(buffers[--num_buffers]);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,260 @@
+/*
+ * gate_test.c
+ * Matrix-free gate application on kets.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define NQ  11
+#define DIM (1 << NQ)
+
+static uint64_t **kind;
+static uint64_t kdims[1];
+
+/* full COMPLEX128 ket over a fresh copy of (re, im) */
+static
+qg8_tensor *
+_ket(const double *re,
+     const double *im)
+{
+	double *r, *i;
+	r = (double *) malloc(sizeof(double) * DIM);
+	i = (double *) malloc(sizeof(double) * DIM);
+	memcpy(r, re, sizeof(double) * DIM);
+	memcpy(i, im, sizeof(double) * DIM);
+	return qg8_tensor_create_double(kind, r, i, DIM, kdims, 1,
+	                                QG8_PACKING_FULL);
+}
+
+static
+void
+_free_ket(qg8_tensor *t)
+{
+	free(t->redata);
+	free(t->imdata);
+	qg8_tensor_destroy(t);
+}
+
+/* reference by definition: gate index bits read from the listed qubits */
+static
+int
+_check(qg8_tensor *ket,
+       const double *re,
+       const double *im,
+       const double *gre,
+       const double *gim,
+       const uint64_t *qubits,
+       uint64_t k)
+{
+	uint64_t x, y, i, j, t, d;
+	double sr, si, *or, *oi;
+
+	or = (double *) ket->redata;
+	oi = (double *) ket->imdata;
+	d = (uint64_t) 1 << k;
+	for (x = 0; x < DIM; ++x)
+	{
+		i = 0;
+		for (t = 0; t < k; ++t)
+			i = i << 1 | (x >> (NQ - 1 - qubits[t]) & 1);
+		sr = 0.0;
+		si = 0.0;
+		for (j = 0; j < d; ++j)
+		{
+			y = x;
+			for (t = 0; t < k; ++t)
+			{
+				y &= ~((uint64_t) 1 << (NQ - 1 - qubits[t]));
+				y |= (j >> (k - 1 - t) & 1) << (NQ - 1 - qubits[t]);
+			}
+			sr += gre[i*d+j] * re[y] - gim[i*d+j] * im[y];
+			si += gre[i*d+j] * im[y] + gim[i*d+j] * re[y];
+		}
+		if (fabs(sr - or[x]) > 1e-12 || fabs(si - oi[x]) > 1e-12)
+			return 0;
+	}
+	return 1;
+}
+
+static
+int
+_case(const double *re,
+      const double *im,
+      qg8_tensor *gate,
+      const uint64_t *qubits,
+      uint64_t k)
+{
+	qg8_tensor *ket;
+	double gre[64], gim[64];
+	int ok;
+
+	ket = _ket(re, im);
+	_tensor_to_dense(gate, gre, gim);
+	qg8_tensor_apply_gate(ket, gate, qubits, k);
+	ok = _check(ket, re, im, gre, gim, qubits, k);
+	_free_ket(ket);
+	return ok;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *gind[2], gdims[2], cdims[2], rdims[2], q[3], i;
+	double re[DIM], im[DIM], hre[4], him[4], cre[16], cim[16];
+	double rre[64], rim[64];
+	qg8_tensor *h, *cnot, *r3;
+	int isa;
+
+	INIT();
+
+	(void) argc;
+	(void) argv;
+
+	kind = (uint64_t **) malloc(sizeof(uint64_t *));
+	kind[0] = (uint64_t *) malloc(sizeof(uint64_t) * DIM);
+	kdims[0] = DIM;
+	for (i = 0; i < DIM; ++i)
+	{
+		kind[0][i] = i;
+		re[i] = (double) ((i * 37) % 101) / 101.0 - 0.5;
+		im[i] = (double) ((i * 53) % 97) / 97.0 - 0.5;
+	}
+	gind[0] = (uint64_t *) malloc(sizeof(uint64_t) * 64);
+	gind[1] = (uint64_t *) malloc(sizeof(uint64_t) * 64);
+	for (i = 0; i < 64; ++i)
+	{
+		rre[i] = (double) ((i * 13) % 11) / 11.0 - 0.5;
+		rim[i] = (double) ((i * 7) % 5) / 5.0 - 0.5;
+	}
+
+	/* Hadamard, full packing */
+	gdims[0] = 2;
+	gdims[1] = 2;
+	for (i = 0; i < 4; ++i)
+	{
+		gind[0][i] = i / 2;
+		gind[1][i] = i % 2;
+		hre[i] = i == 3 ? -sqrt(0.5) : sqrt(0.5);
+		him[i] = 0.0;
+	}
+	h = qg8_tensor_create_double(gind, hre, him, 4, gdims, 2,
+	                             QG8_PACKING_FULL);
+
+	/* CNOT, sparse: |00>,|01> kept, |10> <-> |11> */
+	cdims[0] = 4;
+	cdims[1] = 4;
+
+	/* random 3 qubit gate, full packing */
+	rdims[0] = 8;
+	rdims[1] = 8;
+
+	for (isa = QG8_ISA_SCALAR; isa <= QG8_ISA_AVX512; ++isa)
+	{
+		if (!qg8_kernel_set_isa(isa))
+			continue;
+		TEST(
+			q[0] = 0;
+		, _case(re, im, h, q, 1), "qg8_tensor_apply_gate (H on qubit 0)"
+		);
+		TEST(
+			q[0] = NQ - 1;
+		, _case(re, im, h, q, 1),
+		  "qg8_tensor_apply_gate (H on the last qubit)"
+		);
+		TEST(
+			q[0] = 5;
+		, _case(re, im, h, q, 1), "qg8_tensor_apply_gate (H on qubit 5)"
+		);
+	}
+
+	for (i = 0; i < 16; ++i)
+	{
+		cre[i] = 0.0;
+		cim[i] = 0.0;
+	}
+	gind[0][0] = 0;
+	gind[1][0] = 0;
+	gind[0][1] = 1;
+	gind[1][1] = 1;
+	gind[0][2] = 2;
+	gind[1][2] = 3;
+	gind[0][3] = 3;
+	gind[1][3] = 2;
+	cre[0] = 1.0;
+	cre[1] = 1.0;
+	cre[2] = 1.0;
+	cre[3] = 1.0;
+	cnot = qg8_tensor_create_double(gind, cre, cim, 4, cdims, 2,
+	                                QG8_PACKING_SPARSE_COO);
+	TEST(
+		q[0] = 3;
+		q[1] = 7;
+	, _case(re, im, cnot, q, 2), "qg8_tensor_apply_gate (CNOT 3 -> 7)"
+	);
+	TEST(
+		q[0] = 7;
+		q[1] = 3;
+	, _case(re, im, cnot, q, 2), "qg8_tensor_apply_gate (CNOT 7 -> 3)"
+	);
+	TEST(
+		q[0] = NQ - 2;
+		q[1] = NQ - 1;
+	, _case(re, im, cnot, q, 2),
+	  "qg8_tensor_apply_gate (CNOT on the last qubits)"
+	);
+	qg8_tensor_destroy(cnot);
+
+	for (i = 0; i < 64; ++i)
+	{
+		gind[0][i] = i / 8;
+		gind[1][i] = i % 8;
+	}
+	r3 = qg8_tensor_create_double(gind, rre, rim, 64, rdims, 2,
+	                              QG8_PACKING_FULL);
+	TEST(
+		q[0] = NQ - 1;
+		q[1] = 2;
+		q[2] = 5;
+	, _case(re, im, r3, q, 3), "qg8_tensor_apply_gate (3 qubits)"
+	);
+	TEST(
+		q[0] = 6;
+		q[1] = 0;
+		q[2] = 4;
+	, _case(re, im, r3, q, 3), "qg8_tensor_apply_gate (3 high qubits)"
+	);
+
+	qg8_tensor_destroy(r3);
+	qg8_tensor_destroy(h);
+	free(gind[0]);
+	free(gind[1]);
+	free(kind[0]);
+	free(kind);
+
+	return EXIT_SUCCESS;
+}
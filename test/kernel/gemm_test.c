@@ -0,0 +1,204 @@
+/*
+ * gemm_test.c
+ * Dense matrix products against a naive reference.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define N 12
+
+static
+double *
+_matrix(uint64_t n,
+        uint64_t salt)
+{
+	double *x;
+	uint64_t i;
+	x = (double *) malloc(sizeof(double) * n);
+	for (i = 0; i < n; ++i)
+		x[i] = (double) ((i * 7 + salt) % 13) / 6.0 - 1.0;
+	return x;
+}
+
+/* checks c = a*b entry by entry, complex if the imaginary parts are set */
+static
+int
+_check(uint64_t m,
+       uint64_t n,
+       uint64_t k,
+       const double *ar,
+       const double *ai,
+       const double *br,
+       const double *bi,
+       const double *cr,
+       const double *ci)
+{
+	uint64_t i, j, p;
+	double sr, si;
+
+	for (i = 0; i < m; ++i)
+	{
+		for (j = 0; j < n; ++j)
+		{
+			sr = 0.0;
+			si = 0.0;
+			for (p = 0; p < k; ++p)
+			{
+				sr += ar[i*k+p] * br[p*n+j];
+				if (ai)
+				{
+					sr -= ai[i*k+p] * bi[p*n+j];
+					si += ar[i*k+p] * bi[p*n+j] + ai[i*k+p] * br[p*n+j];
+				}
+			}
+			if (fabs(sr - cr[i*n+j]) > 1e-9 * (1.0 + fabs(sr)) ||
+			    (ci && fabs(si - ci[i*n+j]) > 1e-9 * (1.0 + fabs(si))))
+				return 0;
+		}
+	}
+	return 1;
+}
+
+static
+int
+_zgemm_case(uint64_t m,
+            uint64_t n,
+            uint64_t k)
+{
+	double *ar, *ai, *br, *bi, *cr, *ci;
+	int ok;
+
+	ar = _matrix(m * k, 1);
+	ai = _matrix(m * k, 2);
+	br = _matrix(k * n, 3);
+	bi = _matrix(k * n, 4);
+	cr = (double *) malloc(sizeof(double) * m * n);
+	ci = (double *) malloc(sizeof(double) * m * n);
+	qg8_kernel_zgemm(m, n, k, ar, ai, br, bi, cr, ci);
+	ok = _check(m, n, k, ar, ai, br, bi, cr, ci);
+	free(ar);
+	free(ai);
+	free(br);
+	free(bi);
+	free(cr);
+	free(ci);
+	return ok;
+}
+
+static
+int
+_dgemm_case(uint64_t m,
+            uint64_t n,
+            uint64_t k)
+{
+	double *a, *b, *c;
+	int ok;
+
+	a = _matrix(m * k, 5);
+	b = _matrix(k * n, 6);
+	c = (double *) malloc(sizeof(double) * m * n);
+	qg8_kernel_dgemm(m, n, k, a, b, c);
+	ok = _check(m, n, k, a, NULL, b, NULL, c, NULL);
+	free(a);
+	free(b);
+	free(c);
+	return ok;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t **ind, dims[2], i;
+	double *are, *aim, *bre, *res_re, *res_im, zero[N*N];
+	qg8_tensor *a, *b, *res;
+	int isa;
+
+	INIT();
+
+	(void) argc;
+	(void) argv;
+
+	for (isa = QG8_ISA_SCALAR; isa <= QG8_ISA_AVX512; ++isa)
+	{
+		if (!qg8_kernel_set_isa(isa))
+			continue;
+		TEST(
+			;
+		, _dgemm_case(37, 53, 29) && _dgemm_case(5, 3, 300) &&
+		  _dgemm_case(1, 1, 1), "qg8_kernel_dgemm"
+		);
+		TEST(
+			;
+		, _zgemm_case(37, 53, 29) && _zgemm_case(4, 8, 513),
+		  "qg8_kernel_zgemm (4M)"
+		);
+		TEST(
+			;
+		, _zgemm_case(130, 140, 150), "qg8_kernel_zgemm (3M)"
+		);
+	}
+
+	/* MATMUL of two full tensors, complex times real */
+	dims[0] = N;
+	dims[1] = N;
+	ind = (uint64_t **) malloc(sizeof(uint64_t *) * 2);
+	ind[0] = (uint64_t *) malloc(sizeof(uint64_t) * N * N);
+	ind[1] = (uint64_t *) malloc(sizeof(uint64_t) * N * N);
+	for (i = 0; i < N * N; ++i)
+	{
+		ind[0][i] = i / N;
+		ind[1][i] = i % N;
+		zero[i] = 0.0;
+	}
+	are = _matrix(N * N, 7);
+	aim = _matrix(N * N, 8);
+	bre = _matrix(N * N, 9);
+	a = qg8_tensor_create_double(ind, are, aim, N*N, dims, 2,
+	                             QG8_PACKING_FULL);
+	b = qg8_tensor_create_double(ind, bre, NULL, N*N, dims, 2,
+	                             QG8_PACKING_FULL);
+	TEST(
+		res = qg8_tensor_matmul(a, b);
+		res_re = (double *) res->redata;
+		res_im = (double *) res->imdata;
+	, res->packing == QG8_PACKING_FULL && res->num_elems == N * N &&
+	  res->indices[0][N+1] == 1 && res->indices[1][N+1] == 1 &&
+	  _check(N, N, N, are, aim, bre, zero, res_re, res_im),
+	  "qg8_tensor_matmul (full)"
+	);
+	qg8_tensor_destroy(res);
+	qg8_tensor_destroy(a);
+	qg8_tensor_destroy(b);
+	free(are);
+	free(aim);
+	free(bre);
+	free(ind[0]);
+	free(ind[1]);
+	free(ind);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,258 @@
+/*
+ * half_test.c
+ * Half precision and bfloat16 conversions and tensors.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+/* odd length so that the vector loops leave a tail */
+#define N     65539
+#define FNAME "kernel/half_test.qg8"
+
+static
+float
+_bits(uint32_t x)
+{
+	float f;
+
+	memcpy(&f, &x, sizeof(f));
+	return f;
+}
+
+/* floats of every kind: random bits, halves and ties, tiny and huge */
+static
+void
+_fill(float *x)
+{
+	uint32_t b;
+	int i;
+
+	for (i = 0; i < N; ++i)
+	{
+		b = (uint32_t) (_rand_int() << 9) ^ (uint32_t) _rand_int();
+		switch (i % 4)
+		{
+		case 0:
+			break;
+		case 1:
+			/* exponents around the half range, low bits on a tie */
+			b = (b & 0x807fe000) | ((uint32_t) (96 + i % 48) << 23) |
+			    0x1000;
+			break;
+		case 2:
+			/* bfloat16 ties */
+			b = (b & 0xffff0000) | 0x8000;
+			break;
+		default:
+			b = (b & 0x80ffffff) | ((uint32_t) (i % 2 ? 0x38 : 0x47) << 24);
+			break;
+		}
+		x[i] = _bits(b);
+	}
+}
+
+/* conversions of the current instruction set against the portable ones */
+static
+int
+_same_as_scalar(const float *x,
+                const uint16_t *h)
+{
+	static float f[N];
+	static uint16_t o[N];
+	float v;
+	int i;
+
+	qg8_kernel_float_to_half(N, x, o);
+	for (i = 0; i < N; ++i)
+		if (o[i] != _float_to_half(x[i]))
+			return 0;
+	qg8_kernel_float_to_bf16(N, x, o);
+	for (i = 0; i < N; ++i)
+		if (o[i] != _float_to_bf16(x[i]))
+			return 0;
+	qg8_kernel_half_to_float(N, h, f);
+	for (i = 0; i < N; ++i)
+	{
+		v = _half_to_float(h[i]);
+		if (memcmp(f + i, &v, sizeof(v)))
+			return 0;
+	}
+	qg8_kernel_bf16_to_float(N, h, f);
+	for (i = 0; i < N; ++i)
+	{
+		v = _bf16_to_float(h[i]);
+		if (memcmp(f + i, &v, sizeof(v)))
+			return 0;
+	}
+	return 1;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	static float x[N];
+	static uint16_t h[N];
+	uint64_t *ind[1], dims[1], i;
+	uint16_t hre[N], him[N];
+	double *re, *im, err;
+	qg8_tensor *t;
+	qg8_chunk *c;
+	qg8_file *f;
+	qg8_iter iter;
+	int ok, isa;
+
+	INIT();
+	_rand_seed(49);
+	(void) argc;
+	(void) argv;
+
+	TEST(
+		ok = 1;
+		for (i = 0; i < 65536; ++i)
+		{
+			float v;
+
+			v = _half_to_float((uint16_t) i);
+			if (v == v)
+				ok &= _float_to_half(v) == i;
+			else
+				ok &= _float_to_half(v) == (i | 0x200);
+		}
+	, ok, "half precision round trips"
+	);
+
+	TEST(
+		ok = _float_to_half(1.0f) == 0x3c00 &&
+		     _float_to_half(-2.0f) == 0xc000 &&
+		     _float_to_half(65504.0f) == 0x7bff &&
+		     _float_to_half(65520.0f) == 0x7c00 &&
+		     _float_to_half(_bits(0x33800000)) == 0x0001 &&
+		     _float_to_half(_bits(0x33000000)) == 0x0000 &&
+		     _float_to_half(_bits(0x33400000)) == 0x0001 &&
+		     _float_to_half(_bits(0x3f801000)) == 0x3c00 &&
+		     _float_to_half(_bits(0x3f803000)) == 0x3c02 &&
+		     _float_to_bf16(1.0f) == 0x3f80 &&
+		     _float_to_bf16(_bits(0x3f808000)) == 0x3f80 &&
+		     _float_to_bf16(_bits(0x3f818000)) == 0x3f82 &&
+		     _float_to_bf16(_bits(0x7f7fffff)) == 0x7f80 &&
+		     _float_to_bf16(_bits(0x7f800001)) == 0x7fc0 &&
+		     _bf16_to_float(0x4049) == _bits(0x40490000);
+	, ok, "rounding to nearest even"
+	);
+
+	/* every instruction set rounds bit for bit as the portable code */
+	_fill(x);
+	for (i = 0; i < N; ++i)
+		h[i] = (uint16_t) _rand_int();
+	isa = qg8_kernel_get_isa();
+	TEST(
+		ok = 1;
+		if (qg8_kernel_set_isa(QG8_ISA_AVX512))
+			ok &= _same_as_scalar(x, h);
+		if (qg8_kernel_set_isa(QG8_ISA_AVX2))
+			ok &= _same_as_scalar(x, h);
+		qg8_kernel_set_isa(QG8_ISA_SCALAR);
+		ok &= _same_as_scalar(x, h);
+		qg8_kernel_set_isa(isa);
+	, ok, "conversions on every instruction set"
+	);
+
+	/* doubles round once: floats agree, and ties moved off by a double bit */
+	TEST(
+		ok = 1;
+		for (i = 0; i < N; ++i)
+			ok &= _double_to_half((double) x[i]) == _float_to_half(x[i]) &&
+			      _double_to_bf16((double) x[i]) == _float_to_bf16(x[i]);
+		ok = ok &&
+		     _double_to_half(1.0 + ldexp(1.0, -11) + ldexp(1.0, -40)) ==
+		     0x3c01 &&
+		     _double_to_half(1.0 + ldexp(3.0, -11) - ldexp(1.0, -40)) ==
+		     0x3c01 &&
+		     _double_to_half(ldexp(1.0, -25) + ldexp(1.0, -60)) == 0x0001 &&
+		     _double_to_half(65520.0 - ldexp(1.0, -30)) == 0x7bff &&
+		     _double_to_half(1e300) == 0x7c00 &&
+		     _double_to_half(-1e-300) == 0x8000 &&
+		     _double_to_bf16(1.0 + ldexp(1.0, -8) + ldexp(1.0, -40)) ==
+		     0x3f81 &&
+		     _double_to_bf16(ldexp(1.0, -134) + ldexp(1.0, -170)) == 0x0001 &&
+		     _double_to_bf16(-1e300) == 0xff80;
+	, ok, "doubles to 16 bits"
+	);
+
+	/* a complex half precision tensor through a file */
+	dims[0] = N;
+	ind[0] = (uint64_t *) malloc(sizeof(uint64_t) * N);
+	for (i = 0; i < N; ++i)
+	{
+		ind[0][i] = i;
+		x[i] = (float) (i % 1000) / 64.0f - 4.0f;
+	}
+	qg8_kernel_float_to_half(N, x, hre);
+	for (i = 0; i < N; ++i)
+		x[i] = -x[i] / 2.0f;
+	qg8_kernel_float_to_half(N, x, him);
+	t = qg8_tensor_create_half(ind, hre, him, N, dims, 1,
+	                           QG8_PACKING_FULL);
+	TEST(
+		f = qg8_file_open(FNAME, QG8_MODE_WRITE);
+		c = qg8_chunk_create(QG8_TYPE_CONSTANT, 0, NULL, t);
+		qg8_file_write_chunk(f, c);
+		qg8_file_flush(f);
+		qg8_file_close(f);
+		c->tensor = NULL;
+		qg8_chunk_destroy(c);
+		f = qg8_file_open(FNAME, QG8_MODE_READ);
+		iter = qg8_file_iterator(f);
+		c = qg8_file_has_next(&iter) ? qg8_file_extract(&iter) : NULL;
+		qg8_file_close(f);
+		remove(FNAME);
+		ok = c && c->tensor->dtype_id == QG8_DTYPE_COMPLEX32 &&
+		     _tensor_is_complex(c->tensor) &&
+		     !memcmp(c->tensor->redata, hre, sizeof(hre)) &&
+		     !memcmp(c->tensor->imdata, him, sizeof(him));
+		re = (double *) malloc(sizeof(double) * N);
+		im = (double *) malloc(sizeof(double) * N);
+		if (ok)
+			_tensor_to_double(c->tensor, re, im);
+		err = 0.0;
+		for (i = 0; ok && i < N; ++i)
+			err = MAX(err, fabs(re[i] - ((double) (i % 1000) / 64.0 - 4.0)) +
+			               fabs(im[i] + re[i] / 2.0));
+		if (c)
+			qg8_chunk_destroy(c);
+	, ok && err == 0.0, "COMPLEX32 file round trip"
+	);
+
+	qg8_tensor_destroy(t);
+	free(ind[0]);
+	free(re);
+	free(im);
+
+	return EXIT_SUCCESS;
+}
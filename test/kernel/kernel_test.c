@@ -0,0 +1,242 @@
+/*
+ * kernel_test.c
+ * Split complex vector kernels on every supported instruction set.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+/* odd length so that the vector loops leave a tail */
+#define N 37
+
+/* long enough for sums in single precision to round */
+#define M ((1 << 17) + 5)
+
+#define CLOSE(x,y) (fabs((double) (x) - (double) (y)) < 1e-4)
+#define REL(x,y)   (fabs((double) (x) / (double) (y) - 1.0) < 1e-12)
+
+/* big macro set for one precision, BIG squared overflowing it */
+#define TEST_KERNELS(T,CP,RP,BIG) \
+static \
+int \
+test_kernels_##CP(const char *isa) \
+{ \
+	T xr[N], xi[N], yr[N], yi[N], zr[N], zi[N], *lr, *li; \
+	double re, im, rre, rim; \
+	int i, ok; \
+\
+	for (i = 0; i < N; ++i) \
+	{ \
+		xr[i] = (T) (i % 5) - 2; \
+		xi[i] = (T) (i % 3) * 0.5f; \
+		yr[i] = (T) 1 / (i + 1); \
+		yi[i] = (T) -i * 0.25f; \
+		zr[i] = yr[i]; \
+		zi[i] = yi[i]; \
+	} \
+	fprintf(stdout, "-- %s " STRINGIFY(T) " --\n", isa); \
+	TEST( \
+		qg8_kernel_##CP##axpy(N, 2, -1, xr, xi, zr, zi); \
+		ok = 1; \
+		for (i = 0; i < N; ++i) \
+			ok &= CLOSE(zr[i], yr[i] + 2 * xr[i] + xi[i]) && \
+			      CLOSE(zi[i], yi[i] + 2 * xi[i] - xr[i]); \
+	, ok, "qg8_kernel_" STRINGIFY(CP) "axpy" \
+	); \
+	TEST( \
+		qg8_kernel_##RP##axpy(N, 3, xr, zr); \
+		ok = 1; \
+		for (i = 0; i < N; ++i) \
+			ok &= CLOSE(zr[i], yr[i] + 5 * xr[i] + xi[i]); \
+	, ok, "qg8_kernel_" STRINGIFY(RP) "axpy" \
+	); \
+	TEST( \
+		for (i = 0; i < N; ++i) \
+		{ \
+			zr[i] = yr[i]; \
+			zi[i] = yi[i]; \
+		} \
+		qg8_kernel_##CP##scal(N, 0, 1, zr, zi); \
+		ok = 1; \
+		for (i = 0; i < N; ++i) \
+			ok &= CLOSE(zr[i], -yi[i]) && CLOSE(zi[i], yr[i]); \
+	, ok, "qg8_kernel_" STRINGIFY(CP) "scal (multiply by i)" \
+	); \
+	TEST( \
+		qg8_kernel_##RP##scal(N, -2, zi); \
+		ok = 1; \
+		for (i = 0; i < N; ++i) \
+			ok &= CLOSE(zi[i], -2 * yr[i]); \
+	, ok, "qg8_kernel_" STRINGIFY(RP) "scal" \
+	); \
+	TEST( \
+		for (i = 0; i < N; ++i) \
+		{ \
+			zr[i] = yr[i]; \
+			zi[i] = yi[i]; \
+		} \
+		qg8_kernel_##CP##mul(N, xr, xi, zr, zi); \
+		ok = 1; \
+		for (i = 0; i < N; ++i) \
+			ok &= CLOSE(zr[i], xr[i] * yr[i] - xi[i] * yi[i]) && \
+			      CLOSE(zi[i], xr[i] * yi[i] + xi[i] * yr[i]); \
+	, ok, "qg8_kernel_" STRINGIFY(CP) "mul" \
+	); \
+	TEST( \
+		for (i = 0; i < N; ++i) \
+			zr[i] = yr[i]; \
+		qg8_kernel_##RP##mul(N, xr, zr); \
+		ok = 1; \
+		for (i = 0; i < N; ++i) \
+			ok &= CLOSE(zr[i], xr[i] * yr[i]); \
+	, ok, "qg8_kernel_" STRINGIFY(RP) "mul" \
+	); \
+	TEST( \
+		for (i = 0; i < N; ++i) \
+			zi[i] = yi[i]; \
+		qg8_kernel_##CP##conj(N, zi); \
+		ok = 1; \
+		for (i = 0; i < N; ++i) \
+			ok &= zi[i] == -yi[i]; \
+	, ok, "qg8_kernel_" STRINGIFY(CP) "conj" \
+	); \
+	TEST( \
+		qg8_kernel_##CP##dotc(N, xr, xi, yr, yi, &re, &im); \
+		rre = 0; \
+		rim = 0; \
+		for (i = 0; i < N; ++i) \
+		{ \
+			rre += xr[i] * yr[i] + xi[i] * yi[i]; \
+			rim += xr[i] * yi[i] - xi[i] * yr[i]; \
+		} \
+	, CLOSE(re, rre) && CLOSE(im, rim), \
+	  "qg8_kernel_" STRINGIFY(CP) "dotc" \
+	); \
+	TEST( \
+		rre = 0; \
+		for (i = 0; i < N; ++i) \
+			rre += xr[i] * yr[i]; \
+	, CLOSE(qg8_kernel_##RP##dot(N, xr, yr), rre), \
+	  "qg8_kernel_" STRINGIFY(RP) "dot" \
+	); \
+	TEST( \
+		rre = 0; \
+		rim = 0; \
+		for (i = 0; i < N; ++i) \
+		{ \
+			rre += xr[i] * xr[i] + xi[i] * xi[i]; \
+			rim += xr[i] * xr[i]; \
+		} \
+	, CLOSE(qg8_kernel_##CP##nrm2(N, xr, xi), sqrt(rre)) && \
+	  CLOSE(qg8_kernel_##RP##nrm2(N, xr), sqrt(rim)), \
+	  "qg8_kernel_" STRINGIFY(CP) "nrm2/" STRINGIFY(RP) "nrm2" \
+	); \
+	/* every partial sum is exact in double precision */ \
+	lr = (T *) malloc(sizeof(T) * M); \
+	li = (T *) malloc(sizeof(T) * M); \
+	TEST( \
+		rre = 0; \
+		rim = 0; \
+		for (i = 0; i < M; ++i) \
+		{ \
+			lr[i] = (T) 1 + (T) (i % 1021) / 1024; \
+			li[i] = (T) (i % 3) / 4 - 1; \
+			rre += (double) lr[i] * lr[i] + (double) li[i] * li[i]; \
+			rim += (double) lr[i] * li[i]; \
+		} \
+		qg8_kernel_##CP##dotc(M, lr, li, lr, li, &re, &im); \
+	, re == rre && im == 0 && qg8_kernel_##RP##dot(M, lr, li) == rim && \
+	  qg8_kernel_##CP##nrm2(M, lr, li) == sqrt(rre), \
+	  "qg8_kernel_" STRINGIFY(CP) "dotc/" STRINGIFY(RP) "dot (double sums)" \
+	); \
+	TEST( \
+		for (i = 0; i < N; ++i) \
+		{ \
+			zr[i] = (T) BIG; \
+			zi[i] = (T) (1 / BIG); \
+		} \
+		rre = (double) zr[0] * sqrt(N); \
+		rim = (double) zi[0] * sqrt(N); \
+	, REL(qg8_kernel_##RP##nrm2(N, zr), rre) && \
+	  REL(qg8_kernel_##RP##nrm2(N, zi), rim) && \
+	  REL(qg8_kernel_##CP##nrm2(N, zr, zr), rre * sqrt(2)) && \
+	  REL(qg8_kernel_##CP##nrm2(N, zi, zi), rim * sqrt(2)), \
+	  "qg8_kernel_" STRINGIFY(CP) "nrm2/" STRINGIFY(RP) "nrm2 (scaled)" \
+	); \
+	free(lr); \
+	free(li); \
+	return 1; \
+}
+
+TEST_KERNELS(double, z, d, 1e200)
+TEST_KERNELS(float, c, s, 1e30f)
+
+int
+main(int argc,
+     char **argv)
+{
+	double v[64], first[64];
+	int i, ok;
+
+	INIT();
+
+	(void) argc;
+	(void) argv;
+
+	/* threads calling a kernel first at the same time */
+	for (i = 0; i < 64; ++i)
+		v[i] = (double) i;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1)
+#endif /* _OPENMP */
+	for (i = 0; i < 64; ++i)
+		first[i] = qg8_kernel_ddot(64, v, v);
+	TEST(
+		ok = 1;
+		for (i = 1; i < 64; ++i)
+			ok &= first[i] == first[0];
+	, ok && qg8_kernel_get_isa() >= QG8_ISA_SCALAR, "qg8_kernel_get_isa"
+	);
+
+	if (qg8_kernel_set_isa(QG8_ISA_AVX512))
+	{
+		if (!test_kernels_z("avx512") || !test_kernels_c("avx512"))
+			return EXIT_FAILURE;
+	}
+	if (qg8_kernel_set_isa(QG8_ISA_AVX2))
+	{
+		if (!test_kernels_z("avx2") || !test_kernels_c("avx2"))
+			return EXIT_FAILURE;
+	}
+	TEST(
+		;
+	, qg8_kernel_set_isa(QG8_ISA_SCALAR) == 1 &&
+	  qg8_kernel_get_isa() == QG8_ISA_SCALAR, "qg8_kernel_set_isa (scalar)"
+	);
+	if (!test_kernels_z("scalar") || !test_kernels_c("scalar"))
+		return EXIT_FAILURE;
+
+	PASS();
+}
@@ -0,0 +1,224 @@
+/*
+ * trajectory_test.c
+ * Monte Carlo wavefunction trajectories through noise channels.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif /* _OPENMP */
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define NQ    3
+#define DIM   (1 << NQ)
+#define TRAJ  20000
+#define GAMMA 0.2
+#define DEPH  0.1
+
+static
+void
+_threads(int n)
+{
+#ifdef _OPENMP
+	omp_set_num_threads(n);
+#else
+	(void) n;
+#endif /* _OPENMP */
+}
+
+static
+int
+_same(qg8_tensor *a,
+      qg8_tensor *b)
+{
+	return a->num_elems == b->num_elems &&
+	       memcmp(a->redata, b->redata, sizeof(double) * a->num_elems) == 0 &&
+	       memcmp(a->imdata, b->imdata, sizeof(double) * a->num_elems) == 0;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *kind[1], *hind[2], *xind[2], *pind[2], *aind[3], *dind[3];
+	uint64_t kdims[1], dims[2], cdims[3], i, b, n;
+	double kre[DIM], hre[2*DIM], xre[DIM], pre[DIM], are[2*DIM], dre[2*DIM];
+	double expect[4], err, *re, *im;
+	qg8_tensor *ket, *res, *res3, *other;
+	qg8_chunk *h, *x, *p, *ad, *dp, *seq[8];
+
+	INIT();
+	(void) argc;
+	(void) argv;
+
+	/* |100>: qubit 0 excited */
+	kdims[0] = DIM;
+	kind[0] = (uint64_t *) malloc(sizeof(uint64_t) * DIM);
+	for (i = 0; i < DIM; ++i)
+	{
+		kind[0][i] = i;
+		kre[i] = i == (1 << (NQ - 1)) ? 1.0 : 0.0;
+	}
+	ket = qg8_tensor_create_double(kind, kre, NULL, DIM, kdims, 1,
+	                               QG8_PACKING_FULL);
+
+	/* Hadamard on qubit 2, X and |1><1| observables on qubits 2 and 0 */
+	dims[0] = DIM;
+	dims[1] = DIM;
+	hind[0] = (uint64_t *) malloc(sizeof(uint64_t) * 2 * DIM);
+	hind[1] = (uint64_t *) malloc(sizeof(uint64_t) * 2 * DIM);
+	xind[0] = (uint64_t *) malloc(sizeof(uint64_t) * DIM);
+	xind[1] = (uint64_t *) malloc(sizeof(uint64_t) * DIM);
+	pind[0] = (uint64_t *) malloc(sizeof(uint64_t) * DIM);
+	pind[1] = pind[0];
+	n = 0;
+	for (b = 0; b < DIM; ++b)
+	{
+		hind[0][2*b] = b;
+		hind[1][2*b] = b;
+		hre[2*b] = (b & 1 ? -1.0 : 1.0) / sqrt(2.0);
+		hind[0][2*b+1] = b ^ 1;
+		hind[1][2*b+1] = b;
+		hre[2*b+1] = 1.0 / sqrt(2.0);
+		xind[0][b] = b ^ 1;
+		xind[1][b] = b;
+		xre[b] = 1.0;
+		if (b & (1 << (NQ - 1)))
+		{
+			pind[0][n] = b;
+			pre[n++] = 1.0;
+		}
+	}
+	h = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, NULL,
+	                     qg8_tensor_create_double(hind, hre, NULL, 2 * DIM,
+	                                              dims, 2,
+	                                              QG8_PACKING_SPARSE_COO));
+	x = qg8_chunk_create(QG8_TYPE_OBSERVABLE, 0, NULL,
+	                     qg8_tensor_create_double(xind, xre, NULL, DIM, dims,
+	                                              2, QG8_PACKING_SPARSE_COO));
+	p = qg8_chunk_create(QG8_TYPE_OBSERVABLE, 0, NULL,
+	                     qg8_tensor_create_double(pind, pre, NULL, n, dims,
+	                                              2, QG8_PACKING_SPARSE_COO));
+
+	/* amplitude damping of qubit 0 and dephasing of qubit 2 */
+	cdims[0] = 2;
+	cdims[1] = DIM;
+	cdims[2] = DIM;
+	for (i = 0; i < 3; ++i)
+	{
+		aind[i] = (uint64_t *) malloc(sizeof(uint64_t) * 2 * DIM);
+		dind[i] = (uint64_t *) malloc(sizeof(uint64_t) * 2 * DIM);
+	}
+	n = 0;
+	for (b = 0; b < DIM; ++b)
+	{
+		aind[0][n] = 0;
+		aind[1][n] = b;
+		aind[2][n] = b;
+		are[n++] = b & (1 << (NQ - 1)) ? sqrt(1.0 - GAMMA) : 1.0;
+		if (b & (1 << (NQ - 1)))
+		{
+			aind[0][n] = 1;
+			aind[1][n] = b ^ (1 << (NQ - 1));
+			aind[2][n] = b;
+			are[n++] = sqrt(GAMMA);
+		}
+		dind[0][2*b] = 0;
+		dind[1][2*b] = b;
+		dind[2][2*b] = b;
+		dre[2*b] = sqrt(1.0 - DEPH);
+		dind[0][2*b+1] = 1;
+		dind[1][2*b+1] = b;
+		dind[2][2*b+1] = b;
+		dre[2*b+1] = (b & 1 ? -1.0 : 1.0) * sqrt(DEPH);
+	}
+	ad = qg8_chunk_create(QG8_TYPE_NOISESPEC, 0, NULL,
+	                      qg8_tensor_create_double(aind, are, NULL, n, cdims,
+	                                               3, QG8_PACKING_SPARSE_COO));
+	dp = qg8_chunk_create(QG8_TYPE_NOISESPEC, 0, NULL,
+	                      qg8_tensor_create_double(dind, dre, NULL, 2 * DIM,
+	                                               cdims, 3,
+	                                               QG8_PACKING_SPARSE_COO));
+
+	seq[0] = h;
+	seq[1] = x;
+	seq[2] = ad;
+	seq[3] = dp;
+	seq[4] = p;
+	seq[5] = x;
+	seq[6] = dp;
+	seq[7] = x;
+	expect[0] = 1.0;
+	expect[1] = 1.0 - GAMMA;
+	expect[2] = 1.0 - 2.0 * DEPH;
+	expect[3] = (1.0 - 2.0 * DEPH) * (1.0 - 2.0 * DEPH);
+	TEST(
+		res = qg8_tensor_trajectories(ket, seq, 8, TRAJ, 7);
+		re = (double *) res->redata;
+		im = (double *) res->imdata;
+		err = 0.0;
+		for (i = 0; i < 4; ++i)
+		{
+			err = MAX(err, fabs(re[i] - expect[i]));
+			err = MAX(err, fabs(im[i]));
+		}
+	, res->num_elems == 4 && fabs(re[0] - 1.0) < 1e-12 && err < 0.04,
+	  "qg8_tensor_trajectories (channels)"
+	);
+
+	TEST(
+		_threads(3);
+		res3 = qg8_tensor_trajectories(ket, seq, 8, TRAJ, 7);
+		_threads(1);
+		other = qg8_tensor_trajectories(ket, seq, 8, TRAJ, 8);
+	, _same(res, res3) && !_same(res, other),
+	  "qg8_tensor_trajectories (reproducible)"
+	);
+	qg8_tensor_destroy(res);
+	qg8_tensor_destroy(res3);
+	qg8_tensor_destroy(other);
+
+	qg8_chunk_destroy(h);
+	qg8_chunk_destroy(x);
+	qg8_chunk_destroy(p);
+	qg8_chunk_destroy(ad);
+	qg8_chunk_destroy(dp);
+	qg8_tensor_destroy(ket);
+	free(kind[0]);
+	free(hind[0]);
+	free(hind[1]);
+	free(xind[0]);
+	free(xind[1]);
+	free(pind[0]);
+	for (i = 0; i < 3; ++i)
+	{
+		free(aind[i]);
+		free(dind[i]);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,297 @@
+/*
+ * batch_test.c
+ * Batched evaluation of a graph over values of its inputs.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define DIM   8
+#define NNZ   20
+#define BATCH 5
+
+/* largest difference between the elements of two full tensors */
+static
+double
+_diff(qg8_tensor *a,
+      qg8_tensor *b)
+{
+	double err, *ai, *bi;
+	uint64_t i;
+
+	if (a->num_elems != b->num_elems)
+		return 1.0;
+	ai = (double *) a->imdata;
+	bi = (double *) b->imdata;
+	err = 0.0;
+	for (i = 0; i < a->num_elems; ++i)
+	{
+		err = MAX(err, fabs(((double *) a->redata)[i] -
+		                    ((double *) b->redata)[i]));
+		if (ai && bi)
+			err = MAX(err, fabs(ai[i] - bi[i]));
+	}
+	return err;
+}
+
+/* run k of the batch, evaluated alone */
+static
+qg8_tensor *
+_alone(qg8_graph *g,
+       qg8_chunk *target,
+       qg8_chunk **inputs,
+       qg8_tensor **batch,
+       uint64_t k)
+{
+	qg8_tensor *save[2], *res;
+	uint64_t i;
+
+	for (i = 0; i < 2; ++i)
+	{
+		save[i] = inputs[i]->tensor;
+		inputs[i]->tensor = batch[k*2+i];
+	}
+	res = qg8_graph_evaluate(g, target);
+	for (i = 0; i < 2; ++i)
+		inputs[i]->tensor = save[i];
+	return res;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *oind[4][2], *kind[1], *ie[2], dims[2], kdims[1], edims[2];
+	uint64_t i, j, k;
+	double ore[4][NNZ], oim[4][NNZ], kre[BATCH][DIM], kim[BATCH][DIM];
+	double ed[8], err;
+	qg8_tensor *ops[4], *batch[2*BATCH], **res, *one;
+	qg8_chunk *c, *d, *o, *in[2], *p, *m, *e, *x;
+	qg8_graph *g;
+	uint8_t fuse;
+	int ok;
+
+	INIT();
+	_rand_seed(17);
+	(void) argc;
+	(void) argv;
+
+	/* three constant operators and BATCH values of an input operator */
+	dims[0] = DIM;
+	dims[1] = DIM;
+	for (i = 0; i < 4; ++i)
+	{
+		oind[i][0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+		oind[i][1] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+		for (j = 0; j < NNZ; ++j)
+		{
+			oind[i][0][j] = (j * (3 + i)) % DIM;
+			oind[i][1][j] = (j * 5 + i) % DIM;
+			ore[i][j] = _rand();
+			oim[i][j] = _rand();
+		}
+		ops[i] = qg8_tensor_create_double(oind[i], ore[i], oim[i], NNZ,
+		                                  dims, 2, QG8_PACKING_SPARSE_COO);
+	}
+	kdims[0] = DIM;
+	kind[0] = (uint64_t *) malloc(sizeof(uint64_t) * DIM);
+	for (i = 0; i < DIM; ++i)
+		kind[0][i] = i;
+	for (k = 0; k < BATCH; ++k)
+	{
+		for (i = 0; i < DIM; ++i)
+		{
+			kre[k][i] = _rand();
+			kim[k][i] = _rand();
+		}
+		batch[2*k] = qg8_tensor_create_double(kind, kre[k], kim[k], DIM,
+		                                      kdims, 1, QG8_PACKING_FULL);
+		batch[2*k+1] = ops[k % 2 ? 3 : 0];
+	}
+
+	/* e = <O| V (C D) x >, with V and x inputs and C D constant */
+	g = qg8_graph_create();
+	c = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, NULL, ops[1]);
+	qg8_graph_add_chunk(g, c);
+	d = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, NULL, ops[2]);
+	qg8_graph_add_chunk(g, d);
+	o = qg8_chunk_create(QG8_TYPE_OBSERVABLE, 0, NULL, ops[3]);
+	qg8_graph_add_chunk(g, o);
+	in[0] = qg8_chunk_create(QG8_TYPE_INPUT, 0, NULL, batch[0]);
+	qg8_graph_add_chunk(g, in[0]);
+	in[1] = qg8_chunk_create(QG8_TYPE_INPUT, 0, NULL, ops[0]);
+	qg8_graph_add_chunk(g, in[1]);
+	p = qg8_chunk_create(QG8_TYPE_MATMUL, 0, NULL, NULL);
+	qg8_graph_add_chunk(g, p);
+	m = qg8_chunk_create(QG8_TYPE_MATMUL, 0, NULL, NULL);
+	qg8_graph_add_chunk(g, m);
+	e = qg8_chunk_create(QG8_TYPE_EXPECTATIONVALUE, 0, NULL, NULL);
+	qg8_graph_add_chunk(g, e);
+	ie[0] = (uint64_t *) malloc(sizeof(uint64_t) * 7);
+	ie[1] = (uint64_t *) malloc(sizeof(uint64_t) * 7);
+	edims[0] = 10;
+	edims[1] = 10;
+	qg8_graph_add_chunk(g, qg8_chunk_create(QG8_TYPE_ADJACENCY, 0, NULL,
+	                    qg8_tensor_create_double(ie, ed, NULL, 7, edims, 2,
+	                                             QG8_PACKING_SPARSE_COO)));
+	ie[0][0] = _index_of(g, c);
+	ie[1][0] = _index_of(g, p);
+	ed[0] = 1.0;
+	ie[0][1] = _index_of(g, d);
+	ie[1][1] = _index_of(g, p);
+	ed[1] = 2.0;
+	ie[0][2] = _index_of(g, in[1]);
+	ie[1][2] = _index_of(g, m);
+	ed[2] = 1.0;
+	ie[0][3] = _index_of(g, p);
+	ie[1][3] = _index_of(g, m);
+	ed[3] = 2.0;
+	ie[0][4] = _index_of(g, in[0]);
+	ie[1][4] = _index_of(g, m);
+	ed[4] = 3.0;
+	ie[0][5] = _index_of(g, o);
+	ie[1][5] = _index_of(g, e);
+	ed[5] = 1.0;
+	ie[0][6] = _index_of(g, m);
+	ie[1][6] = _index_of(g, e);
+	ed[6] = 2.0;
+
+	for (fuse = 0; fuse < 2; ++fuse)
+	{
+		qg8_graph_set_max_fused(g, fuse ? QG8_FUSE_DEFAULT : 0);
+		TEST(
+			res = qg8_graph_evaluate_batch(g, e, in, 2, batch, BATCH);
+			ok = in[0]->tensor == batch[0] && in[1]->tensor == ops[0];
+			err = 0.0;
+			for (k = 0; k < BATCH; ++k)
+			{
+				one = _alone(g, e, in, batch, k);
+				err = MAX(err, _diff(res[k], one));
+				ok = ok && res[k]->num_elems == 1;
+				qg8_tensor_destroy(one);
+				qg8_tensor_destroy(res[k]);
+			}
+			free(res);
+		, ok && err < 1e-12, fuse ?
+		  "qg8_graph_evaluate_batch (fused circuits)" :
+		  "qg8_graph_evaluate_batch (expectation values)"
+		);
+	}
+
+	/* a target which does not depend on the inputs is computed once */
+	TEST(
+		res = qg8_graph_evaluate_batch(g, p, in, 2, batch, BATCH);
+		one = qg8_graph_evaluate(g, p);
+		err = 0.0;
+		for (k = 0; k < BATCH; ++k)
+		{
+			err = MAX(err, _diff(res[k], one));
+			qg8_tensor_destroy(res[k]);
+		}
+		qg8_tensor_destroy(one);
+		free(res);
+	, err == 0.0, "qg8_graph_evaluate_batch (constant target)"
+	);
+
+	/* e = <O| C D x > with only the ket x given, as one block of kets */
+	qg8_graph_destroy(g);
+	for (i = 1; i < 4; ++i)
+		ops[i] = qg8_tensor_create_double(oind[i], ore[i], oim[i], NNZ,
+		                                  dims, 2, QG8_PACKING_SPARSE_COO);
+	batch[0] = qg8_tensor_create_double(kind, kre[0], kim[0], DIM, kdims, 1,
+	                                    QG8_PACKING_FULL);
+	g = qg8_graph_create();
+	c = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, NULL, ops[1]);
+	qg8_graph_add_chunk(g, c);
+	d = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, NULL, ops[2]);
+	qg8_graph_add_chunk(g, d);
+	o = qg8_chunk_create(QG8_TYPE_OBSERVABLE, 0, NULL, ops[3]);
+	qg8_graph_add_chunk(g, o);
+	x = qg8_chunk_create(QG8_TYPE_INPUT, 0, NULL, NULL);
+	qg8_graph_add_chunk(g, x);
+	m = qg8_chunk_create(QG8_TYPE_MATMUL, 0, NULL, NULL);
+	qg8_graph_add_chunk(g, m);
+	e = qg8_chunk_create(QG8_TYPE_EXPECTATIONVALUE, 0, NULL, NULL);
+	qg8_graph_add_chunk(g, e);
+	qg8_graph_add_chunk(g, qg8_chunk_create(QG8_TYPE_ADJACENCY, 0, NULL,
+	                    qg8_tensor_create_double(ie, ed, NULL, 5, edims, 2,
+	                                             QG8_PACKING_SPARSE_COO)));
+	ie[0][0] = _index_of(g, c);
+	ie[1][0] = _index_of(g, m);
+	ed[0] = 1.0;
+	ie[0][1] = _index_of(g, d);
+	ie[1][1] = _index_of(g, m);
+	ed[1] = 2.0;
+	ie[0][2] = _index_of(g, x);
+	ie[1][2] = _index_of(g, m);
+	ed[2] = 3.0;
+	ie[0][3] = _index_of(g, m);
+	ie[1][3] = _index_of(g, e);
+	ed[3] = 1.0;
+	ie[0][4] = _index_of(g, o);
+	ie[1][4] = _index_of(g, e);
+	ed[4] = 2.0;
+	for (k = 0; k < BATCH; ++k)
+		batch[k] = batch[2*k];
+
+	for (i = 0; i < 2; ++i)
+	{
+		TEST(
+			res = qg8_graph_evaluate_batch(g, i ? e : m, &x, 1, batch,
+			                               BATCH);
+			ok = !x->tensor;
+			err = 0.0;
+			for (k = 0; k < BATCH; ++k)
+			{
+				x->tensor = batch[k];
+				one = qg8_graph_evaluate(g, i ? e : m);
+				x->tensor = NULL;
+				err = MAX(err, _diff(res[k], one));
+				ok = ok && res[k]->num_elems == (i ? 1 : DIM);
+				qg8_tensor_destroy(one);
+				qg8_tensor_destroy(res[k]);
+			}
+			free(res);
+		, ok && err < 1e-12, i ?
+		  "qg8_graph_evaluate_batch (block of kets, expectation values)" :
+		  "qg8_graph_evaluate_batch (block of kets)"
+		);
+	}
+
+	/* the chunks own ops[1..3] now */
+	qg8_graph_destroy(g);
+	for (k = 0; k < BATCH; ++k)
+		qg8_tensor_destroy(batch[k]);
+	for (i = 0; i < 4; ++i)
+	{
+		free(oind[i][0]);
+		free(oind[i][1]);
+	}
+	free(kind[0]);
+	free(ie[0]);
+	free(ie[1]);
+
+	return EXIT_SUCCESS;
+}
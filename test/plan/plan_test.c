@@ -0,0 +1,290 @@
+/*
+ * plan_test.c
+ * Product chain planning and graph evaluation.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define N 16
+
+static
+uint64_t **
+_full_indices(uint64_t rows,
+              uint64_t cols)
+{
+	uint64_t **ind, i;
+	ind = (uint64_t **) malloc(sizeof(uint64_t *) * 2);
+	ALLOC(ind);
+	ind[0] = (uint64_t *) malloc(sizeof(uint64_t) * rows * cols);
+	ALLOC(ind[0]);
+	ind[1] = (uint64_t *) malloc(sizeof(uint64_t) * rows * cols);
+	ALLOC(ind[1]);
+	for (i = 0; i < rows * cols; ++i)
+	{
+		ind[0][i] = i / cols;
+		ind[1][i] = i % cols;
+	}
+	return ind;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t **inda, **indv, **inde, dims[2], vdims[1], edims[2];
+	double are[N*N], aim[N*N], bre[N*N], vre[N], vim[N], ere[4];
+	double ref[N], tmp[N], refim[N], tmpim[N], *ore, *oim;
+	uint64_t ijk[3], i, j, big[1], small[1];
+	qg8_tensor *a, *b, *v, *ops[3], *res, *t1, *t2, *t3, *adj;
+	qg8_plan *plan;
+	qg8_graph *g;
+	qg8_chunk *ca, *cb, *cv, *cm1, *cm2;
+	int ok;
+
+	INIT();
+
+	(void) argc;
+	(void) argv;
+
+	dims[0] = N;
+	dims[1] = N;
+	vdims[0] = N;
+	inda = _full_indices(N, N);
+	indv = _full_indices(1, N);
+	for (i = 0; i < N * N; ++i)
+	{
+		are[i] = (double) ((i * 7) % 5) - 2.0;
+		aim[i] = (double) ((i * 3) % 4) * 0.5;
+		bre[i] = (double) ((i * 11) % 7) * 0.25;
+	}
+	for (i = 0; i < N; ++i)
+	{
+		vre[i] = 1.0 / (double) (i + 1);
+		vim[i] = (double) i;
+	}
+	a = qg8_tensor_create_double(inda, are, aim, N*N, dims, 2,
+	                             QG8_PACKING_FULL);
+	b = qg8_tensor_create_double(inda, bre, NULL, N*N, dims, 2,
+	                             QG8_PACKING_FULL);
+	v = qg8_tensor_create_double(indv+1, vre, vim, N, vdims, 1,
+	                             QG8_PACKING_FULL);
+
+	/* reference a*(b*v) */
+	for (i = 0; i < N; ++i)
+	{
+		tmp[i] = 0.0;
+		tmpim[i] = 0.0;
+		for (j = 0; j < N; ++j)
+		{
+			tmp[i] += bre[i*N+j] * vre[j];
+			tmpim[i] += bre[i*N+j] * vim[j];
+		}
+	}
+	for (i = 0; i < N; ++i)
+	{
+		ref[i] = 0.0;
+		refim[i] = 0.0;
+		for (j = 0; j < N; ++j)
+		{
+			ref[i] += are[i*N+j] * tmp[j] - aim[i*N+j] * tmpim[j];
+			refim[i] += are[i*N+j] * tmpim[j] + aim[i*N+j] * tmp[j];
+		}
+	}
+
+	ops[0] = a;
+	ops[1] = b;
+	ops[2] = v;
+	TEST(
+		plan = qg8_plan_create(QG8_TYPE_MATMUL, ops, 3);
+	, plan != NULL && plan->num_operands == 3 &&
+	  plan->steps[0] == 1 && plan->steps[1] == 2 &&
+	  plan->steps[2] == 0 && plan->steps[3] == 3,
+	  "qg8_plan_create (operator chain applied right to left)"
+	);
+
+	TEST(
+		;
+	, qg8_plan_get_cost(plan) < (double) N * N * N,
+	  "qg8_plan_get_cost < N^3"
+	);
+
+	TEST(
+		res = qg8_plan_execute(plan, ops);
+		ore = (double *) qg8_tensor_get_re(res);
+		oim = (double *) qg8_tensor_get_im(res);
+		ok = qg8_tensor_get_rank(res) == 1 &&
+		     ((uint64_t *) qg8_tensor_get_dims(res))[0] == N &&
+		     qg8_tensor_get_num_elems(res) == N &&
+		     qg8_tensor_get_dtypeid(res) == QG8_DTYPE_COMPLEX128;
+		for (i = 0; ok && i < N; ++i)
+		{
+			if (qg8_tensor_get_indices(res)[0][i] != i ||
+			    fabs(ore[i] - ref[i]) > 1e-9 ||
+			    fabs(oim[i] - refim[i]) > 1e-9)
+				ok = 0;
+		}
+	, ok, "qg8_plan_execute == a*(b*v)"
+	);
+	qg8_tensor_destroy(res);
+
+	TEST(
+		;
+	, qg8_plan_destroy(plan) == 1, "qg8_plan_destroy"
+	);
+
+	/* sparse operand: 2x2 diagonal [1, -1] and a swap [[0,1],[1,0]] */
+	edims[0] = 2;
+	edims[1] = 2;
+	inde = (uint64_t **) malloc(sizeof(uint64_t *) * 2);
+	ALLOC(inde);
+	inde[0] = ijk;
+	inde[1] = ijk;
+	ijk[0] = 0;
+	ijk[1] = 1;
+	ere[0] = 1.0;
+	ere[1] = -1.0;
+	t1 = qg8_tensor_create_double(inde, ere, NULL, 2, edims, 2,
+	                              QG8_PACKING_SPARSE_COO);
+	TEST(
+		res = qg8_tensor_matmul(t1, t1);
+		ore = (double *) qg8_tensor_get_re(res);
+	, qg8_tensor_get_num_elems(res) == 2 &&
+	  res->packing == QG8_PACKING_SPARSE_COO &&
+	  res->indices[0][0] == 0 && res->indices[1][0] == 0 &&
+	  res->indices[0][1] == 1 && res->indices[1][1] == 1 &&
+	  ore[0] == 1.0 && ore[1] == 1.0,
+	  "qg8_tensor_matmul (sparse Z*Z == I)"
+	);
+	qg8_tensor_destroy(res);
+
+	TEST(
+		res = qg8_tensor_join(t1, t1);
+		ore = (double *) qg8_tensor_get_re(res);
+		j = qg8_tensor_get_num_elems(res);
+	, j == 4 && res->dimensions[0] == 4 && res->dimensions[1] == 4 &&
+	  res->indices[0][1] == 1 && res->indices[1][1] == 1 && ore[1] == -1.0 &&
+	  res->indices[0][3] == 3 && res->indices[1][3] == 3 && ore[3] == 1.0,
+	  "qg8_tensor_join (Z (x) Z)"
+	);
+	qg8_tensor_destroy(res);
+
+	/* joins are ordered to keep the intermediates small */
+	big[0] = 1000;
+	small[0] = 10;
+	t2 = qg8_tensor_create_double(inde, ere, NULL, 2, edims, 2,
+	                              QG8_PACKING_SPARSE_COO);
+	t3 = qg8_tensor_create_double(inde, ere, NULL, 2, edims, 2,
+	                              QG8_PACKING_SPARSE_COO);
+	t1->num_elems = big[0];
+	t2->num_elems = small[0];
+	t3->num_elems = small[0];
+	ops[0] = t1;
+	ops[1] = t2;
+	ops[2] = t3;
+	TEST(
+		plan = qg8_plan_create(QG8_TYPE_JOIN, ops, 3);
+	, plan->steps[0] == 1 && plan->steps[1] == 2 &&
+	  plan->steps[2] == 0 && plan->steps[3] == 3,
+	  "qg8_plan_create (join of the small factors first)"
+	);
+	qg8_plan_destroy(plan);
+	t1->num_elems = 2;
+	qg8_tensor_destroy(t2);
+	qg8_tensor_destroy(t3);
+
+	/* graph: m2 = m1 * v, m1 = a * b */
+	g = qg8_graph_create();
+	ca = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, (uint8_t *) "a", a);
+	cb = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, (uint8_t *) "b", b);
+	cv = qg8_chunk_create(QG8_TYPE_KET, 0, (uint8_t *) "v", v);
+	cm1 = qg8_chunk_create(QG8_TYPE_MATMUL, 0, (uint8_t *) "m1", NULL);
+	cm2 = qg8_chunk_create(QG8_TYPE_MATMUL, 0, (uint8_t *) "m2", NULL);
+	qg8_graph_add_chunk(g, ca);
+	qg8_graph_add_chunk(g, cb);
+	qg8_graph_add_chunk(g, cv);
+	qg8_graph_add_chunk(g, cm1);
+	qg8_graph_add_chunk(g, cm2);
+	edims[0] = 6;
+	edims[1] = 6;
+	adj = qg8_tensor_create_double(inde, ere, NULL, 4, edims, 2,
+	                               QG8_PACKING_SPARSE_COO);
+	qg8_graph_add_chunk(g, qg8_chunk_create(QG8_TYPE_ADJACENCY, 0, NULL,
+	                                        adj));
+	inde[0] = (uint64_t *) malloc(sizeof(uint64_t) * 4);
+	ALLOC(inde[0]);
+	inde[1] = (uint64_t *) malloc(sizeof(uint64_t) * 4);
+	ALLOC(inde[1]);
+	inde[0][0] = _index_of(g, ca);
+	inde[1][0] = _index_of(g, cm1);
+	inde[0][1] = _index_of(g, cb);
+	inde[1][1] = _index_of(g, cm1);
+	inde[0][2] = _index_of(g, cv);
+	inde[1][2] = _index_of(g, cm2);
+	inde[0][3] = _index_of(g, cm1);
+	inde[1][3] = _index_of(g, cm2);
+	ere[0] = 1.0;
+	ere[1] = 2.0;
+	ere[2] = 2.0;
+	ere[3] = 1.0;
+
+	TEST(
+		res = qg8_graph_evaluate(g, cm2);
+		ore = (double *) qg8_tensor_get_re(res);
+		oim = (double *) qg8_tensor_get_im(res);
+		ok = qg8_tensor_get_rank(res) == 1 &&
+		     qg8_tensor_get_num_elems(res) == N;
+		for (i = 0; ok && i < N; ++i)
+		{
+			if (fabs(ore[i] - ref[i]) > 1e-9 ||
+			    fabs(oim[i] - refim[i]) > 1e-9)
+				ok = 0;
+		}
+	, ok, "qg8_graph_evaluate (MATMUL chain)"
+	);
+	qg8_tensor_destroy(res);
+
+	TEST(
+		res = qg8_graph_evaluate(g, cv);
+	, res != v && qg8_tensor_get_num_elems(res) == N,
+	  "qg8_graph_evaluate (data chunk is copied)"
+	);
+	qg8_tensor_destroy(res);
+
+	qg8_graph_destroy(g);
+	qg8_tensor_destroy(t1);
+	free(inde[0]);
+	free(inde[1]);
+	free(inde);
+	for (i = 0; i < 2; ++i)
+	{
+		free(inda[i]);
+		free(indv[i]);
+	}
+	free(inda);
+	free(indv);
+
+	PASS();
+}
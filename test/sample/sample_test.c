@@ -0,0 +1,218 @@
+/*
+ * sample_test.c
+ * Measurement sampling of kets.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif /* _OPENMP */
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define DIM    (1 << 17)
+#define HEAVY  4096
+#define SHOTS  1000000
+
+/* same states with the same counts */
+static
+int
+_same(qg8_tensor *a,
+      qg8_tensor *b)
+{
+	return a->num_elems == b->num_elems &&
+	       memcmp(*(a->indices), *(b->indices),
+	              sizeof(uint64_t) * a->num_elems) == 0 &&
+	       memcmp(a->redata, b->redata,
+	              sizeof(uint64_t) * a->num_elems) == 0;
+}
+
+static
+void
+_threads(int n)
+{
+#ifdef _OPENMP
+	omp_set_num_threads(n);
+#else
+	(void) n;
+#endif /* _OPENMP */
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *kind[1], *pind[1], *ie[2], kdims[1], pdims[1], edims[2];
+	uint64_t i, e, total, zeros, *cnt;
+	double *kre, *kim, w[DIM], norm, light, expect, chi2, par[2], ere[2];
+	qg8_tensor *ket, *h1, *h2, *h3;
+	qg8_chunk *k, *p, *s;
+	qg8_graph *g;
+
+	INIT();
+
+	(void) argc;
+	(void) argv;
+
+	/* every HEAVY-th state holds most of the mass, every third is empty */
+	kind[0] = (uint64_t *) malloc(sizeof(uint64_t) * DIM);
+	kre = (double *) malloc(sizeof(double) * DIM);
+	kim = (double *) malloc(sizeof(double) * DIM);
+	norm = 0.0;
+	for (i = 0; i < DIM; ++i)
+	{
+		kind[0][i] = i;
+		kre[i] = i % HEAVY == 0 ? 40.0 + (double) (i / HEAVY) : 0.1;
+		kim[i] = i % HEAVY == 0 ? 3.0 : 0.05;
+		if (i % 3 == 1)
+		{
+			kre[i] = 0.0;
+			kim[i] = 0.0;
+		}
+		w[i] = kre[i] * kre[i] + kim[i] * kim[i];
+		norm += w[i];
+	}
+	kdims[0] = DIM;
+	ket = qg8_tensor_create_double(kind, kre, kim, DIM, kdims, 1,
+	                               QG8_PACKING_FULL);
+
+	TEST(
+		h1 = qg8_tensor_sample(ket, SHOTS, 42);
+		cnt = (uint64_t *) h1->redata;
+		total = 0;
+		zeros = 0;
+		chi2 = 0.0;
+		light = 0.0;
+		for (e = 0; e < h1->num_elems; ++e)
+		{
+			i = *(*(h1->indices)+e);
+			total += cnt[e];
+			zeros += w[i] == 0.0;
+			if (e > 0 && *(*(h1->indices)+e-1) >= i)
+				zeros = 1;
+			if (i % HEAVY == 0)
+			{
+				expect = (double) SHOTS * w[i] / norm;
+				chi2 += (cnt[e] - expect) * (cnt[e] - expect) / expect;
+			}
+			else
+			{
+				light += (double) cnt[e];
+			}
+		}
+		expect = 0.0;
+		for (i = 0; i < DIM; ++i)
+			if (i % HEAVY != 0)
+				expect += (double) SHOTS * w[i] / norm;
+		chi2 += (light - expect) * (light - expect) / expect;
+	, h1->dtype_id == QG8_DTYPE_UINT64 && h1->packing == QG8_PACKING_SPARSE_COO &&
+	  total == SHOTS && zeros == 0 && chi2 < 100.0,
+	  "qg8_tensor_sample (distribution)"
+	);
+
+	TEST(
+		_threads(3);
+		h2 = qg8_tensor_sample(ket, SHOTS, 42);
+		_threads(1);
+		h3 = qg8_tensor_sample(ket, SHOTS, 43);
+	, _same(h1, h2) && !_same(h1, h3), "qg8_tensor_sample (reproducible)"
+	);
+	qg8_tensor_destroy(h2);
+	qg8_tensor_destroy(h3);
+
+	/* ket and parameters { shots, seed } feeding a SAMPLE chunk */
+	g = qg8_graph_create();
+	k = qg8_chunk_create(QG8_TYPE_KET, 0, NULL, ket);
+	qg8_graph_add_chunk(g, k);
+	pind[0] = (uint64_t *) malloc(sizeof(uint64_t) * 2);
+	pind[0][0] = 0;
+	pind[0][1] = 1;
+	pdims[0] = 2;
+	par[0] = SHOTS;
+	par[1] = 42;
+	p = qg8_chunk_create(QG8_TYPE_CONSTANT, 0, NULL,
+	                     qg8_tensor_create_double(pind, par, NULL, 2, pdims,
+	                                              1, QG8_PACKING_FULL));
+	qg8_graph_add_chunk(g, p);
+	s = qg8_chunk_create(QG8_TYPE_SAMPLE, 0, NULL, NULL);
+	qg8_graph_add_chunk(g, s);
+	ie[0] = (uint64_t *) malloc(sizeof(uint64_t) * 2);
+	ie[1] = (uint64_t *) malloc(sizeof(uint64_t) * 2);
+	edims[0] = 4;
+	edims[1] = 4;
+	qg8_graph_add_chunk(g, qg8_chunk_create(QG8_TYPE_ADJACENCY, 0, NULL,
+	                    qg8_tensor_create_double(ie, ere, NULL, 2, edims, 2,
+	                                             QG8_PACKING_SPARSE_COO)));
+	ie[0][0] = _index_of(g, p);
+	ie[1][0] = _index_of(g, s);
+	ere[0] = 1.0;
+	ie[0][1] = _index_of(g, k);
+	ie[1][1] = _index_of(g, s);
+	ere[1] = 2.0;
+	TEST(
+		h2 = qg8_graph_evaluate(g, s);
+	, _same(h1, h2), "qg8_graph_evaluate (sample)"
+	);
+	qg8_tensor_destroy(h2);
+	qg8_tensor_destroy(h1);
+
+	qg8_graph_destroy(g);
+
+	/* weights summing past the largest double leave every state over */
+	kdims[0] = 4;
+	for (i = 0; i < 4; ++i)
+	{
+		kre[i] = i < 2 ? 1e154 : 0.0;
+		kim[i] = 0.0;
+	}
+	ket = qg8_tensor_create_double(kind, kre, kim, 4, kdims, 1,
+	                               QG8_PACKING_FULL);
+	TEST(
+		h1 = qg8_tensor_sample(ket, SHOTS, 42);
+		cnt = (uint64_t *) h1->redata;
+		total = 0;
+		zeros = 0;
+		for (e = 0; e < h1->num_elems; ++e)
+		{
+			total += cnt[e];
+			zeros += *(*(h1->indices)+e) >= 2;
+		}
+	, total == SHOTS && zeros == 0 && h1->num_elems == 2 &&
+	  cnt[0] > SHOTS / 2 - SHOTS / 100 && cnt[1] > SHOTS / 2 - SHOTS / 100,
+	  "qg8_tensor_sample (overflowing weights)"
+	);
+	qg8_tensor_destroy(h1);
+	qg8_tensor_destroy(ket);
+
+	free(kind[0]);
+	free(kre);
+	free(kim);
+	free(pind[0]);
+	free(ie[0]);
+	free(ie[1]);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,213 @@
+/*
+ * eigen_test.c
+ * Lanczos lowest eigenpairs of Hermitian operators.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define DIM   256
+#define NHH   1500
+#define K     4
+
+/* largest |op x - l x| over the kets, and largest |<x_i|x_j> - d_ij| */
+static
+double
+_check(qg8_tensor *op,
+       qg8_tensor **kets,
+       const double *values,
+       uint64_t k)
+{
+	double yr[DIM], yi[DIM], *xr, *xi, *zr, *zi, err, dr, di;
+	uint64_t n, i, j, p;
+
+	n = op->dimensions[0];
+	err = 0.0;
+	for (i = 0; i < k; ++i)
+	{
+		xr = (double *) kets[i]->redata;
+		xi = (double *) kets[i]->imdata;
+		qg8_tensor_spmv(op, xr, xi, yr, yi);
+		for (p = 0; p < n; ++p)
+		{
+			err = MAX(err, fabs(yr[p] - values[i] * xr[p]));
+			err = MAX(err, fabs(yi[p] - values[i] * xi[p]));
+		}
+		for (j = 0; j <= i; ++j)
+		{
+			zr = (double *) kets[j]->redata;
+			zi = (double *) kets[j]->imdata;
+			dr = 0.0;
+			di = 0.0;
+			for (p = 0; p < n; ++p)
+			{
+				dr += zr[p] * xr[p] + zi[p] * xi[p];
+				di += zr[p] * xi[p] - zi[p] * xr[p];
+			}
+			err = MAX(err, fabs(dr - (i == j ? 1.0 : 0.0)));
+			err = MAX(err, fabs(di));
+		}
+	}
+	return err;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *dind[2], *hind[2], *find[2], *pind[2], dims[2], pdims[2], i;
+	double dre[DIM], hre[NHH], him[NHH], fre[2*NHH], fim[2*NHH], pre[2];
+	double values[K], full[K], err;
+	qg8_tensor *diag, *hh, *coo, *pauli, *kets[K], *fkets[K];
+	qg8_chunk **chunks;
+	uint64_t nf;
+
+	INIT();
+	_rand_seed(11);
+	(void) argc;
+	(void) argv;
+
+	dims[0] = DIM;
+	dims[1] = DIM;
+
+	/* diagonal operator with a shuffled, evenly spaced spectrum */
+	dind[0] = (uint64_t *) malloc(sizeof(uint64_t) * DIM);
+	dind[1] = dind[0];
+	for (i = 0; i < DIM; ++i)
+	{
+		dind[0][i] = i;
+		dre[i] = 0.05 * (double) ((i * 97) % DIM) - 3.0;
+	}
+	diag = qg8_tensor_create_double(dind, dre, NULL, DIM, dims, 2,
+	                                QG8_PACKING_SPARSE_COO);
+	TEST(
+		qg8_tensor_eigen(diag, K, 1e-10, values, kets);
+		err = _check(diag, kets, values, K);
+		for (i = 0; i < K; ++i)
+			err = MAX(err, fabs(values[i] - (0.05 * (double) i - 3.0)));
+	, err < 1e-8, "qg8_tensor_eigen (diagonal)"
+	);
+	for (i = 0; i < K; ++i)
+		qg8_tensor_destroy(kets[i]);
+
+	/* random Hermitian operator, half stored, then both halves in CSR */
+	hind[0] = (uint64_t *) malloc(sizeof(uint64_t) * NHH);
+	hind[1] = (uint64_t *) malloc(sizeof(uint64_t) * NHH);
+	find[0] = (uint64_t *) malloc(sizeof(uint64_t) * 2 * NHH);
+	find[1] = (uint64_t *) malloc(sizeof(uint64_t) * 2 * NHH);
+	nf = 0;
+	for (i = 0; i < NHH; ++i)
+	{
+		hind[0][i] = (i * 37) % DIM;
+		hind[1][i] = hind[0][i] + (i * 11) % (DIM - hind[0][i]);
+		hre[i] = _rand();
+		him[i] = hind[0][i] == hind[1][i] ? 0.0 : _rand();
+		find[0][nf] = hind[0][i];
+		find[1][nf] = hind[1][i];
+		fre[nf] = hre[i];
+		fim[nf++] = him[i];
+		if (hind[0][i] == hind[1][i])
+			continue;
+		find[0][nf] = hind[1][i];
+		find[1][nf] = hind[0][i];
+		fre[nf] = hre[i];
+		fim[nf++] = -him[i];
+	}
+	hh = qg8_tensor_create_double(hind, hre, him, NHH, dims, 2,
+	                              QG8_PACKING_HALF_HERMITIAN);
+	TEST(
+		qg8_tensor_eigen(hh, K, 1e-10, values, kets);
+		err = _check(hh, kets, values, K);
+	, err < 1e-8 && values[0] < values[1] && values[K-2] < values[K-1],
+	  "qg8_tensor_eigen (half-Hermitian)"
+	);
+	coo = qg8_tensor_create_double(find, fre, fim, nf, dims, 2,
+	                               QG8_PACKING_SPARSE_COO);
+	qg8_tensor_csr_build(coo);
+	TEST(
+		qg8_tensor_eigen(coo, K, 1e-10, full, fkets);
+		err = _check(coo, fkets, full, K);
+		for (i = 0; i < K; ++i)
+			err = MAX(err, fabs(values[i] - full[i]));
+	, err < 1e-8, "qg8_tensor_eigen (CSR)"
+	);
+	for (i = 0; i < K; ++i)
+	{
+		qg8_tensor_destroy(kets[i]);
+		qg8_tensor_destroy(fkets[i]);
+	}
+
+	/* Z0 Z1 + X0/2 on two qubits: the whole, degenerate, spectrum */
+	pdims[0] = 4;
+	pdims[1] = 4;
+	pind[0] = (uint64_t *) malloc(sizeof(uint64_t) * 2);
+	pind[1] = (uint64_t *) malloc(sizeof(uint64_t) * 2);
+	pind[0][0] = 0;
+	pind[1][0] = 3;
+	pre[0] = 1.0;
+	pind[0][1] = 2;
+	pind[1][1] = 0;
+	pre[1] = 0.5;
+	pauli = qg8_tensor_create_double(pind, pre, NULL, 2, pdims, 2,
+	                                 QG8_PACKING_PAULI);
+	TEST(
+		qg8_tensor_eigen(pauli, 4, 1e-10, values, kets);
+		err = _check(pauli, kets, values, 4);
+		for (i = 0; i < 4; ++i)
+			err = MAX(err, fabs(fabs(values[i]) - sqrt(1.25)));
+	, err < 1e-8 && values[1] < 0.0 && values[2] > 0.0,
+	  "qg8_tensor_eigen (full spectrum)"
+	);
+	for (i = 0; i < 4; ++i)
+		qg8_tensor_destroy(kets[i]);
+
+	TEST(
+		chunks = qg8_tensor_eigenkets(diag, 2, values);
+	, qg8_chunk_get_type(chunks[0]) == QG8_TYPE_KET &&
+	  (qg8_chunk_get_flags(chunks[1]) & QG8_FLAG_LABEL) &&
+	  !strcmp((char *) qg8_chunk_get_string_id(chunks[1]), "eigen1") &&
+	  fabs(*(double *) qg8_chunk_get_tensor(chunks[0])->redata - 1.0) < 1e-8 &&
+	  fabs(values[1] + 2.95) < 1e-8,
+	  "qg8_tensor_eigenkets"
+	);
+	for (i = 0; i < 2; ++i)
+		qg8_chunk_destroy(chunks[i]);
+	free(chunks);
+
+	qg8_tensor_destroy(diag);
+	qg8_tensor_destroy(hh);
+	qg8_tensor_destroy(coo);
+	qg8_tensor_destroy(pauli);
+	free(dind[0]);
+	free(hind[0]);
+	free(hind[1]);
+	free(find[0]);
+	free(find[1]);
+	free(pind[0]);
+	free(pind[1]);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,249 @@
+/*
+ * solve_test.c
+ * Krylov time evolution of kets.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define NQ    8
+#define DIM   (1 << NQ)
+#define NHH   1500
+
+static
+uint64_t
+_popcount(uint64_t v)
+{
+	uint64_t n;
+	for (n = 0; v; v &= v - 1)
+		++n;
+	return n;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *dind[2], *pind[2], *hind[2], *kind[1], *tind[1], *ie[3];
+	uint64_t dims[2], kdims[1], tdims[1], edims[2], i, k, b, w;
+	double dre[DIM], pre[NQ], hre[NHH], him[NHH], kre[DIM];
+	double kim[DIM], zre[DIM], zim[DIM], times[3], back[2], ed[3];
+	double *or, *oi, ph, c, s, ar, ai, err, norm;
+	qg8_tensor *diag, *pauli, *hh, *ket, *zero, *res, *ref;
+	qg8_chunk *op, *kc, *tc, *sc;
+	qg8_graph *g;
+
+	INIT();
+	_rand_seed(5);
+
+	(void) argc;
+	(void) argv;
+
+	dims[0] = DIM;
+	dims[1] = DIM;
+	kdims[0] = DIM;
+	kind[0] = (uint64_t *) malloc(sizeof(uint64_t) * DIM);
+	norm = 0.0;
+	for (i = 0; i < DIM; ++i)
+	{
+		kind[0][i] = i;
+		kre[i] = _rand();
+		kim[i] = _rand();
+		norm += kre[i] * kre[i] + kim[i] * kim[i];
+		zre[i] = i == 0 ? 1.0 : 0.0;
+		zim[i] = 0.0;
+	}
+	ket = qg8_tensor_create_double(kind, kre, kim, DIM, kdims, 1,
+	                               QG8_PACKING_FULL);
+	zero = qg8_tensor_create_double(kind, zre, zim, DIM, kdims, 1,
+	                                QG8_PACKING_FULL);
+
+	/* diagonal operator: every amplitude turns at its own frequency */
+	dind[0] = (uint64_t *) malloc(sizeof(uint64_t) * DIM);
+	dind[1] = dind[0];
+	for (i = 0; i < DIM; ++i)
+	{
+		dind[0][i] = i;
+		dre[i] = 4.0 * _rand();
+	}
+	diag = qg8_tensor_create_double(dind, dre, NULL, DIM, dims, 2,
+	                                QG8_PACKING_SPARSE_COO);
+	times[0] = 0.5;
+	times[1] = 1.0;
+	times[2] = 3.0;
+	TEST(
+		res = qg8_tensor_evolve(diag, ket, times, 3, 1e-10);
+		or = (double *) res->redata;
+		oi = (double *) res->imdata;
+		err = 0.0;
+		for (k = 0; k < 3; ++k)
+		{
+			for (i = 0; i < DIM; ++i)
+			{
+				ph = -dre[i] * times[k];
+				ar = cos(ph) * kre[i] - sin(ph) * kim[i];
+				ai = cos(ph) * kim[i] + sin(ph) * kre[i];
+				err = MAX(err, fabs(or[k*DIM+i] - ar));
+				err = MAX(err, fabs(oi[k*DIM+i] - ai));
+			}
+		}
+	, res->rank == 2 && res->dimensions[0] == 3 && err < 1e-8,
+	  "qg8_tensor_evolve (diagonal)"
+	);
+	qg8_tensor_destroy(res);
+
+	/* transverse field sum_q X_q from |0..0>: a product of rotations */
+	pind[0] = (uint64_t *) malloc(sizeof(uint64_t) * NQ);
+	pind[1] = (uint64_t *) malloc(sizeof(uint64_t) * NQ);
+	for (i = 0; i < NQ; ++i)
+	{
+		pind[0][i] = 1UL << i;
+		pind[1][i] = 0;
+		pre[i] = 0.7;
+	}
+	pauli = qg8_tensor_create_double(pind, pre, NULL, NQ, dims, 2,
+	                                 QG8_PACKING_PAULI);
+	times[0] = 5.0;
+	TEST(
+		res = qg8_tensor_evolve(pauli, zero, times, 1, 1e-10);
+		or = (double *) res->redata;
+		oi = (double *) res->imdata;
+		c = cos(0.7 * times[0]);
+		s = sin(0.7 * times[0]);
+		err = 0.0;
+		for (b = 0; b < DIM; ++b)
+		{
+			/* (-i s)^w c^(NQ-w) */
+			w = _popcount(b);
+			ar = pow(c, (double) (NQ - w)) * pow(s, (double) w);
+			ai = 0.0;
+			switch (w % 4)
+			{
+			case 1: ai = -ar; ar = 0.0; break;
+			case 2: ar = -ar; break;
+			case 3: ai = ar; ar = 0.0; break;
+			default: break;
+			}
+			err = MAX(err, fabs(or[b] - ar));
+			err = MAX(err, fabs(oi[b] - ai));
+		}
+	, res->rank == 1 && res->num_elems == DIM && err < 1e-8,
+	  "qg8_tensor_evolve (Pauli)"
+	);
+	qg8_tensor_destroy(res);
+
+	/* random Hermitian operator: forth and back again */
+	hind[0] = (uint64_t *) malloc(sizeof(uint64_t) * NHH);
+	hind[1] = (uint64_t *) malloc(sizeof(uint64_t) * NHH);
+	for (i = 0; i < NHH; ++i)
+	{
+		hind[0][i] = (i * 37) % DIM;
+		hind[1][i] = hind[0][i] + (i * 11) % (DIM - hind[0][i]);
+		hre[i] = _rand();
+		him[i] = hind[0][i] == hind[1][i] ? 0.0 : _rand();
+	}
+	hh = qg8_tensor_create_double(hind, hre, him, NHH, dims, 2,
+	                              QG8_PACKING_HALF_HERMITIAN);
+	back[0] = 2.0;
+	back[1] = 0.0;
+	TEST(
+		res = qg8_tensor_evolve(hh, ket, back, 2, 1e-10);
+		or = (double *) res->redata;
+		oi = (double *) res->imdata;
+		err = 0.0;
+		s = 0.0;
+		for (i = 0; i < DIM; ++i)
+		{
+			s += or[i] * or[i] + oi[i] * oi[i];
+			err = MAX(err, fabs(or[DIM+i] - kre[i]));
+			err = MAX(err, fabs(oi[DIM+i] - kim[i]));
+		}
+	, fabs(s - norm) < 1e-8 && err < 1e-8,
+	  "qg8_tensor_evolve (reversible)"
+	);
+	ref = res;
+
+	/* operator, ket and times feeding a SOLVE chunk */
+	g = qg8_graph_create();
+	op = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, NULL, hh);
+	qg8_graph_add_chunk(g, op);
+	kc = qg8_chunk_create(QG8_TYPE_KET, 0, NULL, ket);
+	qg8_graph_add_chunk(g, kc);
+	tind[0] = (uint64_t *) malloc(sizeof(uint64_t) * 2);
+	tind[0][0] = 0;
+	tind[0][1] = 1;
+	tdims[0] = 2;
+	tc = qg8_chunk_create(QG8_TYPE_TIME, 0, NULL,
+	                      qg8_tensor_create_double(tind, back, NULL, 2, tdims,
+	                                               1, QG8_PACKING_FULL));
+	qg8_graph_add_chunk(g, tc);
+	sc = qg8_chunk_create(QG8_TYPE_SOLVE, 0, NULL, NULL);
+	qg8_graph_add_chunk(g, sc);
+	ie[0] = (uint64_t *) malloc(sizeof(uint64_t) * 3);
+	ie[1] = (uint64_t *) malloc(sizeof(uint64_t) * 3);
+	edims[0] = 5;
+	edims[1] = 5;
+	qg8_graph_add_chunk(g, qg8_chunk_create(QG8_TYPE_ADJACENCY, 0, NULL,
+	                    qg8_tensor_create_double(ie, ed, NULL, 3, edims, 2,
+	                                             QG8_PACKING_SPARSE_COO)));
+	ie[0][0] = _index_of(g, tc);
+	ie[0][1] = _index_of(g, kc);
+	ie[0][2] = _index_of(g, op);
+	for (i = 0; i < 3; ++i)
+	{
+		ie[1][i] = _index_of(g, sc);
+		ed[i] = (double) (i + 1);
+	}
+	TEST(
+		res = qg8_graph_evaluate(g, sc);
+		err = 0.0;
+		for (i = 0; i < 2 * DIM; ++i)
+		{
+			err = MAX(err, fabs(((double *) res->redata)[i] -
+			                    ((double *) ref->redata)[i]));
+			err = MAX(err, fabs(((double *) res->imdata)[i] -
+			                    ((double *) ref->imdata)[i]));
+		}
+	, res->num_elems == 2 * DIM && err == 0.0, "qg8_graph_evaluate (solve)"
+	);
+	qg8_tensor_destroy(res);
+	qg8_tensor_destroy(ref);
+
+	qg8_graph_destroy(g);
+	qg8_tensor_destroy(diag);
+	qg8_tensor_destroy(pauli);
+	qg8_tensor_destroy(zero);
+	free(kind[0]);
+	free(dind[0]);
+	free(pind[0]);
+	free(pind[1]);
+	free(hind[0]);
+	free(hind[1]);
+	free(tind[0]);
+	free(ie[0]);
+	free(ie[1]);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+/*
+ * bad_reorder.c
+ * Reordering a graph which builds its operator with JOIN.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *ind[2], *hi[2], *ki[1], *ie[2], dims[2], hdims[2], kdims[1];
+	uint64_t edims[2], i;
+	double re[4], xr[4], ed[4];
+	qg8_chunk *op, *h, *j, *ket, *mm;
+	qg8_graph *g;
+
+	INIT();
+	(void) argc;
+	(void) argv;
+
+	ind[0] = (uint64_t *) malloc(sizeof(uint64_t) * 4);
+	ind[1] = (uint64_t *) malloc(sizeof(uint64_t) * 4);
+	ki[0] = (uint64_t *) malloc(sizeof(uint64_t) * 4);
+	for (i = 0; i < 4; ++i)
+	{
+		ind[0][i] = i;
+		ind[1][i] = 3 - i;
+		ki[0][i] = i;
+		re[i] = 1.0;
+		xr[i] = 0.5;
+	}
+	dims[0] = 4;
+	dims[1] = 4;
+	kdims[0] = 4;
+
+	/* y = (X (x) X) x next to an operator of the same four states */
+	g = qg8_graph_create();
+	op = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, NULL,
+	                      qg8_tensor_create_double(ind, re, NULL, 4, dims, 2,
+	                                               QG8_PACKING_SPARSE_COO));
+	qg8_graph_add_chunk(g, op);
+	hi[0] = ind[0];
+	hi[1] = ind[1] + 2;
+	hdims[0] = 2;
+	hdims[1] = 2;
+	h = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, NULL,
+	                     qg8_tensor_create_double(hi, re, NULL, 2, hdims, 2,
+	                                              QG8_PACKING_SPARSE_COO));
+	qg8_graph_add_chunk(g, h);
+	j = qg8_chunk_create(QG8_TYPE_JOIN, 0, NULL, NULL);
+	qg8_graph_add_chunk(g, j);
+	ket = qg8_chunk_create(QG8_TYPE_KET, 0, NULL,
+	                       qg8_tensor_create_double(ki, xr, NULL, 4, kdims,
+	                                                1, QG8_PACKING_FULL));
+	qg8_graph_add_chunk(g, ket);
+	mm = qg8_chunk_create(QG8_TYPE_MATMUL, 0, NULL, NULL);
+	qg8_graph_add_chunk(g, mm);
+	ie[0] = (uint64_t *) malloc(sizeof(uint64_t) * 4);
+	ie[1] = (uint64_t *) malloc(sizeof(uint64_t) * 4);
+	edims[0] = 6;
+	edims[1] = 6;
+	qg8_graph_add_chunk(g, qg8_chunk_create(QG8_TYPE_ADJACENCY, 0, NULL,
+	                    qg8_tensor_create_double(ie, ed, NULL, 4, edims, 2,
+	                                             QG8_PACKING_SPARSE_COO)));
+	ie[0][0] = _index_of(g, h);
+	ie[1][0] = _index_of(g, j);
+	ed[0] = 1.0;
+	ie[0][1] = _index_of(g, h);
+	ie[1][1] = _index_of(g, j);
+	ed[1] = 2.0;
+	ie[0][2] = _index_of(g, j);
+	ie[1][2] = _index_of(g, mm);
+	ed[2] = 1.0;
+	ie[0][3] = _index_of(g, ket);
+	ie[1][3] = _index_of(g, mm);
+	ed[3] = 2.0;
+
+	TEST(
+		qg8_graph_reorder(g, op);
+	, 1 == 0, "qg8_graph_reorder (JOIN of the operator dimension)\n"
+	);
+
+	PASS();
+}
@@ -0,0 +1,237 @@
+/*
+ * canon_test.c
+ * Canonical ordering of sparse tensors.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define ROWS  300
+#define COLS  70000
+#define NNZ   150000
+#define FNAME "sparse/canon_test.qg8"
+
+/* entries strictly increasing by coordinates, first axis first */
+static
+int
+_is_canonical(qg8_tensor *t)
+{
+	uint64_t e;
+	uint16_t k;
+	int cmp;
+
+	for (e = 1; e < t->num_elems; ++e)
+	{
+		cmp = 0;
+		for (k = 0; cmp == 0 && k < t->rank; ++k)
+		{
+			if (*(*(t->indices+k)+e-1) != *(*(t->indices+k)+e))
+				cmp = *(*(t->indices+k)+e-1) < *(*(t->indices+k)+e) ?
+				      -1 : 1;
+		}
+		if (cmp >= 0)
+			return 0;
+	}
+	return (t->flags & QG8_TENSOR_SORTED) != 0;
+}
+
+/* largest difference between t*x and ref*x */
+static
+double
+_spmv_diff(qg8_tensor *t,
+           qg8_tensor *ref,
+           const double *xr,
+           const double *xi)
+{
+	double *yr, *yi, *zr, *zi, err;
+	uint64_t i, n;
+
+	n = *(ref->dimensions);
+	yr = (double *) malloc(sizeof(double) * n);
+	yi = (double *) malloc(sizeof(double) * n);
+	zr = (double *) malloc(sizeof(double) * n);
+	zi = (double *) malloc(sizeof(double) * n);
+	qg8_tensor_spmv(t, xr, xi, yr, yi);
+	qg8_tensor_spmv(ref, xr, xi, zr, zi);
+	err = 0.0;
+	for (i = 0; i < n; ++i)
+	{
+		err = MAX(err, fabs(yr[i] - zr[i]));
+		err = MAX(err, fabs(yi[i] - zi[i]));
+	}
+	free(yr);
+	free(yi);
+	free(zr);
+	free(zi);
+	return err;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *ai[2], *ti[3], dims[2], tdims[3], i, sum;
+	double *are, *aim, *xr, *xi, err;
+	uint32_t tre[12];
+	qg8_tensor *a, *c, *t, *tc, *back;
+	qg8_chunk *chunk;
+	qg8_file *f;
+	qg8_iter iter;
+
+	INIT();
+	_rand_seed(31);
+	(void) argc;
+	(void) argv;
+
+	/* a wide complex matrix, unordered and with many duplicates */
+	dims[0] = ROWS;
+	dims[1] = COLS;
+	ai[0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	ai[1] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	are = (double *) malloc(sizeof(double) * NNZ);
+	aim = (double *) malloc(sizeof(double) * NNZ);
+	for (i = 0; i < NNZ; ++i)
+	{
+		ai[0][i] = _rand_int() % ROWS;
+		ai[1][i] = (_rand_int() % 600) * 113 % COLS;
+		are[i] = (double) (_rand_int() % 1000) / 1000.0;
+		aim[i] = (double) (_rand_int() % 1000) / 1000.0;
+	}
+	a = qg8_tensor_create_double(ai, are, aim, NNZ, dims, 2,
+	                             QG8_PACKING_SPARSE_COO);
+	xr = (double *) malloc(sizeof(double) * COLS);
+	xi = (double *) malloc(sizeof(double) * COLS);
+	for (i = 0; i < COLS; ++i)
+	{
+		xr[i] = (double) (_rand_int() % 1000) / 1000.0 - 0.5;
+		xi[i] = (double) (_rand_int() % 1000) / 1000.0 - 0.5;
+	}
+
+	TEST(
+		c = qg8_tensor_canonical(a);
+		err = _spmv_diff(c, a, xr, xi);
+	, _is_canonical(c) && c->num_elems < NNZ &&
+	  c->dtype_id == QG8_DTYPE_COMPLEX128 &&
+	  c->packing == QG8_PACKING_SPARSE_COO && err < 1e-9,
+	  "qg8_tensor_canonical (duplicates summed)"
+	);
+
+	/* integers keep their dtype, every axis is a key */
+	tdims[0] = 2;
+	tdims[1] = 3;
+	tdims[2] = 300;
+	for (i = 0; i < 3; ++i)
+		ti[i] = (uint64_t *) malloc(sizeof(uint64_t) * 12);
+	for (i = 0; i < 12; ++i)
+	{
+		ti[0][i] = (11 - i) % 2;
+		ti[1][i] = (i * 5) % 3;
+		ti[2][i] = (i % 4) * 97;
+		tre[i] = (uint32_t) i + 1;
+	}
+	t = qg8_tensor_create_uint32(ti, tre, 12, tdims, 3,
+	                             QG8_PACKING_SPARSE_COO);
+	TEST(
+		tc = qg8_tensor_canonical(t);
+		sum = 0;
+		for (i = 0; i < tc->num_elems; ++i)
+			sum += ((uint32_t *) tc->redata)[i];
+	, _is_canonical(tc) && tc->num_elems == 12 &&
+	  tc->dtype_id == QG8_DTYPE_UINT32 && sum == 78 &&
+	  tc->indices[0][0] == 0 && tc->indices[2][11] == 194,
+	  "qg8_tensor_canonical (rank 3 integers)"
+	);
+
+	/* the flag survives a file, so the sort is done once */
+	TEST(
+		f = qg8_file_open(FNAME, QG8_MODE_WRITE);
+		chunk = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, NULL, c);
+		qg8_file_write_chunk(f, chunk);
+		qg8_file_flush(f);
+		qg8_file_close(f);
+		qg8_chunk_destroy(chunk);
+		f = qg8_file_open(FNAME, QG8_MODE_READ);
+		iter = qg8_file_iterator(f);
+		chunk = NULL;
+		if (qg8_file_has_next(&iter))
+			chunk = qg8_file_extract(&iter);
+		qg8_file_close(f);
+		remove(FNAME);
+		back = chunk ? chunk->tensor : NULL;
+		err = back ? _spmv_diff(back, a, xr, xi) : 1.0;
+	, back && _is_canonical(back) && err < 1e-9,
+	  "QG8_TENSOR_SORTED file round trip"
+	);
+	qg8_chunk_destroy(chunk);
+
+	/* canonical tensors stay as they are, others are not flagged */
+	TEST(
+		back = qg8_tensor_canonical(tc);
+		err = (double) (back->num_elems != tc->num_elems);
+		qg8_tensor_destroy(back);
+	, !(a->flags & QG8_TENSOR_SORTED) && !(t->flags & QG8_TENSOR_SORTED) &&
+	  err == 0.0, "qg8_tensor_canonical (idempotent)"
+	);
+
+	/* a file claiming an order its entries do not have is not trusted */
+	TEST(
+		a->flags |= QG8_TENSOR_SORTED;
+		f = qg8_file_open(FNAME, QG8_MODE_WRITE);
+		chunk = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, NULL, a);
+		qg8_file_write_chunk(f, chunk);
+		qg8_file_flush(f);
+		qg8_file_close(f);
+		chunk->tensor = NULL;
+		qg8_chunk_destroy(chunk);
+		a->flags &= ~QG8_TENSOR_SORTED;
+		f = qg8_file_open(FNAME, QG8_MODE_READ);
+		iter = qg8_file_iterator(f);
+		chunk = NULL;
+		if (qg8_file_has_next(&iter))
+			chunk = qg8_file_extract(&iter);
+		qg8_file_close(f);
+		remove(FNAME);
+		back = chunk ? chunk->tensor : NULL;
+		err = back ? _spmv_diff(back, a, xr, xi) : 1.0;
+	, back && !(back->flags & QG8_TENSOR_SORTED) && err < 1e-9,
+	  "QG8_TENSOR_SORTED checked on load"
+	);
+	qg8_chunk_destroy(chunk);
+
+	qg8_tensor_destroy(a);
+	qg8_tensor_destroy(t);
+	qg8_tensor_destroy(tc);
+	for (i = 0; i < 3; ++i)
+		free(ti[i]);
+	free(ai[0]);
+	free(ai[1]);
+	free(are);
+	free(aim);
+	free(xr);
+	free(xi);
+
+	return EXIT_SUCCESS;
+}
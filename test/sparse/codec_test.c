@@ -0,0 +1,196 @@
+/*
+ * codec_test.c
+ * Packed indices of canonical tensors in files.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define ROWS  4096
+#define N     (1 << 20)
+#define NNZ   30001
+#define FNAME "sparse/codec_test.qg8"
+
+/* same entries, with the same coordinates and values, in the same order */
+static
+int
+_same(qg8_tensor *a,
+      qg8_tensor *b)
+{
+	double ar, ai, br, bi;
+	uint64_t e;
+	uint16_t k;
+
+	if (a->num_elems != b->num_elems || a->rank != b->rank ||
+	    a->packing != b->packing || a->flags != b->flags)
+		return 0;
+	for (e = 0; e < a->num_elems; ++e)
+	{
+		for (k = 0; k < _tensor_index_arrays(a); ++k)
+			if (a->indices[k][e] != b->indices[k][e])
+				return 0;
+		_tensor_element(a, e, &ar, &ai);
+		_tensor_element(b, e, &br, &bi);
+		if (ar != br || ai != bi)
+			return 0;
+	}
+	return 1;
+}
+
+/* t read back from the file last written, with the given instruction set */
+static
+qg8_chunk *
+_read_isa(int isa)
+{
+	qg8_chunk *c;
+	qg8_file *f;
+	qg8_iter iter;
+
+	qg8_kernel_set_isa(isa);
+	f = qg8_file_open(FNAME, QG8_MODE_READ);
+	iter = qg8_file_iterator(f);
+	c = qg8_file_has_next(&iter) ? qg8_file_extract(&iter) : NULL;
+	qg8_file_close(f);
+	return c;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *hi[2], *wi[1], dims[2], wdims[1], i;
+	double hre[NNZ], him[NNZ], wre[NNZ];
+	qg8_tensor *h, *canon, *plain, *w;
+	qg8_chunk *back, *c1, *c2;
+	long plain_size, packed_size;
+	int ok, isa;
+
+	INIT();
+	_rand_seed(47);
+	(void) argc;
+	(void) argv;
+
+	/* an operator of dimension 2^20 with a few entries on ROWS rows */
+	dims[0] = N;
+	dims[1] = N;
+	hi[0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	hi[1] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	for (i = 0; i < NNZ; ++i)
+	{
+		hi[0][i] = (_rand_int() % ROWS) * (N / ROWS);
+		hi[1][i] = _rand_int() % N;
+		hre[i] = (double) (_rand_int() % 100) / 10.0;
+		him[i] = (double) (_rand_int() % 100) / 10.0;
+	}
+	h = qg8_tensor_create_double(hi, hre, him, NNZ, dims, 2,
+	                             QG8_PACKING_SPARSE_COO);
+	canon = qg8_tensor_canonical(h);
+
+	/* the plain copy differs only in not being marked canonical */
+	TEST(
+		plain = _tensor_copy(canon);
+		plain->flags = 0;
+		plain_size = _round_trip(FNAME, QG8_TYPE_OBSERVABLE, &plain, 1,
+		                         QG8_COMPRESS_NONE, QG8_INDEX_PLAIN, 0,
+		                         &back);
+		qg8_chunk_destroy(back);
+		packed_size = _round_trip(FNAME, QG8_TYPE_OBSERVABLE, &canon,
+		                          1, QG8_COMPRESS_NONE,
+		                          QG8_INDEX_PLAIN, 0, &back);
+		ok = back && _same(back->tensor, canon) &&
+		     back->tensor->itype_id == QG8_DTYPE_UINT32;
+		qg8_chunk_destroy(back);
+	, ok && plain_size - packed_size > 4 * (long) canon->num_elems,
+	  "packed COO file round trip"
+	);
+
+	TEST(
+		_round_trip(FNAME, QG8_TYPE_OBSERVABLE, &canon, 1,
+		            QG8_COMPRESS_NONE, QG8_INDEX_LINEAR, 0, &back);
+		ok = back && _same(back->tensor, canon) &&
+		     qg8_chunk_get_index_encoding(back) == QG8_INDEX_LINEAR;
+		qg8_chunk_destroy(back);
+	, ok, "packed LINEAR file round trip"
+	);
+
+	/* gaps of 59 bits, too wide for the vector unpacking */
+	wdims[0] = UINT64_MAX;
+	wi[0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	for (i = 0; i < NNZ; ++i)
+	{
+		wi[0][i] = ((uint64_t) 1 << 58) * (i % 32) + i / 32 * 3;
+		wre[i] = (double) i;
+	}
+	w = qg8_tensor_create_double(wi, wre, NULL, NNZ, wdims, 1,
+	                             QG8_PACKING_SPARSE_COO);
+	qg8_tensor_destroy(canon);
+	canon = qg8_tensor_canonical(w);
+
+	/* every instruction set unpacks the same indices */
+	TEST(
+		isa = qg8_kernel_get_isa();
+		_round_trip(FNAME, QG8_TYPE_OBSERVABLE, &canon, 1,
+		            QG8_COMPRESS_NONE, QG8_INDEX_PLAIN, 0, &back);
+		c1 = _read_isa(QG8_ISA_SCALAR);
+		ok = _same(c1->tensor, canon) && _same(back->tensor, canon);
+		qg8_chunk_destroy(back);
+		_round_trip(FNAME, QG8_TYPE_OBSERVABLE, &canon, 1,
+		            QG8_COMPRESS_NONE, QG8_INDEX_LINEAR, 0, &back);
+		c2 = _read_isa(QG8_ISA_SCALAR);
+		ok = ok && _same(c2->tensor, back->tensor);
+		qg8_chunk_destroy(c1);
+		qg8_chunk_destroy(c2);
+		qg8_chunk_destroy(back);
+		qg8_kernel_set_isa(isa);
+	, ok, "packed index unpacking on every instruction set"
+	);
+
+	/* out of order entries marked canonical are written plain */
+	TEST(
+		qg8_tensor_destroy(plain);
+		plain = _tensor_copy(w);
+		plain->flags = QG8_TENSOR_SORTED;
+		plain_size = _round_trip(FNAME, QG8_TYPE_OBSERVABLE, &plain, 1,
+		                         QG8_COMPRESS_NONE, QG8_INDEX_PLAIN, 0,
+		                         &back);
+		/* and lose the mark once read */
+		plain->flags = 0;
+		ok = back && _same(back->tensor, plain);
+		qg8_chunk_destroy(back);
+		remove(FNAME);
+	, ok && plain_size > 8 * (long) plain->num_elems,
+	  "unsorted indices written plain"
+	);
+
+	qg8_tensor_destroy(h);
+	qg8_tensor_destroy(canon);
+	qg8_tensor_destroy(plain);
+	qg8_tensor_destroy(w);
+	free(hi[0]);
+	free(hi[1]);
+	free(wi[0]);
+
+	return EXIT_SUCCESS;
+}
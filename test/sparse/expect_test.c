@@ -0,0 +1,210 @@
+/*
+ * expect_test.c
+ * Expectation values of sparse, half-Hermitian and full observables.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define DIM   300
+#define NNZ   20000
+#define NHH   5000
+
+/* <ket|op|ket> through the applied operator */
+static
+void
+_reference(qg8_tensor *op,
+           qg8_tensor *ket,
+           double *re,
+           double *im)
+{
+	qg8_tensor *y;
+	double *xr, *xi, *yr, *yi;
+	uint64_t i;
+
+	y = qg8_tensor_apply(op, ket);
+	xr = (double *) ket->redata;
+	xi = (double *) ket->imdata;
+	yr = (double *) y->redata;
+	yi = (double *) y->imdata;
+	*re = 0.0;
+	*im = 0.0;
+	for (i = 0; i < DIM; ++i)
+	{
+		*re += xr[i] * yr[i] + xi[i] * yi[i];
+		*im += xr[i] * yi[i] - xi[i] * yr[i];
+	}
+	qg8_tensor_destroy(y);
+}
+
+static
+int
+_close(double a,
+       double b)
+{
+	return fabs(a - b) < 1e-9 * MAX(1.0, fabs(b));
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *ic[2], *ih[2], *id[2], *ik[1], *ie[2], dims[2], kdims[1];
+	uint64_t edims[2], i;
+	double *cre, *cim, *hre, *him, *dre, *dim, kre[DIM], kim[DIM], ere[2];
+	double re, im, rre, rim;
+	qg8_tensor *coo, *hh, *full, *ket, *res;
+	qg8_chunk *obs, *k, *ev;
+	qg8_graph *g;
+
+	INIT();
+	_rand_seed(7);
+
+	(void) argc;
+	(void) argv;
+
+	dims[0] = DIM;
+	dims[1] = DIM;
+	kdims[0] = DIM;
+	ik[0] = (uint64_t *) malloc(sizeof(uint64_t) * DIM);
+	for (i = 0; i < DIM; ++i)
+	{
+		ik[0][i] = i;
+		kre[i] = _rand();
+		kim[i] = _rand();
+	}
+	ket = qg8_tensor_create_double(ik, kre, kim, DIM, kdims, 1,
+	                               QG8_PACKING_FULL);
+
+	ic[0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	ic[1] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	cre = (double *) malloc(sizeof(double) * NNZ);
+	cim = (double *) malloc(sizeof(double) * NNZ);
+	for (i = 0; i < NNZ; ++i)
+	{
+		ic[0][i] = (uint64_t) ((_rand() + 0.5) * DIM);
+		ic[1][i] = (uint64_t) ((_rand() + 0.5) * DIM);
+		cre[i] = _rand();
+		cim[i] = _rand();
+	}
+	coo = qg8_tensor_create_double(ic, cre, cim, NNZ, dims, 2,
+	                               QG8_PACKING_SPARSE_COO);
+	TEST(
+		qg8_tensor_expectation(coo, ket, &re, &im);
+		_reference(coo, ket, &rre, &rim);
+	, _close(re, rre) && _close(im, rim), "qg8_tensor_expectation (COO)"
+	);
+
+	/* upper triangle only, the expectation value is real */
+	ih[0] = (uint64_t *) malloc(sizeof(uint64_t) * NHH);
+	ih[1] = (uint64_t *) malloc(sizeof(uint64_t) * NHH);
+	hre = (double *) malloc(sizeof(double) * NHH);
+	him = (double *) malloc(sizeof(double) * NHH);
+	for (i = 0; i < NHH; ++i)
+	{
+		ih[0][i] = (i * 7) % DIM;
+		ih[1][i] = ih[0][i] + (i * 13) % (DIM - ih[0][i]);
+		hre[i] = _rand();
+		him[i] = ih[0][i] == ih[1][i] ? 0.0 : _rand();
+	}
+	hh = qg8_tensor_create_double(ih, hre, him, NHH, dims, 2,
+	                              QG8_PACKING_HALF_HERMITIAN);
+	TEST(
+		qg8_tensor_expectation(hh, ket, &re, &im);
+		_reference(hh, ket, &rre, &rim);
+	, _close(re, rre) && fabs(im) < 1e-12,
+	  "qg8_tensor_expectation (half-Hermitian)"
+	);
+
+	id[0] = (uint64_t *) malloc(sizeof(uint64_t) * DIM * DIM);
+	id[1] = (uint64_t *) malloc(sizeof(uint64_t) * DIM * DIM);
+	dre = (double *) malloc(sizeof(double) * DIM * DIM);
+	dim = (double *) malloc(sizeof(double) * DIM * DIM);
+	for (i = 0; i < DIM * DIM; ++i)
+	{
+		id[0][i] = i / DIM;
+		id[1][i] = i % DIM;
+		dre[i] = _rand();
+		dim[i] = _rand();
+	}
+	full = qg8_tensor_create_double(id, dre, dim, DIM * DIM, dims, 2,
+	                                QG8_PACKING_FULL);
+	TEST(
+		qg8_tensor_expectation(full, ket, &re, &im);
+		_reference(full, ket, &rre, &rim);
+	, _close(re, rre) && _close(im, rim), "qg8_tensor_expectation (full)"
+	);
+
+	/* ket first: the observable is recognised by its shape */
+	g = qg8_graph_create();
+	k = qg8_chunk_create(QG8_TYPE_KET, 0, NULL, ket);
+	qg8_graph_add_chunk(g, k);
+	obs = qg8_chunk_create(QG8_TYPE_OBSERVABLE, 0, NULL, coo);
+	qg8_graph_add_chunk(g, obs);
+	ev = qg8_chunk_create(QG8_TYPE_EXPECTATIONVALUE, 0, NULL, NULL);
+	qg8_graph_add_chunk(g, ev);
+	ie[0] = (uint64_t *) malloc(sizeof(uint64_t) * 2);
+	ie[1] = (uint64_t *) malloc(sizeof(uint64_t) * 2);
+	edims[0] = 4;
+	edims[1] = 4;
+	qg8_graph_add_chunk(g, qg8_chunk_create(QG8_TYPE_ADJACENCY, 0, NULL,
+	                    qg8_tensor_create_double(ie, ere, NULL, 2, edims, 2,
+	                                             QG8_PACKING_SPARSE_COO)));
+	ie[0][0] = _index_of(g, k);
+	ie[1][0] = _index_of(g, ev);
+	ere[0] = 1.0;
+	ie[0][1] = _index_of(g, obs);
+	ie[1][1] = _index_of(g, ev);
+	ere[1] = 2.0;
+	qg8_tensor_expectation(coo, ket, &rre, &rim);
+	TEST(
+		res = qg8_graph_evaluate(g, ev);
+	, res->num_elems == 1 && res->dtype_id == QG8_DTYPE_COMPLEX128 &&
+	  *((double *) res->redata) == rre && *((double *) res->imdata) == rim,
+	  "qg8_graph_evaluate (expectation value)"
+	);
+	qg8_tensor_destroy(res);
+
+	qg8_graph_destroy(g);
+	qg8_tensor_destroy(hh);
+	qg8_tensor_destroy(full);
+	free(ic[0]);
+	free(ic[1]);
+	free(cre);
+	free(cim);
+	free(ih[0]);
+	free(ih[1]);
+	free(hre);
+	free(him);
+	free(id[0]);
+	free(id[1]);
+	free(dre);
+	free(dim);
+	free(ik[0]);
+	free(ie[0]);
+	free(ie[1]);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,200 @@
+/*
+ * kron_test.c
+ * Kronecker products of sparse tensors and Kronecker views.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+/* compares the product with the Kronecker product of the dense operands */
+static
+int
+_check(qg8_tensor *res,
+       qg8_tensor *a,
+       qg8_tensor *b)
+{
+	double ar[64], ai[64], br[64], bi[64], or[4096], oi[4096], sr, si;
+	uint64_t ra, ca, rb, cb, r, c, n;
+
+	ra = a->dimensions[0];
+	ca = a->dimensions[1];
+	rb = b->dimensions[0];
+	cb = b->dimensions[1];
+	n = ca * cb;
+	_tensor_to_dense(a, ar, ai);
+	_tensor_to_dense(b, br, bi);
+	_tensor_to_dense(res, or, oi);
+	if (res->dimensions[0] != ra * rb || res->dimensions[1] != n)
+		return 0;
+	for (r = 0; r < ra * rb; ++r)
+	{
+		for (c = 0; c < n; ++c)
+		{
+			sr = ar[r/rb*ca+c/cb] * br[r%rb*cb+c%cb] -
+			     ai[r/rb*ca+c/cb] * bi[r%rb*cb+c%cb];
+			si = ar[r/rb*ca+c/cb] * bi[r%rb*cb+c%cb] +
+			     ai[r/rb*ca+c/cb] * br[r%rb*cb+c%cb];
+			if (fabs(sr - or[r*n+c]) > 1e-12 || fabs(si - oi[r*n+c]) > 1e-12)
+				return 0;
+		}
+	}
+	return 1;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *ia[2], *ib[2], *ih[2], *ii[2], *ik[1], adims[2], bdims[2];
+	uint64_t hdims[2], idims[2], kdims[2], i;
+	double are[6], aim[6], bre[5], hre[4], him[4], ire[2], kre[40], kim[40];
+	double *yr, *yi, *rr, *ri;
+	qg8_tensor *a, *b, *h, *id, *ket, *res, *ab, *abi, *ref, *factors[3];
+	qg8_kron *view;
+	int ok;
+
+	INIT();
+
+	(void) argc;
+	(void) argv;
+
+	/* a: 3x4 complex, b: 2x5 real, both sparse */
+	ia[0] = (uint64_t *) malloc(sizeof(uint64_t) * 6);
+	ia[1] = (uint64_t *) malloc(sizeof(uint64_t) * 6);
+	ib[0] = (uint64_t *) malloc(sizeof(uint64_t) * 5);
+	ib[1] = (uint64_t *) malloc(sizeof(uint64_t) * 5);
+	for (i = 0; i < 6; ++i)
+	{
+		ia[0][i] = (i * 5) % 3;
+		ia[1][i] = (i * 3 + 1) % 4;
+		are[i] = (double) i - 2.5;
+		aim[i] = (double) (i % 3) * 0.5;
+	}
+	for (i = 0; i < 5; ++i)
+	{
+		ib[0][i] = i % 2;
+		ib[1][i] = (i * 2) % 5;
+		bre[i] = (double) i + 1.0;
+	}
+	adims[0] = 3;
+	adims[1] = 4;
+	bdims[0] = 2;
+	bdims[1] = 5;
+	a = qg8_tensor_create_double(ia, are, aim, 6, adims, 2,
+	                             QG8_PACKING_SPARSE_COO);
+	b = qg8_tensor_create_double(ib, bre, NULL, 5, bdims, 2,
+	                             QG8_PACKING_SPARSE_COO);
+
+	TEST(
+		res = qg8_tensor_join(a, b);
+	, res->packing == QG8_PACKING_SPARSE_COO && res->num_elems == 30 &&
+	  res->itype_id == QG8_DTYPE_UINT8 && _check(res, a, b),
+	  "qg8_tensor_join (COO)"
+	);
+	qg8_tensor_destroy(res);
+
+	/* half-Hermitian factor, upper triangle stored */
+	ih[0] = (uint64_t *) malloc(sizeof(uint64_t) * 3);
+	ih[1] = (uint64_t *) malloc(sizeof(uint64_t) * 3);
+	ih[0][0] = 0; ih[1][0] = 0; hre[0] = 1.0; him[0] = 0.0;
+	ih[0][1] = 0; ih[1][1] = 1; hre[1] = 2.0; him[1] = -1.0;
+	ih[0][2] = 1; ih[1][2] = 1; hre[2] = -3.0; him[2] = 0.0;
+	hdims[0] = 2;
+	hdims[1] = 2;
+	h = qg8_tensor_create_double(ih, hre, him, 3, hdims, 2,
+	                             QG8_PACKING_HALF_HERMITIAN);
+	TEST(
+		res = qg8_tensor_join(h, b);
+	, res->num_elems == 20 && _check(res, h, b),
+	  "qg8_tensor_join (half-Hermitian)"
+	);
+	qg8_tensor_destroy(res);
+
+	/* view of a (x) I2 (x) b applied to a ket of 4*2*5 elements */
+	ii[0] = (uint64_t *) malloc(sizeof(uint64_t) * 2);
+	ii[1] = ii[0];
+	ii[0][0] = 0;
+	ii[0][1] = 1;
+	ire[0] = 1.0;
+	ire[1] = 1.0;
+	idims[0] = 2;
+	idims[1] = 2;
+	id = qg8_tensor_create_double(ii, ire, NULL, 2, idims, 2,
+	                              QG8_PACKING_SPARSE_COO);
+	ik[0] = (uint64_t *) malloc(sizeof(uint64_t) * 40);
+	for (i = 0; i < 40; ++i)
+	{
+		ik[0][i] = i;
+		kre[i] = (double) ((i * 7) % 11) - 5.0;
+		kim[i] = (double) ((i * 3) % 4);
+	}
+	kdims[0] = 40;
+	kdims[1] = 1;
+	ket = qg8_tensor_create_double(ik, kre, kim, 40, kdims, 1,
+	                               QG8_PACKING_FULL);
+	ab = qg8_tensor_join(a, id);
+	abi = qg8_tensor_join(ab, b);
+	ref = qg8_tensor_matmul(abi, ket);
+	factors[0] = a;
+	factors[1] = id;
+	factors[2] = b;
+	TEST(
+		view = qg8_kron_create(factors, 3);
+		res = qg8_kron_apply(view, ket);
+		yr = (double *) res->redata;
+		yi = (double *) res->imdata;
+		rr = (double *) ref->redata;
+		ri = (double *) ref->imdata;
+		ok = view->rows == 12 && view->cols == 40 && view->csr[1] == NULL &&
+		     res->num_elems == 12 && ref->num_elems == 12;
+		for (i = 0; ok && i < 12; ++i)
+			ok = fabs(yr[i] - rr[i]) < 1e-12 && fabs(yi[i] - ri[i]) < 1e-12;
+	, ok, "qg8_kron_apply"
+	);
+	qg8_tensor_destroy(res);
+	TEST(
+		;
+	, qg8_kron_destroy(view) == 1, "qg8_kron_destroy"
+	);
+
+	qg8_tensor_destroy(ref);
+	qg8_tensor_destroy(abi);
+	qg8_tensor_destroy(ab);
+	qg8_tensor_destroy(ket);
+	qg8_tensor_destroy(id);
+	qg8_tensor_destroy(h);
+	qg8_tensor_destroy(a);
+	qg8_tensor_destroy(b);
+	free(ia[0]);
+	free(ia[1]);
+	free(ib[0]);
+	free(ib[1]);
+	free(ih[0]);
+	free(ih[1]);
+	free(ii[0]);
+	free(ik[0]);
+
+	return EXIT_SUCCESS;
+}
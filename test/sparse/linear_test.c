@@ -0,0 +1,239 @@
+/*
+ * linear_test.c
+ * Linear index packing of sparse tensors.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define M     4
+#define N     1024
+#define NNZ   3000
+#define FNAME "sparse/linear_test.qg8"
+
+/* same entries, with the same coordinates and values, in the same order */
+static
+int
+_same(qg8_tensor *a,
+      qg8_tensor *b)
+{
+	double ar, ai, br, bi;
+	uint64_t e;
+	uint16_t k;
+
+	if (a->num_elems != b->num_elems || a->rank != b->rank)
+		return 0;
+	for (e = 0; e < a->num_elems; ++e)
+	{
+		for (k = 0; k < a->rank; ++k)
+			if (a->indices[k][e] != b->indices[k][e])
+				return 0;
+		_tensor_element(a, e, &ar, &ai);
+		_tensor_element(b, e, &br, &bi);
+		if (ar != br || ai != bi)
+			return 0;
+	}
+	return 1;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *ki[3], *oi[2], dims[3], odims[2], i;
+	uint64_t *bi[3], bdims[3], *zi[2], zdims[2], *vi[1], vdims[1];
+	uint64_t *fi[2], fdims[2];
+	double kre[NNZ], kim[NNZ], ore[NNZ], bre[4], zre[2], vre[2], fre[32];
+	qg8_tensor *k, *op, *canon, *full, *res[2];
+	qg8_chunk *back, *seq[2];
+	long coo_size, lin_size, packed_size;
+	int ok, j;
+
+	INIT();
+	_rand_seed(41);
+	(void) argc;
+	(void) argv;
+
+	/* a stack of M Kraus operators of dimension N */
+	dims[0] = M;
+	dims[1] = N;
+	dims[2] = N;
+	for (i = 0; i < 3; ++i)
+		ki[i] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	for (i = 0; i < NNZ; ++i)
+	{
+		ki[0][i] = _rand_int() % M;
+		ki[1][i] = _rand_int() % N;
+		ki[2][i] = _rand_int() % N;
+		kre[i] = (double) (_rand_int() % 100) / 10.0;
+		kim[i] = (double) (_rand_int() % 100) / 10.0;
+	}
+	k = qg8_tensor_create_double(ki, kre, kim, NNZ, dims, 3,
+	                             QG8_PACKING_SPARSE_COO);
+
+	/*
+	 * one 32 bit index per entry on disk instead of three 16 bit ones,
+	 * the three dimensions being written as wide as the index, and the
+	 * tensor back in COO packing
+	 */
+	TEST(
+		coo_size = _round_trip(FNAME, QG8_TYPE_NOISESPEC, &k, 1,
+		                       QG8_COMPRESS_NONE, QG8_INDEX_PLAIN, 0,
+		                       &back);
+		ok = back && qg8_chunk_get_index_encoding(back) == QG8_INDEX_PLAIN;
+		qg8_chunk_destroy(back);
+		lin_size = _round_trip(FNAME, QG8_TYPE_NOISESPEC, &k, 1,
+		                       QG8_COMPRESS_NONE, QG8_INDEX_LINEAR, 0,
+		                       &back);
+		ok = ok && back &&
+		     qg8_chunk_get_index_encoding(back) == QG8_INDEX_LINEAR &&
+		     back->tensor->packing == QG8_PACKING_SPARSE_COO &&
+		     back->tensor->itype_id == QG8_DTYPE_UINT32 &&
+		     _same(back->tensor, k);
+		qg8_chunk_destroy(back);
+	, ok && coo_size - lin_size == NNZ * 2 - 3 * 2,
+	  "LINEAR file round trip"
+	);
+
+	/* a canonical operator stays sorted, its single key packed */
+	odims[0] = N;
+	odims[1] = N;
+	oi[0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	oi[1] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	for (i = 0; i < NNZ; ++i)
+	{
+		oi[0][i] = _rand_int() % N;
+		oi[1][i] = _rand_int() % 64;
+		ore[i] = (double) (_rand_int() % 100) / 10.0;
+	}
+	op = qg8_tensor_create_double(oi, ore, NULL, NNZ, odims, 2,
+	                              QG8_PACKING_SPARSE_COO);
+	canon = qg8_tensor_canonical(op);
+	TEST(
+		lin_size = _round_trip(FNAME, QG8_TYPE_NOISESPEC, &op, 1,
+		                       QG8_COMPRESS_NONE, QG8_INDEX_LINEAR, 0,
+		                       &back);
+		qg8_chunk_destroy(back);
+		packed_size = _round_trip(FNAME, QG8_TYPE_NOISESPEC, &canon, 1,
+		                          QG8_COMPRESS_NONE, QG8_INDEX_LINEAR,
+		                          0, &back);
+		ok = back && back->tensor->packing == QG8_PACKING_SPARSE_COO &&
+		     (back->tensor->flags & QG8_TENSOR_SORTED) &&
+		     _same(back->tensor, canon);
+		qg8_chunk_destroy(back);
+	, ok && packed_size < lin_size, "canonical LINEAR file round trip"
+	);
+
+	fdims[0] = 8;
+	fdims[1] = 4;
+	fi[0] = (uint64_t *) malloc(sizeof(uint64_t) * 32);
+	fi[1] = (uint64_t *) malloc(sizeof(uint64_t) * 32);
+	for (i = 0; i < 32; ++i)
+	{
+		fi[0][i] = i / 4;
+		fi[1][i] = i % 4;
+		fre[i] = (double) i;
+	}
+	TEST(
+		full = qg8_tensor_create_double(fi, fre, NULL, 32, fdims, 2,
+		                                QG8_PACKING_FULL);
+		_round_trip(FNAME, QG8_TYPE_NOISESPEC, &full, 1,
+		            QG8_COMPRESS_NONE, QG8_INDEX_LINEAR, 0, &back);
+		ok = back && back->tensor->packing == QG8_PACKING_FULL &&
+		     _same(back->tensor, full);
+		qg8_chunk_destroy(back);
+		qg8_tensor_destroy(full);
+	, ok, "full LINEAR file round trip"
+	);
+
+	/* a bit flip channel read back drives the same trajectories */
+	bdims[0] = 2;
+	bdims[1] = 2;
+	bdims[2] = 2;
+	for (i = 0; i < 3; ++i)
+		bi[i] = (uint64_t *) malloc(sizeof(uint64_t) * 4);
+	for (i = 0; i < 4; ++i)
+	{
+		bi[0][i] = i / 2;
+		bi[1][i] = i % 2;
+		bi[2][i] = i < 2 ? i % 2 : 1 - i % 2;
+		bre[i] = i < 2 ? sqrt(0.8) : sqrt(0.2);
+	}
+	zdims[0] = 2;
+	zdims[1] = 2;
+	zi[0] = (uint64_t *) malloc(sizeof(uint64_t) * 2);
+	zi[0][0] = 0;
+	zi[0][1] = 1;
+	zi[1] = zi[0];
+	zre[0] = 1.0;
+	zre[1] = -1.0;
+	vdims[0] = 2;
+	vi[0] = zi[0];
+	vre[0] = 1.0;
+	vre[1] = 0.0;
+	TEST(
+		seq[1] = qg8_chunk_create(QG8_TYPE_OBSERVABLE, 0, NULL,
+		                          qg8_tensor_create_double(zi, zre, NULL, 2,
+		                          zdims, 2, QG8_PACKING_SPARSE_COO));
+		seq[0] = qg8_chunk_create(QG8_TYPE_NOISESPEC, 0, NULL,
+		                          qg8_tensor_create_double(bi, bre, NULL, 4,
+		                          bdims, 3, QG8_PACKING_SPARSE_COO));
+		_round_trip(FNAME, QG8_TYPE_NOISESPEC, &seq[0]->tensor, 1,
+		            QG8_COMPRESS_NONE, QG8_INDEX_LINEAR, 0, &back);
+		full = qg8_tensor_create_double(vi, vre, NULL, 2, vdims, 1,
+		                                QG8_PACKING_FULL);
+		res[0] = qg8_tensor_trajectories(full, seq, 2, 4000, 5);
+		qg8_chunk_destroy(seq[0]);
+		seq[0] = back;
+		res[1] = qg8_tensor_trajectories(full, seq, 2, 4000, 5);
+		ok = ((double *) res[0]->redata)[0] ==
+		     ((double *) res[1]->redata)[0] &&
+		     fabs(((double *) res[1]->redata)[0] - 0.6) < 0.05;
+		for (j = 0; j < 2; ++j)
+		{
+			qg8_tensor_destroy(res[j]);
+			qg8_chunk_destroy(seq[j]);
+		}
+		qg8_tensor_destroy(full);
+	, ok, "qg8_tensor_trajectories (LINEAR NOISESPEC)"
+	);
+
+	qg8_tensor_destroy(k);
+	qg8_tensor_destroy(op);
+	qg8_tensor_destroy(canon);
+	for (i = 0; i < 3; ++i)
+	{
+		free(ki[i]);
+		free(bi[i]);
+	}
+	free(oi[0]);
+	free(oi[1]);
+	free(fi[0]);
+	free(fi[1]);
+	free(zi[0]);
+
+	return EXIT_SUCCESS;
+}
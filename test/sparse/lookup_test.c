@@ -0,0 +1,241 @@
+/*
+ * lookup_test.c
+ * Element lookups and range queries on sparse tensors.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define ROWS  40
+#define COLS  50
+#define NNZ   600
+
+/* largest difference between every element read back and the dense t */
+static
+double
+_lookup_diff(qg8_tensor *t,
+             int *found)
+{
+	double dr[ROWS*COLS], di[ROWS*COLS], re, im, err;
+	uint64_t c[2];
+
+	_tensor_to_dense(t, dr, di);
+	err = 0.0;
+	*found = 0;
+	for (c[0] = 0; c[0] < *(t->dimensions); ++c[0])
+	{
+		for (c[1] = 0; c[1] < *(t->dimensions+1); ++c[1])
+		{
+			*found += qg8_tensor_get_element(t, c, &re, &im) > 0;
+			err = MAX(err, fabs(re - dr[c[0]*t->dimensions[1]+c[1]]));
+			err = MAX(err, fabs(im - di[c[0]*t->dimensions[1]+c[1]]));
+		}
+	}
+	return err;
+}
+
+/* entries inside [lo, hi), counted by a scan */
+static
+uint64_t
+_scan_count(qg8_tensor *t,
+            const uint64_t *lo,
+            const uint64_t *hi)
+{
+	uint64_t e, n;
+	uint16_t k;
+	int in;
+
+	n = 0;
+	for (e = 0; e < t->num_elems; ++e)
+	{
+		in = 1;
+		for (k = 0; k < t->rank; ++k)
+			in = in && t->indices[k][e] >= lo[k] && t->indices[k][e] < hi[k];
+		n += in;
+	}
+	return n;
+}
+
+/* found entries are inside the range and in coordinate order */
+static
+int
+_range_ok(qg8_tensor *t,
+          const uint64_t *lo,
+          const uint64_t *hi)
+{
+	uint64_t *ent, n, i, x, y;
+	uint16_t k;
+	int ok;
+
+	n = qg8_tensor_find_range(t, lo, hi, &ent);
+	ok = n == _scan_count(t, lo, hi);
+	for (i = 0; ok && i < n; ++i)
+	{
+		for (k = 0; k < t->rank; ++k)
+			ok = ok && t->indices[k][ent[i]] >= lo[k] &&
+			     t->indices[k][ent[i]] < hi[k];
+		for (k = 0; ok && i > 0 && k < t->rank; ++k)
+		{
+			x = t->indices[k][ent[i-1]];
+			y = t->indices[k][ent[i]];
+			if (x != y)
+			{
+				ok = x < y;
+				break;
+			}
+		}
+	}
+	free(ent);
+	return ok;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *ai[2], *hind[2], *ti[3], dims[2], hdims[2], tdims[3];
+	uint64_t lo[3], hi[3], i, r;
+	double are[NNZ], aim[NNZ], hre[NNZ], him[NNZ], tre[NNZ], err;
+	qg8_tensor *a, *c, *h, *t;
+	int found, ok;
+
+	INIT();
+	_rand_seed(5);
+	(void) argc;
+	(void) argv;
+
+	/* an unordered complex matrix with duplicates */
+	dims[0] = ROWS;
+	dims[1] = COLS;
+	ai[0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	ai[1] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	for (i = 0; i < NNZ; ++i)
+	{
+		ai[0][i] = _rand_int() % ROWS;
+		ai[1][i] = _rand_int() % COLS;
+		are[i] = (double) (_rand_int() % 100) / 10.0;
+		aim[i] = (double) (_rand_int() % 100) / 10.0;
+	}
+	a = qg8_tensor_create_double(ai, are, aim, NNZ, dims, 2,
+	                             QG8_PACKING_SPARSE_COO);
+
+	TEST(
+		err = _lookup_diff(a, &found);
+	, err < 1e-12 && a->order != NULL && found > 0 && found < ROWS * COLS,
+	  "qg8_tensor_get_element (unordered)"
+	);
+
+	TEST(
+		c = qg8_tensor_canonical(a);
+		err = _lookup_diff(c, &ok);
+	, err < 1e-12 && c->order == NULL && ok == found,
+	  "qg8_tensor_get_element (canonical)"
+	);
+
+	TEST(
+		ok = 1;
+		for (r = 0; r < ROWS; ++r)
+		{
+			lo[0] = r;
+			lo[1] = 0;
+			hi[0] = r + 1;
+			hi[1] = COLS;
+			ok = ok && _range_ok(a, lo, hi) && _range_ok(c, lo, hi);
+		}
+		lo[0] = 7;
+		lo[1] = 11;
+		hi[0] = 23;
+		hi[1] = 19;
+		ok = ok && _range_ok(a, lo, hi) && _range_ok(c, lo, hi);
+		hi[1] = 11;
+		ok = ok && _range_ok(a, lo, hi);
+	, ok, "qg8_tensor_find_range (rows and blocks)"
+	);
+
+	/* half Hermitian tensors read their mirrored entries */
+	hdims[0] = ROWS;
+	hdims[1] = ROWS;
+	hind[0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	hind[1] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	for (i = 0; i < NNZ; ++i)
+	{
+		hind[0][i] = _rand_int() % ROWS;
+		hind[1][i] = hind[0][i] + _rand_int() % (ROWS - hind[0][i]);
+		hre[i] = (double) (_rand_int() % 100) / 10.0;
+		him[i] = hind[0][i] == hind[1][i] ? 0.0 :
+		         (double) (_rand_int() % 100) / 10.0;
+	}
+	h = qg8_tensor_create_double(hind, hre, him, NNZ, hdims, 2,
+	                             QG8_PACKING_HALF_HERMITIAN);
+	TEST(
+		err = _lookup_diff(h, &found);
+		qg8_tensor_lookup_release(h);
+	, err < 1e-12 && h->order == NULL,
+	  "qg8_tensor_get_element (half Hermitian)"
+	);
+
+	/* a rank 3 stack, with the last axis filtered */
+	tdims[0] = 4;
+	tdims[1] = 30;
+	tdims[2] = 300;
+	for (i = 0; i < 3; ++i)
+		ti[i] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	for (i = 0; i < NNZ; ++i)
+	{
+		ti[0][i] = _rand_int() % tdims[0];
+		ti[1][i] = _rand_int() % tdims[1];
+		ti[2][i] = _rand_int() % tdims[2];
+		tre[i] = 1.0;
+	}
+	t = qg8_tensor_create_double(ti, tre, NULL, NNZ, tdims, 3,
+	                             QG8_PACKING_SPARSE_COO);
+	TEST(
+		lo[0] = 1;
+		lo[1] = 5;
+		lo[2] = 100;
+		hi[0] = 3;
+		hi[1] = 25;
+		hi[2] = 200;
+		ok = _range_ok(t, lo, hi);
+		lo[0] = 0;
+		lo[1] = 0;
+		lo[2] = 0;
+		ok = ok && _range_ok(t, lo, tdims);
+	, ok, "qg8_tensor_find_range (rank 3)"
+	);
+
+	qg8_tensor_destroy(a);
+	qg8_tensor_destroy(c);
+	qg8_tensor_destroy(h);
+	qg8_tensor_destroy(t);
+	for (i = 0; i < 3; ++i)
+		free(ti[i]);
+	free(ai[0]);
+	free(ai[1]);
+	free(hind[0]);
+	free(hind[1]);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,224 @@
+/*
+ * pauli_test.c
+ * Observables stored as sums of Pauli strings.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define NQ     14
+#define DIM    (1 << NQ)
+#define TERMS  24
+
+/* single qubit matrices I, X, Y, Z as 2x2 COO tensors */
+static uint64_t prow[4][2] = {{0, 1}, {0, 1}, {0, 1}, {0, 1}};
+static uint64_t pcol[4][2] = {{0, 1}, {1, 0}, {1, 0}, {0, 1}};
+static double pre[4][2] = {{1, 1}, {1, 1}, {0, 0}, {1, -1}};
+static double pim[4][2] = {{0, 0}, {0, 0}, {-1, 1}, {0, 0}};
+static uint64_t pdims[2] = {2, 2};
+static uint64_t *pind[4][2];
+
+static
+qg8_tensor *
+_single(char c)
+{
+	int p;
+
+	p = c == 'I' ? 0 : c == 'X' ? 1 : c == 'Y' ? 2 : 3;
+	pind[p][0] = prow[p];
+	pind[p][1] = pcol[p];
+	return qg8_tensor_create_double(pind[p], pre[p], pim[p], 2, pdims, 2,
+	                                QG8_PACKING_SPARSE_COO);
+}
+
+/* explicit matrix of a Pauli string built from Kronecker products */
+static
+qg8_tensor *
+_string(const char *s)
+{
+	qg8_tensor *acc, *f, *next;
+
+	acc = _single(*s++);
+	for (; *s; ++s)
+	{
+		f = _single(*s);
+		next = qg8_tensor_join(acc, f);
+		qg8_tensor_destroy(acc);
+		qg8_tensor_destroy(f);
+		acc = next;
+	}
+	return acc;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	static char strings[TERMS][NQ + 1];
+	static const char paulis[] = "IXYZ";
+	uint64_t *ind[2], *kind[1], *ja[2], *jb[2], jx[4], jz[4], dims[2];
+	uint64_t jdims[2], kdims[1], sdims[1], x, z, i, t;
+	double cre[TERMS], cim[TERMS], kre[DIM], kim[DIM], yre[DIM], yim[DIM];
+	double one[1], zero[1], *sr, *si, re, im, rre, rim;
+	qg8_tensor *pauli, *ket, *small, *y, *p, *pa, *pb, *coo, *joined, *mixed;
+	qg8_tensor *ya, *yb;
+	int ok;
+
+	INIT();
+	_rand_seed(11);
+
+	(void) argc;
+	(void) argv;
+
+	TEST(
+		qg8_pauli_parse("XIZY", &x, &z);
+	, x == 9 && z == 3, "qg8_pauli_parse"
+	);
+
+	ind[0] = (uint64_t *) malloc(sizeof(uint64_t) * TERMS);
+	ind[1] = (uint64_t *) malloc(sizeof(uint64_t) * TERMS);
+	for (t = 0; t < TERMS; ++t)
+	{
+		for (i = 0; i < NQ; ++i)
+			strings[t][i] = t == 0 ? 'I' :
+			                paulis[(t * 7 + i * i * 3 + t * i) % 4];
+		strings[t][NQ] = '\0';
+		qg8_pauli_parse(strings[t], &ind[0][t], &ind[1][t]);
+		cre[t] = _rand();
+		cim[t] = t % 3 == 0 ? 0.0 : _rand();
+	}
+	dims[0] = DIM;
+	dims[1] = DIM;
+	pauli = qg8_tensor_create_double(ind, cre, cim, TERMS, dims, 2,
+	                                 QG8_PACKING_PAULI);
+
+	kind[0] = (uint64_t *) malloc(sizeof(uint64_t) * DIM);
+	for (i = 0; i < DIM; ++i)
+	{
+		kind[0][i] = i;
+		kre[i] = _rand();
+		kim[i] = _rand();
+	}
+	kdims[0] = DIM;
+	sdims[0] = 8;
+	one[0] = 1.0;
+	zero[0] = 0.0;
+	ket = qg8_tensor_create_double(kind, kre, kim, DIM, kdims, 1,
+	                               QG8_PACKING_FULL);
+
+	/* reference: every string expanded and applied on its own */
+	for (i = 0; i < DIM; ++i)
+	{
+		yre[i] = 0.0;
+		yim[i] = 0.0;
+	}
+	for (t = 0; t < TERMS; ++t)
+	{
+		p = _string(strings[t]);
+		y = qg8_tensor_apply(p, ket);
+		sr = (double *) y->redata;
+		si = (double *) y->imdata;
+		for (i = 0; i < DIM; ++i)
+		{
+			yre[i] += cre[t] * sr[i] - cim[t] * si[i];
+			yim[i] += cre[t] * si[i] + cim[t] * sr[i];
+		}
+		qg8_tensor_destroy(y);
+		qg8_tensor_destroy(p);
+	}
+	rre = 0.0;
+	rim = 0.0;
+	for (i = 0; i < DIM; ++i)
+	{
+		rre += kre[i] * yre[i] + kim[i] * yim[i];
+		rim += kre[i] * yim[i] - kim[i] * yre[i];
+	}
+
+	TEST(
+		y = qg8_tensor_apply(pauli, ket);
+		sr = (double *) y->redata;
+		si = (double *) y->imdata;
+		ok = y->num_elems == DIM;
+		for (i = 0; ok && i < DIM; ++i)
+			ok = fabs(sr[i] - yre[i]) < 1e-10 && fabs(si[i] - yim[i]) < 1e-10;
+	, ok, "qg8_tensor_apply (Pauli)"
+	);
+	qg8_tensor_destroy(y);
+
+	TEST(
+		qg8_tensor_expectation(pauli, ket, &re, &im);
+	, fabs(re - rre) < 1e-8 && fabs(im - rim) < 1e-8,
+	  "qg8_tensor_expectation (Pauli)"
+	);
+
+	/* both operands Pauli: the product stays packed */
+	ja[0] = jx;
+	ja[1] = jz;
+	qg8_pauli_parse("XI", &jx[0], &jz[0]);
+	qg8_pauli_parse("ZY", &jx[1], &jz[1]);
+	qg8_pauli_parse("YZ", &jx[2], &jz[2]);
+	jb[0] = jx + 3;
+	jb[1] = jz + 3;
+	qg8_pauli_parse("X", &jx[3], &jz[3]);
+	jdims[0] = 4;
+	jdims[1] = 4;
+	pa = qg8_tensor_create_double(ja, cre, cim, 3, jdims, 2,
+	                              QG8_PACKING_PAULI);
+	pb = qg8_tensor_create_double(jb, one, zero, 1, pdims, 2,
+	                              QG8_PACKING_PAULI);
+	coo = _single('X');
+	small = qg8_tensor_create_double(kind, kre, kim, 8, sdims, 1,
+	                                 QG8_PACKING_FULL);
+	TEST(
+		joined = qg8_tensor_join(pa, pb);
+		mixed = qg8_tensor_join(pa, coo);
+		ya = qg8_tensor_apply(joined, small);
+		yb = qg8_tensor_apply(mixed, small);
+		ok = joined->packing == QG8_PACKING_PAULI && joined->num_elems == 3 &&
+		     mixed->packing == QG8_PACKING_SPARSE_COO;
+		sr = (double *) ya->redata;
+		si = (double *) ya->imdata;
+		for (i = 0; ok && i < 8; ++i)
+			ok = fabs(sr[i] - ((double *) yb->redata)[i]) < 1e-12 &&
+			     fabs(si[i] - ((double *) yb->imdata)[i]) < 1e-12;
+	, ok, "qg8_tensor_join (Pauli)"
+	);
+
+	qg8_tensor_destroy(ya);
+	qg8_tensor_destroy(yb);
+	qg8_tensor_destroy(mixed);
+	qg8_tensor_destroy(joined);
+	qg8_tensor_destroy(small);
+	qg8_tensor_destroy(coo);
+	qg8_tensor_destroy(pa);
+	qg8_tensor_destroy(pb);
+	qg8_tensor_destroy(ket);
+	qg8_tensor_destroy(pauli);
+	free(ind[0]);
+	free(ind[1]);
+	free(kind[0]);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,227 @@
+/*
+ * reorder_test.c
+ * Reverse Cuthill-McKee reordering of sparse operators.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define N     64
+#define NNZ   (N * 5)
+
+/* largest distance of a stored entry from the diagonal */
+static
+uint64_t
+_bandwidth(qg8_tensor *t)
+{
+	uint64_t e, r, c, bw;
+
+	bw = 0;
+	for (e = 0; e < t->num_elems; ++e)
+	{
+		r = *(*(t->indices)+e);
+		c = *(*(t->indices+1)+e);
+		bw = MAX(bw, r > c ? r - c : c - r);
+	}
+	return bw;
+}
+
+/* largest difference between the elements of two full kets */
+static
+double
+_diff(qg8_tensor *a,
+      qg8_tensor *b)
+{
+	double ar[N], ai[N], br[N], bi[N], err;
+	uint64_t i;
+
+	_tensor_to_dense(a, ar, ai);
+	_tensor_to_dense(b, br, bi);
+	err = 0.0;
+	for (i = 0; i < N; ++i)
+	{
+		err = MAX(err, fabs(ar[i] - br[i]));
+		err = MAX(err, fabs(ai[i] - bi[i]));
+	}
+	return err;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *ai[2], *ki[1], *ie[2], dims[2], kdims[1], edims[2];
+	uint64_t q[N], *perm, i, j, n, bw;
+	double are[NNZ], aim[NNZ], xr[N], xi[N], ed[2], err;
+	qg8_tensor *a, *x, *ap, *xp, *y, *yp, *back, *ref, *res;
+	qg8_chunk *op, *ket, *mm, *pc, *cst;
+	qg8_graph *g;
+	int ok;
+
+	INIT();
+	_rand_seed(23);
+	(void) argc;
+	(void) argv;
+
+	/* a band of width 2, its states shuffled by q */
+	for (i = 0; i < N; ++i)
+		q[i] = i;
+	for (i = N - 1; i > 0; --i)
+	{
+		j = _rand_int() % (i + 1);
+		n = q[i];
+		q[i] = q[j];
+		q[j] = n;
+	}
+	dims[0] = N;
+	dims[1] = N;
+	ai[0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	ai[1] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	n = 0;
+	for (i = 0; i < NNZ; ++i)
+	{
+		j = i % N + (i / N) % 5;
+		if (j < 2 || j - 2 >= N)
+			continue;
+		ai[0][n] = q[i % N];
+		ai[1][n] = q[j - 2];
+		are[n] = _rand();
+		aim[n++] = _rand();
+	}
+	a = qg8_tensor_create_double(ai, are, aim, n, dims, 2,
+	                             QG8_PACKING_SPARSE_COO);
+	ki[0] = (uint64_t *) malloc(sizeof(uint64_t) * N);
+	for (i = 0; i < N; ++i)
+	{
+		ki[0][i] = i;
+		xr[i] = _rand();
+		xi[i] = _rand();
+	}
+	kdims[0] = N;
+	x = qg8_tensor_create_double(ki, xr, xi, N, kdims, 1, QG8_PACKING_FULL);
+
+	TEST(
+		perm = qg8_tensor_rcm(a);
+		ap = qg8_tensor_permute(a, perm, 0);
+		bw = _bandwidth(ap);
+	, _bandwidth(a) > N / 4 && bw <= 4 && ap->num_elems == a->num_elems,
+	  "qg8_tensor_rcm (shuffled band)"
+	);
+
+	/* (PAP^T)(Px) = P(Ax) */
+	TEST(
+		xp = qg8_tensor_permute(x, perm, 0);
+		y = qg8_tensor_matmul(a, x);
+		yp = qg8_tensor_matmul(ap, xp);
+		back = qg8_tensor_permute(yp, perm, 1);
+		err = _diff(back, y);
+		qg8_tensor_destroy(back);
+		qg8_tensor_destroy(yp);
+		ok = 1;
+		for (i = 0; i < N; ++i)
+			ok = ok && ((double *) xp->redata)[i] == xr[perm[i]];
+	, ok && err < 1e-12, "qg8_tensor_permute (products)"
+	);
+
+	/* the inverse undoes the permutation */
+	TEST(
+		back = qg8_tensor_permute(ap, perm, 1);
+		yp = qg8_tensor_matmul(back, x);
+		err = _diff(yp, y);
+		qg8_tensor_destroy(yp);
+		qg8_tensor_destroy(back);
+	, err < 1e-12, "qg8_tensor_permute (inverse)"
+	);
+
+	/* y = A x in a graph, relabelled in place */
+	g = qg8_graph_create();
+	op = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, NULL, a);
+	qg8_graph_add_chunk(g, op);
+	ket = qg8_chunk_create(QG8_TYPE_KET, 0, NULL, x);
+	qg8_graph_add_chunk(g, ket);
+	mm = qg8_chunk_create(QG8_TYPE_MATMUL, 0, NULL, NULL);
+	qg8_graph_add_chunk(g, mm);
+	ie[0] = (uint64_t *) malloc(sizeof(uint64_t) * 2);
+	ie[1] = (uint64_t *) malloc(sizeof(uint64_t) * 2);
+	edims[0] = 4;
+	edims[1] = 4;
+	qg8_graph_add_chunk(g, qg8_chunk_create(QG8_TYPE_ADJACENCY, 0, NULL,
+	                    qg8_tensor_create_double(ie, ed, NULL, 2, edims, 2,
+	                                             QG8_PACKING_SPARSE_COO)));
+	/* a CONSTANT of as many elements, left as it is */
+	cst = qg8_chunk_create(QG8_TYPE_CONSTANT, 0, NULL, _tensor_copy(x));
+	qg8_graph_add_chunk(g, cst);
+	ie[0][0] = _index_of(g, op);
+	ie[1][0] = _index_of(g, mm);
+	ed[0] = 1.0;
+	ie[0][1] = _index_of(g, ket);
+	ie[1][1] = _index_of(g, mm);
+	ed[1] = 2.0;
+
+	TEST(
+		ref = qg8_graph_evaluate(g, mm);
+		pc = qg8_graph_reorder(g, op);
+		res = qg8_graph_evaluate(g, mm);
+		back = qg8_tensor_permute(res, (uint64_t *) pc->tensor->redata, 1);
+		err = _diff(back, ref);
+		qg8_tensor_destroy(back);
+		qg8_tensor_destroy(res);
+		ok = op->tensor != a && ket->tensor != x &&
+		     !memcmp(cst->tensor->redata, xr, sizeof(xr));
+	, ok && err < 1e-12 && pc->type == QG8_TYPE_PERMUTATION &&
+	  _index_of(g, pc) == 5 && _bandwidth(op->tensor) <= 4,
+	  "qg8_graph_reorder"
+	);
+
+	/* reordering again composes into the same permutation chunk */
+	TEST(
+		pc = qg8_graph_reorder(g, op);
+		res = qg8_graph_evaluate(g, mm);
+		back = qg8_tensor_permute(res, (uint64_t *) pc->tensor->redata, 1);
+		err = _diff(back, ref);
+		qg8_tensor_destroy(back);
+		qg8_tensor_destroy(res);
+	, err < 1e-12 && qg8_graph_get_number_chunks(g) == 6,
+	  "qg8_graph_reorder (twice)"
+	);
+
+	qg8_tensor_destroy(ref);
+	qg8_graph_destroy(g);
+	/* the tensors replaced in the graph are still the caller's */
+	qg8_tensor_destroy(a);
+	qg8_tensor_destroy(x);
+	qg8_tensor_destroy(ap);
+	qg8_tensor_destroy(xp);
+	qg8_tensor_destroy(y);
+	free(perm);
+	free(ai[0]);
+	free(ai[1]);
+	free(ki[0]);
+	free(ie[0]);
+	free(ie[1]);
+
+	return EXIT_SUCCESS;
+}
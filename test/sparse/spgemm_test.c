@@ -0,0 +1,225 @@
+/*
+ * spgemm_test.c
+ * Sparse-sparse matrix products against a dense reference.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define N    83
+#define NNZ  600
+#define WIDE 70001 /* wider than the dense accumulator */
+
+/*
+ * Fills a COO tensor of shape dims, which the tensor borrows, and adds it to
+ * the dense matrix d.
+ */
+static
+qg8_tensor *
+_random(uint64_t **ind,
+        double *re,
+        double *im,
+        uint64_t *dims,
+        double *dre,
+        double *dim)
+{
+	uint64_t e, rows, cols;
+
+	rows = dims[0];
+	cols = dims[1];
+	for (e = 0; e < NNZ; ++e)
+	{
+		ind[0][e] = _rand_int() % rows;
+		ind[1][e] = _rand_int() % cols;
+		re[e] = (double) (_rand_int() % 9) - 4.0;
+		dre[ind[0][e]*cols+ind[1][e]] += re[e];
+		if (im)
+		{
+			im[e] = (double) (_rand_int() % 5) * 0.5;
+			dim[ind[0][e]*cols+ind[1][e]] += im[e];
+		}
+	}
+	return qg8_tensor_create_double(ind, re, im, NNZ, dims, 2,
+	                                QG8_PACKING_SPARSE_COO);
+}
+
+/*
+ * Checks that a COO product is sorted, has the expected index type and
+ * matches the dense product of a and b on every entry.
+ */
+static
+int
+_check(qg8_tensor *res,
+       const double *are,
+       const double *aim,
+       const double *bre,
+       const double *bim,
+       uint64_t rows,
+       uint64_t inner,
+       uint64_t cols,
+       uint8_t itype)
+{
+	uint64_t e, r, c, k, last;
+	double sre, sim, *ore, *oim;
+
+	ore = (double *) res->redata;
+	oim = (double *) res->imdata;
+	if (res->packing != QG8_PACKING_SPARSE_COO ||
+	    res->itype_id != itype)
+		return 0;
+	last = 0;
+	for (e = 0; e < res->num_elems; ++e)
+	{
+		r = res->indices[0][e];
+		c = res->indices[1][e];
+		if (e > 0 && r * cols + c <= last)
+			return 0;
+		last = r * cols + c;
+		sre = 0.0;
+		sim = 0.0;
+		for (k = 0; k < inner; ++k)
+		{
+			sre += are[r*inner+k] * bre[k*cols+c] -
+			       aim[r*inner+k] * bim[k*cols+c];
+			sim += are[r*inner+k] * bim[k*cols+c] +
+			       aim[r*inner+k] * bre[k*cols+c];
+		}
+		if (fabs(sre - ore[e]) > 1e-9 || fabs(sim - oim[e]) > 1e-9)
+			return 0;
+	}
+	(void) rows;
+	return 1;
+}
+
+/* structural nnz of the product of the patterns of a and b */
+static
+uint64_t
+_pattern_nnz(qg8_tensor *a,
+             qg8_tensor *b,
+             uint64_t rows,
+             uint64_t cols)
+{
+	unsigned char *hit;
+	uint64_t p, q, n;
+
+	hit = (unsigned char *) calloc(rows * cols, 1);
+	n = 0;
+	for (p = 0; p < a->num_elems; ++p)
+		for (q = 0; q < b->num_elems; ++q)
+			if (a->indices[1][p] == b->indices[0][q] &&
+			    !hit[a->indices[0][p]*cols+b->indices[1][q]])
+			{
+				hit[a->indices[0][p]*cols+b->indices[1][q]] = 1;
+				++n;
+			}
+	free(hit);
+	return n;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *ia[2], *ib[2], adims[2], bdims[2];
+	double are[NNZ], aim[NNZ], bre[NNZ], bim[NNZ];
+	double *dare, *daim, *dbre, *dbim;
+	qg8_tensor *a, *b, *res;
+
+	INIT();
+	_rand_seed(777);
+
+	(void) argc;
+	(void) argv;
+
+	ia[0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	ia[1] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	ib[0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	ib[1] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+
+	/* square complex times real, duplicates included */
+	dare = (double *) calloc(N * N, sizeof(double));
+	daim = (double *) calloc(N * N, sizeof(double));
+	dbre = (double *) calloc(N * N, sizeof(double));
+	dbim = (double *) calloc(N * N, sizeof(double));
+	adims[0] = N;
+	adims[1] = N;
+	bdims[0] = N;
+	bdims[1] = N;
+	a = _random(ia, are, aim, adims, dare, daim);
+	b = _random(ib, bre, NULL, bdims, dbre, dbim);
+	TEST(
+		res = qg8_tensor_matmul(a, b);
+	, _check(res, dare, daim, dbre, dbim, N, N, N, QG8_DTYPE_UINT8) &&
+	  res->num_elems == _pattern_nnz(a, b, N, N), "qg8_tensor_matmul (COO)"
+	);
+	qg8_tensor_destroy(res);
+
+	TEST(
+		qg8_tensor_csr_build(a);
+		qg8_tensor_csr_build(b);
+		res = qg8_tensor_matmul(a, b);
+	, _check(res, dare, daim, dbre, dbim, N, N, N, QG8_DTYPE_UINT8),
+	  "qg8_tensor_matmul (cached CSR)"
+	);
+	qg8_tensor_destroy(res);
+	qg8_tensor_destroy(a);
+	qg8_tensor_destroy(b);
+	free(dare);
+	free(daim);
+	free(dbre);
+	free(dbim);
+
+	/* wide result, rows are accumulated in hash tables */
+	dare = (double *) calloc(4 * N, sizeof(double));
+	daim = (double *) calloc(4 * N, sizeof(double));
+	dbre = (double *) calloc(N * WIDE, sizeof(double));
+	dbim = (double *) calloc(N * WIDE, sizeof(double));
+	adims[0] = 4;
+	adims[1] = N;
+	bdims[0] = N;
+	bdims[1] = WIDE;
+	a = _random(ia, are, aim, adims, dare, daim);
+	b = _random(ib, bre, bim, bdims, dbre, dbim);
+	TEST(
+		res = qg8_tensor_matmul(a, b);
+	, _check(res, dare, daim, dbre, dbim, 4, N, WIDE, QG8_DTYPE_UINT32) &&
+	  res->num_elems == _pattern_nnz(a, b, 4, WIDE),
+	  "qg8_tensor_matmul (hash accumulator)"
+	);
+	qg8_tensor_destroy(res);
+	qg8_tensor_destroy(a);
+	qg8_tensor_destroy(b);
+	free(dare);
+	free(daim);
+	free(dbre);
+	free(dbim);
+
+	free(ia[0]);
+	free(ia[1]);
+	free(ib[0]);
+	free(ib[1]);
+
+	return EXIT_SUCCESS;
+}
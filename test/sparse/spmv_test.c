@@ -0,0 +1,216 @@
+/*
+ * spmv_test.c
+ * Sparse matrix-vector products against a dense reference.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define N   97
+#define NNZ 700
+
+/* dense y = a*x */
+static
+void
+_reference(const double *are,
+           const double *aim,
+           const double *xre,
+           const double *xim,
+           double *yre,
+           double *yim)
+{
+	uint64_t i, j;
+	for (i = 0; i < N; ++i)
+	{
+		yre[i] = 0.0;
+		yim[i] = 0.0;
+		for (j = 0; j < N; ++j)
+		{
+			yre[i] += are[i*N+j] * xre[j] - aim[i*N+j] * xim[j];
+			yim[i] += are[i*N+j] * xim[j] + aim[i*N+j] * xre[j];
+		}
+	}
+}
+
+static
+int
+_close(const double *a,
+       const double *b,
+       uint64_t n)
+{
+	uint64_t i;
+	for (i = 0; i < n; ++i)
+		if (fabs(a[i] - b[i]) > 1e-9 * (1.0 + fabs(b[i])))
+			return 0;
+	return 1;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *ind[2], *hind[2], *kind[1], dims[2], kdims[1], e, h, r, c, seed;
+	double re[NNZ], im[NNZ], hre[NNZ], him[NNZ], kre[N/2], kim[N/2];
+	double *dre, *dim, *hdre, *hdim, xre[N], xim[N];
+	double yre[N], yim[N], rre[N], rim[N];
+	qg8_tensor *a, *herm, *ket, *res;
+	int isa, ok;
+
+	INIT();
+
+	(void) argc;
+	(void) argv;
+
+	dims[0] = N;
+	dims[1] = N;
+	kdims[0] = N;
+	ind[0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	ind[1] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	hind[0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	hind[1] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	kind[0] = (uint64_t *) malloc(sizeof(uint64_t) * (N/2));
+	dre = (double *) calloc(N * N, sizeof(double));
+	dim = (double *) calloc(N * N, sizeof(double));
+	hdre = (double *) calloc(N * N, sizeof(double));
+	hdim = (double *) calloc(N * N, sizeof(double));
+
+	/* unordered entries with duplicates and one long row */
+	seed = 12345;
+	h = 0;
+	for (e = 0; e < NNZ; ++e)
+	{
+		seed = (seed * 1103515245 + 12345) % 2147483648UL;
+		r = e % 5 == 0 ? 3 : (seed >> 8) % N;
+		c = (seed >> 4) % N;
+		ind[0][e] = r;
+		ind[1][e] = c;
+		re[e] = (double) ((seed >> 12) % 17) - 8.0;
+		im[e] = (double) ((seed >> 20) % 9) * 0.5;
+		dre[r*N+c] += re[e];
+		dim[r*N+c] += im[e];
+		/* upper triangle of a Hermitian matrix, real diagonal */
+		if (r <= c && (r != c || h % 2 == 0))
+		{
+			hind[0][h] = r;
+			hind[1][h] = c;
+			hre[h] = re[e];
+			him[h] = r == c ? 0.0 : im[e];
+			hdre[r*N+c] += hre[h];
+			hdim[r*N+c] += him[h];
+			if (r != c)
+			{
+				hdre[c*N+r] += hre[h];
+				hdim[c*N+r] -= him[h];
+			}
+			++h;
+		}
+	}
+	for (e = 0; e < N; ++e)
+	{
+		xre[e] = 1.0 / (double) (e + 1);
+		xim[e] = (double) (e % 7) - 3.0;
+	}
+
+	a = qg8_tensor_create_double(ind, re, im, NNZ, dims, 2,
+	                             QG8_PACKING_SPARSE_COO);
+	herm = qg8_tensor_create_double(hind, hre, him, h, dims, 2,
+	                                QG8_PACKING_HALF_HERMITIAN);
+
+	TEST(
+		;
+	, qg8_tensor_csr_build(a) == 1 && a->csr != NULL &&
+	  qg8_tensor_csr_build(a) == 1, "qg8_tensor_csr_build"
+	);
+
+	for (isa = QG8_ISA_SCALAR; isa <= QG8_ISA_AVX512; ++isa)
+	{
+		if (!qg8_kernel_set_isa(isa))
+			continue;
+		_reference(dre, dim, xre, xim, rre, rim);
+		TEST(
+		qg8_tensor_spmv(a, xre, xim, yre, yim);
+		, _close(yre, rre, N) && _close(yim, rim, N),
+		  "qg8_tensor_spmv (COO)"
+		);
+		_reference(hdre, hdim, xre, xim, rre, rim);
+		TEST(
+		qg8_tensor_spmv(herm, xre, xim, yre, yim);
+		, _close(yre, rre, N) && _close(yim, rim, N),
+		  "qg8_tensor_spmv (half-Hermitian)"
+		);
+	}
+
+	/* sparse ket, every other basis state */
+	for (e = 0; e < N / 2; ++e)
+	{
+		kind[0][e] = (N / 2 - 1 - e) * 2;
+		kre[e] = 0.5 * (double) e;
+		kim[e] = -1.0;
+	}
+	for (e = 0; e < N; ++e)
+	{
+		xre[e] = 0.0;
+		xim[e] = 0.0;
+	}
+	for (e = 0; e < N / 2; ++e)
+	{
+		xre[kind[0][e]] = kre[e];
+		xim[kind[0][e]] = kim[e];
+	}
+	ket = qg8_tensor_create_double(kind, kre, kim, N / 2, kdims, 1,
+	                               QG8_PACKING_SPARSE_COO);
+	_reference(dre, dim, xre, xim, rre, rim);
+	TEST(
+	res = qg8_tensor_apply(a, ket);
+	ok = res->rank == 1 && res->num_elems == N &&
+	     res->packing == QG8_PACKING_FULL;
+	for (e = 0; ok && e < N; ++e)
+		ok = res->indices[0][e] == e;
+	, ok && _close((double *) res->redata, rre, N) &&
+	  _close((double *) res->imdata, rim, N), "qg8_tensor_apply"
+	);
+	qg8_tensor_destroy(res);
+
+	TEST(
+		;
+	, qg8_tensor_csr_release(a) == 1 && a->csr == NULL,
+	  "qg8_tensor_csr_release"
+	);
+
+	qg8_tensor_destroy(ket);
+	qg8_tensor_destroy(herm);
+	qg8_tensor_destroy(a);
+	free(ind[0]);
+	free(ind[1]);
+	free(hind[0]);
+	free(hind[1]);
+	free(kind[0]);
+	free(dre);
+	free(dim);
+	free(hdre);
+	free(hdim);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,201 @@
+/*
+ * structured_test.c
+ * Diagonal and block sparse packings.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define N     48
+#define M     30
+#define NNZ   (N * 8)
+#define FNAME "sparse/structured_test.qg8"
+
+/* largest difference between t*x and ref*x */
+static
+double
+_spmv_diff(qg8_tensor *t,
+           qg8_tensor *ref,
+           const double *xr,
+           const double *xi)
+{
+	double yr[N], yi[N], zr[N], zi[N], err;
+	uint64_t i;
+
+	qg8_tensor_spmv(t, xr, xi, yr, yi);
+	qg8_tensor_spmv(ref, xr, xi, zr, zi);
+	err = 0.0;
+	for (i = 0; i < *(ref->dimensions); ++i)
+	{
+		err = MAX(err, fabs(yr[i] - zr[i]));
+		err = MAX(err, fabs(yi[i] - zi[i]));
+	}
+	return err;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *bi[2], *ri[2], *ki[1], dims[2], rdims[2], kdims[1], i, n;
+	double bre[NNZ], bim[NNZ], rre[NNZ], xr[N], xi[N], a[2], b[2], err;
+	qg8_tensor *band, *rect, *ket, *dia, *bsr, *rdia, *rbsr, *back[2];
+	qg8_chunk *c[2];
+	qg8_file *f;
+	qg8_iter iter;
+
+	INIT();
+	_rand_seed(11);
+	(void) argc;
+	(void) argv;
+
+	/* a complex band of offsets -2..3 with duplicates, and a ket */
+	dims[0] = N;
+	dims[1] = N;
+	bi[0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	bi[1] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	n = 0;
+	for (i = 0; i < NNZ; ++i)
+	{
+		bi[0][n] = i % N;
+		bi[1][n] = i % N + (i / N) % 6 - 2;
+		if (bi[1][n] >= N)
+			continue;
+		bre[n] = _rand();
+		bim[n++] = _rand();
+	}
+	band = qg8_tensor_create_double(bi, bre, bim, n, dims, 2,
+	                                QG8_PACKING_SPARSE_COO);
+	ki[0] = (uint64_t *) malloc(sizeof(uint64_t) * N);
+	for (i = 0; i < N; ++i)
+	{
+		ki[0][i] = i;
+		xr[i] = _rand();
+		xi[i] = _rand();
+	}
+	kdims[0] = N;
+	ket = qg8_tensor_create_double(ki, xr, xi, N, kdims, 1,
+	                               QG8_PACKING_FULL);
+
+	TEST(
+		dia = qg8_tensor_to_dia(band);
+		err = _spmv_diff(dia, band, xr, xi);
+	, dia->packing == QG8_PACKING_DIA && dia->num_elems == 6 * N &&
+	  _tensor_index_len(dia) == 6 && dia->indices[0][0] == 2 &&
+	  dia->indices[1][5] == 3 && err < 1e-12,
+	  "qg8_tensor_to_dia (band)"
+	);
+
+	TEST(
+		bsr = qg8_tensor_to_bsr(band, 4, 4);
+		err = _spmv_diff(bsr, band, xr, xi);
+	, bsr->packing == QG8_PACKING_BSR &&
+	  bsr->num_elems == (3 * (N / 4) - 2) * 16 &&
+	  _tensor_index_len(bsr) == 3 * (N / 4) - 1 && err < 1e-12,
+	  "qg8_tensor_to_bsr (band)"
+	);
+
+	/* a real rectangular matrix, wider than tall */
+	rdims[0] = M;
+	rdims[1] = N;
+	ri[0] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	ri[1] = (uint64_t *) malloc(sizeof(uint64_t) * NNZ);
+	for (i = 0; i < NNZ; ++i)
+	{
+		ri[0][i] = (i * 7) % M;
+		ri[1][i] = (i * 13 + i / M) % N;
+		rre[i] = _rand();
+	}
+	rect = qg8_tensor_create_double(ri, rre, NULL, NNZ, rdims, 2,
+	                                QG8_PACKING_SPARSE_COO);
+	TEST(
+		rdia = qg8_tensor_to_dia(rect);
+		rbsr = qg8_tensor_to_bsr(rect, 3, 2);
+		err = MAX(_spmv_diff(rdia, rect, xr, xi),
+		          _spmv_diff(rbsr, rect, xr, xi));
+	, rdia->num_elems % M == 0 && rbsr->num_elems % 6 == 0 && err < 1e-12,
+	  "qg8_tensor_spmv (rectangular DIA and BSR)"
+	);
+
+	/* other operations expand the packings */
+	TEST(
+		qg8_tensor_expectation(band, ket, &a[0], &a[1]);
+		qg8_tensor_expectation(dia, ket, &b[0], &b[1]);
+		err = fabs(a[0] - b[0]) + fabs(a[1] - b[1]);
+		qg8_tensor_expectation(bsr, ket, &b[0], &b[1]);
+		err += fabs(a[0] - b[0]) + fabs(a[1] - b[1]);
+		back[0] = qg8_tensor_to_dia(bsr);
+		err += _spmv_diff(back[0], band, xr, xi);
+		qg8_tensor_destroy(back[0]);
+	, err < 1e-12, "DIA and BSR expectation values and conversions"
+	);
+
+	/* the index arrays are as short on disk as in memory */
+	TEST(
+		f = qg8_file_open(FNAME, QG8_MODE_WRITE);
+		c[0] = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, NULL, dia);
+		c[1] = qg8_chunk_create(QG8_TYPE_OPERATOR, 0, NULL, rbsr);
+		qg8_file_write_chunk(f, c[0]);
+		qg8_file_write_chunk(f, c[1]);
+		qg8_file_flush(f);
+		qg8_file_close(f);
+		qg8_chunk_destroy(c[0]);
+		qg8_chunk_destroy(c[1]);
+		f = qg8_file_open(FNAME, QG8_MODE_READ);
+		iter = qg8_file_iterator(f);
+		back[0] = NULL;
+		back[1] = NULL;
+		for (i = 0; i < 2 && qg8_file_has_next(&iter); ++i)
+		{
+			c[i] = qg8_file_extract(&iter);
+			back[i] = c[i]->tensor;
+		}
+		qg8_file_close(f);
+		remove(FNAME);
+		err = i < 2 ? 1.0 : MAX(_spmv_diff(back[0], band, xr, xi),
+		                        _spmv_diff(back[1], rect, xr, xi));
+	, i == 2 && back[0]->packing == QG8_PACKING_DIA &&
+	  _tensor_index_len(back[0]) == 6 &&
+	  back[1]->packing == QG8_PACKING_BSR &&
+	  back[1]->indices[0][0] == 3 && back[1]->indices[1][0] == 2 &&
+	  err < 1e-12, "DIA and BSR file round trip"
+	);
+	qg8_chunk_destroy(c[0]);
+	qg8_chunk_destroy(c[1]);
+
+	qg8_tensor_destroy(band);
+	qg8_tensor_destroy(rect);
+	qg8_tensor_destroy(ket);
+	qg8_tensor_destroy(bsr);
+	qg8_tensor_destroy(rdia);
+	free(bi[0]);
+	free(bi[1]);
+	free(ri[0]);
+	free(ri[1]);
+	free(ki[0]);
+
+	return EXIT_SUCCESS;
+}
@@ -74,10 +74,37 @@ fail_tests "tensor" "bad_tensor1 bad_tensor2 bad_tensor3 bad_tensor4"
 succeed_tests "chunk" "chunk_test"
 
 # file tests
-succeed_tests "file" "file_write file_read"
+succeed_tests "file" "file_write file_read compress_test convert_test"
 
 # graph tests
 succeed_tests "graph" "graph_load" "graph_create"
 
+# kernel tests
+succeed_tests "kernel" "kernel_test gemm_test half_test"
+
+# sparse tests
+succeed_tests "sparse" "spmv_test spgemm_test kron_test expect_test \
+               pauli_test structured_test reorder_test canon_test \
+               lookup_test linear_test codec_test"
+fail_tests "sparse" "bad_reorder"
+
+# gate tests
+succeed_tests "gate" "gate_test fusion_test"
+
+# sample tests
+succeed_tests "sample" "sample_test"
+
+# solve tests
+succeed_tests "solve" "solve_test eigen_test"
+
+# noise tests
+succeed_tests "noise" "trajectory_test"
+
+# partial trace tests
+succeed_tests "trace" "trace_test"
+
+# planner tests
+succeed_tests "plan" "plan_test batch_test"
+
 echo "-- $passed/$total tests passed --"
 
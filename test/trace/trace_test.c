@@ -0,0 +1,254 @@
+/*
+ * trace_test.c
+ * Reduced density matrices of kets and density matrices.
+ *
+ * Date created : 19/10/2026
+ */
+
+/*
+ * Copyright 2021 University of Strasbourg
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "common_test.h"
+#include "macros.h"
+#include "qg8.h"
+
+#define NQ    6
+#define DIM   (1 << NQ)
+#define BIGQ  16
+#define BIG   (1 << BIGQ)
+
+/* state of the kept qubits in basis state i of nq qubits */
+static
+uint64_t
+_kept(uint64_t i,
+      const uint64_t *q,
+      uint64_t k,
+      uint64_t nq)
+{
+	uint64_t a, j;
+
+	a = 0;
+	for (j = 0; j < k; ++j)
+		a = (a << 1) | ((i >> (nq - 1 - q[j])) & 1);
+	return a;
+}
+
+/* basis state i with its kept qubits set to a */
+static
+uint64_t
+_with(uint64_t i,
+      uint64_t a,
+      const uint64_t *q,
+      uint64_t k,
+      uint64_t nq)
+{
+	uint64_t j, bit;
+
+	for (j = 0; j < k; ++j)
+	{
+		bit = (uint64_t) 1 << (nq - 1 - q[j]);
+		i = (a >> (k - 1 - j)) & 1 ? i | bit : i & ~bit;
+	}
+	return i;
+}
+
+/* reference reduced density matrix of a dense ket, by the definition */
+static
+void
+_reference(const double *xr,
+           const double *xi,
+           uint64_t nq,
+           const uint64_t *q,
+           uint64_t k,
+           double *rr,
+           double *ri)
+{
+	uint64_t dk, i, j, a, c;
+
+	dk = (uint64_t) 1 << k;
+	for (a = 0; a < dk * dk; ++a)
+	{
+		rr[a] = 0.0;
+		ri[a] = 0.0;
+	}
+	for (i = 0; i < ((uint64_t) 1 << nq); ++i)
+	{
+		a = _kept(i, q, k, nq);
+		for (c = 0; c < dk; ++c)
+		{
+			j = _with(i, c, q, k, nq);
+			rr[a*dk+c] += xr[i] * xr[j] + xi[i] * xi[j];
+			ri[a*dk+c] += xi[i] * xr[j] - xr[i] * xi[j];
+		}
+	}
+}
+
+static
+double
+_diff(qg8_tensor *t,
+      const double *rr,
+      const double *ri,
+      uint64_t dk)
+{
+	double err;
+	uint64_t a;
+
+	if (t->rank != 2 || t->dimensions[0] != dk || t->dimensions[1] != dk)
+		return 1.0;
+	err = 0.0;
+	for (a = 0; a < dk * dk; ++a)
+	{
+		err = MAX(err, fabs(((double *) t->redata)[a] - rr[a]));
+		err = MAX(err, fabs(((double *) t->imdata)[a] - ri[a]));
+	}
+	return err;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+	uint64_t *kind[1], *fi[2], *hi[2], kdims[1], dims[2], keep[3], i, j;
+	uint64_t nh, bell[1];
+	double *kre, *kim, *fre, *fim, *hre, *him, rr[64], ri[64], err;
+	qg8_tensor *ket, *full, *hh, *big, *res;
+
+	INIT();
+	_rand_seed(3);
+	(void) argc;
+	(void) argv;
+
+	kind[0] = (uint64_t *) malloc(sizeof(uint64_t) * BIG);
+	kre = (double *) malloc(sizeof(double) * BIG);
+	kim = (double *) malloc(sizeof(double) * BIG);
+	for (i = 0; i < BIG; ++i)
+	{
+		kind[0][i] = i;
+		kre[i] = _rand();
+		kim[i] = _rand();
+	}
+	kdims[0] = DIM;
+	ket = qg8_tensor_create_double(kind, kre, kim, DIM, kdims, 1,
+	                               QG8_PACKING_FULL);
+	keep[0] = 4;
+	keep[1] = 1;
+	_reference(kre, kim, NQ, keep, 2, rr, ri);
+	TEST(
+		res = qg8_tensor_partial_trace(ket, keep, 2);
+		err = _diff(res, rr, ri, 4);
+	, err < 1e-12, "qg8_tensor_partial_trace (ket)"
+	);
+	qg8_tensor_destroy(res);
+
+	/* |x><x| stored whole, and its upper triangle as half-Hermitian */
+	dims[0] = DIM;
+	dims[1] = DIM;
+	fi[0] = (uint64_t *) malloc(sizeof(uint64_t) * DIM * DIM);
+	fi[1] = (uint64_t *) malloc(sizeof(uint64_t) * DIM * DIM);
+	fre = (double *) malloc(sizeof(double) * DIM * DIM);
+	fim = (double *) malloc(sizeof(double) * DIM * DIM);
+	hi[0] = (uint64_t *) malloc(sizeof(uint64_t) * DIM * DIM);
+	hi[1] = (uint64_t *) malloc(sizeof(uint64_t) * DIM * DIM);
+	hre = (double *) malloc(sizeof(double) * DIM * DIM);
+	him = (double *) malloc(sizeof(double) * DIM * DIM);
+	nh = 0;
+	for (i = 0; i < DIM; ++i)
+	{
+		for (j = 0; j < DIM; ++j)
+		{
+			fi[0][i*DIM+j] = i;
+			fi[1][i*DIM+j] = j;
+			fre[i*DIM+j] = kre[i] * kre[j] + kim[i] * kim[j];
+			fim[i*DIM+j] = kim[i] * kre[j] - kre[i] * kim[j];
+			if (j < i)
+				continue;
+			hi[0][nh] = i;
+			hi[1][nh] = j;
+			hre[nh] = fre[i*DIM+j];
+			him[nh++] = fim[i*DIM+j];
+		}
+	}
+	full = qg8_tensor_create_double(fi, fre, fim, DIM * DIM, dims, 2,
+	                                QG8_PACKING_FULL);
+	hh = qg8_tensor_create_double(hi, hre, him, nh, dims, 2,
+	                              QG8_PACKING_HALF_HERMITIAN);
+	TEST(
+		res = qg8_tensor_partial_trace(full, keep, 2);
+		err = _diff(res, rr, ri, 4);
+		qg8_tensor_destroy(res);
+		res = qg8_tensor_partial_trace(hh, keep, 2);
+		err = MAX(err, _diff(res, rr, ri, 4));
+	, err < 1e-12, "qg8_tensor_partial_trace (density matrix)"
+	);
+	qg8_tensor_destroy(res);
+
+	/* enough environment states for every block */
+	kdims[0] = BIG;
+	big = qg8_tensor_create_double(kind, kre, kim, BIG, kdims, 1,
+	                               QG8_PACKING_FULL);
+	keep[0] = 15;
+	keep[1] = 0;
+	keep[2] = 7;
+	_reference(kre, kim, BIGQ, keep, 3, rr, ri);
+	TEST(
+		res = qg8_tensor_partial_trace(big, keep, 3);
+		err = _diff(res, rr, ri, 8);
+	, err < 1e-9, "qg8_tensor_partial_trace (blocks)"
+	);
+	qg8_tensor_destroy(res);
+
+	/* either half of a Bell pair is maximally mixed */
+	kdims[0] = 4;
+	for (i = 0; i < 4; ++i)
+	{
+		kre[i] = i == 0 || i == 3 ? sqrt(0.5) : 0.0;
+		kim[i] = 0.0;
+	}
+	qg8_tensor_destroy(ket);
+	ket = qg8_tensor_create_double(kind, kre, NULL, 4, kdims, 1,
+	                               QG8_PACKING_FULL);
+	bell[0] = 1;
+	TEST(
+		res = qg8_tensor_partial_trace(ket, bell, 1);
+		err = fabs(((double *) res->redata)[0] - 0.5) +
+		      fabs(((double *) res->redata)[1]) +
+		      fabs(((double *) res->redata)[2]) +
+		      fabs(((double *) res->redata)[3] - 0.5);
+	, err < 1e-15, "qg8_tensor_partial_trace (Bell pair)"
+	);
+	qg8_tensor_destroy(res);
+
+	qg8_tensor_destroy(ket);
+	qg8_tensor_destroy(full);
+	qg8_tensor_destroy(hh);
+	qg8_tensor_destroy(big);
+	free(kind[0]);
+	free(kre);
+	free(kim);
+	free(fi[0]);
+	free(fi[1]);
+	free(fre);
+	free(fim);
+	free(hi[0]);
+	free(hi[1]);
+	free(hre);
+	free(him);
+
+	return EXIT_SUCCESS;
+}